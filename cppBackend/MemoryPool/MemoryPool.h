@@ -1,5 +1,6 @@
 #pragma once
 #include"threadcache.h"
+#include"pageCache.h"
 
 //最上层类，直接调用ThreadCache的单例模式进行初始化，使用内存池时，直接使用此类
 class MemoryPool{
@@ -10,4 +11,8 @@ public:
   static void deallocate(void *ptr,size_t size){
     threadcache::getInstance()->deallocate(ptr,size);
   }
+  //页缓存层的内存用量（原子读取，不加锁）
+  static pageCache::Stats stats(){
+    return pageCache::getInstance().getStats();
+  }
 };
\ No newline at end of file
@@ -34,6 +34,7 @@ void *pageCache::allocateSpan(size_t numPages){
     }
 
     spanMap_[span->pageAddr] = std::move(spanPtr);
+    spanInUseBytes_.fetch_add(numPages * PAGE_SIZE, std::memory_order_relaxed);
     return span->pageAddr;
   }
 
@@ -49,6 +50,8 @@ void *pageCache::allocateSpan(size_t numPages){
 
   // 记录span信息用于回收
   spanMap_[memory] = std::move(span);
+  mappedBytes_.fetch_add(numPages * PAGE_SIZE, std::memory_order_relaxed);
+  spanInUseBytes_.fetch_add(numPages * PAGE_SIZE, std::memory_order_relaxed);
   return memory;
 }
 
@@ -61,6 +64,7 @@ void pageCache::deallocateSpan(void* ptr, size_t numPages){
   if (it == spanMap_.end()) return;
 
   Span* span = it->second.get();
+  spanInUseBytes_.fetch_sub(numPages * PAGE_SIZE, std::memory_order_relaxed);
 
   //尝试合并相邻的span
   void *nextAddr = static_cast<char*>(ptr) + numPages * PAGE_SIZE;
@@ -126,6 +130,7 @@ void* pageCache::allocateLarge(size_t size){
 
   // 记录大型内存信息用于释放
   largeSpanMap_[ptr] = size;
+  largeBytes_.fetch_add(size, std::memory_order_relaxed);
   return ptr;
 }
 
@@ -136,8 +141,17 @@ void pageCache::deallocateLarge(void* ptr, size_t size){
   if (it != largeSpanMap_.end()) {
     size_t recordedSize = it->second;
     largeSpanMap_.erase(it);
+    largeBytes_.fetch_sub(recordedSize, std::memory_order_relaxed);
     munmap(ptr, recordedSize);
   } else {
     munmap(ptr, size);
   }
-}
\ No newline at end of file
+}
+
+pageCache::Stats pageCache::getStats() const{
+  Stats st;
+  st.mappedBytes = mappedBytes_.load(std::memory_order_relaxed);
+  st.spanInUseBytes = spanInUseBytes_.load(std::memory_order_relaxed);
+  st.largeBytes = largeBytes_.load(std::memory_order_relaxed);
+  return st;
+}
@@ -3,6 +3,7 @@
 #include<map>
 #include<mutex>
 #include<memory>
+#include<atomic>
 
 class pageCache{
 public:
@@ -25,6 +26,14 @@ public:
   //释放大型内存
   void deallocateLarge(void* ptr, size_t size);
 
+  //内存使用统计（字节），原子读取，不加锁
+  struct Stats{
+    size_t mappedBytes;     //为span向系统申请的总量（不归还系统）
+    size_t spanInUseBytes;  //已分配给上层的span
+    size_t largeBytes;      //当前持有的大型内存
+  };
+  Stats getStats() const;
+
 private:
   pageCache() =default;
 
@@ -51,4 +60,8 @@ private:
 
   //大型内存的独立mutex
   std::mutex largeMutex_;
+
+  std::atomic<size_t> mappedBytes_{0};
+  std::atomic<size_t> spanInUseBytes_{0};
+  std::atomic<size_t> largeBytes_{0};
 };
\ No newline at end of file
@@ -1,9 +1,11 @@
 #pragma once
 
+#include <atomic>
 #include <chrono>
 #include <memory>
 #include <string>
 #include <vector>
+#include <sys/uio.h>
 
 #include "core/IHttpMessage.h"
 #include "error/HttpError.h"
@@ -12,10 +14,13 @@
 // 前向声明必要的类
 class ISslHandler;
 class IHttpParser;
+class Http1Parser;
 class HandlerChain;
 class IRequestHandler;
+class HttpRequest;
 class HttpResponse;
 class Router;
+struct RouteMatchInfo;
 
 // HTTP服务器处理结果
 enum class HttpServerResult {
@@ -73,6 +78,33 @@ public:
     // 设置路由处理器（预留接口）
     void SetRouter(std::shared_ptr<Router> router);
 
+    // 设置连接级取消令牌，路由前注入到请求对象，供处理器轮询
+    void SetCancelToken(std::shared_ptr<const std::atomic_bool> token);
+
+    // 延迟路由：ProcessPending 只做到责任链验证，路由匹配与处理器执行由调用方通过
+    // MatchRoute/RunRoute 分步完成，以便把处理器调度到路由声明的执行池
+    void SetDeferRouting(bool defer);
+    bool IsDeferRouting() const { return defer_routing_; }
+
+    // 分段快速路径上 Content-Length 不小于 threshold 的请求只解析请求头，body 留给调用方流式处理（0 表示关闭）
+    void SetBodyDeferThreshold(size_t threshold);
+
+    // 交还处理完毕的请求消息：HTTP/1 解析器留作下一个请求的对象，其余情况直接释放
+    void RecycleMessage(std::unique_ptr<IHttpMessage> message);
+
+    // 对外部解析器（如 HTTP/2 连接）产出的请求执行解析后的公共阶段（责任链验证；非延迟路由时还包括路由）
+    HttpServerResult ValidateMessage(std::unique_ptr<IHttpMessage>& message,
+                                     HttpResponse& response,
+                                     HttpError& out_error);
+
+    // 路由匹配（执行中间件，不执行处理器）；未匹配时返回 ROUTING_FAILED 并填充 out_error
+    HttpServerResult MatchRoute(IHttpMessage& message, HttpResponse& response,
+                                RouteMatchInfo& out_route, HttpError& out_error);
+
+    // 执行已匹配的处理器；只读取路由器与取消令牌，可在 pending 缓冲的锁之外调用
+    HttpServerResult RunRoute(HttpRequest& request, HttpResponse& response,
+                              const RouteMatchInfo& route, HttpError& out_error);
+
     // 配置服务器
     void ConfigureServer(bool enable_ssl = false,
                         const std::string& cert_file = "",
@@ -100,6 +132,14 @@ public:
                                     HttpResponse& out_response,
                                     HttpError& out_error);
 
+    // 分段输入的处理接口：明文 HTTP/1 直接在调用方的分段缓冲（如连接输入缓冲的各内存块）上解析，
+    // 只拷贝一次请求头；其余情况把数据转入 pending 缓冲走 ProcessPending。
+    // consumed 返回本次从分段中取走的字节数，调用方据此推进读指针
+    HttpServerResult ProcessSegments(const struct iovec* iov, size_t iovcnt, size_t& consumed,
+                                     std::unique_ptr<IHttpMessage>& out_message,
+                                     HttpResponse& out_response,
+                                     HttpError& out_error);
+
 private:
     // SSL处理阶段
     HttpServerResult ProcessSsl(const std::string& raw_data,
@@ -109,6 +149,15 @@ private:
     HttpServerResult ProcessParsing(std::string data,
                                   std::unique_ptr<IHttpMessage>& message);
 
+    // 解析返回码映射为处理结果并填充错误信息
+    HttpServerResult HandleParseResult(int parse_result, size_t received_bytes,
+                                       std::unique_ptr<IHttpMessage>& message);
+
+    // 解析完成后的验证、路由与通知阶段
+    HttpServerResult ProcessParsedMessage(std::unique_ptr<IHttpMessage>& out_message,
+                                          HttpResponse& out_response,
+                                          HttpError& out_error);
+
     // 责任链验证阶段
     HttpServerResult ProcessValidation(IHttpMessage& message, HttpResponse& response);
 
@@ -118,17 +167,26 @@ private:
     // 通知观察者（处理完成事件）
     void NotifyObservers(const IHttpMessage& message);
 
-    // 通知观察者SSL处理事件
-    void NotifySslProcess(const std::string& event, const std::string& details);
-
-    // 通知观察者HTTP解析事件
-    void NotifyHttpParse(const std::string& event, const std::string& details);
-
-    // 通知观察者责任链验证事件
-    void NotifyValidation(const std::string& event, const std::string& details);
-
-    // 通知观察者路由处理事件
-    void NotifyRouting(const std::string& event, const std::string& details);
+    // 是否有观察者订阅了该阶段；定义 HTTP_DISABLE_EVENTS 时在编译期恒为 false，事件点整体被消除
+    bool Observing(HttpProcessStage stage) const {
+#ifdef HTTP_DISABLE_EVENTS
+        (void)stage;
+        return false;
+#else
+        return (event_mask_ & HttpStageBit(stage)) != 0;
+#endif
+    }
+
+    // 事件点：未订阅时只有一次掩码判断，不构造事件、不取时间戳、不调用虚函数
+    void Emit(HttpProcessStage stage, HttpEventKind kind, int code = 0, uint64_t bytes = 0,
+              const IHttpMessage* message = nullptr) {
+        if (Observing(stage)) {
+            EmitEvent(stage, kind, code, bytes, message);
+        }
+    }
+    void EmitEvent(HttpProcessStage stage, HttpEventKind kind, int code, uint64_t bytes,
+                   const IHttpMessage* message);
+    void RebuildEventMask();
 
 private:
     // SSL相关成员
@@ -138,6 +196,7 @@ private:
 
     // HTTP解析相关
     std::shared_ptr<IHttpParser> parser_;
+    Http1Parser* http1_parser_{nullptr};   // parser_ 为 HTTP/1 解析器时的缓存指针，用于分段快速路径
 
     int parse_timeout_ms_{5000};
     bool awaiting_more_data_{false};
@@ -149,8 +208,16 @@ private:
     // 路由处理器
     std::shared_ptr<Router> router_;
 
+    // 连接级取消令牌
+    std::shared_ptr<const std::atomic_bool> cancel_token_;
+
+    bool defer_routing_{false};
+    size_t body_defer_threshold_{0};
+
     // 观察者列表
     std::vector<std::shared_ptr<IHttpObserver>> observers_;
+    std::vector<uint32_t> observer_masks_;   // 与 observers_ 一一对应，注册时读取的订阅阶段
+    uint32_t event_mask_{0};                 // 全部观察者订阅阶段的并集
 
     HttpError last_error_{};
     bool has_error_{false};
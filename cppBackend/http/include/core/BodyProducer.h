@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+/**
+ * BodyProducer：按需生成的响应体
+ * 处理器用 HttpResponse::SetBodyProducer 代替 SetBody 时，body 不必先在内存中拼完：
+ * 服务器随响应头发出第一段，之后每当连接输出缓冲降到高水位以下才再拉取一段，
+ * 发送速度由客户端的接收速度决定，内存中只保留正在发送的一段。
+ * Length() 已知时以 Content-Length 发送，否则 HTTP/1.1 使用 Transfer-Encoding: chunked。
+ * Produce 在路由声明的执行池中调用，同一响应的多次调用不会并发，可以做阻塞操作（遍历目录、查询数据库）。
+ */
+class BodyProducer {
+public:
+  enum class Status { More, Done, Error };
+
+  virtual ~BodyProducer() = default;
+
+  // body 总长度，未知时返回 -1
+  virtual int64_t Length() const { return -1; }
+  // 向 out 追加下一段数据，长度以 max_bytes 为目标（可以略多；返回 More 时应至少追加一个字节）；
+  // Done 表示 body 到此结束，Error 时响应被中止、连接随之关闭
+  virtual Status Produce(std::string& out, size_t max_bytes) = 0;
+};
+
+// 用回调实现的生产者：处理器把遍历状态捕获在闭包里即可
+class CallbackBodyProducer : public BodyProducer {
+public:
+  using ProduceFn = std::function<Status(std::string& out, size_t max_bytes)>;
+
+  explicit CallbackBodyProducer(ProduceFn fn, int64_t length = -1) : fn_(std::move(fn)), length_(length) {}
+
+  int64_t Length() const override { return length_; }
+  Status Produce(std::string& out, size_t max_bytes) override { return fn_(out, max_bytes); }
+
+private:
+  ProduceFn fn_;
+  int64_t length_;
+};
+
+/**
+ * BodyProducerFramer：把生产者的输出转换为线上字节
+ * chunked 时给每段加分块帧、结束时追加终止块；已知长度时校验生产者给出的字节数与声明一致。
+ * 不做线程同步，由调用方保证同一时刻只有一个线程调用 Next。
+ */
+class BodyProducerFramer {
+public:
+  BodyProducerFramer(std::shared_ptr<BodyProducer> producer, bool chunked);
+
+  // 向 wire 追加下一段线上字节：连续拉取直到凑够 max_bytes 或 body 结束
+  BodyProducer::Status Next(std::string& wire, size_t max_bytes);
+
+  bool Chunked() const { return chunked_; }
+  uint64_t Produced() const { return produced_; }
+
+private:
+  std::shared_ptr<BodyProducer> producer_;
+  bool chunked_;
+  int64_t length_;
+  uint64_t produced_{0};
+  bool finished_{false};
+  std::string scratch_;
+};
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// 常用头部：解析/写入时即解析为枚举，按枚举读取为 O(1)，不需要构造规范化的 key
+enum class KnownHeader : uint8_t {
+  Host,
+  Connection,
+  ContentLength,
+  ContentType,
+  ContentEncoding,
+  ContentRange,
+  TransferEncoding,
+  Range,
+  IfRange,
+  IfNoneMatch,
+  IfModifiedSince,
+  Authorization,
+  Cookie,
+  SetCookie,
+  AcceptEncoding,
+  Origin,
+  Upgrade,
+  Expect,
+  Trailer,
+  Date,
+  ETag,
+  LastModified,
+  Location,
+  Vary,
+  CacheControl,
+  AcceptRanges,
+  Count,
+  Unknown = 0xFF
+};
+
+constexpr size_t kKnownHeaderCount = static_cast<size_t>(KnownHeader::Count);
+
+// 忽略大小写识别常用头部名称，不是常用头部时返回 KnownHeader::Unknown
+KnownHeader LookupKnownHeader(std::string_view name);
+// 常用头部的小写规范名称
+std::string_view KnownHeaderName(KnownHeader id);
+
+/**
+ * HeaderTable：请求/响应共用的头部表
+ * 名称与值都存放在表自有的连续缓冲区 arena_ 中，每个头部只记录偏移区间与常用头部枚举；
+ * 名称一律以小写保存，查询返回 string_view，视图在头部表下一次修改或销毁前有效。
+ * 解析器可以把已拷贝的整个请求头直接交给 Adopt 作为 arena，无需再逐个拷贝头部。
+ */
+class HeaderTable {
+public:
+  struct Entry {
+    uint32_t name_off;
+    uint32_t name_len;
+    uint32_t value_off;
+    uint32_t value_len;
+    KnownHeader id{KnownHeader::Unknown};
+  };
+
+  HeaderTable() { known_.fill(0); }
+
+  // 接管解析器拷贝的原始请求头并就地把各头部名称转为小写；entries 的 id 由解析器在扫描时填好
+  void Adopt(std::string&& raw, std::vector<Entry>&& entries);
+  // 清空头部表，并把 arena 与区间数组（保留容量）交给调用方，供解析下一个请求时复用
+  void Release(std::string& raw, std::vector<Entry>& entries);
+
+  void Append(std::string_view name, std::string_view value);
+  // 替换所有同名头部
+  void Set(std::string_view name, std::string_view value);
+  void Set(KnownHeader id, std::string_view value);
+  void Remove(std::string_view name);
+  void Clear();
+  void Reserve(size_t count, size_t bytes);
+
+  // 首个同名头部的值
+  std::optional<std::string_view> Get(std::string_view name) const;
+  std::optional<std::string_view> Get(KnownHeader id) const;
+  std::vector<std::string_view> GetAll(std::string_view name) const;
+  bool Has(std::string_view name) const { return Find(name) != kNotFound; }
+  bool Has(KnownHeader id) const { return known_[static_cast<size_t>(id)] != 0; }
+
+  size_t Size() const { return entries_.size(); }
+  bool Empty() const { return entries_.empty(); }
+  std::string_view NameAt(size_t i) const { return View(entries_[i].name_off, entries_[i].name_len); }
+  std::string_view ValueAt(size_t i) const { return View(entries_[i].value_off, entries_[i].value_len); }
+
+  template <typename Fn>
+  void ForEach(Fn&& fn) const {
+    for (const auto& e : entries_) {
+      fn(View(e.name_off, e.name_len), View(e.value_off, e.value_len));
+    }
+  }
+
+  // 按 "name: value\r\n" 逐行追加到 out
+  void AppendTo(std::string& out) const;
+  size_t SerializedSize() const;
+
+  // 兼容 IHttpMessage::GetAllHeaders 的物化副本，按需构建，头部修改后失效
+  const std::vector<std::pair<std::string, std::string>>& Materialized() const;
+
+private:
+  static constexpr size_t kNotFound = static_cast<size_t>(-1);
+
+  std::string_view View(uint32_t off, uint32_t len) const { return std::string_view(arena_.data() + off, len); }
+  size_t Find(std::string_view name) const;
+  void AppendEntry(std::string_view name, KnownHeader id, std::string_view value);
+  void RemoveIf(std::string_view name, KnownHeader id);
+  void RebuildKnownIndex();
+  void MaybeCompact();
+
+  std::string arena_;
+  std::vector<Entry> entries_;
+  std::array<uint16_t, kKnownHeaderCount> known_;  // 常用头部首次出现的下标 + 1，0 表示不存在
+  size_t deadBytes_{0};                            // 已删除头部在 arena_ 中遗留的字节数
+  mutable std::vector<std::pair<std::string, std::string>> materialized_;
+  mutable bool materializedValid_{false};
+};
@@ -1,9 +1,11 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cctype>
 #include <cstdint>
 #include <map>
+#include <memory>
 #include <optional>
 #include <sstream>
 #include <string>
@@ -12,6 +14,8 @@
 #include <vector>
 
 #include "IHttpMessage.h"
+
+class RequestBodySink;
 enum class HttpMethod{
   GET,
   POST,
@@ -46,10 +50,26 @@ public:
   bool HasHeader(const std::string& key) const override;
   void RemoveHeader(const std::string& key) override;
   void ClearHeaders() override;
+  size_t HeaderCount() const override;
+  void ForEachHeader(const HeaderVisitor& fn) const override;
+
+  std::optional<std::string_view> GetHeaderView(std::string_view key) const override { return headers_.Get(key); }
+  std::optional<std::string_view> GetHeaderView(KnownHeader id) const override { return headers_.Get(id); }
+  const HeaderTable& Headers() const { return headers_; }
+  // 解析器接管：raw_head 为拷贝出的整个请求头（起始行 + 头部 + 空行），entries 为各头部在其中的区间
+  void AdoptRawHeaders(std::string&& raw_head, std::vector<HeaderTable::Entry>&& entries) {
+    headers_.Adopt(std::move(raw_head), std::move(entries));
+  }
+  // 清空请求以便同一连接上的下一个请求复用：各字符串与容器保留容量，请求头缓冲交还给解析器；
+  // 超过 kMaxRetainedBodyBytes 的 body 缓冲直接释放，避免一次大上传长期占住内存
+  void ResetForReuse(std::string& raw_head, std::vector<HeaderTable::Entry>& entries);
+  static constexpr size_t kMaxRetainedBodyBytes = 64 * 1024;
 
   void SetBody(const std::string& body) override { body_ = body; }
+  void ReserveBody(size_t size) { body_.reserve(size); }
   //void SetBinaryBody(const char* binary, size_t length) override;
   std::string GetBody() const override { return body_; }
+  std::string_view GetBodyView() const { return body_; }
   //const char* GetBinaryBody(size_t& length) const override;
   size_t GetBodyLength() const override { return body_.length(); }
   void ClearBody() override {body_.clear(); }
@@ -79,7 +99,7 @@ public:
 
   std::string GetMethodString() const;
   std::string GetUrl() const { return url_; }
-  std::string GetPath() const { return path_; }
+  const std::string& GetPath() const { return path_; }
 
   void AddQueryParam(const std::string& key, const std::string& value);
   void SetQueryParam(const std::string& key, const std::string& value);
@@ -89,8 +109,18 @@ public:
   bool RemoveQueryParam(const std::string& key);
   void ClearQueryParams();
 
+  // 连接级取消令牌：连接关闭后置位，长耗时处理器（DB、文件读写、上传）可轮询以提前退出
+  void SetCancelToken(std::shared_ptr<const std::atomic_bool> token) { cancelToken_ = std::move(token); }
+  bool IsCancelled() const { return cancelToken_ && cancelToken_->load(std::memory_order_acquire); }
+
+  // 流式请求体：解析器只交付请求头，body 的 length 个字节留在连接上，由服务器按路由交给接收器或补齐到 body_
+  void SetDeferredBodyLength(uint64_t length) { deferredBodyLength_ = length; }
+  uint64_t DeferredBodyLength() const { return deferredBodyLength_; }
+  // body 已由路由声明的接收器写出时非空
+  void SetBodySink(std::shared_ptr<RequestBodySink> sink) { bodySink_ = std::move(sink); }
+  RequestBodySink* GetBodySink() const { return bodySink_.get(); }
+
 private:
-  std::string normalizeHeaderKey(const std::string& key) const;
   void ParseUrl();
   void ParseQueryString(const std::string& querystr);
   void RebuildUrl();
@@ -102,7 +132,6 @@ private:
   static bool IsValidUtf8(std::string_view s);
   std::string toHex(char c) const;
   uint8_t HexToByte(char hex) const;
-  void rebuildHeaderIndex();
   
   static const std::unordered_map<std::string, HttpMethod> s_strMethod;
   HttpMethod method_ = HttpMethod::GET;
@@ -110,11 +139,22 @@ private:
   std::string url_;
   std::string path_;
   HttpVersion version_ = HttpVersion::HTTP_1_1;
-  std::vector<std::pair<std::string,std::string>>headers_; // 保持vector以维持头部顺序
-  std::unordered_map<std::string, std::vector<size_t>>headerIndexMap_; // 用于快速查找头部索引
+  HeaderTable headers_;   // 保持头部顺序，常用头部按枚举直接索引
   std::string body_;
   HttpContentEncoding contentEncoding_ = HttpContentEncoding::IDENTITY;
   std::map<std::string,std::vector<std::string>> queryParams_;
+  std::shared_ptr<const std::atomic_bool> cancelToken_;
+  uint64_t deferredBodyLength_ = 0;
+  std::shared_ptr<RequestBodySink> bodySink_;
 
 
 };
+
+// IHttpMessage 只有请求与响应两种实现，按 IsRequest() 静态转换，请求路径上不需要 dynamic_cast
+inline HttpRequest* AsHttpRequest(IHttpMessage* message) {
+  return message && message->IsRequest() ? static_cast<HttpRequest*>(message) : nullptr;
+}
+
+inline const HttpRequest* AsHttpRequest(const IHttpMessage* message) {
+  return message && message->IsRequest() ? static_cast<const HttpRequest*>(message) : nullptr;
+}
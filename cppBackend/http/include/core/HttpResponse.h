@@ -6,6 +6,7 @@
 #include<memory>
 #include<cstdint>
 #include"IHttpMessage.h"
+#include"BodyProducer.h"
 
 enum class HttpStatusCode{
   CONTINUE = 100,
@@ -46,6 +47,13 @@ enum class HttpStatusCode{
   HTTP_VERSION_NOT_SUPPORTED = 505 
 };
 
+// 服务器级的预渲染响应头：序列化时整块拷贝，不进入头部表；由服务器持有，生命周期长于所有响应对象
+struct PrerenderedHeaders {
+  std::string common;   // 每个响应都带的固定头部（Server、安全相关头部），每行 "name: value\r\n"
+  std::string cors;     // 跨域请求才附加的固定 CORS 头部
+  bool date{true};      // 是否附加按秒缓存的 Date 头部（响应已设置 Date 时跳过）
+};
+
 class HttpResponse : public IHttpMessage{
 public:
   HttpResponse();
@@ -62,6 +70,12 @@ public:
   const std::vector<std::pair<std::string,std::string>>& GetAllHeaders()const override;
   void RemoveHeader(const std::string& key) override;
   void ClearHeaders() override;
+  std::optional<std::string_view> GetHeaderView(std::string_view key) const override { return headers_.Get(key); }
+  std::optional<std::string_view> GetHeaderView(KnownHeader id) const override { return headers_.Get(id); }
+  size_t HeaderCount() const override { return headers_.Size(); }
+  void ForEachHeader(const HeaderVisitor& fn) const override { headers_.ForEach(fn); }
+  const HeaderTable& Headers() const { return headers_; }
+  void SetHeader(KnownHeader id, std::string_view value) { headers_.Set(id, value); }
 
   //http版本操作
   void SetVersion(HttpVersion version) override;
@@ -70,8 +84,10 @@ public:
 
   //http body操作
   void SetBody(const std::string& body) override { body_ = body; }
+  void SetBody(std::string&& body) { body_ = std::move(body); }
   //void SetBinaryBody(const char* binary, size_t length) override;
   std::string GetBody() const override { return body_; }
+  std::string_view GetBodyView() const { return body_; }
   //const char* GetBinaryBody(size_t& length) const override;
   size_t GetBodyLength() const override { return body_.length(); }
   void ClearBody() override { body_.clear(); }
@@ -82,6 +98,19 @@ public:
   std::string GetContentEncodingStr() const override;
   void Clear() override;
   std::string Serialize() const override;
+  // 序列化后的精确字节数（状态行 + 头部 + 空行 + body），用于一次性预留输出空间
+  size_t SerializedSize() const;
+  // 只写状态行、头部与空行；默认原因短语的状态行取自预先生成的静态表
+  void SerializeHeadTo(std::string& out) const;
+  // 按 SerializeHeadTo 的顺序访问实际发送的全部头部（含自动补充的 Content-Length、Date 与预渲染块），
+  // 供 HTTP/2 等不使用文本头部的编码器使用
+  void ForEachWireHeader(const HeaderVisitor& fn) const;
+  // 把 body 移交给发送路径，避免整段 body 再拷贝一次；须在 SerializeHeadTo 之后调用
+  std::string TakeBody() {
+    std::string body;
+    body.swap(body_);
+    return body;
+  }
 
   //parser接口
   void SetStatusCodeInt(int code) override;
@@ -103,6 +132,14 @@ public:
   bool isClientError() const { return static_cast<int>(statusCode_) >=400 && static_cast<int>(statusCode_)< 500; }
   bool isServerError() const { return static_cast<int>(statusCode_) >=500 && static_cast<int>(statusCode_)< 600; }
 
+  void SetPrerenderedHeaders(const PrerenderedHeaders* headers) { prerendered_ = headers; }
+  // 改用预渲染的固定 CORS 头部；没有可用的预渲染块时返回 false，由调用方逐个设置
+  bool UsePrerenderedCors() {
+    if (!prerendered_ || prerendered_->cors.empty()) return false;
+    prerendered_cors_ = true;
+    return true;
+  }
+
   void SetSendFile(const std::string& path, uint64_t offset, uint64_t length);
   bool HasSendFile() const { return send_file_enabled_; }
   const std::string& GetSendFilePath() const { return send_file_path_; }
@@ -110,20 +147,33 @@ public:
   uint64_t GetSendFileLength() const { return send_file_length_; }
   void ClearSendFile();
 
+  // 按需生成的 body：清空已有 body，已知长度时设置 Content-Length，否则设置 Transfer-Encoding: chunked
+  void SetBodyProducer(std::shared_ptr<BodyProducer> producer);
+  bool HasBodyProducer() const { return body_producer_ != nullptr; }
+  std::shared_ptr<BodyProducer> TakeBodyProducer() { return std::move(body_producer_); }
+
 private:
   static std::string GetDefaultReason(HttpStatusCode statusCode);
+  std::string_view CachedStatusLine() const;
+  bool NeedsContentLength() const;
+  size_t PrerenderedSize() const;
+  void AppendPrerendered(std::string& out) const;
   static std::string trim(std::string_view& view);
-  std::string normalizeHeaderKey(const std::string& key) const;
   
   HttpVersion version_;
   HttpStatusCode statusCode_;
   std::string statusReason_;
-  std::vector<std::pair<std::string,std::string>>headers_;
+  HeaderTable headers_;
   std::string body_;
   HttpContentEncoding contentEncoding_;
 
+  const PrerenderedHeaders* prerendered_{nullptr};
+  bool prerendered_cors_{false};
+
   bool send_file_enabled_{false};
   std::string send_file_path_;
   uint64_t send_file_offset_{0};
   uint64_t send_file_length_{0};
+
+  std::shared_ptr<BodyProducer> body_producer_;
 };
@@ -5,6 +5,9 @@
 #include<memory>
 #include<vector>
 #include<optional>
+#include<functional>
+#include<string_view>
+#include"HeaderTable.h"
 
   enum class HttpVersion{
     HTTP_1_0,
@@ -41,6 +44,18 @@ public:
   virtual const std::vector<std::pair<std::string,std::string>>& GetAllHeaders() const = 0;
   virtual void RemoveHeader(const std::string& key) = 0;
   virtual void ClearHeaders() = 0;
+  // 零拷贝读取首个同名头部，视图在头部被修改或消息对象销毁前有效
+  virtual std::optional<std::string_view> GetHeaderView(std::string_view key) const = 0;
+  virtual std::optional<std::string_view> GetHeaderView(KnownHeader id) const = 0;
+
+  // 只读遍历头部，不要求把头部物化为 std::string（直接访问头部表的 arena，key 为小写）
+  using HeaderVisitor = std::function<void(std::string_view key, std::string_view value)>;
+  virtual size_t HeaderCount() const { return GetAllHeaders().size(); }
+  virtual void ForEachHeader(const HeaderVisitor& fn) const {
+    for (const auto& header : GetAllHeaders()) {
+      fn(header.first, header.second);
+    }
+  }
 
   //http版本操作
   virtual void SetVersion(HttpVersion version) = 0;
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * RequestBodySink：流式请求体接收器
+ * 路由以 Router::AddStreamingRoute 声明接收器工厂后，大请求体不在 HttpRequest 中累积：
+ * 请求头解析完成即创建接收器，body 字节按到达顺序连同偏移交给 Write，全部到达后调用 Finish，
+ * 之后才执行路由处理器，处理器通过 HttpRequest::GetBodySink() 查看结果。
+ * 工厂与 Write/Finish/Abort 都在路由声明的执行池中依次调用，同一时刻只有一个线程访问同一接收器。
+ */
+class RequestBodySink {
+public:
+  virtual ~RequestBodySink() = default;
+
+  // 服务器侧入口：维护已接收字节数与完成状态，失败后丢弃后续数据并只调用一次 Abort
+  bool Deliver(uint64_t offset, const char* data, size_t len) {
+    if (failed_) return false;
+    if (!Write(offset, data, len)) {
+      Fail();
+      return false;
+    }
+    received_ += len;
+    return true;
+  }
+  bool Complete(uint64_t total) {
+    if (failed_) return false;
+    if (received_ != total || !Finish(total)) {
+      Fail();
+      return false;
+    }
+    completed_ = true;
+    return true;
+  }
+  void Cancel() {
+    if (!completed_) Fail();
+  }
+
+  uint64_t Received() const { return received_; }
+  bool Completed() const { return completed_; }
+
+protected:
+  virtual bool Write(uint64_t offset, const char* data, size_t len) = 0;
+  virtual bool Finish(uint64_t total) = 0;
+  // 连接中断或写入失败：丢弃已写入的内容
+  virtual void Abort() {}
+
+private:
+  void Fail() {
+    if (failed_) return;
+    failed_ = true;
+    Abort();
+  }
+
+  uint64_t received_{0};
+  bool completed_{false};
+  bool failed_{false};
+};
@@ -46,6 +46,7 @@ enum class HttpErrc : uint16_t {
   VALIDATION_FAILED = 1299,
 
   ROUTE_NOT_FOUND = 1300,
+  ROUTE_EXECUTOR_OVERLOADED = 1301,
 
   INTERNAL_ERROR = 2000
 };
@@ -2,8 +2,10 @@
 
 #include "handler/IRequestHandler.h"
 #include "core/HttpRequest.h"  // 需要HttpMethod枚举定义
+#include "security/PatternScanner.h"
 #include <vector>
 #include <cstddef>
+#include <memory>
 #include <string>
 
 // 前向声明
@@ -18,6 +20,9 @@ class IHttpMessage;
 // 4. 路径遍历攻击防护（../, %2e%2e等）
 // 5. Header数量和大小限制（防止Header炸弹攻击）
 // 6. 可疑模式检测（SQL注入、XSS等简单检测）
+//
+// 4 与 6 的模式由 PatternScanner 编译成一个自动机，路径、URL 和选定的请求头各扫描一趟；
+// 规则默认取内置规则，设置环境变量 HTTP_SECURITY_RULES 时在进程内首次使用前从该文件加载一次
 class SecurityValidationHandler : public IRequestHandler {
 public:
   // 构造函数：可配置各项限制参数
@@ -31,6 +36,9 @@ public:
   // 处理入口：执行所有安全检查
   bool Handle(IHttpMessage& message, HttpError& error) override;
 
+  // 替换模式规则（扫描器只读，可在多个处理器间共享）；传空指针时恢复进程默认规则
+  void SetPatternScanner(std::shared_ptr<const PatternScanner> scanner);
+
 private:
   // 检查HTTP方法是否在白名单中
   bool IsMethodAllowed(HttpMethod method) const;
@@ -41,14 +49,14 @@ private:
   // 检查URL长度
   bool CheckUrlLength(const HttpRequest& request) const;
 
-  // 检查路径安全性（防止路径遍历攻击）
+  // 检查路径本身的合法性（非空、无空字节），遍历模式由扫描器检测
   bool CheckPathSecurity(const std::string& path) const;
 
   // 检查Header数量和大小
   bool CheckHeaders(const IHttpMessage& message) const;
 
-  // 检查可疑字符和模式
-  bool CheckSuspiciousPatterns(const HttpRequest& request) const;
+  // 扫描路径、URL 与选定请求头，返回首个命中的规则
+  const PatternScanner::Rule* FindSuspiciousPattern(const HttpRequest& request) const;
 
 private:
   size_t maxBodySize_;
@@ -56,4 +64,5 @@ private:
   size_t maxHeaderCount_;
   size_t maxHeaderValueLength_;
   std::vector<HttpMethod> allowedMethods_;
+  std::shared_ptr<const PatternScanner> scanner_;
 };
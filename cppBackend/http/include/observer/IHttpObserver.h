@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -14,26 +15,69 @@ enum class HttpProcessStage {
     COMPLETE          // 处理完成
 };
 
+// 阶段内的具体事件
+enum class HttpEventKind : uint8_t {
+    SSL_SKIPPED,              // 未启用 SSL 或不是 SSL 连接
+    SSL_BEGIN,
+    SSL_HANDSHAKE_NEED_MORE,
+    SSL_HANDSHAKE_FAILED,
+    SSL_HANDSHAKE_DONE,
+    SSL_DECRYPTED,
+    SSL_DECRYPT_FAILED,
+
+    PARSE_BEGIN,
+    PARSER_CREATED,
+    PARSER_CREATE_FAILED,
+    PARSE_NEED_MORE,
+    PARSE_TIMEOUT,
+    PARSE_UNSUPPORTED_VERSION,
+    PARSE_TOO_LARGE,
+    PARSE_FAILED,
+    PARSE_DONE,
+
+    VALIDATION_BEGIN,
+    VALIDATION_FAILED,
+    VALIDATION_PASSED,
+
+    ROUTE_BEGIN,
+    ROUTE_SKIPPED,            // 未配置路由器
+    ROUTE_NOT_FOUND,
+    ROUTE_HANDLER_REJECTED,
+    ROUTE_DONE,
+
+    MESSAGE_COMPLETE
+};
+
+// 结构化事件：只携带枚举与数值，生成时不格式化任何字符串
+struct HttpEvent {
+    HttpProcessStage stage{HttpProcessStage::HTTP_PARSE};
+    HttpEventKind kind{HttpEventKind::PARSE_BEGIN};
+    int code{0};                            // 解析返回码（ParseResult）或 HTTP 状态码，无意义时为 0
+    uint64_t bytes{0};                      // 本阶段的输入字节数，无意义时为 0
+    int64_t timestamp_ns{0};                // steady_clock 时间戳，同一请求前后两个事件相减即为阶段耗时
+    const IHttpMessage* message{nullptr};   // 事件涉及的消息，只在回调期间有效
+};
+
+constexpr uint32_t HttpStageBit(HttpProcessStage stage) { return 1u << static_cast<uint32_t>(stage); }
+constexpr uint32_t kHttpAllStages = (1u << (static_cast<uint32_t>(HttpProcessStage::COMPLETE) + 1)) - 1;
+
+// 事件名称（小写、下划线分隔），供日志与追踪输出使用
+const char* HttpEventKindName(HttpEventKind kind);
+const char* HttpProcessStageName(HttpProcessStage stage);
+
 // 观察者接口：监听HTTP服务器各个处理阶段的事件
+// facade 只为至少一个观察者订阅的阶段生成事件，没有观察者时每个事件点只是一次掩码判断。
+// 路由处理器可能在执行池中运行，ROUTING/COMPLETE 阶段的回调可能来自 worker 线程
 class IHttpObserver{
 public:
   virtual ~IHttpObserver() = default;
 
-  // SSL处理阶段事件
-  virtual void OnSslProcess(const std::string& event, const std::string& details) {}
-
-  // HTTP解析阶段事件
-  virtual void OnHttpParse(const std::string& event, const std::string& details) {}
+  // 订阅的阶段（HttpStageBit 的组合），注册时读取一次
+  virtual uint32_t StageMask() const { return kHttpAllStages; }
 
-  // 责任链验证阶段事件
-  virtual void OnValidation(const std::string& event, const std::string& details) {}
+  // 阶段事件
+  virtual void OnEvent(const HttpEvent&) {}
 
-  // 路由处理阶段事件
-  virtual void OnRouting(const std::string& event, const std::string& details) {}
-
-  // 处理完成事件（保留原有接口）
+  // 处理完成事件（保留原有接口），订阅 COMPLETE 阶段时回调
   virtual void OnMessage(const IHttpMessage&) {}
-
-  // 通用事件通知（可选）
-  virtual void OnStageEvent(HttpProcessStage stage, const std::string& event, const std::string& details) {}
-};
\ No newline at end of file
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <utility>
+
+/**
+ * HPACK（RFC 7541）：HTTP/2 头部压缩
+ * HpackDecoder 维护与对端编码器同步的动态表，必须按连接持有、按头部块到达顺序解码；
+ * HpackEncoder 只引用静态表、不写动态表，编码结果与连接状态无关，worker 可并行生成响应头部块。
+ */
+
+constexpr size_t kHpackStaticTableSize = 61;
+constexpr size_t kHpackEntryOverhead = 32;        // 动态表每个条目计入大小的固定开销（RFC 7541 4.1）
+constexpr size_t kHpackDefaultTableSize = 4096;
+
+// Huffman 编码（RFC 7541 附录 B）
+size_t HpackHuffmanEncodedSize(std::string_view s);
+void HpackHuffmanEncode(std::string_view s, std::string& out);
+// 解码失败（非法填充、出现 EOS 或未完成的码字）返回 false
+bool HpackHuffmanDecode(const uint8_t* data, size_t len, std::string& out);
+
+class HpackDecoder {
+public:
+  // 返回 false 时中止解码；视图只在回调期间有效
+  using HeaderVisitor = std::function<bool(std::string_view name, std::string_view value)>;
+
+  explicit HpackDecoder(size_t max_table_size = kHpackDefaultTableSize);
+
+  // 本端通告的 SETTINGS_HEADER_TABLE_SIZE：对端的动态表大小更新不得超过此值
+  void SetMaxTableSizeLimit(size_t limit);
+
+  // 解码一个完整的头部块，逐个字段回调；压缩错误或回调中止时返回 false，
+  // 压缩错误之后动态表状态不可信，调用方应以 COMPRESSION_ERROR 关闭连接
+  bool Decode(const uint8_t* data, size_t len, const HeaderVisitor& fn);
+
+  size_t TableSize() const { return size_; }
+  size_t TableEntries() const { return entries_.size(); }
+  size_t MaxTableSize() const { return maxSize_; }
+
+private:
+  bool Lookup(uint64_t index, std::string_view& name, std::string_view& value) const;
+  void Insert(std::string name, std::string value);
+  void EvictTo(size_t target);
+
+  std::deque<std::pair<std::string, std::string>> entries_;   // 最新插入的在前，索引 62 对应 front
+  size_t size_{0};
+  size_t maxSize_;
+  size_t limit_;
+  std::string nameScratch_;
+  std::string valueScratch_;
+};
+
+class HpackEncoder {
+public:
+  // 追加一个字段：静态表中有完全匹配时只写索引，否则以“不索引的字面量”写出（名称能命中静态表时引用其索引）
+  // name 必须已是小写
+  static void Encode(std::string_view name, std::string_view value, std::string& out);
+  static void EncodeStatus(int status, std::string& out);
+
+  // 整数（RFC 7541 5.1）：first_byte 的高位携带表示类型，低 prefix_bits 位开始写整数
+  static void EncodeInteger(uint64_t value, uint8_t prefix_bits, uint8_t first_byte, std::string& out);
+  // 字符串（RFC 7541 5.2）：Huffman 编码更短时使用 Huffman
+  static void EncodeString(std::string_view s, std::string& out);
+};
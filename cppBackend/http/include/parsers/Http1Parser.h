@@ -5,6 +5,8 @@
 #include<memory>
 #include<algorithm>
 #include<unordered_set>
+#include<vector>
+#include<sys/uio.h>
 
 class HttpRequest;
 class HttpResponse;
@@ -16,7 +18,20 @@ public:
   int Parse(const char* data, size_t len, std::unique_ptr<IHttpMessage>& out) override;
   void Reset() override;
 
+  // 直接在调用方的分段缓冲上解析一个完整请求：不修改输入，也不保留跨调用的状态。
+  // 请求头整体只拷贝一次，各头部以区间形式交给 HttpRequest；响应报文与 chunked 请求
+  // 返回 NEEDSTREAMING，由调用方回退到 Parse() 的流式状态机。成功时 GetConsumeBytes() 为该请求的字节数
+  int ParseSegments(const struct iovec* iov, size_t iovcnt, std::unique_ptr<IHttpMessage>& out);
+
   size_t GetConsumeBytes() const { return totalConsumed_; }
+
+  // ParseSegments 遇到 Content-Length 不小于 threshold 的请求时只交付请求头（0 表示关闭）：
+  // body 留在调用方的缓冲中，请求的 DeferredBodyLength() 为其长度，由调用方按路由流式处理
+  void SetBodyDeferThreshold(size_t threshold) { bodyDeferThreshold_ = threshold; }
+
+  // 交还处理完毕的请求：清空后留作下一个请求的对象（至多保留一个），其请求头缓冲转为解析暂存区。
+  // 长连接上稳定状态下，解析请求不再分配请求对象与请求头缓冲
+  void RecycleRequest(std::unique_ptr<HttpRequest> request);
   ~Http1Parser();
 
 private:
@@ -34,8 +49,8 @@ private:
   ParseResult ParseHeaderLine(std::string_view line);
   ParseResult ParseChunkSize(std::string_view line);
   ParseResult FinalizeMessage(std::unique_ptr<IHttpMessage>& out);
+  std::unique_ptr<HttpRequest> AcquireRequest();
 
-  static bool isTokenChar(char c);
   static std::string trimLWS(std::string_view s); //LWS = Linear White space(线性空白)
 
   ParseState state_ = ParseState::kStartLine;
@@ -51,5 +66,9 @@ private:
   size_t bodyTotalReceived_ = 0;
   size_t maxTotalHeaderBytes_ = 16 * 1024;
   size_t maxLineBufferSize_ = 8 * 1024; // 行缓冲区最大大小，默认8KB
+  size_t bodyDeferThreshold_ = 0;
   std::unordered_set<std::string> allowedTrailerKeys_;
+  std::unique_ptr<HttpRequest> spareRequest_;          // RecycleRequest 交还、已清空的请求对象
+  std::string headScratch_;                            // 分段快速路径拷贝请求头的缓冲，成功时移交给请求对象
+  std::vector<HeaderTable::Entry> spanScratch_;        // 各头部区间，同上
 };
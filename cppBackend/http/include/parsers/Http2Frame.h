@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// HTTP/2 帧层（RFC 9113 第 4、6 节）：协议常量与 9 字节帧头的编解码
+
+constexpr std::string_view kHttp2ClientPreface = "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n";
+constexpr size_t kHttp2FrameHeaderSize = 9;
+constexpr uint32_t kHttp2DefaultWindowSize = 65535;
+constexpr uint32_t kHttp2MaxWindowSize = 0x7fffffff;
+constexpr uint32_t kHttp2DefaultMaxFrameSize = 16384;
+constexpr uint32_t kHttp2MaxFrameSizeLimit = 16777215;
+
+enum class Http2FrameType : uint8_t {
+  DATA = 0x0,
+  HEADERS = 0x1,
+  PRIORITY = 0x2,
+  RST_STREAM = 0x3,
+  SETTINGS = 0x4,
+  PUSH_PROMISE = 0x5,
+  PING = 0x6,
+  GOAWAY = 0x7,
+  WINDOW_UPDATE = 0x8,
+  CONTINUATION = 0x9
+};
+
+// 帧标志位，含义随帧类型而定（END_STREAM 与 ACK 共用 0x1）
+constexpr uint8_t kHttp2FlagEndStream = 0x1;
+constexpr uint8_t kHttp2FlagAck = 0x1;
+constexpr uint8_t kHttp2FlagEndHeaders = 0x4;
+constexpr uint8_t kHttp2FlagPadded = 0x8;
+constexpr uint8_t kHttp2FlagPriority = 0x20;
+
+enum class Http2ErrorCode : uint32_t {
+  NO_ERROR = 0x0,
+  PROTOCOL_ERROR = 0x1,
+  INTERNAL_ERROR = 0x2,
+  FLOW_CONTROL_ERROR = 0x3,
+  SETTINGS_TIMEOUT = 0x4,
+  STREAM_CLOSED = 0x5,
+  FRAME_SIZE_ERROR = 0x6,
+  REFUSED_STREAM = 0x7,
+  CANCEL = 0x8,
+  COMPRESSION_ERROR = 0x9,
+  CONNECT_ERROR = 0xa,
+  ENHANCE_YOUR_CALM = 0xb,
+  INADEQUATE_SECURITY = 0xc,
+  HTTP_1_1_REQUIRED = 0xd
+};
+
+enum class Http2SettingId : uint16_t {
+  HEADER_TABLE_SIZE = 0x1,
+  ENABLE_PUSH = 0x2,
+  MAX_CONCURRENT_STREAMS = 0x3,
+  INITIAL_WINDOW_SIZE = 0x4,
+  MAX_FRAME_SIZE = 0x5,
+  MAX_HEADER_LIST_SIZE = 0x6
+};
+
+struct Http2FrameHeader {
+  uint32_t length{0};
+  Http2FrameType type{Http2FrameType::DATA};
+  uint8_t flags{0};
+  uint32_t stream_id{0};
+};
+
+inline uint32_t ReadHttp2Uint32(const uint8_t* p) {
+  return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+         (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+inline void AppendHttp2Uint32(std::string& out, uint32_t v) {
+  const char bytes[4] = {static_cast<char>(v >> 24), static_cast<char>(v >> 16),
+                         static_cast<char>(v >> 8), static_cast<char>(v)};
+  out.append(bytes, 4);
+}
+
+// p 至少 kHttp2FrameHeaderSize 字节；流 ID 的保留位被忽略
+inline Http2FrameHeader DecodeHttp2FrameHeader(const uint8_t* p) {
+  Http2FrameHeader h;
+  h.length = (static_cast<uint32_t>(p[0]) << 16) | (static_cast<uint32_t>(p[1]) << 8) | p[2];
+  h.type = static_cast<Http2FrameType>(p[3]);
+  h.flags = p[4];
+  h.stream_id = ReadHttp2Uint32(p + 5) & 0x7fffffffu;
+  return h;
+}
+
+inline void AppendHttp2FrameHeader(std::string& out, uint32_t length, Http2FrameType type,
+                                   uint8_t flags, uint32_t stream_id) {
+  const char bytes[kHttp2FrameHeaderSize] = {
+      static_cast<char>(length >> 16), static_cast<char>(length >> 8), static_cast<char>(length),
+      static_cast<char>(type), static_cast<char>(flags),
+      static_cast<char>((stream_id >> 24) & 0x7f), static_cast<char>(stream_id >> 16),
+      static_cast<char>(stream_id >> 8), static_cast<char>(stream_id)};
+  out.append(bytes, kHttp2FrameHeaderSize);
+}
@@ -1,49 +1,183 @@
 #pragma once
 
 #include"IHttpParser.h"
+#include"Http2Frame.h"
+#include"Hpack.h"
 #include"core/IHttpMessage.h"
+#include<cstdint>
+#include<deque>
 #include<memory>
-#include<queue>
+#include<string>
+#include<sys/types.h>
+#include<unordered_map>
+#include<utility>
+#include<vector>
 
+class HttpRequest;
+class HttpResponse;
+
+/**
+ * Http2Parser：HTTP/2 服务端连接（RFC 9113）
+ * 输入侧校验客户端前言、解析帧、用连接级 HPACK 动态表解码头部，把各个流组装成独立的 HttpRequest；
+ * 输出侧按对端的连接级/流级窗口与最大帧长把响应切成 HEADERS/CONTINUATION/DATA 帧，多个流轮转交错发送，
+ * 一个慢响应不会阻塞同一连接上的其他响应。文件响应不读入内存：每个 DATA 帧只生成 9 字节帧头，
+ * 负载以文件区间交给 OutputSink，由连接用 sendfile 发送。
+ * 对象只在连接所属的 IO 线程上使用；响应头部块由 EncodeResponseHead 在 worker 上无状态地生成。
+ */
 class Http2Parser : public IHttpParser {
 public:
+  // 本端通告的设置
+  struct Settings {
+    uint32_t headerTableSize = kHpackDefaultTableSize;
+    uint32_t maxConcurrentStreams = 100;
+    uint32_t initialWindowSize = 1u << 20;      // 流级接收窗口，上传时不必频繁等待 WINDOW_UPDATE
+    uint32_t connectionWindowSize = 4u << 20;   // 连接级接收窗口，建立连接时用 WINDOW_UPDATE 从 65535 调大
+    uint32_t maxFrameSize = kHttp2DefaultMaxFrameSize;
+    uint32_t maxHeaderListSize = 65536;
+  };
+
+  // 输出目标：Write 追加到连接输出缓冲，WriteFile 在已写入的字节之后排队一个文件区间；
+  // close_fd 为真时 fd 的所有权随之转移
+  class OutputSink {
+  public:
+    virtual ~OutputSink() = default;
+    virtual void Write(const char* data, size_t len) = 0;
+    virtual void WriteFile(int fd, off_t offset, size_t len, bool close_fd) = 0;
+  };
+
   Http2Parser();
-  int Parse(std::string&,std::unique_ptr<IHttpMessage>& out) override;
+  explicit Http2Parser(const Settings& settings);
+  ~Http2Parser() override;
+
+  // IHttpParser：输入总是被全部消费（不完整的帧缓存在内部），每次最多取出一个已完成的请求
+  int Parse(std::string& data, std::unique_ptr<IHttpMessage>& out) override;
   int Parse(const char* data, size_t len, std::unique_ptr<IHttpMessage>& out) override;
   void Reset() override;
-  ~Http2Parser() override;
-  size_t GetConsumeBytes() const override;
+  size_t GetConsumeBytes() const override { return consumed_; }
 
-/*   void SetMaxConcurrentStreams(size_t max) { maxConcurrentStreams_ = max; }
-  void SetInitialWindowSize(uint32_t size) { initialWindowSize_ = size; }
-  void SetEnablePush(bool enable) { enablePush_ = enable; }
-  size_t GetActiveStreamCount() const;
+  // 输入任意长度的字节，可能产生多个已完成的请求；连接级错误时返回 false（GOAWAY 已排入输出）
+  bool Feed(const char* data, size_t len);
+  // 按完成顺序取出一个请求及其流 ID；已被对端重置的流会被跳过
+  bool PopRequest(std::unique_ptr<IHttpMessage>& out, uint32_t& stream_id);
+  bool HasReadyRequest() const { return !ready_.empty(); }
+  uint32_t LastStreamId() const { return lastPoppedStreamId_; }
+
+  // 提交流的响应：header_block 为 EncodeResponseHead 生成的 HPACK 头部块，body 之后再发送文件区间；
+  // file_fd 的所有权转移给本对象。流已被重置时直接丢弃
+  void SubmitResponse(uint32_t stream_id, std::string header_block, std::string body,
+                      int file_fd = -1, off_t file_offset = 0, size_t file_length = 0);
+  // 提交按需生成 body 的响应：头部块与首段 body 照常发送，发完后流保持打开，
+  // 后续各段由 AppendResponseBody 追加
+  void SubmitStreamingResponse(uint32_t stream_id, std::string header_block, std::string first);
+  // 追加一段 body，end 为真时随最后一个 DATA 帧结束流；流已不存在（如被对端重置）时返回 false
+  bool AppendResponseBody(uint32_t stream_id, std::string piece, bool end);
+  // 需要下一段 body 的流：已排队的 body 全部写出，且流级与连接级发送窗口都还有余量
+  void CollectBodyDemand(std::vector<uint32_t>& out) const;
+  bool HasStream(uint32_t stream_id) const { return streams_.find(stream_id) != streams_.end(); }
+  // 以 RST_STREAM 结束一个流
+  void ResetStream(uint32_t stream_id, Http2ErrorCode code);
+
+  // 把控制帧与各流在窗口允许范围内的响应帧写入 sink；budget 限制本次写出的 DATA 负载字节数（控制帧与 HEADERS 不受限）
+  // 返回是否写出了数据
+  bool Flush(OutputSink& sink, size_t budget);
+  bool HasPendingOutput() const { return !control_.empty() || !sendQueue_.empty(); }
+  // 连接出错，或任一方已发送 GOAWAY 且所有流都已结束：输出发完后即可关闭连接
+  bool ShouldClose() const;
+  bool Failed() const { return failed_; }
+  size_t ActiveStreamCount() const { return streams_.size(); }
+
+  // 对端当前设置与窗口（测试与指标用）
+  uint32_t PeerMaxFrameSize() const { return peerMaxFrameSize_; }
+  int64_t ConnectionSendWindow() const { return connSendWindow_; }
+
+  // worker：把响应状态码与头部编码为 HPACK 头部块（只用静态表），去掉 HTTP/2 禁止的连接级头部
+  static void EncodeResponseHead(const HttpResponse& response, std::string& block);
 
 private:
-  struct Http2Stream; //前向声明（每一个流对应一个request/Response）
-  
-  //HTTP/2 连接级状态
-  bool prefaceReceied_ = false;   //是否接收到 "PRI * HTTP/2.0\r\n"
-  uint32_t nextStreamId_ = 1;     //下一个流 ID(客户端奇数，服务端偶数)
-  size_t maxConcurrentStreams_ = 65535;
-  uint32_t initialWindowSize_ = 100;
-  bool enablePush_ = false;
-
-  //流管理(map<stream_id,stream>)
-  std::map<uint32_t,std::unique_ptr<Http2Stream>> activeStreams_;
-  std::queue<std::unique_ptr<IHttpMessage>> completedMessages_; //已完成的消息队列
-
-  //底层帧解析器
-  struct FrameParser;
-  std::unique_ptr<FrameParser> frameParser_;
-  
-  //核心逻辑
-  ParseResult ProcessPreface(const char*& data,size_t& len);
-  ParseResult ProcessFrame(const char*& data, size_t& len);
-  void OnHeadersFrame(uint32_t stream_id,const std::vector<std::pair<std::string,std::string>>& headers, bool end_headers);
-  void OnDataFrame(uint32_t stream_id, const char* data, size_t len, bool end_stream);
-  void OnStreamComplete(uint32_t stream_id);
-
-  //工具 HPACK解码（此处为占位，实际需要实现或者继承
-  std::vector<std::pair<std::string,std::string>> decodeHeaders(const uint8_t* data, size_t len); */
-};
\ No newline at end of file
+  struct Stream {
+    uint32_t id{0};
+    bool remoteClosed{false};            // 已收到 END_STREAM
+    bool dispatched{false};              // 请求已完整，进入就绪队列
+    std::unique_ptr<HttpRequest> request;
+    int64_t expectedLength{-1};          // content-length，-1 表示未声明
+    uint64_t receivedLength{0};
+    int64_t recvWindow{0};
+    uint32_t recvUnacked{0};             // 已收到、尚未用 WINDOW_UPDATE 归还的流级窗口
+    int64_t sendWindow{0};
+
+    bool responded{false};
+    bool headSent{false};
+    std::string headBlock;
+    std::string body;
+    size_t bodyOffset{0};
+    int fileFd{-1};
+    off_t fileOffset{0};
+    size_t fileRemaining{0};
+    bool fileHandedOut{false};           // 已有文件区间交给 sink：流提前结束时 fd 只能在连接销毁后关闭
+    bool bodyOpen{false};                // 按需生成的 body 尚未结束：排队的部分发完后不结束流
+  };
+
+  enum class StepResult { Progress, Blocked, Done };
+
+  bool ProcessFrame(const Http2FrameHeader& h, const uint8_t* payload);
+  bool OnData(const Http2FrameHeader& h, const uint8_t* payload);
+  bool OnHeaders(const Http2FrameHeader& h, const uint8_t* payload);
+  bool OnContinuation(const Http2FrameHeader& h, const uint8_t* payload);
+  bool OnSettings(const Http2FrameHeader& h, const uint8_t* payload);
+  bool OnWindowUpdate(const Http2FrameHeader& h, const uint8_t* payload);
+  bool OnRstStream(const Http2FrameHeader& h, const uint8_t* payload);
+  bool OnPing(const Http2FrameHeader& h, const uint8_t* payload);
+  bool OnGoAway(const Http2FrameHeader& h, const uint8_t* payload);
+  bool OnHeaderBlockComplete();
+  bool BuildRequest(Stream& stream);
+  void CompleteStream(Stream& stream);
+
+  bool ConnectionError(Http2ErrorCode code);
+  void StreamError(uint32_t stream_id, Http2ErrorCode code);
+  void CloseStream(uint32_t stream_id);
+  void ReleaseStreamFile(Stream& stream);
+  void QueueServerPreface();
+  void QueueWindowUpdate(uint32_t stream_id, uint32_t increment);
+  void QueueRstStream(uint32_t stream_id, Http2ErrorCode code);
+  void QueueGoAway(Http2ErrorCode code);
+  void ReplenishConnectionWindow(uint32_t consumed);
+
+  StepResult StepStream(Stream& stream, OutputSink& sink, std::string& batch, size_t& budget, bool& wrote);
+  void AppendHeaderFrames(const Stream& stream, bool end_stream, std::string& batch) const;
+
+  Settings settings_;
+  HpackDecoder decoder_;
+
+  // 输入
+  std::string partial_;                  // 跨越输入边界的不完整帧（或前言）
+  bool prefaceReceived_{false};
+  bool settingsReceived_{false};
+  size_t consumed_{0};
+  uint32_t lastPeerStreamId_{0};
+  // 正在接收的头部块；HEADERS 未带 END_HEADERS 时，后续只能是同一流的 CONTINUATION
+  std::string headerBlock_;
+  uint32_t headerBlockStream_{0};
+  bool headerBlockEndStream_{false};
+  bool expectContinuation_{false};
+  std::vector<std::pair<std::string, std::string>> pendingFields_;   // 当前头部块解码出的字段（复用容量）
+
+  std::unordered_map<uint32_t, std::unique_ptr<Stream>> streams_;
+  std::deque<std::pair<uint32_t, std::unique_ptr<HttpRequest>>> ready_;
+  uint32_t lastPoppedStreamId_{0};
+
+  // 流量控制
+  int64_t connRecvWindow_{kHttp2DefaultWindowSize};
+  uint32_t connRecvUnacked_{0};
+  int64_t connSendWindow_{kHttp2DefaultWindowSize};
+  int64_t peerInitialWindow_{kHttp2DefaultWindowSize};
+  uint32_t peerMaxFrameSize_{kHttp2DefaultMaxFrameSize};
+
+  // 输出
+  std::string control_;                  // 待发送的控制帧（SETTINGS/ACK/PING/WINDOW_UPDATE/RST_STREAM/GOAWAY）
+  std::deque<uint32_t> sendQueue_;       // 有待发送响应的流，按轮转顺序
+  std::vector<int> orphanFds_;           // 部分区间已交给 sink 的文件，连接销毁时关闭
+
+  bool goAwaySent_{false};
+  bool peerGoAway_{false};
+  bool failed_{false};
+};
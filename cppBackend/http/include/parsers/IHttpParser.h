@@ -14,7 +14,8 @@ enum class ParseResult{
   HEADERTOOLONG = -4,
   BODYTOOLONG = -5,
   LINE_TOO_LONG = -6,
-  UNSUPPORTEDVERSION = -7
+  UNSUPPORTEDVERSION = -7,
+  NEEDSTREAMING = -8          // 分段快速路径无法处理（响应报文、chunked），需改用流式解析
 };
 
 // enum class ParseErrorType {
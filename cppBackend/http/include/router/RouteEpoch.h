@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+/**
+ * RouteEpoch：基于纪元的延迟回收（路由表快照的发布与回收）
+ * 读者进入临界区时在线程私有的记录上公布当前纪元，退出时清零，读路径只有几次原子读写、没有锁；
+ * 写者把旧对象从发布点摘下后交给 Retire，只有当所有活跃读者都已进入更新的纪元时才真正释放。
+ * 读者记录按线程复用、只增不减，线程数不受限制。
+ */
+class RouteEpoch {
+public:
+  // 读临界区：持有期间从发布点读到的对象不会被释放，可以嵌套
+  class Guard {
+  public:
+    Guard() { RouteEpoch::Instance().Enter(); }
+    ~Guard() { RouteEpoch::Instance().Exit(); }
+    Guard(const Guard&) = delete;
+    Guard& operator=(const Guard&) = delete;
+  };
+
+  static RouteEpoch& Instance();
+
+  // 写者：登记一个已经摘下（新读者再也读不到）的对象的释放动作
+  void Retire(std::function<void()> deleter);
+  // 释放所有已无读者可能引用的对象，返回仍在等待的个数
+  size_t Reclaim();
+
+private:
+  struct ReaderRecord {
+    std::atomic<uint64_t> epoch{0};  // 0 表示不在临界区
+    std::atomic<bool> inUse{false};
+    ReaderRecord* next{nullptr};
+    uint32_t depth{0};               // 仅所属线程访问
+  };
+
+  RouteEpoch() = default;
+
+  void Enter();
+  void Exit();
+  ReaderRecord* LocalRecord();
+  ReaderRecord* AcquireRecord();
+  void ReleaseRecord(ReaderRecord* record);
+  uint64_t MinActiveEpoch() const;
+
+  std::atomic<uint64_t> epoch_{1};
+  std::atomic<ReaderRecord*> readers_{nullptr};
+  std::mutex retireMutex_;
+  std::vector<std::pair<uint64_t, std::function<void()>>> retired_;  // (退休纪元, 释放动作)
+
+  friend struct RouteEpochLocal;
+};
@@ -3,26 +3,50 @@
 #include "handler/IRequestHandler.h"
 #include "core/HttpRequest.h"
 #include "core/HttpResponse.h"
+#include "core/RequestBodySink.h"
 #include "util/HttpStringUtil.h"
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <functional>
-#include <shared_mutex>
+#include <map>
+#include <mutex>
 #include <optional>
+#include <string_view>
+
+// 单条路由允许的最大路径参数个数，超出的路由在注册时被拒绝
+constexpr size_t kMaxRouteParams = 8;
+// 路由表按 HttpMethod 下标存放各方法的处理器（UNKNOWN 不可注册）
+constexpr size_t kRouteMethodCount = static_cast<size_t>(HttpMethod::UNKNOWN);
 
 // 路由参数：从URL路径中提取的参数和查询参数
+// 参数名、参数值与通配符部分都是视图：名称指向路由表，值指向请求路径，查询参数指向请求自身，
+// 因此只在对应请求（及路由表）存活期间有效；匹配过程不做任何堆分配
 struct RouteParams {
-  std::unordered_map<std::string, std::string> params_;  // 路径参数，如 /user/:id -> {"id": "123"}
-  std::vector<std::string> wildcards_;                    // 通配符匹配的部分，如 /static/* -> ["file.css"]
-  std::unordered_map<std::string, std::vector<std::string>> queryParams_;  // 查询参数，如 ?name=value&age=20
-  
-  // 获取路径参数值
+  struct Param {
+    std::string_view name;   // 注册时的参数名，如 /user/:id -> "id"
+    std::string_view value;  // 请求路径中对应的段，保持原始大小写
+  };
+  using QueryMap = std::map<std::string, std::vector<std::string>>;
+
+  std::array<Param, kMaxRouteParams> params_{};  // 路径参数，按在路径中出现的顺序
+  size_t paramCount_{0};
+  std::string_view wildcard_;                    // 通配符匹配的剩余路径，如 /static/* -> "css/app.css"
+  const QueryMap* queryParams_{nullptr};         // 查询参数，如 ?name=value&age=20
+
+  // 获取路径参数值（参数名忽略大小写）
   std::optional<std::string> GetParam(const std::string& key) const;
+  std::optional<std::string_view> GetParamView(std::string_view key) const;
+  size_t ParamCount() const { return paramCount_; }
+  const Param& ParamAt(size_t i) const { return params_[i]; }
   
   // 获取通配符部分
-  std::string GetWildcard() const;
+  std::string GetWildcard() const { return std::string(wildcard_); }
+  std::string_view GetWildcardView() const { return wildcard_; }
   
   // 获取查询参数值（单个值，如果有多个同名参数则返回第一个）
   std::optional<std::string> GetQueryParam(const std::string& key) const;
@@ -31,36 +55,35 @@ struct RouteParams {
   std::vector<std::string> GetQueryParams(const std::string& key) const;
   
   // 检查是否存在查询参数
-  inline bool HasQueryParam(const std::string& key) const {
-    return queryParams_.find(LowerAsciiCopy(key)) != queryParams_.end();
-  }
+  bool HasQueryParam(const std::string& key) const;
   
   // 获取所有查询参数
-  inline const std::unordered_map<std::string, std::vector<std::string>>& GetAllQueryParams() const {
-    return queryParams_;
-  }
+  const QueryMap& GetAllQueryParams() const;
   
   // 清空所有参数
   void Clear();
 };
 
 // 路由处理器类型：接收请求、响应和参数，返回是否继续处理
-using RouteHandler = std::function<bool(IHttpMessage&, HttpResponse&, const RouteParams&)>;
+// 路由只匹配请求消息，处理器直接拿到具体类型的 HttpRequest，不需要再做类型转换
+using RouteHandler = std::function<bool(HttpRequest&, HttpResponse&, const RouteParams&)>;
 
-// 中间件类型：接收请求，返回是否继续处理
-using Middleware = std::function<bool(IHttpMessage&)>;
+// 流式请求体接收器工厂：请求头解析完成、路由匹配后在路由的执行池中调用，length 为 body 字节数。
+// 返回空指针表示拒绝该请求体：body 被丢弃，不执行处理器，直接回写工厂填好的 response
+using BodySinkFactory = std::function<std::unique_ptr<RequestBodySink>(
+    HttpRequest& request, const RouteParams& params, uint64_t length, HttpResponse& response)>;
 
-// 路由匹配结果：包含处理器、参数和支持的方法列表
-struct RouteResult {
-  RouteHandler handler = nullptr;                // 匹配到的处理器
-  RouteParams params;                             // 提取的参数
-  std::vector<HttpMethod> allowedMethods;        // 该路径支持的所有方法（用于405处理）
-  bool pathMatched = false;                       // 路径是否匹配（无论方法是否支持）
-  
-  // 检查是否成功匹配
-  bool IsSuccess() const { return handler != nullptr; }
+// 路由表项：处理器、参数名列表、处理器声明的执行池（空表示默认池）以及可选的流式请求体接收器工厂
+struct RouteEntry {
+  RouteHandler handler;
+  std::vector<std::string> paramNames;
+  std::string executor;
+  BodySinkFactory bodySink;
 };
 
+// 中间件类型：接收请求，返回是否继续处理
+using Middleware = std::function<bool(IHttpMessage&)>;
+
 // 路由匹配结果枚举
 enum class RouteMatchResult {
   SUCCESS,                    // 匹配成功
@@ -70,55 +93,112 @@ enum class RouteMatchResult {
   MIDDLEWARE_REJECTED         // 中间件拒绝
 };
 
+struct RouteTable;
+
 // 路由匹配信息结构体
 struct RouteMatchInfo {
   RouteMatchResult result;                        // 匹配结果
-  RouteHandler handler = nullptr;                 // 匹配到的处理器（如果成功）
+  std::shared_ptr<const RouteTable> table;        // 匹配所用的路由表快照，请求处理完之前保持其存活
+  const RouteHandler* handler = nullptr;          // 匹配到的处理器（如果成功），指向 table 中的表项
   RouteParams params;                             // 提取的参数（如果成功）
   std::vector<HttpMethod> allowedMethods;         // 允许的方法列表（用于405处理）
+  std::string executor;                           // 处理器声明的执行池（空表示默认池）
+  const BodySinkFactory* bodySink = nullptr;      // 路由声明的流式请求体接收器工厂，指向 table 中的表项
 };
 
-// 路由节点：Trie树节点，用于高效路由匹配
+/**
+ * 路由节点：压缩前缀树（radix tree）节点
+ * 启动时把路由模式编译进树：静态部分按公共前缀合并为 prefix_（统一小写），
+ * ":name" 参数段挂在 paramChild_ 上，末尾的 "*" 通配符记录在其前一个 '/' 所在节点。
+ * 匹配时直接在请求路径的 string_view 上逐字节比较（忽略大小写），
+ * 按 静态 > 参数 > 通配符 的优先级回溯，参数值写入 RouteParams 的定长数组，全程无堆分配。
+ */
 class RouteNode {
 public:
   RouteNode();
   ~RouteNode() = default;
   
-  // 添加路由：path可以是精确路径、参数路径(:param)或通配符(*)
-  void AddRoute(HttpMethod method, const std::string& path, RouteHandler handler);
+  // 添加路由：path可以是精确路径、参数路径(:param)或通配符(*)，path 须已规范化
+  // 返回是否注册成功（参数名为空、参数过多或通配符不在末尾时失败）
+  bool AddRoute(HttpMethod method, std::string_view path, RouteHandler handler,
+                const std::string& executor = "", BodySinkFactory bodySink = nullptr);
   
-  // 匹配路由：返回匹配的处理器和参数（优化版本，一次返回完整结果）
-  RouteResult MatchRoute(HttpMethod method, const std::string& path) const;
+  // 匹配路由：返回匹配到的表项并把参数写入 params，未匹配返回 nullptr
+  const RouteEntry* MatchRoute(HttpMethod method, std::string_view path, RouteParams& params) const;
   
   // 获取所有支持的方法（用于405错误）
-  std::vector<HttpMethod> GetAllowedMethods(const std::string& path) const;
+  std::vector<HttpMethod> GetAllowedMethods(std::string_view path) const;
+  // 同上，以 HttpMethod 下标为位的掩码形式返回
+  uint32_t AllowedMethodMask(std::string_view path) const;
+  
+  // 深拷贝整棵子树（复制路由表时使用）
+  std::unique_ptr<RouteNode> Clone() const;
 
 private:
-  // 递归匹配辅助函数（支持回溯，优先匹配更具体的路由）
-  RouteResult MatchRouteRecursive(
-      HttpMethod method, const std::vector<std::string_view>& segments,
-      size_t segmentIndex, RouteParams& params,
-      std::vector<std::string>& currentParamValues) const;
+  friend class StaticRouteIndex;
+
+  // 在当前节点下插入一段静态文本，返回恰好结束于该文本末尾的节点（必要时分裂已有节点）
+  RouteNode* InsertStatic(std::string_view text);
+  // 从 pos 开始匹配（当前节点的前缀已消费）
+  const RouteEntry* MatchFrom(size_t method, std::string_view path, size_t pos, RouteParams& params) const;
+  void CollectAllowed(std::string_view path, size_t pos, uint32_t& mask) const;
+  const RouteNode* FindStaticChild(std::string_view path, size_t pos) const;
 
 private:
-  // 精确路径匹配：path -> method -> handler
-  // 精确路径匹配：path -> method -> handler和参数名列表
-  std::unordered_map<std::string, std::unordered_map<HttpMethod, std::pair<RouteHandler, std::vector<std::string>>>> exactRoutes_;
-  
-  // 通配符路径匹配：method -> handler和参数名列表
-  std::unordered_map<HttpMethod, std::pair<RouteHandler, std::vector<std::string>>> wildcardRoutes_;
-  
-  // 子节点：用于路径前缀匹配
-  std::unordered_map<std::string, std::unique_ptr<RouteNode>> children_;
-  
-  // 参数节点：仅表示存在一个参数段，不存储参数名
-  std::unique_ptr<RouteNode> paramNode_;
+  std::string prefix_;                                      // 本节点的静态前缀（小写）
+  std::string indices_;                                     // 各静态子节点前缀的首字节，与 children_ 一一对应
+  std::vector<std::unique_ptr<RouteNode>> children_;        // 静态子节点
+  std::unique_ptr<RouteNode> paramChild_;                   // 参数子节点（匹配到下一个 '/' 为止）
+  std::array<std::unique_ptr<RouteEntry>, kRouteMethodCount> routes_;          // 路径在本节点结束的路由
+  std::array<std::unique_ptr<RouteEntry>, kRouteMethodCount> wildcardRoutes_;  // 本节点之后为 "*" 的路由
+  uint32_t routeMask_{0};
+  uint32_t wildcardMask_{0};
+};
+
+/**
+ * StaticRouteIndex：精确匹配的静态路由索引（最小完美哈希）
+ * 路由表发布前，把前缀树中不含参数/通配符的完整路径编译为 CHD 式的 哈希-位移 表：
+ * 路径先哈希到桶，每个桶记录一个位移值使桶内所有路径落到互不冲突的槽位，槽位数恰好等于路径数。
+ * 每个槽位按 HttpMethod 下标存放表项指针，命中只需一次哈希、一次比较。
+ * 表项指针指向同一路由表中的前缀树，索引必须与前缀树一起复制/重建。
+ */
+class StaticRouteIndex {
+public:
+  // 从前缀树收集静态路由并构建完美哈希；构建失败时索引为空，匹配自动退回前缀树
+  void Build(const RouteNode& root);
   
-  // 通配符节点
-  std::unique_ptr<RouteNode> wildcardNode_;
+  // 路径（忽略大小写）是静态路由且注册了该方法时返回表项，否则返回 nullptr
+  const RouteEntry* Find(HttpMethod method, std::string_view path) const;
   
-  // 解析路径段
-  static void SplitPathToViews(std::string_view path, std::vector<std::string_view>& segments);
+  size_t Size() const { return slots_.size(); }
+
+private:
+  struct Slot {
+    std::string path;                                          // 小写规范路径
+    std::array<const RouteEntry*, kRouteMethodCount> methods{};
+  };
+  
+  static void Collect(const RouteNode& node, std::string& path, std::vector<Slot>& out);
+  static uint64_t Hash(std::string_view path, uint64_t seed);
+  static size_t SlotOf(uint64_t hash, uint32_t displacement, size_t slotCount);
+  bool TryBuild(std::vector<Slot>& slots, uint64_t seed);
+  
+  std::vector<Slot> slots_;
+  std::vector<uint32_t> displacements_;  // 每个桶的位移值
+  uint64_t seed_{0};
+};
+
+// 路由表：前缀树与中间件的整体。发布后只读，修改时复制出新表再整体发布
+struct RouteTable {
+  std::unique_ptr<RouteNode> root = std::make_unique<RouteNode>();
+  StaticRouteIndex statics;  // 由 root 编译出的静态路由索引，匹配时优先查询
+  std::vector<Middleware> globalMiddlewares;
+  // 规范路径 -> middlewares；键比较忽略大小写且支持 string_view 查找，匹配时不需要复制路径
+  std::map<std::string, std::vector<Middleware>, LessIgnoreCaseAscii> pathMiddlewares;
+  
+  // 复制前缀树与中间件；静态索引引用前缀树中的表项，需在修改完成后调用 BuildIndex 重建
+  std::shared_ptr<RouteTable> Clone() const;
+  void BuildIndex() { statics.Build(*root); }
 };
 
 // 路由组：用于组织具有公共前缀或中间件的路由
@@ -153,7 +233,9 @@ private:
 class Router {
 public:
   Router();
-  ~Router() = default;
+  ~Router();
+  Router(const Router&) = delete;
+  Router& operator=(const Router&) = delete;
   
   // 处理请求
   bool Handle(IHttpMessage& message, HttpResponse& response);
@@ -164,28 +246,35 @@ public:
   // ========== 路由注册接口 ==========
   
   // 注册路由（支持所有HTTP方法）
-  void AddRoute(HttpMethod method, const std::string& path, RouteHandler handler);
+  // executor：处理器运行的执行池名称（如 "blocking-db"），为空时在默认池中执行
+  void AddRoute(HttpMethod method, const std::string& path, RouteHandler handler,
+                const std::string& executor = "");
+  
+  // 注册流式请求体路由：大请求体不在内存中累积，到达时即交给 bodySink 创建的接收器，
+  // 处理器在 body 全部写入接收器之后执行
+  void AddStreamingRoute(HttpMethod method, const std::string& path, RouteHandler handler,
+                         BodySinkFactory bodySink, const std::string& executor = "");
   
   // 便捷方法：注册GET路由
-  void Get(const std::string& path, RouteHandler handler);
+  void Get(const std::string& path, RouteHandler handler, const std::string& executor = "");
   
   // 便捷方法：注册POST路由
-  void Post(const std::string& path, RouteHandler handler);
+  void Post(const std::string& path, RouteHandler handler, const std::string& executor = "");
   
   // 便捷方法：注册PUT路由
-  void Put(const std::string& path, RouteHandler handler);
+  void Put(const std::string& path, RouteHandler handler, const std::string& executor = "");
   
   // 便捷方法：注册DELETE路由
-  void Delete(const std::string& path, RouteHandler handler);
+  void Delete(const std::string& path, RouteHandler handler, const std::string& executor = "");
   
   // 便捷方法：注册PATCH路由
-  void Patch(const std::string& path, RouteHandler handler);
+  void Patch(const std::string& path, RouteHandler handler, const std::string& executor = "");
   
   // 便捷方法：注册HEAD路由
-  void Head(const std::string& path, RouteHandler handler);
+  void Head(const std::string& path, RouteHandler handler, const std::string& executor = "");
   
   // 便捷方法：注册OPTIONS路由
-  void Options(const std::string& path, RouteHandler handler);
+  void Options(const std::string& path, RouteHandler handler, const std::string& executor = "");
   
   // ========== 路由分组接口 ==========
   
@@ -194,7 +283,8 @@ public:
   
   // 在路由组中注册路由
   void AddRouteInGroup(std::shared_ptr<RouteGroup> group, HttpMethod method,
-                       const std::string& path, RouteHandler handler);
+                       const std::string& path, RouteHandler handler,
+                       const std::string& executor = "");
   
   // ========== 中间件接口 ==========
   
@@ -209,41 +299,44 @@ public:
   // 清空所有路由
   void Clear();
   
+  // ========== 路由表快照 ==========
+  
+  // 当前路由表快照：持有期间其中的处理器与中间件保持有效
+  std::shared_ptr<const RouteTable> Snapshot() const;
+  
+  // 整体替换路由表（热更新）：正在处理的请求继续使用旧表，之后的请求立即使用新表，匹配侧不加锁
+  void Publish(std::shared_ptr<const RouteTable> table);
+  
   // 验证路径格式
   static bool ValidatePath(const std::string& path);
 
 private:
-  // 路由根节点
-  std::unique_ptr<RouteNode> rootNode_;
+  // 发布点指向的对象：读者在纪元临界区内读取发布点并复制其中的 shared_ptr
+  struct PublishedTable {
+    std::shared_ptr<const RouteTable> table;
+  };
   
-  // 静态路由快速查找表（不含参数和通配符的路由）
-  // 存储格式：path -> method -> (handler, paramNames)
-  // 注意：静态路由的 paramNames 应该为空，但为了与动态路由保持一致，使用相同的存储格式
-  std::unordered_map<std::string, std::unordered_map<HttpMethod, std::pair<RouteHandler, std::vector<std::string>>>> staticRoutes_;
+  // 当前发布的路由表，旧对象交给 RouteEpoch 延迟回收
+  std::atomic<PublishedTable*> current_{nullptr};
   
-  // 全局中间件
-  std::vector<Middleware> globalMiddlewares_;
+  // 串行化写者（注册、热更新）；读者不使用
+  std::mutex writeMutex_;
   
-  // 路径特定中间件：path -> middlewares
-  std::unordered_map<std::string, std::vector<Middleware>> pathMiddlewares_;
-  
-  // 线程安全锁
-  mutable std::shared_mutex mutex_;
+  // 复制当前路由表、修改后整体发布
+  void Modify(const std::function<void(RouteTable&)>& fn);
+  void PublishLocked(std::shared_ptr<const RouteTable> table);
   
   // 执行中间件链
   bool ExecuteMiddlewares(IHttpMessage& message, const std::vector<Middleware>& middlewares) const;
   
-  // 从请求中提取路径（去除查询字符串）
-  static std::string ExtractPath(const HttpRequest& request);
-  
-  // 从请求中提取查询参数并填充到RouteParams中
+  // 让RouteParams引用请求已解析好的查询参数（不拷贝）
   static void ExtractQueryParams(const HttpRequest& request, RouteParams& params);
   
-  // 路径规范化：去除重复的斜杠，可选地去除尾部斜杠
+  // 路径规范化：去除重复的斜杠，可选地去除尾部斜杠（保留原始大小写）
   static std::string NormalizePath(const std::string& path, bool removeTrailingSlash = true);
   
-  // 检查路径是否包含参数或通配符
-  static bool IsStaticPath(const std::string& path);
+  // 路径是否已是规范形式（请求解析产生的路径总是规范的，匹配时可直接使用）
+  static bool IsCanonicalPath(std::string_view path);
   
   // 【新增】将HttpMethod转换为字符串（用于调试和日志）
   static std::string HttpMethodToString(HttpMethod method);
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * 安全规则多模式扫描器
+ * 全部规则在构造时编译成一个 Aho-Corasick 自动机并展开为稠密 DFA：
+ * 输入字节先查 256 项字符类表（同时完成 ASCII 大小写折叠），再查一次转移表，
+ * 一个字段只扫描一趟，每字节的开销与规则条数无关。
+ * 构造后只读，可在所有连接与线程间共享。
+ */
+class PatternScanner {
+public:
+    // 规则作用的字段（可组合）
+    enum Scope : uint8_t {
+        kScopePath = 1,     // 解码、规范化后的路径
+        kScopeUrl = 2,      // 原始 URL（含查询串）
+        kScopeHeader = 4    // ScannedHeaders() 中列出的请求头的值
+    };
+
+    enum class RuleKind : uint8_t {
+        Traversal,    // 路径遍历，拒绝为 403
+        Suspicious    // 注入等可疑片段，拒绝为 400
+    };
+
+    struct Rule {
+        std::string pattern;
+        uint8_t scopes;
+        RuleKind kind;
+    };
+
+    PatternScanner(std::vector<Rule> rules, std::vector<std::string> scanned_headers);
+
+    // 在 text 中查找作用于 scope 的规则（忽略 ASCII 大小写），未命中返回 nullptr。
+    // Traversal 规则优先：命中 Suspicious 后继续扫描完本字段，其后出现的遍历模式仍返回 Traversal（403），
+    // 否则返回最先结束的命中规则
+    const Rule* Scan(std::string_view text, Scope scope) const;
+
+    // 是否有规则作用于该字段，没有时调用方可以跳过扫描
+    bool HasScope(Scope scope) const { return (scopes_ & scope) != 0; }
+    const std::vector<std::string>& ScannedHeaders() const { return scanned_headers_; }
+    const std::vector<Rule>& Rules() const { return rules_; }
+    size_t StateCount() const { return out_scopes_.size(); }
+
+    // 内置规则：路径遍历以及常见的 SQL 注入、XSS 片段
+    static std::vector<Rule> DefaultRules();
+
+    // 从规则文件构建，每行一条，# 开头为注释：
+    //   traversal  path          ../
+    //   suspicious path,url      union select
+    //   headers    referer user-agent
+    // 第一列为类别，第二列为逗号分隔的作用域（path/url/header），其余部分为模式（可含空格）；
+    // headers 行指定 header 作用域扫描的请求头，缺省为 referer 与 user-agent。
+    // 文件内容整体替换内置规则；失败时返回 nullptr 并写入 error
+    static std::shared_ptr<const PatternScanner> LoadFromFile(const std::string& file, std::string* error);
+
+private:
+    const Rule* ResolveHit(int32_t state, uint8_t scope) const;
+
+    std::vector<Rule> rules_;
+    std::vector<std::string> scanned_headers_;
+    std::array<uint16_t, 256> class_{};            // 字节 -> 字符类，大写字母与对应小写同类，0 为不出现在任何模式中的字节
+    size_t alphabet_{1};
+    std::vector<int32_t> next_;                    // 状态 * alphabet_ + 字符类 -> 下一状态
+    std::vector<uint8_t> out_scopes_;              // 该状态（含失败链）上结束的规则的作用域并集
+    std::vector<int32_t> fail_;
+    std::vector<std::vector<int32_t>> terminals_;  // 恰好在该状态结束的规则下标，只在命中时查询
+    uint8_t scopes_{0};
+    uint8_t traversal_scopes_{0};                  // 存在 Traversal 规则的作用域，没有时首次命中即可返回
+};
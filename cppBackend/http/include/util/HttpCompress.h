@@ -0,0 +1,30 @@
+#pragma once
+
+#include "core/BodyProducer.h"
+#include "core/IHttpMessage.h"
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// 响应压缩（RFC 9110 8.4 / 12.5.3）：按 Accept-Encoding 协商 gzip/deflate，用 zlib 压缩 body
+
+// 小于此长度的 body 压缩收益抵不过头部与 CPU 开销
+constexpr size_t kMinCompressBytes = 1024;
+
+// 从 Accept-Encoding 中选出本端支持且 q 值最高的编码（同 q 时优先 gzip）；都不可接受时返回 IDENTITY
+HttpContentEncoding NegotiateContentEncoding(std::string_view accept_encoding);
+
+// 文本类媒体类型（text/*、JSON、JavaScript、XML、SVG）才值得压缩；参数（"; charset=..."）被忽略
+bool IsCompressibleContentType(std::string_view content_type);
+
+// 内容编码的头部取值："gzip" / "deflate"
+const char* ContentEncodingToken(HttpContentEncoding encoding);
+
+// 一次性压缩 in 追加到 out；level 为 zlib 压缩级别 1~9
+bool CompressBody(std::string_view in, HttpContentEncoding encoding, int level, std::string& out);
+
+// 把另一个生产者的输出压缩后再交出：每段以 Z_SYNC_FLUSH 结束，客户端收到一段即可解压一段
+std::shared_ptr<BodyProducer> MakeCompressingProducer(std::shared_ptr<BodyProducer> inner,
+                                                      HttpContentEncoding encoding, int level);
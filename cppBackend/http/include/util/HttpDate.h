@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <ctime>
+#include <string>
+#include <string_view>
+
+// IMF-fixdate（RFC 9110）："Sun, 06 Nov 1994 08:49:37 GMT"，固定 29 字节
+constexpr size_t kHttpDateLen = 29;
+
+// 直接按公历换算格式化，不调用 gmtime/strftime，线程安全；out 至少 kHttpDateLen 字节
+void FormatHttpDate(time_t t, char* out);
+std::string FormatHttpDate(time_t t);
+
+// 当前时间的 IMF-fixdate：每个线程缓存一份，秒数变化时才重新格式化
+std::string_view CachedHttpDate();
@@ -12,16 +12,19 @@ inline void ApplyCommonResponseHeaders(HttpResponse& resp, std::string_view requ
   }
 }
 
+// 与请求无关的 CORS 头部（Allow-Credentials、Expose-Headers、Max-Age）在服务器提供预渲染块时整块写入
 inline void ApplyCorsHeaders(HttpResponse& resp, const HttpRequest* req) {
   if (!req) return;
-  auto origin = req->GetHeader("Origin");
+  auto origin = req->GetHeaderView(KnownHeader::Origin);
   if (!origin) return;
 
-  resp.SetHeader("Access-Control-Allow-Origin", *origin);
-  resp.SetHeader("Vary", "Origin");
-  resp.SetHeader("Access-Control-Allow-Credentials", "true");
-  resp.SetHeader("Access-Control-Expose-Headers", "X-Request-Id");
-  resp.SetHeader("Access-Control-Max-Age", "600");
+  resp.SetHeader("Access-Control-Allow-Origin", std::string(*origin));
+  resp.SetHeader(KnownHeader::Vary, "Origin");
+  if (!resp.UsePrerenderedCors()) {
+    resp.SetHeader("Access-Control-Allow-Credentials", "true");
+    resp.SetHeader("Access-Control-Expose-Headers", "X-Request-Id");
+    resp.SetHeader("Access-Control-Max-Age", "600");
+  }
 
   auto acrm = req->GetHeader("Access-Control-Request-Method");
   if (acrm && !acrm->empty()) {
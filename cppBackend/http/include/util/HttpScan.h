@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+
+// HTTP/1 报文扫描内核：查找行尾、校验头部字符、ASCII 大小写折叠
+// 启动时按 CPU 特性选择 AVX2 / SSE4.2 实现，其他平台或老 CPU 使用标量实现，各实现结果完全一致
+enum class HttpScanIsa {
+  Scalar,
+  Sse42,
+  Avx2
+};
+
+const char* HttpScanIsaName(HttpScanIsa isa);
+bool HttpScanIsaSupported(HttpScanIsa isa);
+HttpScanIsa HttpScanActiveIsa();
+// 切换当前使用的实现（测试与基准用），不支持的指令集返回 false 且不做修改
+bool HttpScanForceIsa(HttpScanIsa isa);
+
+// 返回首个 "\r\n" 中 '\r' 的下标，未找到返回 len
+size_t HttpScanFindCrlf(const char* data, size_t len);
+// 是否全部为 RFC 9110 token 字符（头部名称、方法）；空串返回 false
+bool HttpScanIsToken(const char* data, size_t len);
+// 是否为合法的头部值：除 HTAB 外不含控制字符与 DEL，允许 obs-text（0x80-0xFF）
+bool HttpScanIsFieldValue(const char* data, size_t len);
+// 把 'A'-'Z' 原地转为小写，其余字节不变
+void HttpScanLowerAscii(char* data, size_t len);
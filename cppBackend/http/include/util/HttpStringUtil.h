@@ -3,22 +3,52 @@
 #include <string>
 #include <string_view>
 
+#include "HttpScan.h"
+
 inline char ToLowerAscii(char c) {
   if (c >= 'A' && c <= 'Z') return static_cast<char>(c - 'A' + 'a');
   return c;
 }
 
+// 短于一个向量宽度的字符串直接逐字节处理，省去分派的间接调用
+constexpr size_t kLowerAsciiSimdThreshold = 16;
+
 inline void LowerAsciiInPlace(std::string& s) {
+  if (s.size() >= kLowerAsciiSimdThreshold) {
+    HttpScanLowerAscii(s.data(), s.size());
+    return;
+  }
   for (char& c : s) c = ToLowerAscii(c);
 }
 
 inline std::string LowerAsciiCopy(std::string_view s) {
-  std::string out;
-  out.reserve(s.size());
-  for (char c : s) out.push_back(ToLowerAscii(c));
+  std::string out(s);
+  LowerAsciiInPlace(out);
   return out;
 }
 
+inline bool EqualsIgnoreCaseAscii(std::string_view a, std::string_view b) {
+  if (a.size() != b.size()) return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (ToLowerAscii(a[i]) != ToLowerAscii(b[i])) return false;
+  }
+  return true;
+}
+
+// 忽略 ASCII 大小写的有序比较；is_transparent 使有序容器可以直接用 string_view 查找，不构造键
+struct LessIgnoreCaseAscii {
+  using is_transparent = void;
+  bool operator()(std::string_view a, std::string_view b) const {
+    const size_t n = a.size() < b.size() ? a.size() : b.size();
+    for (size_t i = 0; i < n; ++i) {
+      const unsigned char ca = static_cast<unsigned char>(ToLowerAscii(a[i]));
+      const unsigned char cb = static_cast<unsigned char>(ToLowerAscii(b[i]));
+      if (ca != cb) return ca < cb;
+    }
+    return a.size() < b.size();
+  }
+};
+
 inline std::string_view TrimAsciiWhitespace(std::string_view s) {
   size_t start = 0;
   while (start < s.size()) {
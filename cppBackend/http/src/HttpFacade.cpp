@@ -6,6 +6,7 @@
 
 #include "ssl/SslFactory.h"
 #include "factory/HttpParseFactory.h"
+#include "parsers/Http1Parser.h"
 #include "handler/HandlerChain.h"
 #include "router/Router.h"
 #include "core/HttpRequest.h"
@@ -123,18 +124,18 @@ HttpServerResult HttpFacade::ProcessSsl(const std::string& raw_data,
     if (!ssl_enabled_ || !ssl_handler_) {
         // 不使用SSL，直接返回原始数据
         processed_data = raw_data;
-        NotifySslProcess("SSL未启用", "跳过SSL处理");
+        Emit(HttpProcessStage::SSL_PROCESS, HttpEventKind::SSL_SKIPPED);
         return HttpServerResult::SUCCESS;
     }
 
     // 检测是否为SSL连接
     if (!ssl_handler_->IsSslConnection(raw_data)) {
         processed_data = raw_data;
-        NotifySslProcess("非SSL连接", "检测到非SSL连接，跳过处理");
+        Emit(HttpProcessStage::SSL_PROCESS, HttpEventKind::SSL_SKIPPED);
         return HttpServerResult::SUCCESS;
     }
 
-    NotifySslProcess("开始SSL处理", "检测到SSL连接");
+    Emit(HttpProcessStage::SSL_PROCESS, HttpEventKind::SSL_BEGIN, 0, raw_data.size());
 
     // 执行SSL握手（如果需要）
     if (!handshake_complete_) {
@@ -142,15 +143,15 @@ HttpServerResult HttpFacade::ProcessSsl(const std::string& raw_data,
         SslResult handshake_result = ssl_handler_->Handshake(raw_data, handshake_output);
 
         if (handshake_result == SslResult::NEED_MORE_DATA) {
-            NotifySslProcess("SSL握手需要更多数据", "等待更多数据完成握手");
+            Emit(HttpProcessStage::SSL_PROCESS, HttpEventKind::SSL_HANDSHAKE_NEED_MORE, 0, raw_data.size());
             return HttpServerResult::SSL_HANDSHAKE_NEED_MORE_DATA;
         } else if (handshake_result != SslResult::SUCCESS) {
-            NotifySslProcess("SSL握手失败", "握手过程出错");
+            Emit(HttpProcessStage::SSL_PROCESS, HttpEventKind::SSL_HANDSHAKE_FAILED, static_cast<int>(handshake_result));
             return HttpServerResult::SSL_HANDSHAKE_FAILED;
         }
 
         handshake_complete_ = true;
-        NotifySslProcess("SSL握手完成", handshake_output);
+        Emit(HttpProcessStage::SSL_PROCESS, HttpEventKind::SSL_HANDSHAKE_DONE, 0, handshake_output.size());
     }
 
     // 解密SSL数据
@@ -159,15 +160,15 @@ HttpServerResult HttpFacade::ProcessSsl(const std::string& raw_data,
 
     if (decrypt_result == SslResult::SUCCESS) {
         processed_data = decrypted_data;
-        NotifySslProcess("SSL数据解密成功", "数据已解密，准备进行HTTP解析");
+        Emit(HttpProcessStage::SSL_PROCESS, HttpEventKind::SSL_DECRYPTED, 0, processed_data.size());
         return HttpServerResult::SUCCESS;
     } else if (decrypt_result == SslResult::NOT_SSL_CONNECTION) {
         // 不是SSL连接，继续使用原始数据
         processed_data = raw_data;
-        NotifySslProcess("非SSL连接", "跳过解密，使用原始数据");
+        Emit(HttpProcessStage::SSL_PROCESS, HttpEventKind::SSL_SKIPPED);
         return HttpServerResult::SUCCESS;
     } else {
-        NotifySslProcess("SSL解密失败", "解密过程出错");
+        Emit(HttpProcessStage::SSL_PROCESS, HttpEventKind::SSL_DECRYPT_FAILED, static_cast<int>(decrypt_result));
         return HttpServerResult::SSL_HANDSHAKE_FAILED;
     }
 }
@@ -175,13 +176,13 @@ HttpServerResult HttpFacade::ProcessSsl(const std::string& raw_data,
 // HTTP解析阶段：解析HTTP数据
 HttpServerResult HttpFacade::ProcessParsing(std::string data,
                                           std::unique_ptr<IHttpMessage>& message) {
-    NotifyHttpParse("开始HTTP解析", "准备解析HTTP数据");
+    Emit(HttpProcessStage::HTTP_PARSE, HttpEventKind::PARSE_BEGIN, 0, data.size());
     
     // 使用工厂创建解析器（自动嗅探HTTP版本）
     if (!parser_) {
         parser_ = HttpParseFactory::Create(data);
         if (!parser_) {
-            NotifyHttpParse("HTTP解析失败", "无法创建HTTP解析器");
+            Emit(HttpProcessStage::HTTP_PARSE, HttpEventKind::PARSER_CREATE_FAILED, 0, data.size());
             last_error_.code = HttpErrc::INTERNAL_ERROR;
             last_error_.status = HttpStatusCode::INTERNAL_SERVER_ERROR;
             last_error_.message = "Internal Server Error";
@@ -191,13 +192,24 @@ HttpServerResult HttpFacade::ProcessParsing(std::string data,
             has_error_ = true;
             return HttpServerResult::PARSE_FAILED;
         }
-        NotifyHttpParse("创建解析器成功", "已根据数据特征创建合适的解析器");
+        http1_parser_ = dynamic_cast<Http1Parser*>(parser_.get());
+        if (http1_parser_) {
+            http1_parser_->SetBodyDeferThreshold(body_defer_threshold_);
+        }
+        Emit(HttpProcessStage::HTTP_PARSE, HttpEventKind::PARSER_CREATED);
     }
 
     // 解析HTTP数据
+    const size_t received_bytes = data.size();
     int parse_result = parser_->Parse(data, message);
+    return HandleParseResult(parse_result, received_bytes, message);
+}
+
+// 解析返回码到服务器结果的映射，填充 last_error_；流式与分段两条解析路径共用
+HttpServerResult HttpFacade::HandleParseResult(int parse_result, size_t received_bytes,
+                                               std::unique_ptr<IHttpMessage>& message) {
     if (parse_result == static_cast<int>(ParseResult::NEEDMOREDATA)) {
-        NotifyHttpParse("HTTP解析需要更多数据", "等待更多数据完成解析");
+        Emit(HttpProcessStage::HTTP_PARSE, HttpEventKind::PARSE_NEED_MORE, parse_result, received_bytes);
         if (!awaiting_more_data_) {
             awaiting_more_data_ = true;
             parse_wait_start_ = std::chrono::steady_clock::now();
@@ -205,11 +217,12 @@ HttpServerResult HttpFacade::ProcessParsing(std::string data,
             auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
                 std::chrono::steady_clock::now() - parse_wait_start_);
             if (elapsed.count() > parse_timeout_ms_) {
+                Emit(HttpProcessStage::HTTP_PARSE, HttpEventKind::PARSE_TIMEOUT, parse_result, received_bytes);
                 last_error_.code = HttpErrc::PARSE_TIMEOUT;
                 last_error_.status = HttpStatusCode::REQUEST_TIMEOUT;
                 last_error_.message = "Request Timeout";
                 last_error_.ctx.stage = HttpErrorStage::PARSING;
-                last_error_.ctx.received_bytes = data.size();
+                last_error_.ctx.received_bytes = received_bytes;
                 last_error_.ctx.consumed_bytes = parser_->GetConsumeBytes();
                 last_error_.ctx.detail = "incomplete request";
                 has_error_ = true;
@@ -221,13 +234,13 @@ HttpServerResult HttpFacade::ProcessParsing(std::string data,
         return HttpServerResult::NEED_MORE_DATA;
     }
     if (parse_result == static_cast<int>(ParseResult::UNSUPPORTEDVERSION)) {
-        NotifyHttpParse("HTTP版本不支持", "解析到不支持的HTTP版本");
+        Emit(HttpProcessStage::HTTP_PARSE, HttpEventKind::PARSE_UNSUPPORTED_VERSION, parse_result, received_bytes);
         last_error_.code = HttpErrc::PARSE_UNSUPPORTED_VERSION;
         last_error_.status = HttpStatusCode::HTTP_VERSION_NOT_SUPPORTED;
         last_error_.message = "HTTP Version Not Supported";
         last_error_.ctx.stage = HttpErrorStage::PARSING;
         last_error_.ctx.parser_result = parse_result;
-        last_error_.ctx.received_bytes = data.size();
+        last_error_.ctx.received_bytes = received_bytes;
         last_error_.ctx.consumed_bytes = parser_->GetConsumeBytes();
         has_error_ = true;
         parser_->Reset();
@@ -236,7 +249,7 @@ HttpServerResult HttpFacade::ProcessParsing(std::string data,
     }
     if (parse_result == static_cast<int>(ParseResult::HEADERTOOLONG) ||
         parse_result == static_cast<int>(ParseResult::BODYTOOLONG)) {
-        NotifyHttpParse("HTTP报文过大", "Header或Body超过限制");
+        Emit(HttpProcessStage::HTTP_PARSE, HttpEventKind::PARSE_TOO_LARGE, parse_result, received_bytes);
         if (parse_result == static_cast<int>(ParseResult::HEADERTOOLONG)) {
             last_error_.code = HttpErrc::PARSE_HEADER_TOO_LARGE;
             last_error_.status = HttpStatusCode::REQUEST_HEADER_FIELDS_TOO_LARGE;
@@ -248,7 +261,7 @@ HttpServerResult HttpFacade::ProcessParsing(std::string data,
         }
         last_error_.ctx.stage = HttpErrorStage::PARSING;
         last_error_.ctx.parser_result = parse_result;
-        last_error_.ctx.received_bytes = data.size();
+        last_error_.ctx.received_bytes = received_bytes;
         last_error_.ctx.consumed_bytes = parser_->GetConsumeBytes();
         has_error_ = true;
         parser_->Reset();
@@ -256,8 +269,7 @@ HttpServerResult HttpFacade::ProcessParsing(std::string data,
         return HttpServerResult::PAYLOAD_TOO_LARGE;
     }
     if (parse_result != static_cast<int>(ParseResult::SUCCESS) || !message) {
-        std::string error_detail = "解析返回码: " + std::to_string(parse_result);
-        NotifyHttpParse("HTTP解析失败", error_detail);
+        Emit(HttpProcessStage::HTTP_PARSE, HttpEventKind::PARSE_FAILED, parse_result, received_bytes);
         if (parse_result == static_cast<int>(ParseResult::INVALIDSTARTLINE)) {
             last_error_.code = HttpErrc::PARSE_INVALID_START_LINE;
         } else if (parse_result == static_cast<int>(ParseResult::INVALIDHEADER)) {
@@ -271,25 +283,16 @@ HttpServerResult HttpFacade::ProcessParsing(std::string data,
         last_error_.message = "Bad Request";
         last_error_.ctx.stage = HttpErrorStage::PARSING;
         last_error_.ctx.parser_result = parse_result;
-        last_error_.ctx.received_bytes = data.size();
+        last_error_.ctx.received_bytes = received_bytes;
         last_error_.ctx.consumed_bytes = parser_->GetConsumeBytes();
-        last_error_.ctx.detail = error_detail;
+        last_error_.ctx.detail = "解析返回码: " + std::to_string(parse_result);
         has_error_ = true;
         parser_->Reset();
         awaiting_more_data_ = false;
         return HttpServerResult::PARSE_FAILED;
     }
 
-    // 解析成功，提取请求信息用于日志
-    std::string parse_detail;
-    if (auto* req = dynamic_cast<HttpRequest*>(message.get())) {
-        parse_detail = "方法: " + req->GetMethodString() + 
-                      ", 路径: " + req->GetPath() + 
-                      ", 版本: " + req->GetVersionStr();
-    } else {
-        parse_detail = "响应消息解析成功";
-    }
-    NotifyHttpParse("HTTP解析成功", parse_detail);
+    Emit(HttpProcessStage::HTTP_PARSE, HttpEventKind::PARSE_DONE, parse_result, received_bytes, message.get());
     awaiting_more_data_ = false;
 
     return HttpServerResult::SUCCESS;
@@ -297,17 +300,17 @@ HttpServerResult HttpFacade::ProcessParsing(std::string data,
 
 // 责任链验证阶段：执行中间件和基础校验
 HttpServerResult HttpFacade::ProcessValidation(IHttpMessage& message, HttpResponse& response) {
-    NotifyValidation("开始责任链验证", "执行中间件和基础校验");
+    Emit(HttpProcessStage::VALIDATION, HttpEventKind::VALIDATION_BEGIN, 0, 0, &message);
 
     if (!handler_chain_->Handle(message, last_error_)) {
-        if (auto* request = dynamic_cast<HttpRequest*>(&message)) {
+        if (auto* request = AsHttpRequest(&message)) {
             last_error_.ctx.method = request->GetMethodString();
             last_error_.ctx.url = request->GetUrl();
             last_error_.ctx.path = request->GetPath();
             last_error_.ctx.version = request->GetVersionStr();
         }
         has_error_ = true;
-        NotifyValidation("责任链验证失败", "某个中间件或验证器拒绝了请求");
+        Emit(HttpProcessStage::VALIDATION, HttpEventKind::VALIDATION_FAILED, last_error_.HttpStatus(), 0, &message);
         if (last_error_.status == HttpStatusCode::NOT_IMPLEMENTED) {
             return HttpServerResult::NOT_IMPLEMENTED;
         }
@@ -318,25 +321,26 @@ HttpServerResult HttpFacade::ProcessValidation(IHttpMessage& message, HttpRespon
         return HttpServerResult::VALIDATION_FAILED;
     }
     
-    NotifyValidation("责任链验证成功", "所有验证器和中间件通过");
+    Emit(HttpProcessStage::VALIDATION, HttpEventKind::VALIDATION_PASSED, 0, 0, &message);
     return HttpServerResult::SUCCESS;
 }
 
 // 路由处理阶段：处理路由并返回响应
 HttpServerResult HttpFacade::ProcessRouting(IHttpMessage& message, HttpResponse& response) {
     if (router_) {
-        NotifyRouting("开始路由处理", "使用配置的路由器处理请求");
+        Emit(HttpProcessStage::ROUTING, HttpEventKind::ROUTE_BEGIN, 0, 0, &message);
         
         // 检查是否是请求消息
         if (message.IsRequest()) {
-            auto* request = dynamic_cast<HttpRequest*>(&message);
+            auto* request = AsHttpRequest(&message);
             if (request) {
                 // 设置响应版本
                 response.SetVersion(request->GetVersion());
+                request->SetCancelToken(cancel_token_);
                 
                 // 调用路由器处理请求
                 if (!router_->Handle(message, response)) {
-                    NotifyRouting("路由处理失败", "路由器无法处理该请求");
+                    Emit(HttpProcessStage::ROUTING, HttpEventKind::ROUTE_NOT_FOUND, static_cast<int>(HttpStatusCode::NOT_FOUND), 0, &message);
                     last_error_.code = HttpErrc::ROUTE_NOT_FOUND;
                     last_error_.status = HttpStatusCode::NOT_FOUND;
                     last_error_.message = "Not Found";
@@ -349,20 +353,22 @@ HttpServerResult HttpFacade::ProcessRouting(IHttpMessage& message, HttpResponse&
                     return HttpServerResult::ROUTING_FAILED;
                 }
                 
-                NotifyRouting("路由处理成功", "请求已路由到对应的处理器");
+                Emit(HttpProcessStage::ROUTING, HttpEventKind::ROUTE_DONE, 0, 0, &message);
             }
         }
     } else {
-        NotifyRouting("跳过路由处理", "未配置路由器，使用默认处理");
+        Emit(HttpProcessStage::ROUTING, HttpEventKind::ROUTE_SKIPPED, 0, 0, &message);
     }
     // 预留：这里可以添加路由逻辑（JWT令牌、Cookie、Session等）
     return HttpServerResult::SUCCESS;
 }
 
-// 添加观察者
+// 添加观察者；订阅阶段在注册时读取一次并并入 event_mask_
 void HttpFacade::AddObserver(std::shared_ptr<IHttpObserver> observer) {
     if (observer) {
-        observers_.push_back(observer);
+        observer_masks_.push_back(observer->StageMask());
+        observers_.push_back(std::move(observer));
+        RebuildEventMask();
     }
 }
 
@@ -371,52 +377,49 @@ void HttpFacade::RemoveObserver(std::shared_ptr<IHttpObserver> observer) {
     if (observer) {
         auto it = std::find(observers_.begin(), observers_.end(), observer);
         if (it != observers_.end()) {
+            observer_masks_.erase(observer_masks_.begin() + (it - observers_.begin()));
             observers_.erase(it);
+            RebuildEventMask();
         }
     }
 }
 
-// 通知所有观察者（处理完成事件）
-void HttpFacade::NotifyObservers(const IHttpMessage& message) {
-    for (auto& observer : observers_) {
-        if (observer) {
-            observer->OnMessage(message);
-        }
+void HttpFacade::RebuildEventMask() {
+    event_mask_ = 0;
+    for (uint32_t mask : observer_masks_) {
+        event_mask_ |= mask;
     }
 }
 
-// 通知观察者SSL处理事件
-void HttpFacade::NotifySslProcess(const std::string& event, const std::string& details) {
-    for (auto& observer : observers_) {
-        if (observer) {
-            observer->OnSslProcess(event, details);
-        }
-    }
-}
-
-// 通知观察者HTTP解析事件
-void HttpFacade::NotifyHttpParse(const std::string& event, const std::string& details) {
-    for (auto& observer : observers_) {
-        if (observer) {
-            observer->OnHttpParse(event, details);
-        }
-    }
-}
-
-// 通知观察者责任链验证事件
-void HttpFacade::NotifyValidation(const std::string& event, const std::string& details) {
-    for (auto& observer : observers_) {
-        if (observer) {
-            observer->OnValidation(event, details);
+// 通知所有观察者（处理完成事件）
+void HttpFacade::NotifyObservers(const IHttpMessage& message) {
+    if (!Observing(HttpProcessStage::COMPLETE)) {
+        return;
+    }
+    EmitEvent(HttpProcessStage::COMPLETE, HttpEventKind::MESSAGE_COMPLETE, 0, 0, &message);
+    const uint32_t bit = HttpStageBit(HttpProcessStage::COMPLETE);
+    for (size_t i = 0; i < observers_.size(); ++i) {
+        if (observer_masks_[i] & bit) {
+            observers_[i]->OnMessage(message);
         }
     }
 }
 
-// 通知观察者路由处理事件
-void HttpFacade::NotifyRouting(const std::string& event, const std::string& details) {
-    for (auto& observer : observers_) {
-        if (observer) {
-            observer->OnRouting(event, details);
+// 生成事件并分发给订阅了该阶段的观察者；调用方已通过 Observing() 判断过
+void HttpFacade::EmitEvent(HttpProcessStage stage, HttpEventKind kind, int code, uint64_t bytes,
+                           const IHttpMessage* message) {
+    HttpEvent event;
+    event.stage = stage;
+    event.kind = kind;
+    event.code = code;
+    event.bytes = bytes;
+    event.timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    event.message = message;
+    const uint32_t bit = HttpStageBit(stage);
+    for (size_t i = 0; i < observers_.size(); ++i) {
+        if (observer_masks_[i] & bit) {
+            observers_[i]->OnEvent(event);
         }
     }
 }
@@ -448,6 +451,80 @@ void HttpFacade::SetRouter(std::shared_ptr<Router> router) {
     router_ = router;
 }
 
+// 设置连接级取消令牌
+void HttpFacade::SetCancelToken(std::shared_ptr<const std::atomic_bool> token) {
+    cancel_token_ = std::move(token);
+}
+
+void HttpFacade::SetDeferRouting(bool defer) {
+    defer_routing_ = defer;
+}
+
+void HttpFacade::SetBodyDeferThreshold(size_t threshold) {
+    body_defer_threshold_ = threshold;
+    if (http1_parser_) {
+        http1_parser_->SetBodyDeferThreshold(threshold);
+    }
+}
+
+void HttpFacade::RecycleMessage(std::unique_ptr<IHttpMessage> message) {
+    HttpRequest* request = AsHttpRequest(message.get());
+    if (!http1_parser_ || !request) {
+        return;
+    }
+    message.release();
+    http1_parser_->RecycleRequest(std::unique_ptr<HttpRequest>(request));
+}
+
+namespace {
+void FillRouteNotFound(HttpError& err, const HttpRequest& request) {
+    err.code = HttpErrc::ROUTE_NOT_FOUND;
+    err.status = HttpStatusCode::NOT_FOUND;
+    err.message = "Not Found";
+    err.ctx.stage = HttpErrorStage::ROUTING;
+    err.ctx.method = request.GetMethodString();
+    err.ctx.url = request.GetUrl();
+    err.ctx.path = request.GetPath();
+    err.ctx.version = request.GetVersionStr();
+}
+}  // namespace
+
+// 路由匹配：与 ProcessRouting 的错误语义一致（未匹配统一返回404）
+HttpServerResult HttpFacade::MatchRoute(IHttpMessage& message, HttpResponse& response,
+                                        RouteMatchInfo& out_route, HttpError& out_error) {
+    auto* request = AsHttpRequest(&message);
+    if (!router_ || !request) {
+        Emit(HttpProcessStage::ROUTING, HttpEventKind::ROUTE_SKIPPED, 0, 0, &message);
+        return HttpServerResult::SUCCESS;
+    }
+
+    Emit(HttpProcessStage::ROUTING, HttpEventKind::ROUTE_BEGIN, 0, 0, &message);
+    response.SetVersion(request->GetVersion());
+    request->SetCancelToken(cancel_token_);
+    out_route = router_->MatchRoute(*request);
+    if (out_route.result != RouteMatchResult::SUCCESS || !out_route.handler) {
+        Emit(HttpProcessStage::ROUTING, HttpEventKind::ROUTE_NOT_FOUND, static_cast<int>(HttpStatusCode::NOT_FOUND), 0, &message);
+        FillRouteNotFound(out_error, *request);
+        return HttpServerResult::ROUTING_FAILED;
+    }
+    return HttpServerResult::SUCCESS;
+}
+
+HttpServerResult HttpFacade::RunRoute(HttpRequest& request, HttpResponse& response,
+                                      const RouteMatchInfo& route, HttpError& out_error) {
+    if (!route.handler) {
+        return HttpServerResult::SUCCESS;
+    }
+    if (!(*route.handler)(request, response, route.params)) {
+        Emit(HttpProcessStage::ROUTING, HttpEventKind::ROUTE_HANDLER_REJECTED, 0, 0, &request);
+        FillRouteNotFound(out_error, request);
+        return HttpServerResult::ROUTING_FAILED;
+    }
+    Emit(HttpProcessStage::ROUTING, HttpEventKind::ROUTE_DONE, 0, 0, &request);
+    NotifyObservers(request);
+    return HttpServerResult::SUCCESS;
+}
+
 // 配置服务器
 void HttpFacade::ConfigureServer(bool enable_ssl,
                                const std::string& cert_file,
@@ -570,13 +647,93 @@ HttpServerResult HttpFacade::ProcessPending(std::unique_ptr<IHttpMessage>& out_m
         return ssl_result;
     }
 
-    // 2. HTTP解析阶段（直接在 pending_data_ 上解析）
+    // 2. HTTP解析阶段：流式解析器每次都从 pending 开头重新解析，先丢弃上一轮未完成的状态
+    if (http1_parser_) {
+        http1_parser_->Reset();
+    }
     HttpServerResult parse_result = ProcessParsing(processed_data, out_message);
     if (parse_result != HttpServerResult::SUCCESS || !out_message) {
         out_error = last_error_;
         return parse_result;
     }
 
+    return ProcessParsedMessage(out_message, out_response, out_error);
+}
+
+HttpServerResult HttpFacade::ProcessSegments(const struct iovec* iov, size_t iovcnt, size_t& consumed,
+                                             std::unique_ptr<IHttpMessage>& out_message,
+                                             HttpResponse& out_response,
+                                             HttpError& out_error) {
+    consumed = 0;
+    size_t total = 0;
+    for (size_t i = 0; i < iovcnt; ++i) {
+        total += iov[i].iov_len;
+    }
+
+    // 解析器只需嗅探开头的字节即可确定协议版本
+    if (!parser_ && !ssl_enabled_ && iovcnt > 0 && iov[0].iov_len > 0) {
+        parser_ = HttpParseFactory::Create(static_cast<const char*>(iov[0].iov_base), iov[0].iov_len);
+        http1_parser_ = dynamic_cast<Http1Parser*>(parser_.get());
+        if (http1_parser_) {
+            http1_parser_->SetBodyDeferThreshold(body_defer_threshold_);
+        }
+    }
+
+    // 快速路径：明文 HTTP/1 且没有残留的 pending 数据时，直接在分段缓冲上解析
+    if (!ssl_enabled_ && pending_data_.empty() && http1_parser_ && total > 0) {
+        has_error_ = false;
+        last_error_ = HttpError{};
+        int rc = http1_parser_->ParseSegments(iov, iovcnt, out_message);
+        if (rc != static_cast<int>(ParseResult::NEEDSTREAMING)) {
+            HttpServerResult parse_result = HandleParseResult(rc, total, out_message);
+            if (parse_result == HttpServerResult::NEED_MORE_DATA) {
+                out_error = last_error_;
+                return parse_result;
+            }
+            // 出错时连接随后关闭，剩余数据一并视为已消费
+            consumed = parse_result == HttpServerResult::SUCCESS ? http1_parser_->GetConsumeBytes() : total;
+            if (parse_result != HttpServerResult::SUCCESS || !out_message) {
+                out_error = last_error_;
+                return parse_result;
+            }
+            return ProcessParsedMessage(out_message, out_response, out_error);
+        }
+    }
+
+    // 慢路径（TLS、HTTP/2、chunked 与响应报文）：全部转入 pending 缓冲，由流式解析器处理
+    for (size_t i = 0; i < iovcnt; ++i) {
+        pending_data_.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    }
+    consumed = total;
+    HttpServerResult result = ProcessPending(out_message, out_response, out_error);
+    if (out_message) {
+        ErasePending(GetConsumedBytes());
+    }
+    return result;
+}
+
+HttpServerResult HttpFacade::ValidateMessage(std::unique_ptr<IHttpMessage>& message,
+                                             HttpResponse& response,
+                                             HttpError& out_error) {
+    has_error_ = false;
+    last_error_ = HttpError{};
+    if (!message) {
+        last_error_.code = HttpErrc::INTERNAL_ERROR;
+        last_error_.status = HttpStatusCode::INTERNAL_SERVER_ERROR;
+        last_error_.message = "Internal Server Error";
+        last_error_.ctx.stage = HttpErrorStage::VALIDATION;
+        last_error_.ctx.detail = "empty message";
+        has_error_ = true;
+        out_error = last_error_;
+        return HttpServerResult::VALIDATION_FAILED;
+    }
+    return ProcessParsedMessage(message, response, out_error);
+}
+
+// 解析完成后的公共阶段：责任链验证、路由与观察者通知
+HttpServerResult HttpFacade::ProcessParsedMessage(std::unique_ptr<IHttpMessage>& out_message,
+                                                  HttpResponse& out_response,
+                                                  HttpError& out_error) {
     // 3. 责任链验证阶段
     if (!handler_chain_) {
         last_error_.code = HttpErrc::INTERNAL_ERROR;
@@ -594,6 +751,12 @@ HttpServerResult HttpFacade::ProcessPending(std::unique_ptr<IHttpMessage>& out_m
         return validation_result;
     }
 
+    // 延迟路由：匹配与处理器执行交给调用方（MatchRoute/RunRoute）
+    if (defer_routing_) {
+        out_error = last_error_;
+        return HttpServerResult::SUCCESS;
+    }
+
     // 4. 路由处理阶段
     HttpServerResult routing_result = ProcessRouting(*out_message, out_response);
     if (routing_result != HttpServerResult::SUCCESS) {
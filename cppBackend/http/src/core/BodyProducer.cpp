@@ -0,0 +1,66 @@
+#include "../../include/core/BodyProducer.h"
+
+#include <charconv>
+
+namespace {
+
+// 分块帧："<十六进制长度>\r\n<数据>\r\n"
+void AppendChunk(std::string& wire, const std::string& data) {
+  char size[16];
+  auto res = std::to_chars(size, size + sizeof(size), data.size(), 16);
+  wire.append(size, static_cast<size_t>(res.ptr - size)).append("\r\n");
+  wire.append(data).append("\r\n");
+}
+
+}  // namespace
+
+BodyProducerFramer::BodyProducerFramer(std::shared_ptr<BodyProducer> producer, bool chunked)
+    : producer_(std::move(producer)), chunked_(chunked), length_(producer_ ? producer_->Length() : 0) {}
+
+BodyProducer::Status BodyProducerFramer::Next(std::string& wire, size_t max_bytes) {
+  if (finished_) {
+    return BodyProducer::Status::Done;
+  }
+  if (!producer_) {
+    finished_ = true;
+    if (chunked_) wire.append("0\r\n\r\n");
+    return BodyProducer::Status::Done;
+  }
+
+  size_t appended = 0;
+  while (appended < max_bytes) {
+    // chunked 时先生成到暂存区再整段加帧；长度为 0 的分块会被对端当作终止块，必须跳过
+    std::string& out = chunked_ ? scratch_ : wire;
+    const size_t before = out.size();
+    const BodyProducer::Status status = producer_->Produce(out, max_bytes - appended);
+    const size_t n = out.size() - before;
+    produced_ += n;
+    appended += n;
+    if (chunked_ && n > 0) {
+      AppendChunk(wire, scratch_);
+    }
+    scratch_.clear();
+
+    if (status == BodyProducer::Status::Error ||
+        (length_ >= 0 && produced_ > static_cast<uint64_t>(length_))) {
+      finished_ = true;
+      producer_.reset();
+      return BodyProducer::Status::Error;
+    }
+    if (status == BodyProducer::Status::Done) {
+      finished_ = true;
+      producer_.reset();
+      // 声明了长度却提前结束：已发出的 Content-Length 无法再兑现
+      if (length_ >= 0 && produced_ != static_cast<uint64_t>(length_)) {
+        return BodyProducer::Status::Error;
+      }
+      if (chunked_) wire.append("0\r\n\r\n");
+      return BodyProducer::Status::Done;
+    }
+    // 生产者暂时给不出数据：先把已有的发出去，避免在执行池里空转
+    if (n == 0) {
+      break;
+    }
+  }
+  return BodyProducer::Status::More;
+}
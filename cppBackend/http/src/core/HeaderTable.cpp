@@ -0,0 +1,284 @@
+#include "core/HeaderTable.h"
+
+#include "util/HttpStringUtil.h"
+
+namespace {
+
+// 与 KnownHeader 枚举一一对应的小写名称
+constexpr std::string_view kKnownHeaderNames[kKnownHeaderCount] = {
+  "host",
+  "connection",
+  "content-length",
+  "content-type",
+  "content-encoding",
+  "content-range",
+  "transfer-encoding",
+  "range",
+  "if-range",
+  "if-none-match",
+  "if-modified-since",
+  "authorization",
+  "cookie",
+  "set-cookie",
+  "accept-encoding",
+  "origin",
+  "upgrade",
+  "expect",
+  "trailer",
+  "date",
+  "etag",
+  "last-modified",
+  "location",
+  "vary",
+  "cache-control",
+  "accept-ranges",
+};
+
+constexpr size_t kMaxKnownNameLen = 17;
+constexpr size_t kMaxCandidates = 6;
+
+// 按名称长度分桶，查找时只需与同长度的少数几个候选比较
+struct KnownHeaderBuckets {
+  uint8_t count[kMaxKnownNameLen + 1] = {};
+  KnownHeader ids[kMaxKnownNameLen + 1][kMaxCandidates] = {};
+
+  KnownHeaderBuckets() {
+    for (size_t i = 0; i < kKnownHeaderCount; ++i) {
+      size_t len = kKnownHeaderNames[i].size();
+      ids[len][count[len]++] = static_cast<KnownHeader>(i);
+    }
+  }
+};
+
+const KnownHeaderBuckets& Buckets() {
+  static const KnownHeaderBuckets buckets;
+  return buckets;
+}
+
+// lower 必须已是小写
+bool EqualsLowered(std::string_view s, std::string_view lower) {
+  for (size_t i = 0; i < lower.size(); ++i) {
+    if (ToLowerAscii(s[i]) != lower[i]) return false;
+  }
+  return true;
+}
+
+void LowerRange(char* p, size_t n) {
+  if (n >= kLowerAsciiSimdThreshold) {
+    HttpScanLowerAscii(p, n);
+    return;
+  }
+  for (size_t i = 0; i < n; ++i) p[i] = ToLowerAscii(p[i]);
+}
+
+}  // namespace
+
+KnownHeader LookupKnownHeader(std::string_view name) {
+  if (name.empty() || name.size() > kMaxKnownNameLen) return KnownHeader::Unknown;
+  const auto& buckets = Buckets();
+  const size_t len = name.size();
+  for (uint8_t i = 0; i < buckets.count[len]; ++i) {
+    KnownHeader id = buckets.ids[len][i];
+    if (EqualsLowered(name, kKnownHeaderNames[static_cast<size_t>(id)])) return id;
+  }
+  return KnownHeader::Unknown;
+}
+
+std::string_view KnownHeaderName(KnownHeader id) {
+  if (id >= KnownHeader::Count) return std::string_view();
+  return kKnownHeaderNames[static_cast<size_t>(id)];
+}
+
+void HeaderTable::Adopt(std::string&& raw, std::vector<Entry>&& entries) {
+  arena_ = std::move(raw);
+  entries_ = std::move(entries);
+  deadBytes_ = 0;
+  for (const auto& e : entries_) {
+    LowerRange(arena_.data() + e.name_off, e.name_len);
+  }
+  RebuildKnownIndex();
+  materializedValid_ = false;
+}
+
+void HeaderTable::Release(std::string& raw, std::vector<Entry>& entries) {
+  raw.swap(arena_);
+  entries.swap(entries_);
+  raw.clear();
+  entries.clear();
+  Clear();
+}
+
+void HeaderTable::Append(std::string_view name, std::string_view value) {
+  name = TrimAsciiWhitespace(name);
+  AppendEntry(name, LookupKnownHeader(name), value);
+}
+
+void HeaderTable::Set(std::string_view name, std::string_view value) {
+  name = TrimAsciiWhitespace(name);
+  KnownHeader id = LookupKnownHeader(name);
+  RemoveIf(name, id);
+  AppendEntry(name, id, value);
+  MaybeCompact();
+}
+
+void HeaderTable::Set(KnownHeader id, std::string_view value) {
+  std::string_view name = KnownHeaderName(id);
+  RemoveIf(name, id);
+  AppendEntry(name, id, value);
+  MaybeCompact();
+}
+
+void HeaderTable::Remove(std::string_view name) {
+  name = TrimAsciiWhitespace(name);
+  RemoveIf(name, LookupKnownHeader(name));
+  MaybeCompact();
+}
+
+void HeaderTable::Clear() {
+  arena_.clear();
+  entries_.clear();
+  known_.fill(0);
+  deadBytes_ = 0;
+  materialized_.clear();
+  materializedValid_ = false;
+}
+
+void HeaderTable::Reserve(size_t count, size_t bytes) {
+  entries_.reserve(count);
+  arena_.reserve(bytes);
+}
+
+std::optional<std::string_view> HeaderTable::Get(std::string_view name) const {
+  size_t idx = Find(TrimAsciiWhitespace(name));
+  if (idx == kNotFound) return std::nullopt;
+  return ValueAt(idx);
+}
+
+std::optional<std::string_view> HeaderTable::Get(KnownHeader id) const {
+  uint16_t slot = known_[static_cast<size_t>(id)];
+  if (slot == 0) return std::nullopt;
+  return ValueAt(slot - 1);
+}
+
+std::vector<std::string_view> HeaderTable::GetAll(std::string_view name) const {
+  std::vector<std::string_view> values;
+  name = TrimAsciiWhitespace(name);
+  KnownHeader id = LookupKnownHeader(name);
+  for (const auto& e : entries_) {
+    bool match = id != KnownHeader::Unknown ? e.id == id
+                                            : (e.name_len == name.size() && EqualsLowered(name, View(e.name_off, e.name_len)));
+    if (match) values.push_back(View(e.value_off, e.value_len));
+  }
+  return values;
+}
+
+void HeaderTable::AppendTo(std::string& out) const {
+  for (const auto& e : entries_) {
+    out.append(arena_, e.name_off, e.name_len);
+    out.append(": ", 2);
+    out.append(arena_, e.value_off, e.value_len);
+    out.append("\r\n", 2);
+  }
+}
+
+size_t HeaderTable::SerializedSize() const {
+  size_t total = 0;
+  for (const auto& e : entries_) total += e.name_len + e.value_len + 4;
+  return total;
+}
+
+const std::vector<std::pair<std::string, std::string>>& HeaderTable::Materialized() const {
+  if (!materializedValid_) {
+    materialized_.clear();
+    materialized_.reserve(entries_.size());
+    for (const auto& e : entries_) {
+      materialized_.emplace_back(std::string(View(e.name_off, e.name_len)), std::string(View(e.value_off, e.value_len)));
+    }
+    materializedValid_ = true;
+  }
+  return materialized_;
+}
+
+size_t HeaderTable::Find(std::string_view name) const {
+  KnownHeader id = LookupKnownHeader(name);
+  if (id != KnownHeader::Unknown) {
+    uint16_t slot = known_[static_cast<size_t>(id)];
+    return slot == 0 ? kNotFound : slot - 1;
+  }
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const auto& e = entries_[i];
+    if (e.name_len == name.size() && EqualsLowered(name, View(e.name_off, e.name_len))) return i;
+  }
+  return kNotFound;
+}
+
+void HeaderTable::AppendEntry(std::string_view name, KnownHeader id, std::string_view value) {
+  Entry e;
+  e.id = id;
+  e.name_off = static_cast<uint32_t>(arena_.size());
+  e.name_len = static_cast<uint32_t>(name.size());
+  if (id != KnownHeader::Unknown) {
+    arena_.append(KnownHeaderName(id));
+  } else {
+    arena_.append(name);
+    LowerRange(arena_.data() + e.name_off, e.name_len);
+  }
+  e.value_off = static_cast<uint32_t>(arena_.size());
+  e.value_len = static_cast<uint32_t>(value.size());
+  arena_.append(value);
+
+  if (id != KnownHeader::Unknown && known_[static_cast<size_t>(id)] == 0 && entries_.size() < UINT16_MAX) {
+    known_[static_cast<size_t>(id)] = static_cast<uint16_t>(entries_.size() + 1);
+  }
+  entries_.push_back(e);
+  materializedValid_ = false;
+}
+
+void HeaderTable::RemoveIf(std::string_view name, KnownHeader id) {
+  if (id != KnownHeader::Unknown && known_[static_cast<size_t>(id)] == 0) return;
+
+  size_t kept = 0;
+  for (size_t i = 0; i < entries_.size(); ++i) {
+    const auto& e = entries_[i];
+    bool match = id != KnownHeader::Unknown ? e.id == id
+                                            : (e.name_len == name.size() && EqualsLowered(name, View(e.name_off, e.name_len)));
+    if (match) {
+      deadBytes_ += e.name_len + e.value_len;
+    } else {
+      entries_[kept++] = e;
+    }
+  }
+  if (kept == entries_.size()) return;
+  entries_.resize(kept);
+  RebuildKnownIndex();
+  materializedValid_ = false;
+}
+
+void HeaderTable::RebuildKnownIndex() {
+  known_.fill(0);
+  const size_t limit = entries_.size() < UINT16_MAX ? entries_.size() : UINT16_MAX - 1;
+  for (size_t i = 0; i < limit; ++i) {
+    KnownHeader id = entries_[i].id;
+    if (id != KnownHeader::Unknown && known_[static_cast<size_t>(id)] == 0) {
+      known_[static_cast<size_t>(id)] = static_cast<uint16_t>(i + 1);
+    }
+  }
+}
+
+void HeaderTable::MaybeCompact() {
+  // 反复 Set 同一头部会在 arena 中累积废弃字节，超过一半时重新紧凑排列；
+  // 在写入新值之后才整理，新值可能就是指向旧 arena 的视图
+  if (deadBytes_ <= 256 || deadBytes_ * 2 <= arena_.size()) return;
+  std::string packed;
+  packed.reserve(arena_.size() - deadBytes_);
+  for (auto& e : entries_) {
+    uint32_t name_off = static_cast<uint32_t>(packed.size());
+    packed.append(arena_, e.name_off, e.name_len);
+    uint32_t value_off = static_cast<uint32_t>(packed.size());
+    packed.append(arena_, e.value_off, e.value_len);
+    e.name_off = name_off;
+    e.value_off = value_off;
+  }
+  arena_.swap(packed);
+  deadBytes_ = 0;
+}
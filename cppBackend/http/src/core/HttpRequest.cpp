@@ -1,6 +1,29 @@
 #include"core/HttpRequest.h"
 #include "util/HttpStringUtil.h"
 
+namespace {
+
+// 已是规范形式的路径：以 '/' 开头，只含可见 ASCII 字符，没有查询串、片段、转义、'+'、空段、
+// "."/".." 段与结尾的 '/'。对它解码与规范化都不会改变结果
+bool IsCanonicalPlainPath(std::string_view url) {
+  if (url.empty() || url[0] != '/') return false;
+  if (url.size() > 1 && url.back() == '/') return false;
+  size_t seg_start = 1;
+  for (size_t i = 1; i <= url.size(); ++i) {
+    if (i == url.size() || url[i] == '/') {
+      std::string_view seg = url.substr(seg_start, i - seg_start);
+      if ((seg.empty() && url.size() > 1) || seg == "." || seg == "..") return false;
+      seg_start = i + 1;
+      continue;
+    }
+    unsigned char c = static_cast<unsigned char>(url[i]);
+    if (c <= 0x20 || c >= 0x7f || c == '%' || c == '+' || c == '?' || c == '#') return false;
+  }
+  return true;
+}
+
+}  // namespace
+
 const std::unordered_map<std::string,HttpMethod> HttpRequest::s_strMethod = {
   {"get",HttpMethod::GET},
   {"post",HttpMethod::POST},
@@ -16,25 +39,29 @@ const std::unordered_map<std::string,HttpMethod> HttpRequest::s_strMethod = {
 HttpRequest::HttpRequest(const HttpRequest& other) 
     :version_(other.version_),
     headers_(other.headers_),
-    headerIndexMap_(other.headerIndexMap_),
     body_(other.body_),
     contentEncoding_(other.contentEncoding_),
     method_(other.method_),
     url_(other.url_),
     path_(other.path_),
-    queryParams_(other.queryParams_) {}
+    queryParams_(other.queryParams_),
+    cancelToken_(other.cancelToken_),
+    deferredBodyLength_(other.deferredBodyLength_),
+    bodySink_(other.bodySink_) {}
 
 
 HttpRequest::HttpRequest(HttpRequest && other) noexcept 
   :version_(other.version_),
   headers_(std::move(other.headers_)),
-  headerIndexMap_(std::move(other.headerIndexMap_)),
   body_(std::move(other.body_)),
   contentEncoding_(other.contentEncoding_),
   method_(other.method_),
   url_(std::move(other.url_)),
   path_(std::move(other.path_)),
-  queryParams_(std::move(other.queryParams_)) {
+  queryParams_(std::move(other.queryParams_)),
+  cancelToken_(std::move(other.cancelToken_)),
+  deferredBodyLength_(other.deferredBodyLength_),
+  bodySink_(std::move(other.bodySink_)) {
   other.version_ = HttpVersion::HTTP_1_1;
   other.contentEncoding_ = HttpContentEncoding::IDENTITY;
   other.method_ = HttpMethod::GET;
@@ -44,13 +71,15 @@ HttpRequest& HttpRequest::operator=(const HttpRequest& other) {
   if(&other == this) return *this;
   version_=other.version_;
   headers_=other.headers_;
-  headerIndexMap_=other.headerIndexMap_;
   body_=other.body_;
   contentEncoding_=other.contentEncoding_;
   method_=other.method_;
   url_=other.url_;
   path_=other.path_;
   queryParams_=other.queryParams_;
+  cancelToken_=other.cancelToken_;
+  deferredBodyLength_=other.deferredBodyLength_;
+  bodySink_=other.bodySink_;
 
   return *this;
 }
@@ -59,13 +88,15 @@ HttpRequest& HttpRequest::operator=(HttpRequest&& other) noexcept {
   if(&other == this) return *this;
   version_=other.version_;
   headers_=std::move(other.headers_);
-  headerIndexMap_=std::move(other.headerIndexMap_);
   body_=std::move(other.body_);
   contentEncoding_=other.contentEncoding_;
   method_=std::move(other.method_);
   url_=std::move(other.url_);
   path_=std::move(other.path_);
   queryParams_=std::move(other.queryParams_);
+  cancelToken_=std::move(other.cancelToken_);
+  deferredBodyLength_=other.deferredBodyLength_;
+  bodySink_=std::move(other.bodySink_);
 
   other.version_ = HttpVersion::HTTP_1_1;
   other.contentEncoding_ = HttpContentEncoding::IDENTITY;
@@ -74,83 +105,51 @@ HttpRequest& HttpRequest::operator=(HttpRequest&& other) noexcept {
 }
 
 void HttpRequest::SetHeader(const std::string& key,const std::string& value) {
-  std::string normalized_key = normalizeHeaderKey(key);
-  // 移除所有相同名称的头部并重建索引，避免 erase 导致的下标漂移
-  headerIndexMap_.erase(normalized_key);
-
-  for(auto it = headers_.begin(); it != headers_.end();) {
-    if(it->first == normalized_key) {
-      it = headers_.erase(it);
-    } else {
-      ++it;
-    }
-  }
-
-  headers_.emplace_back(normalized_key, value);
-  rebuildHeaderIndex();
+  headers_.Set(key, value);
 }
 
 void HttpRequest::AppendHeader(const std::string& key,const std::string& value) {
-  std::string normalized_key = normalizeHeaderKey(key);
-  headers_.emplace_back(normalized_key, value);
-  headerIndexMap_[normalized_key].push_back(headers_.size() - 1);
+  headers_.Append(key, value);
 }
 
 void HttpRequest::AppendHeader(const std::vector<std::pair<std::string,std::string>>& headers) {
-  headers_.reserve(headers_.size()+headers.size());
-
   for(auto &pair:headers) {
-    std::string normalized_key = normalizeHeaderKey(pair.first);
-    headers_.emplace_back(normalized_key, pair.second);
-    headerIndexMap_[normalized_key].push_back(headers_.size() - 1);
+    headers_.Append(pair.first, pair.second);
   }
 }
 
 std::optional<std::string> HttpRequest::GetHeader(const std::string& key) const {
-  std::string normal_key = normalizeHeaderKey(key);
-  auto it = headerIndexMap_.find(normal_key);
-  if(it != headerIndexMap_.end() && !it->second.empty()) {
-    return headers_[it->second[0]].second;
-  }
+  auto view = headers_.Get(key);
+  if (view) return std::string(*view);
   return std::nullopt;
 }
 
 std::vector<std::string> HttpRequest::GetHeaders(const std::string& key) const {
   std::vector<std::string> heads;
-  std::string normal_key = normalizeHeaderKey(key);
-  
-  auto it = headerIndexMap_.find(normal_key);
-  if(it != headerIndexMap_.end()) {
-    for(size_t index : it->second) {
-      heads.emplace_back(headers_[index].second);
-    }
+  for (std::string_view value : headers_.GetAll(key)) {
+    heads.emplace_back(value);
   }
   return heads;
 }
 
-
 const std::vector<std::pair<std::string,std::string>>& HttpRequest::GetAllHeaders() const {
-  return headers_;
+  return headers_.Materialized();
+}
+
+size_t HttpRequest::HeaderCount() const {
+  return headers_.Size();
+}
+
+void HttpRequest::ForEachHeader(const HeaderVisitor& fn) const {
+  headers_.ForEach(fn);
 }
 
 bool HttpRequest::HasHeader(const std::string& key) const {
-  std::string normal_key = normalizeHeaderKey(key);
-  return headerIndexMap_.find(normal_key) != headerIndexMap_.end();
+  return headers_.Has(key);
 }
 
 void HttpRequest::RemoveHeader(const std::string& key) {
-  std::string normal_key = normalizeHeaderKey(key);
-  headerIndexMap_.erase(normal_key);
-
-  // 从headers_中移除所有相同名称的头部
-  for(auto it = headers_.begin(); it != headers_.end();) {
-    if(it->first == normal_key) {
-      it = headers_.erase(it);
-    } else {
-      ++it;
-    }
-  }
-  rebuildHeaderIndex();
+  headers_.Remove(key);
 }
 
 //void HttpRequest::SetBinaryBody(const char* binary, size_t length);
@@ -192,8 +191,7 @@ void HttpRequest::AppendBodyChunk(const char* data,size_t len) {
 }
 
 void HttpRequest::Clear() {
-  headers_.clear();
-  headerIndexMap_.clear();
+  headers_.Clear();
   body_.clear();
   url_.clear();
   path_ = "/";
@@ -201,26 +199,27 @@ void HttpRequest::Clear() {
   method_ = HttpMethod::GET;
   version_ = HttpVersion::HTTP_1_1;
   contentEncoding_ = HttpContentEncoding::IDENTITY;
+  cancelToken_.reset();
+  deferredBodyLength_ = 0;
+  bodySink_.reset();
 }
 
-void HttpRequest::ClearHeaders() {
-  headers_.clear();
-  headerIndexMap_.clear();
+void HttpRequest::ResetForReuse(std::string& raw_head, std::vector<HeaderTable::Entry>& entries) {
+  headers_.Release(raw_head, entries);
+  if (body_.capacity() > kMaxRetainedBodyBytes) {
+    std::string().swap(body_);
+  }
+  Clear();
 }
 
-void HttpRequest::rebuildHeaderIndex() {
-  headerIndexMap_.clear();
-  for(size_t i = 0; i < headers_.size(); ++i) {
-    headerIndexMap_[headers_[i].first].push_back(i);
-  }
+void HttpRequest::ClearHeaders() {
+  headers_.Clear();
 }
 
 std::string HttpRequest::Serialize() const {
   std::string result = GetMethodString() + " " + url_ + " " + GetVersionStr() + "\r\n";
-
-  for(const auto& pair : headers_) {
-    result += pair.first + ": " + pair.second + "\r\n";
-  }
+  result.reserve(result.size() + headers_.SerializedSize() + 2 + body_.size());
+  headers_.AppendTo(result);
 
   result += "\r\n";
   
@@ -297,17 +296,18 @@ bool HttpRequest::RemoveQueryParam(const std::string& key) {
   return false;
 }
 
-std::string HttpRequest::normalizeHeaderKey(const std::string& key) const {
-  std::string_view trimmed = TrimAsciiWhitespace(key);
-  return LowerAsciiCopy(trimmed);
-}
-
 void HttpRequest::ParseUrl() {
   if(url_.empty()){
     path_ = "/";
     queryParams_.clear();
     return;
   }
+  // 常见的简单路径直接复用 path_ 的容量，不经过解码、规范化与重建 URL 的临时字符串
+  if (IsCanonicalPlainPath(url_)) {
+    path_.assign(url_);
+    queryParams_.clear();
+    return;
+  }
 
   std::string tmp = url_;
   std::string path, query, fragment;
@@ -1,5 +1,8 @@
 #include"core/HttpResponse.h"
+#include <array>
 #include <cctype>
+#include <charconv>
+#include "util/HttpDate.h"
 #include "util/HttpStringUtil.h"
 
 HttpResponse::HttpResponse() : 
@@ -17,72 +20,48 @@ HttpResponse::HttpResponse(HttpStatusCode statuscode) :
 }
 
 void HttpResponse::SetHeader(const std::string& key,const std::string& value) {
-  std::string normalized_key = normalizeHeaderKey(key);
-  for(auto it = headers_.begin(); it != headers_.end();) {
-    if(it->first == normalized_key) {
-      it = headers_.erase(it);
-    } else {
-      ++it;
-    }
-  }
-  headers_.emplace_back(normalized_key,value);
+  headers_.Set(key, value);
 }
 
 void HttpResponse::AppendHeader(const std::string& key,const std::string& value) {
-  headers_.emplace_back(normalizeHeaderKey(key),value);
+  headers_.Append(key, value);
 }
 
 void HttpResponse::AppendHeader(const std::vector<std::pair<std::string,std::string>>& headers) {
-  headers_.reserve(headers_.size()+headers.size());
-
   for(auto &pair:headers) {
-    headers_.emplace_back(normalizeHeaderKey(pair.first),pair.second);
+    headers_.Append(pair.first, pair.second);
   }
 }
 
 std::optional<std::string> HttpResponse::GetHeader(const std::string& key) const {
-  std::string normal_key = normalizeHeaderKey(key);
-  for(auto & pair : headers_) {
-    if (pair.first == normal_key) {
-      return pair.second;
-    }
-  }
+  auto view = headers_.Get(key);
+  if (view) return std::string(*view);
   return std::nullopt;
 }
 
 std::vector<std::string> HttpResponse::GetHeaders(const std::string& key) const {
   std::vector<std::string> heads;
-  std::string normal_key = normalizeHeaderKey(key);
-   for(auto & pair : headers_) {
-    if (pair.first == normal_key) {
-      heads.emplace_back(pair.second);
-    }
+  for (std::string_view value : headers_.GetAll(key)) {
+    heads.emplace_back(value);
   }
   return heads;
 }
 
 bool HttpResponse::HasHeader(const std::string& key)const {
-  std::string normal_key = normalizeHeaderKey(key);
-  for(auto & pair : headers_) {
-    if(pair.first == normal_key) return true;
-  }
-  return false;
+  return headers_.Has(key);
 }
 
 const std::vector<std::pair<std::string,std::string>>& HttpResponse::GetAllHeaders()const {
-  return headers_;
+  return headers_.Materialized();
 }
 
 void HttpResponse::RemoveHeader(const std::string& key) {
-  std::string normal_key = normalizeHeaderKey(key);
-  for(auto it = headers_.begin(); it != headers_.end();) {
-    if(it->first == normal_key) it = headers_.erase(it);
-    else ++it;
-  }
+  headers_.Remove(key);
 }
 
 void HttpResponse::ClearHeaders() {
-  headers_.clear();
+  headers_.Clear();
+  prerendered_cors_ = false;
 }
 
 //http版本操作
@@ -117,10 +96,13 @@ void HttpResponse::Clear() {
   version_ = HttpVersion::HTTP_1_1;
   statusCode_ = HttpStatusCode::OK;
   statusReason_ = "OK";
-  headers_.clear();
+  headers_.Clear();
   body_.clear();
   contentEncoding_ = HttpContentEncoding::IDENTITY;
+  prerendered_ = nullptr;
+  prerendered_cors_ = false;
   ClearSendFile();
+  body_producer_.reset();
 }
 
 std::string HttpResponse::GetContentEncodingStr() const {
@@ -178,21 +160,139 @@ void HttpResponse::SetStatusCodeInt(int code) {
   }
 }
 
-std::string HttpResponse::Serialize() const {
-  std::string result = GetVersionStr() + " " + std::to_string(static_cast<int>(statusCode_)) + " " + statusReason_ + "\r\n";
+namespace {
+
+constexpr std::string_view kContentLengthPrefix = "content-length: ";
+constexpr std::string_view kDatePrefix = "date: ";
+
+// "HTTP/1.x <code> <默认原因短语>\r\n"，按状态码下标，只生成有默认原因短语的状态码
+struct StatusLineTable {
+  std::array<std::string, 600> http11;
+  std::array<std::string, 600> http10;
+};
+
+// 逐行访问预渲染块中的 "name: value\r\n"
+void VisitHeaderLines(std::string_view block, const IHttpMessage::HeaderVisitor& fn) {
+  while (!block.empty()) {
+    size_t eol = block.find("\r\n");
+    std::string_view line = block.substr(0, eol);
+    block = eol == std::string_view::npos ? std::string_view() : block.substr(eol + 2);
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos) continue;
+    fn(line.substr(0, colon), TrimAsciiWhitespace(line.substr(colon + 1)));
+  }
+}
+
+}  // namespace
+
+std::string_view HttpResponse::CachedStatusLine() const {
+  static const StatusLineTable table = [] {
+    StatusLineTable t;
+    for (int code = 100; code < 600; ++code) {
+      std::string reason = GetDefaultReason(static_cast<HttpStatusCode>(code));
+      if (reason == "Unknown Status") continue;
+      std::string tail = " " + std::to_string(code) + " " + reason + "\r\n";
+      t.http11[code] = "HTTP/1.1" + tail;
+      t.http10[code] = "HTTP/1.0" + tail;
+    }
+    return t;
+  }();
+
+  const int code = static_cast<int>(statusCode_);
+  if (code < 100 || code >= 600) return std::string_view();
+  const std::string* line = nullptr;
+  if (version_ == HttpVersion::HTTP_1_1) line = &table.http11[code];
+  else if (version_ == HttpVersion::HTTP_1_0) line = &table.http10[code];
+  if (!line || line->empty()) return std::string_view();
+
+  // 自定义原因短语不能使用缓存
+  std::string_view cached_reason = std::string_view(*line).substr(13, line->size() - 15);
+  if (cached_reason != statusReason_) return std::string_view();
+  return *line;
+}
+
+bool HttpResponse::NeedsContentLength() const {
+  return !headers_.Has(KnownHeader::ContentLength) && !headers_.Has(KnownHeader::TransferEncoding);
+}
+
+size_t HttpResponse::PrerenderedSize() const {
+  if (!prerendered_) return 0;
+  size_t size = prerendered_->common.size();
+  if (prerendered_->date && !headers_.Has(KnownHeader::Date)) size += kDatePrefix.size() + kHttpDateLen + 2;
+  if (prerendered_cors_) size += prerendered_->cors.size();
+  return size;
+}
 
-  if (!HasHeader("Content-Length") && !HasHeader("Transfer-Encoding")) {
-    result += "content-length: " + std::to_string(body_.size()) + "\r\n";
+void HttpResponse::AppendPrerendered(std::string& out) const {
+  if (!prerendered_) return;
+  if (prerendered_->date && !headers_.Has(KnownHeader::Date)) {
+    out.append(kDatePrefix).append(CachedHttpDate()).append("\r\n");
   }
+  out.append(prerendered_->common);
+  if (prerendered_cors_) out.append(prerendered_->cors);
+}
 
-  for(auto &pair : headers_) {
-    result += pair.first + ": " + pair.second + "\r\n";
+void HttpResponse::ForEachWireHeader(const HeaderVisitor& fn) const {
+  if (NeedsContentLength()) {
+    char digits[24];
+    auto res = std::to_chars(digits, digits + sizeof(digits), body_.size());
+    fn(KnownHeaderName(KnownHeader::ContentLength), std::string_view(digits, static_cast<size_t>(res.ptr - digits)));
   }
+  if (prerendered_) {
+    if (prerendered_->date && !headers_.Has(KnownHeader::Date)) {
+      fn(KnownHeaderName(KnownHeader::Date), CachedHttpDate());
+    }
+    VisitHeaderLines(prerendered_->common, fn);
+    if (prerendered_cors_) VisitHeaderLines(prerendered_->cors, fn);
+  }
+  headers_.ForEach(fn);
+}
+
+size_t HttpResponse::SerializedSize() const {
+  size_t size = 0;
+  std::string_view status_line = CachedStatusLine();
+  if (!status_line.empty()) {
+    size += status_line.size();
+  } else {
+    size += GetVersionStr().size() + 1 + std::to_string(static_cast<int>(statusCode_)).size() + 1 +
+            statusReason_.size() + 2;
+  }
+  if (NeedsContentLength()) {
+    char digits[24];
+    auto res = std::to_chars(digits, digits + sizeof(digits), body_.size());
+    size += kContentLengthPrefix.size() + static_cast<size_t>(res.ptr - digits) + 2;
+  }
+  size += PrerenderedSize() + headers_.SerializedSize() + 2;
+  return size + body_.size();
+}
 
-  result += "\r\n";
+void HttpResponse::SerializeHeadTo(std::string& out) const {
+  out.reserve(out.size() + SerializedSize() - body_.size());
 
-  result += body_;
+  std::string_view status_line = CachedStatusLine();
+  if (!status_line.empty()) {
+    out.append(status_line);
+  } else {
+    out.append(GetVersionStr()).append(" ").append(std::to_string(static_cast<int>(statusCode_)))
+       .append(" ").append(statusReason_).append("\r\n");
+  }
 
+  if (NeedsContentLength()) {
+    char digits[24];
+    auto res = std::to_chars(digits, digits + sizeof(digits), body_.size());
+    out.append(kContentLengthPrefix).append(digits, static_cast<size_t>(res.ptr - digits)).append("\r\n");
+  }
+
+  AppendPrerendered(out);
+  headers_.AppendTo(out);
+  out.append("\r\n");
+}
+
+std::string HttpResponse::Serialize() const {
+  std::string result;
+  result.reserve(SerializedSize());
+  SerializeHeadTo(result);
+  result.append(body_);
   return result;
 }
 
@@ -213,10 +313,7 @@ void HttpResponse::AppendRawHeaderLine(std::string_view line) {
   std::string_view key_view = line.substr(0, pos);
   std::string_view value_view = line.substr(pos + 1);
 
-  std::string normalized_key = normalizeHeaderKey(trim(key_view));
-  std::string value_str(trim(value_view));
-
-  headers_.emplace_back(std::move(normalized_key),std::move(value_str));
+  headers_.Append(trim(key_view), trim(value_view));
 }
 
 void HttpResponse::AppendBodyChunk(const char* data,size_t len) {
@@ -239,6 +336,19 @@ void HttpResponse::ClearSendFile(){
   send_file_length_ = 0;
 }
 
+void HttpResponse::SetBodyProducer(std::shared_ptr<BodyProducer> producer){
+  body_.clear();
+  headers_.Remove("Content-Length");
+  headers_.Remove("Transfer-Encoding");
+  const int64_t length = producer ? producer->Length() : 0;
+  if (length >= 0) {
+    headers_.Set(KnownHeader::ContentLength, std::to_string(length));
+  } else {
+    headers_.Set(KnownHeader::TransferEncoding, "chunked");
+  }
+  body_producer_ = std::move(producer);
+}
+
 std::string HttpResponse::GetDefaultReason(HttpStatusCode statusCode) {
   switch (statusCode) {
     case HttpStatusCode::CONTINUE: return "Continue";
@@ -290,8 +400,3 @@ std::string HttpResponse::trim(std::string_view& view) {
 
   return std::string(view.substr(key_start, key_end - key_start));
 }
-
-std::string HttpResponse::normalizeHeaderKey(const std::string& key) const {
-  std::string_view trimmed = TrimAsciiWhitespace(key);
-  return LowerAsciiCopy(trimmed);
-}
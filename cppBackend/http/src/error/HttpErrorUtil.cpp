@@ -43,6 +43,7 @@ std::string ToString(HttpErrc code) {
     case HttpErrc::VALIDATION_RATE_LIMITED: return "VALIDATION_RATE_LIMITED";
     case HttpErrc::VALIDATION_FAILED: return "VALIDATION_FAILED";
     case HttpErrc::ROUTE_NOT_FOUND: return "ROUTE_NOT_FOUND";
+    case HttpErrc::ROUTE_EXECUTOR_OVERLOADED: return "ROUTE_EXECUTOR_OVERLOADED";
     case HttpErrc::INTERNAL_ERROR: return "INTERNAL_ERROR";
   }
   return "UNKNOWN";
@@ -1,12 +1,14 @@
 #include "handler/ProtocolValidationHandler.h"
 
+#include <charconv>
+
 #include "core/HttpRequest.h"
 #include "core/IHttpMessage.h"
 #include "error/HttpError.h"
 
 bool ProtocolValidationHandler::Handle(IHttpMessage& message, HttpError& error) {
-  auto contentLength = message.GetHeader("Content-Length");
-  auto transferEncoding = message.GetHeader("Transfer-Encoding");
+  auto contentLength = message.GetHeaderView(KnownHeader::ContentLength);
+  auto transferEncoding = message.GetHeaderView(KnownHeader::TransferEncoding);
 
   // Content-Length 与 Transfer-Encoding 不应同时出现
   if (contentLength && transferEncoding) {
@@ -22,9 +24,9 @@ bool ProtocolValidationHandler::Handle(IHttpMessage& message, HttpError& error)
   // Content-Length 必须为合法数字，且与已累积的 body 长度一致
   if (contentLength) {
     size_t len = 0;
-    try {
-      len = std::stoull(*contentLength);
-    } catch (...) {
+    auto parsed = std::from_chars(contentLength->data(), contentLength->data() + contentLength->size(), len);
+    if (contentLength->empty() || parsed.ec != std::errc() ||
+        parsed.ptr != contentLength->data() + contentLength->size()) {
       error.code = HttpErrc::VALIDATION_CONTENT_LENGTH_INVALID;
       error.status = HttpStatusCode::BAD_REQUEST;
       error.message = "Bad Request";
@@ -45,9 +47,9 @@ bool ProtocolValidationHandler::Handle(IHttpMessage& message, HttpError& error)
   }
 
   // HTTP/1.1 请求必须携带 Host，方法不可未知，路径不能为空
-  if (auto* request = dynamic_cast<HttpRequest*>(&message)) {
+  if (auto* request = AsHttpRequest(&message)) {
     if (request->GetVersion() == HttpVersion::HTTP_1_1 &&
-        !request->HasHeader("Host")) {
+        !request->GetHeaderView(KnownHeader::Host)) {
       error.code = HttpErrc::VALIDATION_MISSING_HOST;
       error.status = HttpStatusCode::BAD_REQUEST;
       error.message = "Bad Request";
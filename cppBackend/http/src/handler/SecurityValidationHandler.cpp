@@ -3,11 +3,35 @@
 #include "core/HttpRequest.h"
 #include "core/IHttpMessage.h"
 #include "error/HttpError.h"
-#include "util/HttpStringUtil.h"
+#include "../../logger/log_fac.h"
 #include <algorithm>
-#include <cctype>
+#include <charconv>
+#include <cstdlib>
 #include <string>
 
+namespace {
+
+// 进程级默认规则：首次使用时编译一次，之后所有连接共享，请求路径上不再读取配置
+std::shared_ptr<const PatternScanner> DefaultPatternScanner() {
+  static const std::shared_ptr<const PatternScanner> scanner = [] {
+    const char* file = std::getenv("HTTP_SECURITY_RULES");
+    if (file && *file) {
+      std::string error;
+      auto loaded = PatternScanner::LoadFromFile(file, &error);
+      if (loaded) {
+        LOGINFO("[Security] loaded " + std::to_string(loaded->Rules().size()) + " pattern rules from " + file);
+        return loaded;
+      }
+      LOGWARNING("[Security] " + error + ", falling back to built-in rules");
+    }
+    return std::make_shared<const PatternScanner>(PatternScanner::DefaultRules(),
+                                                  std::vector<std::string>{"referer", "user-agent"});
+  }();
+  return scanner;
+}
+
+}  // namespace
+
 SecurityValidationHandler::SecurityValidationHandler(
     size_t max_body_size,
     size_t max_url_length,
@@ -17,6 +41,7 @@ SecurityValidationHandler::SecurityValidationHandler(
   , maxUrlLength_(max_url_length)
   , maxHeaderCount_(max_header_count)
   , maxHeaderValueLength_(max_header_value_length)
+  , scanner_(DefaultPatternScanner())
 {
   // 默认允许的HTTP方法白名单
   allowedMethods_ = {
@@ -35,7 +60,7 @@ bool SecurityValidationHandler::Handle(IHttpMessage& message, HttpError& error)
     return CallNext(message, error);
   }
 
-  auto* request = dynamic_cast<HttpRequest*>(&message);
+  auto* request = AsHttpRequest(&message);
   if (!request) {
     return false;
   }
@@ -69,8 +94,10 @@ bool SecurityValidationHandler::Handle(IHttpMessage& message, HttpError& error)
     return false;
   }
 
-  // 4. 检查路径安全性（防止路径遍历攻击）
-  if (!CheckPathSecurity(request->GetPath())) {
+  // 4. 检查路径安全性（防止路径遍历攻击）；路径、URL、请求头的模式扫描在这里一次完成，结果供第 6 步复用
+  const PatternScanner::Rule* hit = FindSuspiciousPattern(*request);
+  if (!CheckPathSecurity(request->GetPath()) ||
+      (hit && hit->kind == PatternScanner::RuleKind::Traversal)) {
     error.code = HttpErrc::VALIDATION_PATH_UNSAFE;
     error.status = HttpStatusCode::FORBIDDEN;
     error.message = "Forbidden";
@@ -79,9 +106,8 @@ bool SecurityValidationHandler::Handle(IHttpMessage& message, HttpError& error)
     return false;
   }
 
-  // 5. 检查Header数量和大小
-  const auto& headers = message.GetAllHeaders();
-  if (headers.size() > maxHeaderCount_) {
+  // 5. 检查Header数量和大小（遍历视图，不物化请求头）
+  if (message.HeaderCount() > maxHeaderCount_) {
     error.code = HttpErrc::VALIDATION_HEADERS_TOO_MANY;
     error.status = HttpStatusCode::REQUEST_HEADER_FIELDS_TOO_LARGE;
     error.message = "Request Header Fields Too Large";
@@ -89,16 +115,22 @@ bool SecurityValidationHandler::Handle(IHttpMessage& message, HttpError& error)
     error.ctx.detail = "too many headers";
     return false;
   }
-  for (const auto& header : headers) {
-    if (header.second.length() > maxHeaderValueLength_) {
-      error.code = HttpErrc::VALIDATION_HEADER_VALUE_TOO_LARGE;
-      error.status = HttpStatusCode::REQUEST_HEADER_FIELDS_TOO_LARGE;
-      error.message = "Request Header Fields Too Large";
-      error.ctx.stage = HttpErrorStage::VALIDATION;
-      error.ctx.header_key = header.first;
-      error.ctx.detail = "header value too large";
-      return false;
+  std::string_view oversized_key;
+  bool oversized = false;
+  message.ForEachHeader([&](std::string_view key, std::string_view value) {
+    if (!oversized && value.length() > maxHeaderValueLength_) {
+      oversized = true;
+      oversized_key = key;
     }
+  });
+  if (oversized) {
+    error.code = HttpErrc::VALIDATION_HEADER_VALUE_TOO_LARGE;
+    error.status = HttpStatusCode::REQUEST_HEADER_FIELDS_TOO_LARGE;
+    error.message = "Request Header Fields Too Large";
+    error.ctx.stage = HttpErrorStage::VALIDATION;
+    error.ctx.header_key = std::string(oversized_key);
+    error.ctx.detail = "header value too large";
+    return false;
   }
   if (!CheckHeaders(message)) {
     error.code = HttpErrc::VALIDATION_FAILED;
@@ -110,19 +142,24 @@ bool SecurityValidationHandler::Handle(IHttpMessage& message, HttpError& error)
   }
 
   // 6. 检查可疑字符和模式
-  if (!CheckSuspiciousPatterns(*request)) {
+  if (hit) {
     error.code = HttpErrc::VALIDATION_SUSPICIOUS_PATTERN;
     error.status = HttpStatusCode::BAD_REQUEST;
     error.message = "Bad Request";
     error.ctx.stage = HttpErrorStage::VALIDATION;
     error.ctx.path = request->GetPath();
     error.ctx.url = request->GetUrl();
+    error.ctx.detail = "pattern: " + hit->pattern;
     return false;
   }
 
   return CallNext(message, error);
 }
 
+void SecurityValidationHandler::SetPatternScanner(std::shared_ptr<const PatternScanner> scanner) {
+  scanner_ = scanner ? std::move(scanner) : DefaultPatternScanner();
+}
+
 bool SecurityValidationHandler::IsMethodAllowed(HttpMethod method) const {
   return std::find(allowedMethods_.begin(), allowedMethods_.end(), method) 
          != allowedMethods_.end();
@@ -130,14 +167,12 @@ bool SecurityValidationHandler::IsMethodAllowed(HttpMethod method) const {
 
 bool SecurityValidationHandler::CheckBodySize(const IHttpMessage& message) const {
   // 检查Content-Length声明的body大小
-  auto contentLength = message.GetHeader("Content-Length");
+  auto contentLength = message.GetHeaderView(KnownHeader::ContentLength);
   if (contentLength) {
-    try {
-      size_t len = std::stoull(*contentLength);
-      if (len > maxBodySize_) {
-        return false;
-      }
-    } catch (...) {
+    size_t len = 0;
+    auto parsed = std::from_chars(contentLength->data(), contentLength->data() + contentLength->size(), len);
+    if (contentLength->empty() || parsed.ec != std::errc() ||
+        parsed.ptr != contentLength->data() + contentLength->size() || len > maxBodySize_) {
       return false;
     }
   }
@@ -163,20 +198,6 @@ bool SecurityValidationHandler::CheckPathSecurity(const std::string& path) const
     return false;
   }
 
-  // 检查路径遍历攻击：../, ..\, %2e%2e, %2e%2e%2f等
-  std::string lower_path = path;
-  LowerAsciiInPlace(lower_path);
-
-  // 检查常见的路径遍历模式
-  if (lower_path.find("../") != std::string::npos ||
-      lower_path.find("..\\") != std::string::npos ||
-      lower_path.find("%2e%2e%2f") != std::string::npos ||
-      lower_path.find("%2e%2e%5c") != std::string::npos ||
-      lower_path.find("..%2f") != std::string::npos ||
-      lower_path.find("..%5c") != std::string::npos) {
-    return false;
-  }
-
   // 检查绝对路径（Windows和Unix）
   if (path.length() > 0 && (path[0] == '/' || 
       (path.length() > 1 && path[1] == ':'))) {
@@ -195,51 +216,41 @@ bool SecurityValidationHandler::CheckPathSecurity(const std::string& path) const
 }
 
 bool SecurityValidationHandler::CheckHeaders(const IHttpMessage& message) const {
-  const auto& headers = message.GetAllHeaders();
-  
   // 检查Header数量
-  if (headers.size() > maxHeaderCount_) {
+  if (message.HeaderCount() > maxHeaderCount_) {
     return false;
   }
 
   // 检查每个Header值的大小
-  for (const auto& header : headers) {
-    if (header.second.length() > maxHeaderValueLength_) {
-      return false;
-    }
-  }
-
-  return true;
+  bool ok = true;
+  message.ForEachHeader([&](std::string_view, std::string_view value) {
+    if (value.length() > maxHeaderValueLength_) ok = false;
+  });
+  return ok;
 }
 
-bool SecurityValidationHandler::CheckSuspiciousPatterns(const HttpRequest& request) const {
-  const std::string& path = request.GetPath();
-  const std::string& url = request.GetUrl();
-
-  // 检查SQL注入常见模式（简单检测）
-  std::string lower_path = path;
-  LowerAsciiInPlace(lower_path);
-  
-  // 检查常见的SQL注入关键词（简单检测，实际应该更复杂）
-  std::vector<std::string> suspicious_patterns = {
-    "union select", "drop table", "delete from", 
-    "insert into", "update set", "exec(", "script>"
+// 与单个字段内一致，跨字段同样 Traversal 优先：命中遍历模式立即返回，否则返回首个可疑模式
+const PatternScanner::Rule* SecurityValidationHandler::FindSuspiciousPattern(const HttpRequest& request) const {
+  const PatternScanner::Rule* first = nullptr;
+  auto take = [&first](const PatternScanner::Rule* hit) {
+    if (hit && !first) first = hit;
+    return hit && hit->kind == PatternScanner::RuleKind::Traversal;
   };
-
-  for (const auto& pattern : suspicious_patterns) {
-    if (lower_path.find(pattern) != std::string::npos ||
-        url.find(pattern) != std::string::npos) {
-      return false;
-    }
+  if (take(scanner_->Scan(request.GetPath(), PatternScanner::kScopePath))) {
+    return first;
   }
-
-  // 检查XSS常见模式
-  if (lower_path.find("<script") != std::string::npos ||
-      lower_path.find("javascript:") != std::string::npos ||
-      lower_path.find("onerror=") != std::string::npos ||
-      lower_path.find("onload=") != std::string::npos) {
-    return false;
+  // URL 保留原始编码与查询串，路径之外的部分（如查询参数）也在这一趟里覆盖
+  if (const auto* hit = scanner_->Scan(request.GetUrl(), PatternScanner::kScopeUrl); take(hit)) {
+    return hit;
   }
-
-  return true;
+  if (scanner_->HasScope(PatternScanner::kScopeHeader)) {
+    for (const auto& name : scanner_->ScannedHeaders()) {
+      auto value = request.GetHeaderView(name);
+      if (!value) continue;
+      if (const auto* hit = scanner_->Scan(*value, PatternScanner::kScopeHeader); take(hit)) {
+        return hit;
+      }
+    }
+  }
+  return first;
 }
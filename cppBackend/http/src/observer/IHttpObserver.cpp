@@ -0,0 +1,43 @@
+#include "observer/IHttpObserver.h"
+
+const char* HttpEventKindName(HttpEventKind kind) {
+    switch (kind) {
+        case HttpEventKind::SSL_SKIPPED: return "ssl_skipped";
+        case HttpEventKind::SSL_BEGIN: return "ssl_begin";
+        case HttpEventKind::SSL_HANDSHAKE_NEED_MORE: return "ssl_handshake_need_more";
+        case HttpEventKind::SSL_HANDSHAKE_FAILED: return "ssl_handshake_failed";
+        case HttpEventKind::SSL_HANDSHAKE_DONE: return "ssl_handshake_done";
+        case HttpEventKind::SSL_DECRYPTED: return "ssl_decrypted";
+        case HttpEventKind::SSL_DECRYPT_FAILED: return "ssl_decrypt_failed";
+        case HttpEventKind::PARSE_BEGIN: return "parse_begin";
+        case HttpEventKind::PARSER_CREATED: return "parser_created";
+        case HttpEventKind::PARSER_CREATE_FAILED: return "parser_create_failed";
+        case HttpEventKind::PARSE_NEED_MORE: return "parse_need_more";
+        case HttpEventKind::PARSE_TIMEOUT: return "parse_timeout";
+        case HttpEventKind::PARSE_UNSUPPORTED_VERSION: return "parse_unsupported_version";
+        case HttpEventKind::PARSE_TOO_LARGE: return "parse_too_large";
+        case HttpEventKind::PARSE_FAILED: return "parse_failed";
+        case HttpEventKind::PARSE_DONE: return "parse_done";
+        case HttpEventKind::VALIDATION_BEGIN: return "validation_begin";
+        case HttpEventKind::VALIDATION_FAILED: return "validation_failed";
+        case HttpEventKind::VALIDATION_PASSED: return "validation_passed";
+        case HttpEventKind::ROUTE_BEGIN: return "route_begin";
+        case HttpEventKind::ROUTE_SKIPPED: return "route_skipped";
+        case HttpEventKind::ROUTE_NOT_FOUND: return "route_not_found";
+        case HttpEventKind::ROUTE_HANDLER_REJECTED: return "route_handler_rejected";
+        case HttpEventKind::ROUTE_DONE: return "route_done";
+        case HttpEventKind::MESSAGE_COMPLETE: return "message_complete";
+    }
+    return "unknown";
+}
+
+const char* HttpProcessStageName(HttpProcessStage stage) {
+    switch (stage) {
+        case HttpProcessStage::SSL_PROCESS: return "ssl";
+        case HttpProcessStage::HTTP_PARSE: return "parse";
+        case HttpProcessStage::VALIDATION: return "validation";
+        case HttpProcessStage::ROUTING: return "routing";
+        case HttpProcessStage::COMPLETE: return "complete";
+    }
+    return "unknown";
+}
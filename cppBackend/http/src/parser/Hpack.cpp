@@ -0,0 +1,482 @@
+#include "parsers/Hpack.h"
+
+#include <array>
+#include <charconv>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+struct HuffmanCode {
+  uint32_t code;
+  uint8_t bits;
+};
+
+// RFC 7541 附录 B：按符号 0..255 与 EOS(256) 排列的码字及其位数
+constexpr HuffmanCode kHuffmanCodes[257] = {
+  {0x1ff8, 13}, {0x7fffd8, 23}, {0xfffffe2, 28}, {0xfffffe3, 28},
+  {0xfffffe4, 28}, {0xfffffe5, 28}, {0xfffffe6, 28}, {0xfffffe7, 28},
+  {0xfffffe8, 28}, {0xffffea, 24}, {0x3ffffffc, 30}, {0xfffffe9, 28},
+  {0xfffffea, 28}, {0x3ffffffd, 30}, {0xfffffeb, 28}, {0xfffffec, 28},
+  {0xfffffed, 28}, {0xfffffee, 28}, {0xfffffef, 28}, {0xffffff0, 28},
+  {0xffffff1, 28}, {0xffffff2, 28}, {0x3ffffffe, 30}, {0xffffff3, 28},
+  {0xffffff4, 28}, {0xffffff5, 28}, {0xffffff6, 28}, {0xffffff7, 28},
+  {0xffffff8, 28}, {0xffffff9, 28}, {0xffffffa, 28}, {0xffffffb, 28},
+  {0x14, 6}, {0x3f8, 10}, {0x3f9, 10}, {0xffa, 12},
+  {0x1ff9, 13}, {0x15, 6}, {0xf8, 8}, {0x7fa, 11},
+  {0x3fa, 10}, {0x3fb, 10}, {0xf9, 8}, {0x7fb, 11},
+  {0xfa, 8}, {0x16, 6}, {0x17, 6}, {0x18, 6},
+  {0x0, 5}, {0x1, 5}, {0x2, 5}, {0x19, 6},
+  {0x1a, 6}, {0x1b, 6}, {0x1c, 6}, {0x1d, 6},
+  {0x1e, 6}, {0x1f, 6}, {0x5c, 7}, {0xfb, 8},
+  {0x7ffc, 15}, {0x20, 6}, {0xffb, 12}, {0x3fc, 10},
+  {0x1ffa, 13}, {0x21, 6}, {0x5d, 7}, {0x5e, 7},
+  {0x5f, 7}, {0x60, 7}, {0x61, 7}, {0x62, 7},
+  {0x63, 7}, {0x64, 7}, {0x65, 7}, {0x66, 7},
+  {0x67, 7}, {0x68, 7}, {0x69, 7}, {0x6a, 7},
+  {0x6b, 7}, {0x6c, 7}, {0x6d, 7}, {0x6e, 7},
+  {0x6f, 7}, {0x70, 7}, {0x71, 7}, {0x72, 7},
+  {0xfc, 8}, {0x73, 7}, {0xfd, 8}, {0x1ffb, 13},
+  {0x7fff0, 19}, {0x1ffc, 13}, {0x3ffc, 14}, {0x22, 6},
+  {0x7ffd, 15}, {0x3, 5}, {0x23, 6}, {0x4, 5},
+  {0x24, 6}, {0x5, 5}, {0x25, 6}, {0x26, 6},
+  {0x27, 6}, {0x6, 5}, {0x74, 7}, {0x75, 7},
+  {0x28, 6}, {0x29, 6}, {0x2a, 6}, {0x7, 5},
+  {0x2b, 6}, {0x76, 7}, {0x2c, 6}, {0x8, 5},
+  {0x9, 5}, {0x2d, 6}, {0x77, 7}, {0x78, 7},
+  {0x79, 7}, {0x7a, 7}, {0x7b, 7}, {0x7ffe, 15},
+  {0x7fc, 11}, {0x3ffd, 14}, {0x1ffd, 13}, {0xffffffc, 28},
+  {0xfffe6, 20}, {0x3fffd2, 22}, {0xfffe7, 20}, {0xfffe8, 20},
+  {0x3fffd3, 22}, {0x3fffd4, 22}, {0x3fffd5, 22}, {0x7fffd9, 23},
+  {0x3fffd6, 22}, {0x7fffda, 23}, {0x7fffdb, 23}, {0x7fffdc, 23},
+  {0x7fffdd, 23}, {0x7fffde, 23}, {0xffffeb, 24}, {0x7fffdf, 23},
+  {0xffffec, 24}, {0xffffed, 24}, {0x3fffd7, 22}, {0x7fffe0, 23},
+  {0xffffee, 24}, {0x7fffe1, 23}, {0x7fffe2, 23}, {0x7fffe3, 23},
+  {0x7fffe4, 23}, {0x1fffdc, 21}, {0x3fffd8, 22}, {0x7fffe5, 23},
+  {0x3fffd9, 22}, {0x7fffe6, 23}, {0x7fffe7, 23}, {0xffffef, 24},
+  {0x3fffda, 22}, {0x1fffdd, 21}, {0xfffe9, 20}, {0x3fffdb, 22},
+  {0x3fffdc, 22}, {0x7fffe8, 23}, {0x7fffe9, 23}, {0x1fffde, 21},
+  {0x7fffea, 23}, {0x3fffdd, 22}, {0x3fffde, 22}, {0xfffff0, 24},
+  {0x1fffdf, 21}, {0x3fffdf, 22}, {0x7fffeb, 23}, {0x7fffec, 23},
+  {0x1fffe0, 21}, {0x1fffe1, 21}, {0x3fffe0, 22}, {0x1fffe2, 21},
+  {0x7fffed, 23}, {0x3fffe1, 22}, {0x7fffee, 23}, {0x7fffef, 23},
+  {0xfffea, 20}, {0x3fffe2, 22}, {0x3fffe3, 22}, {0x3fffe4, 22},
+  {0x7ffff0, 23}, {0x3fffe5, 22}, {0x3fffe6, 22}, {0x7ffff1, 23},
+  {0x3ffffe0, 26}, {0x3ffffe1, 26}, {0xfffeb, 20}, {0x7fff1, 19},
+  {0x3fffe7, 22}, {0x7ffff2, 23}, {0x3fffe8, 22}, {0x1ffffec, 25},
+  {0x3ffffe2, 26}, {0x3ffffe3, 26}, {0x3ffffe4, 26}, {0x7ffffde, 27},
+  {0x7ffffdf, 27}, {0x3ffffe5, 26}, {0xfffff1, 24}, {0x1ffffed, 25},
+  {0x7fff2, 19}, {0x1fffe3, 21}, {0x3ffffe6, 26}, {0x7ffffe0, 27},
+  {0x7ffffe1, 27}, {0x3ffffe7, 26}, {0x7ffffe2, 27}, {0xfffff2, 24},
+  {0x1fffe4, 21}, {0x1fffe5, 21}, {0x3ffffe8, 26}, {0x3ffffe9, 26},
+  {0xffffffd, 28}, {0x7ffffe3, 27}, {0x7ffffe4, 27}, {0x7ffffe5, 27},
+  {0xfffec, 20}, {0xfffff3, 24}, {0xfffed, 20}, {0x1fffe6, 21},
+  {0x3fffe9, 22}, {0x1fffe7, 21}, {0x1fffe8, 21}, {0x7ffff3, 23},
+  {0x3fffea, 22}, {0x3fffeb, 22}, {0x1ffffee, 25}, {0x1ffffef, 25},
+  {0xfffff4, 24}, {0xfffff5, 24}, {0x3ffffea, 26}, {0x7ffff4, 23},
+  {0x3ffffeb, 26}, {0x7ffffe6, 27}, {0x3ffffec, 26}, {0x3ffffed, 26},
+  {0x7ffffe7, 27}, {0x7ffffe8, 27}, {0x7ffffe9, 27}, {0x7ffffea, 27},
+  {0x7ffffeb, 27}, {0xffffffe, 28}, {0x7ffffec, 27}, {0x7ffffed, 27},
+  {0x7ffffee, 27}, {0x7ffffef, 27}, {0x7fffff0, 27}, {0x3ffffee, 26},
+  {0x3fffffff, 30},
+};
+
+constexpr uint16_t kHuffmanEos = 256;
+
+// 解码表：按 4 位半字节推进的状态机，状态是 Huffman 树的内部节点（257 个叶子对应 256 个内部节点）；
+// 最短码字 5 位，每个半字节至多产出一个符号
+constexpr uint8_t kHuffmanEmit = 0x1;
+constexpr uint8_t kHuffmanAccept = 0x2;   // 在此状态结束时剩余的位是合法填充（EOS 的前缀，少于 8 位）
+constexpr uint8_t kHuffmanFail = 0x4;
+
+struct HuffmanTransition {
+  uint8_t next;
+  uint8_t flags;
+  uint8_t symbol;
+};
+
+struct HuffmanDecodeTable {
+  HuffmanTransition transitions[256][16];
+
+  HuffmanDecodeTable() {
+    struct Node {
+      int32_t child[2] = {-1, -1};
+      int32_t symbol = -1;
+    };
+    std::vector<Node> nodes(1);
+    for (uint16_t sym = 0; sym <= kHuffmanEos; ++sym) {
+      const HuffmanCode& hc = kHuffmanCodes[sym];
+      int32_t cur = 0;
+      for (int i = hc.bits - 1; i >= 0; --i) {
+        const int bit = (hc.code >> i) & 1;
+        if (nodes[cur].child[bit] < 0) {
+          nodes[cur].child[bit] = static_cast<int32_t>(nodes.size());
+          nodes.emplace_back();
+        }
+        cur = nodes[cur].child[bit];
+      }
+      nodes[cur].symbol = sym;
+    }
+
+    // 内部节点按创建顺序编号，根节点为状态 0
+    std::vector<int32_t> state_of(nodes.size(), -1);
+    std::vector<int32_t> node_of;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+      if (nodes[i].symbol < 0) {
+        state_of[i] = static_cast<int32_t>(node_of.size());
+        node_of.push_back(static_cast<int32_t>(i));
+      }
+    }
+
+    std::array<bool, 256> accepting{};
+    int32_t cur = 0;
+    for (int depth = 0; depth < 8 && cur >= 0 && nodes[cur].symbol < 0; ++depth) {
+      accepting[state_of[cur]] = true;
+      cur = nodes[cur].child[1];
+    }
+
+    for (size_t s = 0; s < node_of.size(); ++s) {
+      for (int nibble = 0; nibble < 16; ++nibble) {
+        HuffmanTransition t{0, 0, 0};
+        int32_t node = node_of[s];
+        for (int i = 3; i >= 0; --i) {
+          node = nodes[node].child[(nibble >> i) & 1];
+          if (node < 0 || nodes[node].symbol == kHuffmanEos) {
+            t.flags = kHuffmanFail;
+            break;
+          }
+          if (nodes[node].symbol >= 0) {
+            t.flags |= kHuffmanEmit;
+            t.symbol = static_cast<uint8_t>(nodes[node].symbol);
+            node = 0;
+          }
+        }
+        if (!(t.flags & kHuffmanFail)) {
+          t.next = static_cast<uint8_t>(state_of[node]);
+          if (accepting[t.next]) t.flags |= kHuffmanAccept;
+        }
+        transitions[s][nibble] = t;
+      }
+    }
+  }
+};
+
+const HuffmanDecodeTable& DecodeTable() {
+  static const HuffmanDecodeTable table;
+  return table;
+}
+
+struct StaticEntry {
+  std::string_view name;
+  std::string_view value;
+};
+
+// RFC 7541 附录 A，下标 0 对应索引 1
+constexpr StaticEntry kStaticTable[kHpackStaticTableSize] = {
+  {":authority", ""},
+  {":method", "GET"},
+  {":method", "POST"},
+  {":path", "/"},
+  {":path", "/index.html"},
+  {":scheme", "http"},
+  {":scheme", "https"},
+  {":status", "200"},
+  {":status", "204"},
+  {":status", "206"},
+  {":status", "304"},
+  {":status", "400"},
+  {":status", "404"},
+  {":status", "500"},
+  {"accept-charset", ""},
+  {"accept-encoding", "gzip, deflate"},
+  {"accept-language", ""},
+  {"accept-ranges", ""},
+  {"accept", ""},
+  {"access-control-allow-origin", ""},
+  {"age", ""},
+  {"allow", ""},
+  {"authorization", ""},
+  {"cache-control", ""},
+  {"content-disposition", ""},
+  {"content-encoding", ""},
+  {"content-language", ""},
+  {"content-length", ""},
+  {"content-location", ""},
+  {"content-range", ""},
+  {"content-type", ""},
+  {"cookie", ""},
+  {"date", ""},
+  {"etag", ""},
+  {"expect", ""},
+  {"expires", ""},
+  {"from", ""},
+  {"host", ""},
+  {"if-match", ""},
+  {"if-modified-since", ""},
+  {"if-none-match", ""},
+  {"if-range", ""},
+  {"if-unmodified-since", ""},
+  {"last-modified", ""},
+  {"link", ""},
+  {"location", ""},
+  {"max-forwards", ""},
+  {"proxy-authenticate", ""},
+  {"proxy-authorization", ""},
+  {"range", ""},
+  {"referer", ""},
+  {"refresh", ""},
+  {"retry-after", ""},
+  {"server", ""},
+  {"set-cookie", ""},
+  {"strict-transport-security", ""},
+  {"transfer-encoding", ""},
+  {"user-agent", ""},
+  {"vary", ""},
+  {"via", ""},
+  {"www-authenticate", ""},
+};
+
+// 名称 -> (首个索引, 同名条目数)；同名条目在静态表中连续排列
+const std::unordered_map<std::string_view, std::pair<uint8_t, uint8_t>>& StaticNameIndex() {
+  static const auto index = [] {
+    std::unordered_map<std::string_view, std::pair<uint8_t, uint8_t>> m;
+    for (size_t i = 0; i < kHpackStaticTableSize; ++i) {
+      auto [it, inserted] = m.emplace(kStaticTable[i].name, std::make_pair(static_cast<uint8_t>(i + 1), uint8_t{0}));
+      ++it->second.second;
+    }
+    return m;
+  }();
+  return index;
+}
+
+bool DecodeInteger(const uint8_t*& p, const uint8_t* end, uint8_t prefix_bits, uint64_t& value) {
+  if (p == end) return false;
+  const uint8_t mask = static_cast<uint8_t>((1u << prefix_bits) - 1);
+  value = *p++ & mask;
+  if (value < mask) return true;
+  for (unsigned shift = 0; p < end; shift += 7) {
+    // 超过 32 位的整数在 HTTP/2 中没有合法用途，直接视为压缩错误，顺带排除移位溢出
+    if (shift > 28) return false;
+    const uint8_t b = *p++;
+    value += static_cast<uint64_t>(b & 0x7f) << shift;
+    if (!(b & 0x80)) return true;
+  }
+  return false;
+}
+
+// 未经 Huffman 编码的字符串直接返回输入中的视图，否则解码到 scratch
+bool DecodeString(const uint8_t*& p, const uint8_t* end, std::string& scratch, std::string_view& out) {
+  if (p == end) return false;
+  const bool huffman = (*p & 0x80) != 0;
+  uint64_t len = 0;
+  if (!DecodeInteger(p, end, 7, len)) return false;
+  if (len > static_cast<uint64_t>(end - p)) return false;
+  if (huffman) {
+    scratch.clear();
+    if (!HpackHuffmanDecode(p, static_cast<size_t>(len), scratch)) return false;
+    out = scratch;
+  } else {
+    out = std::string_view(reinterpret_cast<const char*>(p), static_cast<size_t>(len));
+  }
+  p += len;
+  return true;
+}
+
+}  // namespace
+
+size_t HpackHuffmanEncodedSize(std::string_view s) {
+  uint64_t bits = 0;
+  for (unsigned char c : s) bits += kHuffmanCodes[c].bits;
+  return static_cast<size_t>((bits + 7) / 8);
+}
+
+void HpackHuffmanEncode(std::string_view s, std::string& out) {
+  uint64_t acc = 0;
+  unsigned bits = 0;
+  for (unsigned char c : s) {
+    const HuffmanCode& hc = kHuffmanCodes[c];
+    acc = (acc << hc.bits) | hc.code;
+    bits += hc.bits;
+    while (bits >= 8) {
+      bits -= 8;
+      out.push_back(static_cast<char>(acc >> bits));
+    }
+  }
+  if (bits > 0) {
+    // 用 EOS 码字的高位（全 1）补齐最后一个字节
+    out.push_back(static_cast<char>((acc << (8 - bits)) | (0xffu >> bits)));
+  }
+}
+
+bool HpackHuffmanDecode(const uint8_t* data, size_t len, std::string& out) {
+  const HuffmanDecodeTable& table = DecodeTable();
+  uint8_t state = 0;
+  bool accept = true;
+  for (size_t i = 0; i < len; ++i) {
+    const uint8_t nibbles[2] = {static_cast<uint8_t>(data[i] >> 4), static_cast<uint8_t>(data[i] & 0xf)};
+    for (uint8_t nibble : nibbles) {
+      const HuffmanTransition& t = table.transitions[state][nibble];
+      if (t.flags & kHuffmanFail) return false;
+      if (t.flags & kHuffmanEmit) out.push_back(static_cast<char>(t.symbol));
+      state = t.next;
+      accept = (t.flags & kHuffmanAccept) != 0;
+    }
+  }
+  return accept;
+}
+
+HpackDecoder::HpackDecoder(size_t max_table_size) : maxSize_(max_table_size), limit_(max_table_size) {}
+
+void HpackDecoder::SetMaxTableSizeLimit(size_t limit) {
+  limit_ = limit;
+  if (maxSize_ > limit_) {
+    maxSize_ = limit_;
+    EvictTo(maxSize_);
+  }
+}
+
+bool HpackDecoder::Lookup(uint64_t index, std::string_view& name, std::string_view& value) const {
+  if (index == 0) return false;
+  if (index <= kHpackStaticTableSize) {
+    name = kStaticTable[index - 1].name;
+    value = kStaticTable[index - 1].value;
+    return true;
+  }
+  const uint64_t dyn = index - kHpackStaticTableSize - 1;
+  if (dyn >= entries_.size()) return false;
+  name = entries_[dyn].first;
+  value = entries_[dyn].second;
+  return true;
+}
+
+void HpackDecoder::EvictTo(size_t target) {
+  while (size_ > target && !entries_.empty()) {
+    size_ -= entries_.back().first.size() + entries_.back().second.size() + kHpackEntryOverhead;
+    entries_.pop_back();
+  }
+}
+
+void HpackDecoder::Insert(std::string name, std::string value) {
+  const size_t entry_size = name.size() + value.size() + kHpackEntryOverhead;
+  // 比整个表还大的条目使表清空且不被插入（RFC 7541 4.4）
+  if (entry_size > maxSize_) {
+    entries_.clear();
+    size_ = 0;
+    return;
+  }
+  EvictTo(maxSize_ - entry_size);
+  entries_.emplace_front(std::move(name), std::move(value));
+  size_ += entry_size;
+}
+
+bool HpackDecoder::Decode(const uint8_t* data, size_t len, const HeaderVisitor& fn) {
+  const uint8_t* p = data;
+  const uint8_t* end = data + len;
+  bool field_seen = false;
+
+  while (p < end) {
+    const uint8_t b = *p;
+
+    if (b & 0x80) {  // 索引字段
+      uint64_t index = 0;
+      std::string_view name, value;
+      if (!DecodeInteger(p, end, 7, index) || !Lookup(index, name, value)) return false;
+      field_seen = true;
+      if (!fn(name, value)) return false;
+      continue;
+    }
+
+    if ((b & 0xe0) == 0x20) {  // 动态表大小更新，只能出现在头部块开头
+      uint64_t size = 0;
+      if (field_seen || !DecodeInteger(p, end, 5, size) || size > limit_) return false;
+      maxSize_ = static_cast<size_t>(size);
+      EvictTo(maxSize_);
+      continue;
+    }
+
+    // 字面量：01 带增量索引，0000 不索引，0001 永不索引
+    const bool indexing = (b & 0xc0) == 0x40;
+    uint64_t name_index = 0;
+    if (!DecodeInteger(p, end, indexing ? 6 : 4, name_index)) return false;
+    std::string_view name, value, unused;
+    if (name_index != 0) {
+      if (!Lookup(name_index, name, unused)) return false;
+    } else if (!DecodeString(p, end, nameScratch_, name)) {
+      return false;
+    }
+    if (!DecodeString(p, end, valueScratch_, value)) return false;
+    field_seen = true;
+
+    if (!indexing) {
+      if (!fn(name, value)) return false;
+      continue;
+    }
+    // 名称可能引用即将被淘汰的动态表条目，先拷贝再插入
+    std::string name_copy(name);
+    std::string value_copy(value);
+    if (!fn(name_copy, value_copy)) return false;
+    Insert(std::move(name_copy), std::move(value_copy));
+  }
+  return true;
+}
+
+void HpackEncoder::EncodeInteger(uint64_t value, uint8_t prefix_bits, uint8_t first_byte, std::string& out) {
+  const uint8_t max_prefix = static_cast<uint8_t>((1u << prefix_bits) - 1);
+  if (value < max_prefix) {
+    out.push_back(static_cast<char>(first_byte | value));
+    return;
+  }
+  out.push_back(static_cast<char>(first_byte | max_prefix));
+  value -= max_prefix;
+  while (value >= 0x80) {
+    out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+void HpackEncoder::EncodeString(std::string_view s, std::string& out) {
+  const size_t huffman_len = HpackHuffmanEncodedSize(s);
+  if (huffman_len < s.size()) {
+    EncodeInteger(huffman_len, 7, 0x80, out);
+    HpackHuffmanEncode(s, out);
+  } else {
+    EncodeInteger(s.size(), 7, 0x00, out);
+    out.append(s);
+  }
+}
+
+void HpackEncoder::Encode(std::string_view name, std::string_view value, std::string& out) {
+  const auto& index = StaticNameIndex();
+  uint8_t name_index = 0;
+  auto it = index.find(name);
+  if (it != index.end()) {
+    name_index = it->second.first;
+    for (uint8_t i = 0; i < it->second.second; ++i) {
+      if (kStaticTable[name_index - 1 + i].value == value) {
+        EncodeInteger(name_index + i, 7, 0x80, out);
+        return;
+      }
+    }
+  }
+  EncodeInteger(name_index, 4, 0x00, out);
+  if (name_index == 0) EncodeString(name, out);
+  EncodeString(value, out);
+}
+
+void HpackEncoder::EncodeStatus(int status, std::string& out) {
+  switch (status) {
+    case 200: out.push_back(static_cast<char>(0x80 | 8)); return;
+    case 204: out.push_back(static_cast<char>(0x80 | 9)); return;
+    case 206: out.push_back(static_cast<char>(0x80 | 10)); return;
+    case 304: out.push_back(static_cast<char>(0x80 | 11)); return;
+    case 400: out.push_back(static_cast<char>(0x80 | 12)); return;
+    case 404: out.push_back(static_cast<char>(0x80 | 13)); return;
+    case 500: out.push_back(static_cast<char>(0x80 | 14)); return;
+    default: break;
+  }
+  char digits[8];
+  auto res = std::to_chars(digits, digits + sizeof(digits), status);
+  EncodeInteger(8, 4, 0x00, out);
+  EncodeString(std::string_view(digits, static_cast<size_t>(res.ptr - digits)), out);
+}
@@ -1,33 +1,86 @@
 #include "parsers/Http1Parser.h"
 #include "core/HttpRequest.h"
 #include "core/HttpResponse.h"
+#include "util/HttpScan.h"
+#include "util/HttpStringUtil.h"
 #include <cctype>
 #include <charconv>
+#include <cstring>
 #include <sstream>
 
 namespace {
 // HTTP/1.x 响应行的固定前缀
 constexpr std::string_view kHttpPrefix = "HTTP/";
 
-// 大小写不敏感字符串比较，供头部/编码判断使用
-bool iequals(std::string_view a, std::string_view b) {
-  if (a.size() != b.size()) return false;
-  for (size_t i = 0; i < a.size(); ++i) {
-    if (std::tolower(static_cast<unsigned char>(a[i])) !=
-        std::tolower(static_cast<unsigned char>(b[i]))) {
-      return false;
+// 从 pos 起查找 "\r\n"，未找到返回 npos；扫描由 HttpScan 按 CPU 特性选择向量实现
+size_t FindCrlf(std::string_view s, size_t pos) {
+  size_t off = HttpScanFindCrlf(s.data() + pos, s.size() - pos);
+  return off == s.size() - pos ? std::string_view::npos : pos + off;
+}
+
+// 在分段缓冲中定位请求头结束标记 "\r\n\r\n"，返回标记之后的偏移；未找到返回 0。
+// 只用 memchr 找 '\n'，再回看前 3 个字节，跨段时由 tail 补齐；扫描超过 limit 时置位 over_limit
+size_t FindHeadEnd(const struct iovec* iov, size_t iovcnt, size_t limit, bool& over_limit) {
+  char tail[3] = {0, 0, 0};   // 之前各段的最后 3 个字节，tail[2] 最靠后
+  size_t base = 0;
+  for (size_t s = 0; s < iovcnt; ++s) {
+    const char* p = static_cast<const char*>(iov[s].iov_base);
+    const size_t len = iov[s].iov_len;
+    const size_t scan = base >= limit ? 0 : std::min(len, limit - base);
+    auto back = [&](size_t i, size_t n) -> char {
+      return i >= n ? p[i - n] : tail[3 - (n - i)];
+    };
+    const char* cur = p;
+    const char* end = p + scan;
+    while (cur < end) {
+      const char* nl = static_cast<const char*>(std::memchr(cur, '\n', static_cast<size_t>(end - cur)));
+      if (!nl) break;
+      size_t i = static_cast<size_t>(nl - p);
+      if (back(i, 1) == '\r' && back(i, 2) == '\n' && back(i, 3) == '\r') {
+        return base + i + 1;
+      }
+      cur = nl + 1;
+    }
+    if (scan < len) {
+      over_limit = true;
+      return 0;
+    }
+    if (len >= 3) {
+      std::memcpy(tail, p + len - 3, 3);
+    } else {
+      for (size_t i = 0; i < len; ++i) {
+        tail[0] = tail[1];
+        tail[1] = tail[2];
+        tail[2] = p[i];
+      }
     }
+    base += len;
   }
-  return true;
+  return 0;
 }
 
-std::string LowerAscii(std::string_view s) {
-  std::string out;
-  out.reserve(s.size());
-  for (char c : s) {
-    out.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+// 从分段缓冲的 offset 处起拷贝 len 个字节，逐段交给 sink
+template <typename Sink>
+void CopySegments(const struct iovec* iov, size_t iovcnt, size_t offset, size_t len, Sink&& sink) {
+  for (size_t s = 0; s < iovcnt && len > 0; ++s) {
+    const size_t seg_len = iov[s].iov_len;
+    if (offset >= seg_len) {
+      offset -= seg_len;
+      continue;
+    }
+    const size_t take = std::min(seg_len - offset, len);
+    sink(static_cast<const char*>(iov[s].iov_base) + offset, take);
+    len -= take;
+    offset = 0;
   }
-  return out;
+}
+
+// 起始行按空白切分出下一个字段（与 istringstream >> 的行为一致）
+std::string_view NextToken(std::string_view line, size_t& pos) {
+  while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) ++pos;
+  size_t start = pos;
+  while (pos < line.size() && line[pos] != ' ' && line[pos] != '\t') ++pos;
+  return line.substr(start, pos - start);
 }
 } // namespace
 
@@ -49,7 +102,7 @@ int Http1Parser::Parse(std::string& data, std::unique_ptr<IHttpMessage>& out) {
       case ParseState::kHeaders:
       case ParseState::kBodyChunkedSize: {
         // 这些状态按行解析
-        size_t lineEnd = data.find("\r\n", consumed);
+        size_t lineEnd = FindCrlf(data, consumed);
         if (lineEnd == std::string::npos) {
           // 不完整行，缓存后返回 NEEDMOREDATA
           // 检查行缓冲区大小限制
@@ -93,12 +146,12 @@ int Http1Parser::Parse(std::string& data, std::unique_ptr<IHttpMessage>& out) {
         if (state_ == ParseState::kHeaders) {
           if (line.empty()) {
             // 头结束，决定 body 解析方式
-            auto te = currentMessage_->GetHeader("Transfer-Encoding");
-            if (te && iequals(*te, "chunked")) {
+            auto te = currentMessage_->GetHeaderView(KnownHeader::TransferEncoding);
+            if (te && EqualsIgnoreCaseAscii(*te, "chunked")) {
               isChunked_ = true;
               allowedTrailerKeys_.clear();
-              if (auto trailer = currentMessage_->GetHeader("Trailer")) {
-                std::string_view v(*trailer);
+              if (auto trailer = currentMessage_->GetHeaderView(KnownHeader::Trailer)) {
+                std::string_view v = *trailer;
                 size_t pos = 0;
                 while (pos < v.size()) {
                   while (pos < v.size() && (v[pos] == ' ' || v[pos] == '\t' || v[pos] == ',')) ++pos;
@@ -107,7 +160,7 @@ int Http1Parser::Parse(std::string& data, std::unique_ptr<IHttpMessage>& out) {
                   size_t end = pos;
                   while (end > start && (v[end - 1] == ' ' || v[end - 1] == '\t')) --end;
                   if (end > start) {
-                    allowedTrailerKeys_.insert(LowerAscii(v.substr(start, end - start)));
+                    allowedTrailerKeys_.insert(LowerAsciiCopy(v.substr(start, end - start)));
                   }
                 }
               }
@@ -250,7 +303,7 @@ int Http1Parser::Parse(std::string& data, std::unique_ptr<IHttpMessage>& out) {
 
       case ParseState::kBodyChunkedEnd: {
         // 解析 trailer，直到空行结束
-        size_t lineEnd = data.find("\r\n", consumed);
+        size_t lineEnd = FindCrlf(data, consumed);
         if (lineEnd == std::string::npos) {
           // 检查行缓冲区大小限制
           size_t remaining = data.size() - consumed;
@@ -314,7 +367,7 @@ int Http1Parser::Parse(std::string& data, std::unique_ptr<IHttpMessage>& out) {
           return static_cast<int>(ParseResult::ERROR);
         }
 
-        std::string lowerKey = LowerAscii(key);
+        std::string lowerKey = LowerAsciiCopy(key);
         if (lowerKey == "transfer-encoding" || lowerKey == "content-length" || lowerKey == "trailer") {
           data.erase(0, consumed);
           totalConsumed_ += consumed;
@@ -328,7 +381,8 @@ int Http1Parser::Parse(std::string& data, std::unique_ptr<IHttpMessage>& out) {
         }
 
         std::string value = trimLWS(std::string_view(line).substr(colon + 1));
-        if (strictHeaderCheck_ && !isTokenChar(key[0])) {
+        if (strictHeaderCheck_ && (!HttpScanIsToken(key.data(), key.size()) ||
+                                   !HttpScanIsFieldValue(value.data(), value.size()))) {
           data.erase(0, consumed);
           totalConsumed_ += consumed;
           return static_cast<int>(ParseResult::ERROR);
@@ -364,6 +418,136 @@ int Http1Parser::Parse(const char* data, size_t len, std::unique_ptr<IHttpMessag
   return Parse(buf, out);
 }
 
+int Http1Parser::ParseSegments(const struct iovec* iov, size_t iovcnt, std::unique_ptr<IHttpMessage>& out) {
+  totalConsumed_ = 0;
+  if (state_ != ParseState::kStartLine) {
+    // 流式状态机已有未完成的报文，不能从头重新解析
+    return static_cast<int>(ParseResult::NEEDSTREAMING);
+  }
+
+  size_t available = 0;
+  for (size_t i = 0; i < iovcnt; ++i) available += iov[i].iov_len;
+  if (available == 0) return static_cast<int>(ParseResult::NEEDMOREDATA);
+
+  // 起始行 + 全部头部 + 结尾空行的上限
+  const size_t headLimit = maxLineBufferSize_ + maxTotalHeaderBytes_ + 2;
+  bool overLimit = false;
+  const size_t headEnd = FindHeadEnd(iov, iovcnt, headLimit, overLimit);
+  if (overLimit) return static_cast<int>(ParseResult::HEADERTOOLONG);
+  if (headEnd == 0) return static_cast<int>(ParseResult::NEEDMOREDATA);
+
+  // 分段缓冲在调用方推进读指针后即被回收，请求头需要一次性拷贝到请求对象自有的存储中
+  std::string& head = headScratch_;
+  head.clear();
+  head.reserve(headEnd);
+  CopySegments(iov, iovcnt, 0, headEnd, [&head](const char* p, size_t n) { head.append(p, n); });
+  std::string_view view(head);
+
+  size_t lineEnd = FindCrlf(view, 0);
+  std::string_view startLine = view.substr(0, lineEnd);
+  if (startLine.size() > maxLineBufferSize_) return static_cast<int>(ParseResult::LINE_TOO_LONG);
+  if (startLine.empty()) return static_cast<int>(ParseResult::INVALIDSTARTLINE);
+  if (startLine.rfind(kHttpPrefix, 0) == 0) return static_cast<int>(ParseResult::NEEDSTREAMING);
+
+  size_t tokPos = 0;
+  std::string_view method = NextToken(startLine, tokPos);
+  std::string_view url = NextToken(startLine, tokPos);
+  std::string_view versionStr = NextToken(startLine, tokPos);
+  if (versionStr.empty()) return static_cast<int>(ParseResult::INVALIDSTARTLINE);
+  HttpVersion version = HttpVersion::HTTP_1_1;
+  if (versionStr == "HTTP/1.0") version = HttpVersion::HTTP_1_0;
+  else if (versionStr == "HTTP/1.1") version = HttpVersion::HTTP_1_1;
+  else return static_cast<int>(ParseResult::UNSUPPORTEDVERSION);
+
+  std::vector<HeaderTable::Entry>& spans = spanScratch_;
+  spans.clear();
+  spans.reserve(16);
+  std::string_view transferEncoding;
+  std::string_view contentLengthStr;
+  bool hasTransferEncoding = false;
+  bool hasContentLength = false;
+  size_t headerBytes = 0;
+
+  size_t pos = lineEnd + 2;
+  while (true) {
+    size_t end = FindCrlf(view, pos);
+    std::string_view line = view.substr(pos, end - pos);
+    if (line.empty()) break;   // headEnd 保证最后一行是空行
+
+    if (line.size() > maxLineBufferSize_) return static_cast<int>(ParseResult::LINE_TOO_LONG);
+    headerBytes += line.size() + 2;
+    if (headerBytes > maxTotalHeaderBytes_ || line.size() > maxHeaderLineSize_ ||
+        spans.size() + 1 > maxHeaderCount_) {
+      return static_cast<int>(ParseResult::HEADERTOOLONG);
+    }
+
+    size_t colon = line.find(':');
+    if (colon == std::string_view::npos) return static_cast<int>(ParseResult::INVALIDHEADER);
+    std::string_view key = line.substr(0, colon);
+    std::string_view value = TrimAsciiWhitespace(line.substr(colon + 1));
+    if (strictHeaderCheck_ && (!HttpScanIsToken(key.data(), key.size()) ||
+                               !HttpScanIsFieldValue(value.data(), value.size()))) {
+      return static_cast<int>(ParseResult::INVALIDHEADER);
+    }
+    key = TrimAsciiWhitespace(key);
+    // 常用头部在此解析为枚举，请求对象按枚举直接索引
+    const KnownHeader id = LookupKnownHeader(key);
+
+    if (!hasTransferEncoding && id == KnownHeader::TransferEncoding) {
+      hasTransferEncoding = true;
+      transferEncoding = value;
+    } else if (!hasContentLength && id == KnownHeader::ContentLength) {
+      hasContentLength = true;
+      contentLengthStr = value;
+    }
+
+    spans.push_back(HeaderTable::Entry{
+        static_cast<uint32_t>(key.data() - view.data()), static_cast<uint32_t>(key.size()),
+        static_cast<uint32_t>(value.data() - view.data()), static_cast<uint32_t>(value.size()), id});
+    pos = end + 2;
+  }
+
+  if (hasTransferEncoding && EqualsIgnoreCaseAscii(transferEncoding, "chunked")) {
+    return static_cast<int>(ParseResult::NEEDSTREAMING);
+  }
+
+  size_t contentLength = 0;
+  if (hasContentLength) {
+    auto res = std::from_chars(contentLengthStr.data(), contentLengthStr.data() + contentLengthStr.size(),
+                               contentLength);
+    if (res.ec != std::errc() || res.ptr != contentLengthStr.data() + contentLengthStr.size()) {
+      return static_cast<int>(ParseResult::INVALIDHEADER);
+    }
+    if (maxBodySize_ > 0 && contentLength > maxBodySize_) {
+      return static_cast<int>(ParseResult::BODYTOOLONG);
+    }
+  }
+  // 大请求体不等待收齐：先交付请求头，body 由调用方边到达边处理
+  const bool deferBody = bodyDeferThreshold_ > 0 && contentLength >= bodyDeferThreshold_;
+  if (!deferBody && available - headEnd < contentLength) {
+    return static_cast<int>(ParseResult::NEEDMOREDATA);
+  }
+
+  auto request = AcquireRequest();
+  request->SetRequestLine(method, url, version);
+  if (deferBody) {
+    request->SetDeferredBodyLength(contentLength);
+    request->AdoptRawHeaders(std::move(head), std::move(spans));
+    out = std::move(request);
+    totalConsumed_ = headEnd;
+    return static_cast<int>(ParseResult::SUCCESS);
+  }
+  if (contentLength > 0) {
+    request->ReserveBody(contentLength);
+    CopySegments(iov, iovcnt, headEnd, contentLength,
+                 [&request](const char* p, size_t n) { request->AppendBodyChunk(p, n); });
+  }
+  request->AdoptRawHeaders(std::move(head), std::move(spans));
+  out = std::move(request);
+  totalConsumed_ = headEnd + contentLength;
+  return static_cast<int>(ParseResult::SUCCESS);
+}
+
 void Http1Parser::Reset() {
   // 重置状态机与缓存，方便复用同一解析器实例
   state_ = ParseState::kStartLine;
@@ -382,6 +566,17 @@ void Http1Parser::Reset() {
 
 Http1Parser::~Http1Parser() = default;
 
+void Http1Parser::RecycleRequest(std::unique_ptr<HttpRequest> request) {
+  if (!request || spareRequest_) return;
+  request->ResetForReuse(headScratch_, spanScratch_);
+  spareRequest_ = std::move(request);
+}
+
+std::unique_ptr<HttpRequest> Http1Parser::AcquireRequest() {
+  if (spareRequest_) return std::move(spareRequest_);
+  return std::make_unique<HttpRequest>();
+}
+
 ParseResult Http1Parser::ParseStartLine(std::string_view line) {
   // 解析请求/响应起始行，自动生成 HttpRequest 或 HttpResponse
   if (line.empty()) return ParseResult::INVALIDSTARTLINE;
@@ -421,7 +616,7 @@ ParseResult Http1Parser::ParseStartLine(std::string_view line) {
   else if (version_str == "HTTP/1.1") version = HttpVersion::HTTP_1_1;
   else return ParseResult::UNSUPPORTEDVERSION;
 
-  currentMessage_ = std::make_unique<HttpRequest>();
+  currentMessage_ = AcquireRequest();
   currentMessage_->SetRequestLine(method, url, version);
   return ParseResult::SUCCESS;
 }
@@ -434,7 +629,9 @@ ParseResult Http1Parser::ParseHeaderLine(std::string_view line) {
   std::string key(line.substr(0, colon));
   std::string value = trimLWS(line.substr(colon + 1));
 
-  if (strictHeaderCheck_ && !isTokenChar(key[0])) {
+  // 严格模式校验整个名称均为 token 字符（名称与冒号之间不允许空白）、值中不含控制字符
+  if (strictHeaderCheck_ && (!HttpScanIsToken(key.data(), key.size()) ||
+                             !HttpScanIsFieldValue(value.data(), value.size()))) {
     return ParseResult::INVALIDHEADER;
   }
 
@@ -467,16 +664,6 @@ ParseResult Http1Parser::FinalizeMessage(std::unique_ptr<IHttpMessage>& out) {
   return ParseResult::SUCCESS;
 }
 
-bool Http1Parser::isTokenChar(char c) {
-  // RFC 7230 token
-  return std::isalpha(static_cast<unsigned char>(c)) ||
-         std::isdigit(static_cast<unsigned char>(c)) ||
-         c == '!' || c == '#' || c == '$' || c == '%' ||
-         c == '&' || c == '\''|| c == '*' || c == '+' ||
-         c == '-' || c == '.' || c == '^' || c == '_' ||
-         c == '`' || c == '|' || c == '~';
-}
-
 std::string Http1Parser::trimLWS(std::string_view s) {
   // 去除头部值左右的空白 (LWS)
   size_t start = 0;
@@ -1,30 +1,809 @@
 #include "parsers/Http2Parser.h"
 
-#include <utility>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <unistd.h>
 
-Http2Parser::Http2Parser() = default;
-Http2Parser::~Http2Parser() = default;
+#include "core/HeaderTable.h"
+#include "core/HttpRequest.h"
+#include "core/HttpResponse.h"
+#include "util/HttpStringUtil.h"
 
-int Http2Parser::Parse(std::string&, std::unique_ptr<IHttpMessage>& out) {
-  // 占位实现：当前未提供 HTTP/2 解析，返回不支持版本
-  (void)out;
-  return static_cast<int>(ParseResult::UNSUPPORTEDVERSION);
+namespace {
+
+// CONTINUATION 累积的头部块上限，防止对端用不带 END_HEADERS 的帧无限占用内存
+constexpr size_t kMaxHeaderBlockBytes = 256 * 1024;
+
+// RFC 9113 8.2.2：HTTP/2 中禁止出现的连接级头部
+bool IsConnectionSpecificHeader(std::string_view name) {
+  return name == "connection" || name == "keep-alive" || name == "proxy-connection" ||
+         name == "transfer-encoding" || name == "upgrade";
+}
+
+bool HasUpperAscii(std::string_view s) {
+  for (char c : s) {
+    if (c >= 'A' && c <= 'Z') return true;
+  }
+  return false;
+}
+
+// 去掉 PADDED 帧的填充，payload/length 收缩为数据部分；填充长度非法时返回 false
+bool StripPadding(const Http2FrameHeader& h, const uint8_t*& payload, uint32_t& length) {
+  length = h.length;
+  if (!(h.flags & kHttp2FlagPadded)) return true;
+  if (length < 1) return false;
+  const uint8_t pad = payload[0];
+  payload += 1;
+  length -= 1;
+  if (pad > length) return false;
+  length -= pad;
+  return true;
+}
+
+void AppendField(std::string& arena, std::vector<HeaderTable::Entry>& entries,
+                 std::string_view name, std::string_view value) {
+  HeaderTable::Entry e;
+  e.id = LookupKnownHeader(name);
+  e.name_off = static_cast<uint32_t>(arena.size());
+  e.name_len = static_cast<uint32_t>(name.size());
+  arena.append(name);
+  e.value_off = static_cast<uint32_t>(arena.size());
+  e.value_len = static_cast<uint32_t>(value.size());
+  arena.append(value);
+  entries.push_back(e);
+}
+
+}  // namespace
+
+Http2Parser::Http2Parser() : Http2Parser(Settings{}) {}
+
+Http2Parser::Http2Parser(const Settings& settings)
+    : settings_(settings), decoder_(settings.headerTableSize) {
+  QueueServerPreface();
+}
+
+Http2Parser::~Http2Parser() {
+  for (auto& [id, stream] : streams_) {
+    ReleaseStreamFile(*stream);
+  }
+  for (int fd : orphanFds_) {
+    ::close(fd);
+  }
+}
+
+int Http2Parser::Parse(std::string& data, std::unique_ptr<IHttpMessage>& out) {
+  return Parse(data.data(), data.size(), out);
 }
 
 int Http2Parser::Parse(const char* data, size_t len, std::unique_ptr<IHttpMessage>& out) {
-  std::string buf(data, data + len);
-  return Parse(buf, out);
+  consumed_ = len;
+  if (len > 0 && !Feed(data, len)) {
+    return static_cast<int>(ParseResult::ERROR);
+  }
+  uint32_t stream_id = 0;
+  if (PopRequest(out, stream_id)) {
+    return static_cast<int>(ParseResult::SUCCESS);
+  }
+  return static_cast<int>(failed_ ? ParseResult::ERROR : ParseResult::NEEDMOREDATA);
 }
 
 void Http2Parser::Reset() {
-/*   activeStreams_.clear();
-  while(!completedMessages_.empty()) completedMessages_.pop();
-  prefaceReceied_ = false;
-  nextStreamId_ = 1; */
+  for (auto& [id, stream] : streams_) {
+    ReleaseStreamFile(*stream);
+  }
+  streams_.clear();
+  ready_.clear();
+  sendQueue_.clear();
+  control_.clear();
+  partial_.clear();
+  headerBlock_.clear();
+  decoder_ = HpackDecoder(settings_.headerTableSize);
+  prefaceReceived_ = false;
+  settingsReceived_ = false;
+  consumed_ = 0;
+  lastPeerStreamId_ = 0;
+  headerBlockStream_ = 0;
+  headerBlockEndStream_ = false;
+  expectContinuation_ = false;
+  lastPoppedStreamId_ = 0;
+  connRecvUnacked_ = 0;
+  connSendWindow_ = kHttp2DefaultWindowSize;
+  peerInitialWindow_ = kHttp2DefaultWindowSize;
+  peerMaxFrameSize_ = kHttp2DefaultMaxFrameSize;
+  goAwaySent_ = false;
+  peerGoAway_ = false;
+  failed_ = false;
+  QueueServerPreface();
+}
+
+void Http2Parser::QueueServerPreface() {
+  // 服务端前言是一个 SETTINGS 帧，不必等待客户端前言即可发出
+  const std::pair<Http2SettingId, uint32_t> settings[] = {
+    {Http2SettingId::HEADER_TABLE_SIZE, settings_.headerTableSize},
+    {Http2SettingId::MAX_CONCURRENT_STREAMS, settings_.maxConcurrentStreams},
+    {Http2SettingId::INITIAL_WINDOW_SIZE, settings_.initialWindowSize},
+    {Http2SettingId::MAX_FRAME_SIZE, settings_.maxFrameSize},
+    {Http2SettingId::MAX_HEADER_LIST_SIZE, settings_.maxHeaderListSize},
+  };
+  AppendHttp2FrameHeader(control_, static_cast<uint32_t>(sizeof(settings) / sizeof(settings[0]) * 6),
+                         Http2FrameType::SETTINGS, 0, 0);
+  for (const auto& [id, value] : settings) {
+    const uint16_t raw = static_cast<uint16_t>(id);
+    control_.push_back(static_cast<char>(raw >> 8));
+    control_.push_back(static_cast<char>(raw));
+    AppendHttp2Uint32(control_, value);
+  }
+
+  connRecvWindow_ = kHttp2DefaultWindowSize;
+  if (settings_.connectionWindowSize > kHttp2DefaultWindowSize) {
+    QueueWindowUpdate(0, settings_.connectionWindowSize - kHttp2DefaultWindowSize);
+    connRecvWindow_ = settings_.connectionWindowSize;
+  }
+}
+
+bool Http2Parser::Feed(const char* data, size_t len) {
+  if (failed_) return false;
+
+  // 没有残留时直接在输入上解析，只有跨越输入边界的不完整帧才拷贝进 partial_
+  const bool buffered = !partial_.empty();
+  if (buffered) partial_.append(data, len);
+  const uint8_t* p = reinterpret_cast<const uint8_t*>(buffered ? partial_.data() : data);
+  const size_t avail = buffered ? partial_.size() : len;
+  size_t pos = 0;
+
+  if (!prefaceReceived_) {
+    const size_t n = std::min(avail, kHttp2ClientPreface.size());
+    if (std::memcmp(p, kHttp2ClientPreface.data(), n) != 0) {
+      return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+    }
+    if (n == kHttp2ClientPreface.size()) {
+      prefaceReceived_ = true;
+      pos = n;
+    } else {
+      pos = avail;   // 前言不完整：保留已收到的部分
+      if (!buffered) partial_.assign(data, len);
+      return true;
+    }
+  }
+
+  while (avail - pos >= kHttp2FrameHeaderSize) {
+    const Http2FrameHeader h = DecodeHttp2FrameHeader(p + pos);
+    if (h.length > settings_.maxFrameSize) {
+      return ConnectionError(Http2ErrorCode::FRAME_SIZE_ERROR);
+    }
+    if (avail - pos - kHttp2FrameHeaderSize < h.length) break;
+    if (!ProcessFrame(h, p + pos + kHttp2FrameHeaderSize)) return false;
+    pos += kHttp2FrameHeaderSize + h.length;
+  }
+
+  if (buffered) {
+    partial_.erase(0, pos);
+  } else {
+    partial_.assign(data + pos, len - pos);
+  }
+  return true;
+}
+
+bool Http2Parser::ProcessFrame(const Http2FrameHeader& h, const uint8_t* payload) {
+  if (expectContinuation_ &&
+      (h.type != Http2FrameType::CONTINUATION || h.stream_id != headerBlockStream_)) {
+    return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+  }
+  // 客户端前言之后的第一帧必须是 SETTINGS
+  if (!settingsReceived_ && h.type != Http2FrameType::SETTINGS) {
+    return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+  }
+
+  switch (h.type) {
+    case Http2FrameType::DATA: return OnData(h, payload);
+    case Http2FrameType::HEADERS: return OnHeaders(h, payload);
+    case Http2FrameType::CONTINUATION: return OnContinuation(h, payload);
+    case Http2FrameType::SETTINGS: return OnSettings(h, payload);
+    case Http2FrameType::WINDOW_UPDATE: return OnWindowUpdate(h, payload);
+    case Http2FrameType::RST_STREAM: return OnRstStream(h, payload);
+    case Http2FrameType::PING: return OnPing(h, payload);
+    case Http2FrameType::GOAWAY: return OnGoAway(h, payload);
+    case Http2FrameType::PRIORITY:
+      // 优先级提示不影响本端的轮转调度，只做格式校验
+      if (h.stream_id == 0) return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+      if (h.length != 5) StreamError(h.stream_id, Http2ErrorCode::FRAME_SIZE_ERROR);
+      return true;
+    case Http2FrameType::PUSH_PROMISE:
+      return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+  }
+  return true;   // 未知类型的帧必须忽略
 }
-size_t Http2Parser::GetConsumeBytes() const {
-  return 0;
+
+bool Http2Parser::OnData(const Http2FrameHeader& h, const uint8_t* payload) {
+  if (h.stream_id == 0) return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+
+  // 整个帧（含填充）计入流量控制；数据随即并入请求体，连接级窗口可以立即归还
+  if (static_cast<int64_t>(h.length) > connRecvWindow_) {
+    return ConnectionError(Http2ErrorCode::FLOW_CONTROL_ERROR);
+  }
+  connRecvWindow_ -= h.length;
+  ReplenishConnectionWindow(h.length);
+
+  const uint8_t* data = payload;
+  uint32_t len = 0;
+  if (!StripPadding(h, data, len)) return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+
+  auto it = streams_.find(h.stream_id);
+  if (it == streams_.end()) {
+    if (h.stream_id > lastPeerStreamId_) return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+    return true;   // 已关闭或已重置的流上仍在途的数据
+  }
+  Stream& s = *it->second;
+  if (s.remoteClosed) {
+    StreamError(s.id, Http2ErrorCode::STREAM_CLOSED);
+    return true;
+  }
+  if (static_cast<int64_t>(h.length) > s.recvWindow) {
+    StreamError(s.id, Http2ErrorCode::FLOW_CONTROL_ERROR);
+    return true;
+  }
+  s.recvWindow -= h.length;
+  s.receivedLength += len;
+  if (maxBodySize_ > 0 && s.receivedLength > maxBodySize_) {
+    StreamError(s.id, Http2ErrorCode::CANCEL);
+    return true;
+  }
+  if (len > 0) {
+    s.request->AppendBodyChunk(reinterpret_cast<const char*>(data), len);
+  }
+
+  if (h.flags & kHttp2FlagEndStream) {
+    s.remoteClosed = true;
+    CompleteStream(s);
+    return true;
+  }
+  s.recvUnacked += h.length;
+  if (s.recvUnacked >= settings_.initialWindowSize / 2) {
+    QueueWindowUpdate(s.id, s.recvUnacked);
+    s.recvWindow += s.recvUnacked;
+    s.recvUnacked = 0;
+  }
+  return true;
+}
+
+bool Http2Parser::OnHeaders(const Http2FrameHeader& h, const uint8_t* payload) {
+  if (h.stream_id == 0) return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+
+  const uint8_t* p = payload;
+  uint32_t len = 0;
+  if (!StripPadding(h, p, len)) return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+  if (h.flags & kHttp2FlagPriority) {
+    if (len < 5) return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+    // 流不能依赖自身；优先级本身不参与调度
+    if ((ReadHttp2Uint32(p) & 0x7fffffffu) == h.stream_id) {
+      return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+    }
+    p += 5;
+    len -= 5;
+  }
+
+  headerBlock_.assign(reinterpret_cast<const char*>(p), len);
+  headerBlockStream_ = h.stream_id;
+  headerBlockEndStream_ = (h.flags & kHttp2FlagEndStream) != 0;
+  if (!(h.flags & kHttp2FlagEndHeaders)) {
+    expectContinuation_ = true;
+    return true;
+  }
+  return OnHeaderBlockComplete();
+}
+
+bool Http2Parser::OnContinuation(const Http2FrameHeader& h, const uint8_t* payload) {
+  if (!expectContinuation_) return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+  if (headerBlock_.size() + h.length > kMaxHeaderBlockBytes) {
+    return ConnectionError(Http2ErrorCode::ENHANCE_YOUR_CALM);
+  }
+  headerBlock_.append(reinterpret_cast<const char*>(payload), h.length);
+  if (!(h.flags & kHttp2FlagEndHeaders)) return true;
+  expectContinuation_ = false;
+  return OnHeaderBlockComplete();
+}
+
+bool Http2Parser::OnHeaderBlockComplete() {
+  const uint32_t id = headerBlockStream_;
+
+  // 无论流最终是否被接受，头部块都必须解码，否则 HPACK 动态表会与对端失去同步
+  pendingFields_.clear();
+  size_t list_size = 0;
+  bool too_large = false;
+  const bool decoded = decoder_.Decode(
+      reinterpret_cast<const uint8_t*>(headerBlock_.data()), headerBlock_.size(),
+      [&](std::string_view name, std::string_view value) {
+        list_size += name.size() + value.size() + kHpackEntryOverhead;
+        if (list_size > settings_.maxHeaderListSize) {
+          too_large = true;
+        } else {
+          pendingFields_.emplace_back(name, value);
+        }
+        return true;
+      });
+  headerBlock_.clear();
+  if (!decoded) return ConnectionError(Http2ErrorCode::COMPRESSION_ERROR);
+
+  auto it = streams_.find(id);
+  if (it != streams_.end()) {
+    // 已存在的流上只能是请求体之后的 trailers，且必须结束流；trailers 不并入请求头部
+    Stream& s = *it->second;
+    if (s.remoteClosed) {
+      StreamError(id, Http2ErrorCode::STREAM_CLOSED);
+    } else if (!headerBlockEndStream_) {
+      StreamError(id, Http2ErrorCode::PROTOCOL_ERROR);
+    } else {
+      s.remoteClosed = true;
+      CompleteStream(s);
+    }
+    return true;
+  }
+
+  // 客户端发起的流 ID 必须是奇数且单调递增
+  if ((id & 1) == 0 || id <= lastPeerStreamId_) {
+    return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+  }
+  lastPeerStreamId_ = id;
+
+  if (goAwaySent_) return true;   // GOAWAY 之后的新流不再处理
+  if (streams_.size() >= settings_.maxConcurrentStreams) {
+    QueueRstStream(id, Http2ErrorCode::REFUSED_STREAM);
+    return true;
+  }
+  if (too_large) {
+    QueueRstStream(id, Http2ErrorCode::PROTOCOL_ERROR);
+    return true;
+  }
+
+  auto stream = std::make_unique<Stream>();
+  stream->id = id;
+  stream->recvWindow = settings_.initialWindowSize;
+  stream->sendWindow = peerInitialWindow_;
+  if (!BuildRequest(*stream)) {
+    QueueRstStream(id, Http2ErrorCode::PROTOCOL_ERROR);
+    return true;
+  }
+  Stream& s = *stream;
+  streams_.emplace(id, std::move(stream));
+  if (headerBlockEndStream_) {
+    s.remoteClosed = true;
+    CompleteStream(s);
+  }
+  return true;
+}
+
+bool Http2Parser::BuildRequest(Stream& stream) {
+  std::string_view method, scheme, path, authority;
+  bool regular_seen = false;
+  bool has_host = false;
+  std::string arena;
+  std::vector<HeaderTable::Entry> entries;
+  std::string cookie;
+  entries.reserve(pendingFields_.size() + 1);
+
+  for (const auto& [name, value] : pendingFields_) {
+    if (name.empty()) return false;
+    if (name[0] == ':') {
+      // 伪头部只能出现在普通头部之前，且每个至多一次
+      if (regular_seen) return false;
+      std::string_view* slot = name == ":method" ? &method
+                             : name == ":scheme" ? &scheme
+                             : name == ":path" ? &path
+                             : name == ":authority" ? &authority
+                             : nullptr;
+      if (!slot || slot->data() != nullptr) return false;
+      *slot = value;
+      continue;
+    }
+    regular_seen = true;
+    if (HasUpperAscii(name) || IsConnectionSpecificHeader(name)) return false;
+    if (name == "te" && value != "trailers") return false;
+    if (name == "cookie") {
+      // 拆分发送的 cookie 在交给 HTTP/1 语义的处理器前合并（RFC 9113 8.2.3）
+      if (!cookie.empty()) cookie.append("; ");
+      cookie.append(value);
+      continue;
+    }
+    has_host = has_host || name == "host";
+    AppendField(arena, entries, name, value);
+  }
+
+  if (method.empty() || method == "CONNECT" || scheme.empty() || path.empty()) return false;
+  if (!cookie.empty()) AppendField(arena, entries, "cookie", cookie);
+  if (!has_host && !authority.empty()) AppendField(arena, entries, "host", authority);
+  if (entries.size() > maxHeaderCount_) return false;
+
+  for (const auto& e : entries) {
+    if (e.id != KnownHeader::ContentLength) continue;
+    uint64_t length = 0;
+    const char* begin = arena.data() + e.value_off;
+    const char* end = begin + e.value_len;
+    auto res = std::from_chars(begin, end, length);
+    if (res.ec != std::errc() || res.ptr != end) return false;
+    stream.expectedLength = static_cast<int64_t>(length);
+  }
+
+  auto request = std::make_unique<HttpRequest>();
+  request->SetRequestLine(method, path, HttpVersion::HTTP_2);
+  request->AdoptRawHeaders(std::move(arena), std::move(entries));
+  if (stream.expectedLength > 0) {
+    request->ReserveBody(std::min<uint64_t>(static_cast<uint64_t>(stream.expectedLength), 1u << 20));
+  }
+  stream.request = std::move(request);
+  return true;
+}
+
+void Http2Parser::CompleteStream(Stream& stream) {
+  if (stream.expectedLength >= 0 && static_cast<uint64_t>(stream.expectedLength) != stream.receivedLength) {
+    StreamError(stream.id, Http2ErrorCode::PROTOCOL_ERROR);
+    return;
+  }
+  stream.dispatched = true;
+  ready_.emplace_back(stream.id, std::move(stream.request));
+}
+
+bool Http2Parser::OnSettings(const Http2FrameHeader& h, const uint8_t* payload) {
+  if (h.stream_id != 0) return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+  settingsReceived_ = true;
+  if (h.flags & kHttp2FlagAck) {
+    return h.length == 0 ? true : ConnectionError(Http2ErrorCode::FRAME_SIZE_ERROR);
+  }
+  if (h.length % 6 != 0) return ConnectionError(Http2ErrorCode::FRAME_SIZE_ERROR);
+
+  for (uint32_t off = 0; off < h.length; off += 6) {
+    const uint16_t id = static_cast<uint16_t>((payload[off] << 8) | payload[off + 1]);
+    const uint32_t value = ReadHttp2Uint32(payload + off + 2);
+    switch (static_cast<Http2SettingId>(id)) {
+      case Http2SettingId::ENABLE_PUSH:
+        if (value > 1) return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+        break;
+      case Http2SettingId::INITIAL_WINDOW_SIZE: {
+        if (value > kHttp2MaxWindowSize) return ConnectionError(Http2ErrorCode::FLOW_CONTROL_ERROR);
+        // 新的初始窗口按差值作用于所有已打开的流（RFC 9113 6.9.2）
+        const int64_t delta = static_cast<int64_t>(value) - peerInitialWindow_;
+        for (auto& [sid, stream] : streams_) {
+          stream->sendWindow += delta;
+          if (stream->sendWindow > kHttp2MaxWindowSize) {
+            return ConnectionError(Http2ErrorCode::FLOW_CONTROL_ERROR);
+          }
+        }
+        peerInitialWindow_ = value;
+        break;
+      }
+      case Http2SettingId::MAX_FRAME_SIZE:
+        if (value < kHttp2DefaultMaxFrameSize || value > kHttp2MaxFrameSizeLimit) {
+          return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+        }
+        peerMaxFrameSize_ = value;
+        break;
+      default:
+        // HEADER_TABLE_SIZE：本端编码器不使用动态表；其余设置只约束对端
+        break;
+    }
+  }
+  AppendHttp2FrameHeader(control_, 0, Http2FrameType::SETTINGS, kHttp2FlagAck, 0);
+  return true;
+}
+
+bool Http2Parser::OnWindowUpdate(const Http2FrameHeader& h, const uint8_t* payload) {
+  if (h.length != 4) return ConnectionError(Http2ErrorCode::FRAME_SIZE_ERROR);
+  const uint32_t increment = ReadHttp2Uint32(payload) & 0x7fffffffu;
+
+  if (h.stream_id == 0) {
+    if (increment == 0) return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+    if (connSendWindow_ + increment > kHttp2MaxWindowSize) {
+      return ConnectionError(Http2ErrorCode::FLOW_CONTROL_ERROR);
+    }
+    connSendWindow_ += increment;
+    return true;
+  }
+
+  auto it = streams_.find(h.stream_id);
+  if (it == streams_.end()) {
+    if (h.stream_id > lastPeerStreamId_) return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+    return true;
+  }
+  Stream& s = *it->second;
+  if (increment == 0) {
+    StreamError(s.id, Http2ErrorCode::PROTOCOL_ERROR);
+  } else if (s.sendWindow + increment > kHttp2MaxWindowSize) {
+    StreamError(s.id, Http2ErrorCode::FLOW_CONTROL_ERROR);
+  } else {
+    s.sendWindow += increment;
+  }
+  return true;
+}
+
+bool Http2Parser::OnRstStream(const Http2FrameHeader& h, const uint8_t* /*payload*/) {
+  if (h.length != 4) return ConnectionError(Http2ErrorCode::FRAME_SIZE_ERROR);
+  if (h.stream_id == 0 || h.stream_id > lastPeerStreamId_) {
+    return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+  }
+  // 对端取消：worker 之后提交的响应会因流不存在而被丢弃
+  CloseStream(h.stream_id);
+  return true;
+}
+
+bool Http2Parser::OnPing(const Http2FrameHeader& h, const uint8_t* payload) {
+  if (h.stream_id != 0) return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+  if (h.length != 8) return ConnectionError(Http2ErrorCode::FRAME_SIZE_ERROR);
+  if (!(h.flags & kHttp2FlagAck)) {
+    AppendHttp2FrameHeader(control_, 8, Http2FrameType::PING, kHttp2FlagAck, 0);
+    control_.append(reinterpret_cast<const char*>(payload), 8);
+  }
+  return true;
+}
+
+bool Http2Parser::OnGoAway(const Http2FrameHeader& h, const uint8_t* /*payload*/) {
+  if (h.stream_id != 0) return ConnectionError(Http2ErrorCode::PROTOCOL_ERROR);
+  if (h.length < 8) return ConnectionError(Http2ErrorCode::FRAME_SIZE_ERROR);
+  // 对端不再发起新流：已有的流照常完成，之后关闭连接
+  peerGoAway_ = true;
+  return true;
+}
+
+bool Http2Parser::PopRequest(std::unique_ptr<IHttpMessage>& out, uint32_t& stream_id) {
+  while (!ready_.empty()) {
+    auto [id, request] = std::move(ready_.front());
+    ready_.pop_front();
+    if (streams_.find(id) == streams_.end()) continue;
+    out = std::move(request);
+    stream_id = id;
+    lastPoppedStreamId_ = id;
+    return true;
+  }
+  return false;
+}
+
+void Http2Parser::SubmitResponse(uint32_t stream_id, std::string header_block, std::string body,
+                                 int file_fd, off_t file_offset, size_t file_length) {
+  auto it = streams_.find(stream_id);
+  if (it == streams_.end() || it->second->responded) {
+    if (file_fd >= 0) ::close(file_fd);
+    return;
+  }
+  Stream& s = *it->second;
+  s.responded = true;
+  s.headBlock = std::move(header_block);
+  s.body = std::move(body);
+  s.fileFd = file_fd;
+  s.fileOffset = file_offset;
+  s.fileRemaining = file_fd >= 0 ? file_length : 0;
+  sendQueue_.push_back(stream_id);
+}
+
+void Http2Parser::SubmitStreamingResponse(uint32_t stream_id, std::string header_block, std::string first) {
+  auto it = streams_.find(stream_id);
+  if (it == streams_.end() || it->second->responded) {
+    return;
+  }
+  SubmitResponse(stream_id, std::move(header_block), std::move(first));
+  it->second->bodyOpen = true;
+}
+
+bool Http2Parser::AppendResponseBody(uint32_t stream_id, std::string piece, bool end) {
+  auto it = streams_.find(stream_id);
+  if (it == streams_.end() || !it->second->bodyOpen) {
+    return false;
+  }
+  Stream& s = *it->second;
+  // 已写出的前缀不再需要：通常整段都已写出，直接换成新的一段
+  if (s.bodyOffset == s.body.size()) {
+    s.body = std::move(piece);
+  } else {
+    s.body.erase(0, s.bodyOffset);
+    s.body += piece;
+  }
+  s.bodyOffset = 0;
+  s.bodyOpen = !end;
+  return true;
+}
+
+void Http2Parser::CollectBodyDemand(std::vector<uint32_t>& out) const {
+  if (connSendWindow_ <= 0) return;
+  for (const auto& [id, stream] : streams_) {
+    const Stream& s = *stream;
+    if (s.bodyOpen && s.bodyOffset == s.body.size() && s.sendWindow > 0) {
+      out.push_back(id);
+    }
+  }
+}
+
+void Http2Parser::ResetStream(uint32_t stream_id, Http2ErrorCode code) {
+  if (streams_.find(stream_id) != streams_.end()) {
+    StreamError(stream_id, code);
+  }
+}
+
+bool Http2Parser::Flush(OutputSink& sink, size_t budget) {
+  bool wrote = false;
+  std::string batch;
+  batch.swap(control_);
+
+  // 轮转：每个流每轮最多写一帧，窗口或预算不足的流留在队列中等待 WINDOW_UPDATE 或下一次 Flush
+  size_t blocked_in_row = 0;
+  while (!sendQueue_.empty() && blocked_in_row < sendQueue_.size()) {
+    const uint32_t id = sendQueue_.front();
+    sendQueue_.pop_front();
+    auto it = streams_.find(id);
+    if (it == streams_.end()) continue;
+    const StepResult r = StepStream(*it->second, sink, batch, budget, wrote);
+    if (r == StepResult::Done) {
+      streams_.erase(it);
+      blocked_in_row = 0;
+      continue;
+    }
+    sendQueue_.push_back(id);
+    blocked_in_row = r == StepResult::Blocked ? blocked_in_row + 1 : 0;
+  }
+
+  if (!batch.empty()) {
+    sink.Write(batch.data(), batch.size());
+    wrote = true;
+  }
+  return wrote;
+}
+
+Http2Parser::StepResult Http2Parser::StepStream(Stream& s, OutputSink& sink, std::string& batch,
+                                                size_t& budget, bool& wrote) {
+  const bool has_body = s.bodyOffset < s.body.size();
+  if (!s.headSent) {
+    const bool has_data = has_body || s.fileRemaining > 0 || s.bodyOpen;
+    AppendHeaderFrames(s, !has_data, batch);
+    s.headSent = true;
+    std::string().swap(s.headBlock);
+    if (!has_data) {
+      ReleaseStreamFile(s);
+      return StepResult::Done;
+    }
+    return StepResult::Progress;
+  }
+
+  if (!has_body && s.fileRemaining == 0) {
+    // 按需生成的 body：等待下一段；生成已结束但没有剩余字节时以空 DATA 帧结束流（不占窗口）
+    if (s.bodyOpen) return StepResult::Blocked;
+    AppendHttp2FrameHeader(batch, 0, Http2FrameType::DATA, kHttp2FlagEndStream, s.id);
+    return StepResult::Done;
+  }
+
+  const int64_t window = std::min(connSendWindow_, s.sendWindow);
+  size_t avail = window > 0 ? std::min<size_t>(static_cast<size_t>(window), peerMaxFrameSize_) : 0;
+  avail = std::min(avail, budget);
+  if (avail == 0) return StepResult::Blocked;
+
+  if (has_body) {
+    const size_t n = std::min(avail, s.body.size() - s.bodyOffset);
+    const bool end = s.bodyOffset + n == s.body.size() && s.fileRemaining == 0 && !s.bodyOpen;
+    AppendHttp2FrameHeader(batch, static_cast<uint32_t>(n), Http2FrameType::DATA,
+                           end ? kHttp2FlagEndStream : 0, s.id);
+    batch.append(s.body, s.bodyOffset, n);
+    s.bodyOffset += n;
+    connSendWindow_ -= static_cast<int64_t>(n);
+    s.sendWindow -= static_cast<int64_t>(n);
+    budget -= n;
+    if (end) {
+      ReleaseStreamFile(s);
+      return StepResult::Done;
+    }
+    return StepResult::Progress;
+  }
+
+  // 文件负载：帧头随前面的字节一起写出，负载作为紧随其后的 sendfile 区间；最后一段转移 fd 所有权
+  const size_t n = std::min(avail, s.fileRemaining);
+  const bool end = n == s.fileRemaining;
+  AppendHttp2FrameHeader(batch, static_cast<uint32_t>(n), Http2FrameType::DATA,
+                         end ? kHttp2FlagEndStream : 0, s.id);
+  sink.Write(batch.data(), batch.size());
+  batch.clear();
+  sink.WriteFile(s.fileFd, s.fileOffset, n, end);
+  wrote = true;
+  s.fileOffset += static_cast<off_t>(n);
+  s.fileRemaining -= n;
+  connSendWindow_ -= static_cast<int64_t>(n);
+  s.sendWindow -= static_cast<int64_t>(n);
+  budget -= n;
+  if (end) {
+    s.fileFd = -1;
+    return StepResult::Done;
+  }
+  s.fileHandedOut = true;
+  return StepResult::Progress;
+}
+
+void Http2Parser::AppendHeaderFrames(const Stream& s, bool end_stream, std::string& batch) const {
+  // 头部块超过对端最大帧长时拆成 HEADERS + CONTINUATION，END_STREAM 只能标在 HEADERS 上
+  const std::string& block = s.headBlock;
+  size_t off = 0;
+  bool first = true;
+  do {
+    const size_t n = std::min<size_t>(block.size() - off, peerMaxFrameSize_);
+    uint8_t flags = off + n == block.size() ? kHttp2FlagEndHeaders : 0;
+    if (first && end_stream) flags |= kHttp2FlagEndStream;
+    AppendHttp2FrameHeader(batch, static_cast<uint32_t>(n),
+                           first ? Http2FrameType::HEADERS : Http2FrameType::CONTINUATION, flags, s.id);
+    batch.append(block, off, n);
+    off += n;
+    first = false;
+  } while (off < block.size());
+}
+
+bool Http2Parser::ShouldClose() const {
+  return failed_ || ((goAwaySent_ || peerGoAway_) && streams_.empty() && ready_.empty());
+}
+
+bool Http2Parser::ConnectionError(Http2ErrorCode code) {
+  if (!goAwaySent_) QueueGoAway(code);
+  failed_ = true;
+  for (auto& [id, stream] : streams_) {
+    ReleaseStreamFile(*stream);
+  }
+  streams_.clear();
+  ready_.clear();
+  sendQueue_.clear();
+  return false;
+}
+
+void Http2Parser::StreamError(uint32_t stream_id, Http2ErrorCode code) {
+  QueueRstStream(stream_id, code);
+  CloseStream(stream_id);
+}
+
+void Http2Parser::CloseStream(uint32_t stream_id) {
+  auto it = streams_.find(stream_id);
+  if (it == streams_.end()) return;
+  ReleaseStreamFile(*it->second);
+  streams_.erase(it);
+}
+
+void Http2Parser::ReleaseStreamFile(Stream& s) {
+  if (s.fileFd < 0) return;
+  if (s.fileHandedOut) {
+    orphanFds_.push_back(s.fileFd);
+  } else {
+    ::close(s.fileFd);
+  }
+  s.fileFd = -1;
+  s.fileRemaining = 0;
+}
+
+void Http2Parser::QueueWindowUpdate(uint32_t stream_id, uint32_t increment) {
+  AppendHttp2FrameHeader(control_, 4, Http2FrameType::WINDOW_UPDATE, 0, stream_id);
+  AppendHttp2Uint32(control_, increment & 0x7fffffffu);
+}
+
+void Http2Parser::QueueRstStream(uint32_t stream_id, Http2ErrorCode code) {
+  AppendHttp2FrameHeader(control_, 4, Http2FrameType::RST_STREAM, 0, stream_id);
+  AppendHttp2Uint32(control_, static_cast<uint32_t>(code));
+}
+
+void Http2Parser::QueueGoAway(Http2ErrorCode code) {
+  AppendHttp2FrameHeader(control_, 8, Http2FrameType::GOAWAY, 0, 0);
+  AppendHttp2Uint32(control_, lastPeerStreamId_);
+  AppendHttp2Uint32(control_, static_cast<uint32_t>(code));
+  goAwaySent_ = true;
+}
+
+void Http2Parser::ReplenishConnectionWindow(uint32_t consumed) {
+  connRecvUnacked_ += consumed;
+  if (connRecvUnacked_ >= settings_.connectionWindowSize / 2) {
+    QueueWindowUpdate(0, connRecvUnacked_);
+    connRecvWindow_ += connRecvUnacked_;
+    connRecvUnacked_ = 0;
+  }
+}
+
+void Http2Parser::EncodeResponseHead(const HttpResponse& response, std::string& block) {
+  HpackEncoder::EncodeStatus(response.getStatusCodeInt(), block);
+  std::string lowered;
+  response.ForEachWireHeader([&](std::string_view name, std::string_view value) {
+    // 头部表中的名称已是小写，预渲染块中的名称按 HTTP/1 习惯书写
+    if (HasUpperAscii(name)) {
+      lowered.assign(name);
+      for (char& c : lowered) c = ToLowerAscii(c);
+      name = lowered;
+    }
+    if (IsConnectionSpecificHeader(name)) return;
+    HpackEncoder::Encode(name, value, block);
+  });
 }
-/* size_t Http2Parser::GetActiveStreamCount() const {
-  return activeStreams_.size(); 
-} */
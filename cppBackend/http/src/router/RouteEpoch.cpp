@@ -0,0 +1,100 @@
+#include "router/RouteEpoch.h"
+
+#include <algorithm>
+
+// 线程退出时归还读者记录，供之后的线程复用
+struct RouteEpochLocal {
+  RouteEpoch::ReaderRecord* record{nullptr};
+  ~RouteEpochLocal() {
+    if (record) RouteEpoch::Instance().ReleaseRecord(record);
+  }
+};
+
+namespace {
+thread_local RouteEpochLocal t_local;
+}  // namespace
+
+RouteEpoch& RouteEpoch::Instance() {
+  // 有意不析构：其他线程的 thread_local 记录可能在静态对象析构之后才归还
+  static RouteEpoch* instance = new RouteEpoch();
+  return *instance;
+}
+
+RouteEpoch::ReaderRecord* RouteEpoch::LocalRecord() {
+  if (!t_local.record) t_local.record = AcquireRecord();
+  return t_local.record;
+}
+
+RouteEpoch::ReaderRecord* RouteEpoch::AcquireRecord() {
+  for (ReaderRecord* r = readers_.load(std::memory_order_acquire); r; r = r->next) {
+    bool expected = false;
+    if (!r->inUse.load(std::memory_order_relaxed) &&
+        r->inUse.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+      return r;
+    }
+  }
+  auto* record = new ReaderRecord();
+  record->inUse.store(true, std::memory_order_relaxed);
+  ReaderRecord* head = readers_.load(std::memory_order_relaxed);
+  do {
+    record->next = head;
+  } while (!readers_.compare_exchange_weak(head, record, std::memory_order_release, std::memory_order_relaxed));
+  return record;
+}
+
+void RouteEpoch::ReleaseRecord(ReaderRecord* record) {
+  record->epoch.store(0, std::memory_order_seq_cst);
+  record->depth = 0;
+  record->inUse.store(false, std::memory_order_release);
+}
+
+void RouteEpoch::Enter() {
+  ReaderRecord* record = LocalRecord();
+  if (record->depth++ > 0) return;
+  // 先公布纪元再读取发布点（均为 seq_cst）：写者回收时要么看到本线程的纪元，
+  // 要么本线程随后读到的已经是新对象
+  record->epoch.store(epoch_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+}
+
+void RouteEpoch::Exit() {
+  ReaderRecord* record = t_local.record;
+  if (--record->depth > 0) return;
+  record->epoch.store(0, std::memory_order_release);
+}
+
+uint64_t RouteEpoch::MinActiveEpoch() const {
+  uint64_t min_epoch = UINT64_MAX;
+  for (ReaderRecord* r = readers_.load(std::memory_order_acquire); r; r = r->next) {
+    const uint64_t e = r->epoch.load(std::memory_order_seq_cst);
+    if (e != 0) min_epoch = std::min(min_epoch, e);
+  }
+  return min_epoch;
+}
+
+void RouteEpoch::Retire(std::function<void()> deleter) {
+  // 摘下旧对象之后推进纪元：此后进入的读者公布的纪元都不小于 retire_epoch
+  const uint64_t retire_epoch = epoch_.fetch_add(1, std::memory_order_seq_cst) + 1;
+  {
+    std::lock_guard<std::mutex> lock(retireMutex_);
+    retired_.emplace_back(retire_epoch, std::move(deleter));
+  }
+  Reclaim();
+}
+
+size_t RouteEpoch::Reclaim() {
+  std::vector<std::function<void()>> ready;
+  size_t pending = 0;
+  {
+    std::lock_guard<std::mutex> lock(retireMutex_);
+    if (retired_.empty()) return 0;
+    const uint64_t min_epoch = MinActiveEpoch();
+    auto keep = std::stable_partition(retired_.begin(), retired_.end(),
+                                      [min_epoch](const auto& item) { return item.first > min_epoch; });
+    for (auto it = keep; it != retired_.end(); ++it) ready.push_back(std::move(it->second));
+    retired_.erase(keep, retired_.end());
+    pending = retired_.size();
+  }
+  // 在锁外执行释放动作，析构路由表时可能再次进入路由相关代码
+  for (auto& deleter : ready) deleter();
+  return pending;
+}
@@ -1,14 +1,33 @@
 #include "router/Router.h"
 
 #include <algorithm>
+#include <cstring>
 #include <sstream>
 #include <cctype>
 #include <unordered_set>
 #include <mutex>
+#include "router/RouteEpoch.h"
 #include "util/HttpStringUtil.h"
 
 // ========== 工具函数实现 ==========
 
+namespace {
+
+// lower 必须已是小写
+bool EqualsLowered(std::string_view s, std::string_view lower) {
+  for (size_t i = 0; i < lower.size(); ++i) {
+    if (ToLowerAscii(s[i]) != lower[i]) return false;
+  }
+  return true;
+}
+
+const RouteParams::QueryMap& EmptyQueryMap() {
+  static const RouteParams::QueryMap empty;
+  return empty;
+}
+
+}  // namespace
+
 std::string Router::NormalizePath(const std::string& path, bool removeTrailingSlash) {
   if (path.empty()) {
     return "/";
@@ -43,327 +62,485 @@ std::string Router::NormalizePath(const std::string& path, bool removeTrailingSl
     normalized.pop_back();
   }
 
-  LowerAsciiInPlace(normalized);
   return normalized;
 }
 
-bool Router::IsStaticPath(const std::string& path) {
-  // 【优化】检查路径中是否包含参数标记(:)或通配符(*)
-  // 使用范围for循环和早期返回优化性能
-  for (char c : path) {
-    if (c == ':' || c == '*') {
-      return false;
-    }
+bool Router::IsCanonicalPath(std::string_view path) {
+  if (path.empty() || path[0] != '/') {
+    return false;
   }
-  return true;
+  if (path.size() > 1 && path.back() == '/') {
+    return false;
+  }
+  return path.find("//") == std::string_view::npos;
 }
 
 // ========== RouteParams 实现 ==========
 
-std::optional<std::string> RouteParams::GetParam(const std::string& key) const {
-  auto it = params_.find(LowerAsciiCopy(key));
-  if (it != params_.end()) {
-    return it->second;
+std::optional<std::string_view> RouteParams::GetParamView(std::string_view key) const {
+  for (size_t i = 0; i < paramCount_; ++i) {
+    if (EqualsIgnoreCaseAscii(params_[i].name, key)) {
+      return params_[i].value;
+    }
   }
   return std::nullopt;
 }
 
-std::string RouteParams::GetWildcard() const {
-  if (wildcards_.empty()) {
-    return "";
+std::optional<std::string> RouteParams::GetParam(const std::string& key) const {
+  if (auto value = GetParamView(key)) {
+    return std::string(*value);
   }
-  return wildcards_[0];
+  return std::nullopt;
 }
 
 std::optional<std::string> RouteParams::GetQueryParam(const std::string& key) const {
-  auto it = queryParams_.find(LowerAsciiCopy(key));
-  if (it != queryParams_.end() && !it->second.empty()) {
+  const auto& query = GetAllQueryParams();
+  auto it = query.find(LowerAsciiCopy(key));
+  if (it != query.end() && !it->second.empty()) {
     return it->second[0];  // 返回第一个值
   }
   return std::nullopt;
 }
 
 std::vector<std::string> RouteParams::GetQueryParams(const std::string& key) const {
-  auto it = queryParams_.find(LowerAsciiCopy(key));
-  if (it != queryParams_.end()) {
+  const auto& query = GetAllQueryParams();
+  auto it = query.find(LowerAsciiCopy(key));
+  if (it != query.end()) {
     return it->second;
   }
   return {};
 }
 
-// HasQueryParam 和 GetAllQueryParams 已内联到头文件中
+bool RouteParams::HasQueryParam(const std::string& key) const {
+  const auto& query = GetAllQueryParams();
+  return query.find(LowerAsciiCopy(key)) != query.end();
+}
+
+const RouteParams::QueryMap& RouteParams::GetAllQueryParams() const {
+  return queryParams_ ? *queryParams_ : EmptyQueryMap();
+}
 
 void RouteParams::Clear() {
-  params_.clear();
-  wildcards_.clear();
-  queryParams_.clear();
+  paramCount_ = 0;
+  wildcard_ = std::string_view();
+  queryParams_ = nullptr;
 }
 
 // ========== RouteNode 实现 ==========
 
 RouteNode::RouteNode() = default;
 
-void RouteNode::SplitPathToViews(std::string_view path, std::vector<std::string_view>& segments) {
-  segments.clear();
-  segments.reserve(8);  // 预分配空间
-  
-  if (path.empty() || path == "/") {
-    segments.push_back("/");
-    return;
-  }
-  
-  size_t start = 0;
-  for (size_t i = 0; i < path.length(); ++i) {
-    if (path[i] == '/') {
-      if (i > start) {
-        segments.push_back(path.substr(start, i - start));
-      }
-      start = i + 1;
+RouteNode* RouteNode::InsertStatic(std::string_view text) {
+  RouteNode* current = this;
+  while (!text.empty()) {
+    size_t idx = current->indices_.find(text[0]);
+    if (idx == std::string::npos) {
+      auto child = std::make_unique<RouteNode>();
+      child->prefix_ = std::string(text);
+      RouteNode* raw = child.get();
+      current->indices_.push_back(text[0]);
+      current->children_.push_back(std::move(child));
+      return raw;
     }
+    
+    RouteNode* child = current->children_[idx].get();
+    size_t common = 0;
+    while (common < text.size() && common < child->prefix_.size() && text[common] == child->prefix_[common]) {
+      ++common;
+    }
+    
+    // 只共享部分前缀：把已有子节点分裂为 公共前缀 + 剩余部分
+    if (common < child->prefix_.size()) {
+      auto split = std::make_unique<RouteNode>();
+      split->prefix_ = child->prefix_.substr(0, common);
+      child->prefix_.erase(0, common);
+      split->indices_.push_back(child->prefix_[0]);
+      split->children_.push_back(std::move(current->children_[idx]));
+      child = split.get();
+      current->children_[idx] = std::move(split);
+    }
+    
+    current = child;
+    text.remove_prefix(common);
   }
-  
-  // 处理最后一段
-  if (start < path.length()) {
-    segments.push_back(path.substr(start));
-  }
+  return current;
 }
 
-void RouteNode::AddRoute(HttpMethod method, const std::string& path, RouteHandler handler) {
-  std::vector<std::string_view> segments;
-  SplitPathToViews(path, segments);
-  if (segments.empty()) {
-    return;
+bool RouteNode::AddRoute(HttpMethod method, std::string_view path, RouteHandler handler,
+                         const std::string& executor, BodySinkFactory bodySink) {
+  const size_t methodIndex = static_cast<size_t>(method);
+  if (path.empty() || path[0] != '/' || methodIndex >= kRouteMethodCount) {
+    return false;
   }
   
   RouteNode* current = this;
   std::vector<std::string> paramNames; // 用于收集参数名
-  
-  for (size_t i = 0; i < segments.size(); ++i) {
-    std::string_view segment = segments[i];
-    
-    // 检查是否是参数段 (:param)
-    if (!segment.empty() && segment[0] == ':') {
-      std::string paramName(segment.substr(1));
-      if (paramName.empty()) {
+  bool wildcard = false;
+  
+  size_t pos = 0;
+  while (pos < path.size()) {
+    // 检查是否是参数段 (:param)，参数只能占据一个完整路径段
+    if (path[pos] == ':' && path[pos - 1] == '/') {
+      size_t end = path.find('/', pos);
+      if (end == std::string_view::npos) end = path.size();
+      std::string paramName(path.substr(pos + 1, end - pos - 1));
+      if (paramName.empty() || paramNames.size() >= kMaxRouteParams) {
         #ifdef DEBUG_ROUTER
-        fprintf(stderr, "[Router Error] Invalid parameter name in path: '%s'\n", path.c_str());
+        fprintf(stderr, "[Router Error] Invalid parameter in path: '%.*s'\n", static_cast<int>(path.size()), path.data());
         #endif
-        return;  // 无效参数名
+        return false;  // 无效参数名或参数过多
       }
-      paramNames.push_back(paramName); // 收集参数名
+      paramNames.push_back(std::move(paramName)); // 收集参数名（保留原始大小写，查询时忽略大小写）
       
-      if (!current->paramNode_) {
-        current->paramNode_ = std::make_unique<RouteNode>();
+      if (!current->paramChild_) {
+        current->paramChild_ = std::make_unique<RouteNode>();
       }
-      // 不再存储 paramName_ 在 RouteNode 中
-      current = current->paramNode_.get();
+      current = current->paramChild_.get();
+      pos = end;
+      continue;
     }
-    // 检查是否是通配符 (*)
-    else if (segment == "*") {
-      if (i != segments.size() - 1) {
-        // 通配符只能在最后
-        #ifdef DEBUG_ROUTER
-        fprintf(stderr, "[Router Error] Wildcard must be at the end of path: '%s'\n", path.c_str());
-        #endif
-        return;
-      }
-      
-      if (!current->wildcardNode_) {
-        current->wildcardNode_ = std::make_unique<RouteNode>();
-      }
-      current = current->wildcardNode_.get();
-      
-      // 【改进】重复路由检测：检查该方法是否已注册
-      if (current->wildcardRoutes_.count(method)) { // 使用 count 代替 find != end
+    
+    // 检查是否是通配符 (*)，通配符必须是最后一个完整路径段
+    if (path[pos] == '*' && path[pos - 1] == '/') {
+      if (pos + 1 != path.size()) {
         #ifdef DEBUG_ROUTER
-        fprintf(stderr, "[Router Warning] Route already exists: %s %s (overwriting)\n",
-                HttpMethodToString(method).c_str(), path.c_str());
+        fprintf(stderr, "[Router Error] Wildcard must be at the end of path: '%.*s'\n", static_cast<int>(path.size()), path.data());
         #endif
+        return false;
       }
-      
-      current->wildcardRoutes_[method] = {handler, paramNames}; // 存储 handler 和 paramNames
-      return;
+      wildcard = true;
+      break;
     }
-    // 精确匹配
-    else {
-      std::string segmentStr(segment); // 转换为 std::string 用于查找和存储
-      if (current->children_.find(segmentStr) == current->children_.end()) {
-        current->children_[segmentStr] = std::make_unique<RouteNode>();
-      }
-      current = current->children_[segmentStr].get();
+    
+    // 静态部分：一直到下一个参数段或通配符段，统一以小写存入树中
+    size_t end = pos;
+    while (end < path.size()) {
+      if ((path[end] == ':' || path[end] == '*') && end > 0 && path[end - 1] == '/') break;
+      ++end;
     }
-  }
-  
-  // 在最后一个节点注册路由
-  // 【改进】重复路由检测：检查该路径和方法是否已注册
-  if (current->exactRoutes_.count("/")) { // 使用 count 代替 find != end
-    auto& methodMap = current->exactRoutes_["/"];
-    if (methodMap.count(method)) {
-      #ifdef DEBUG_ROUTER
-      fprintf(stderr, "[Router Warning] Route already exists: %s %s (overwriting)\n",
-              HttpMethodToString(method).c_str(), path.c_str());
-      #endif
+    std::string text = LowerAsciiCopy(path.substr(pos, end - pos));
+    current = current->InsertStatic(text);
+    pos = end;
+  }
+  
+  auto& slots = wildcard ? current->wildcardRoutes_ : current->routes_;
+  auto& slot = slots[methodIndex];
+  #ifdef DEBUG_ROUTER
+  if (slot) {
+    fprintf(stderr, "[Router Warning] Route already exists: method=%zu %.*s (overwriting)\n",
+            methodIndex, static_cast<int>(path.size()), path.data());
+  }
+  #endif
+  // 覆盖时复用原表项
+  if (!slot) slot = std::make_unique<RouteEntry>();
+  *slot = RouteEntry{std::move(handler), std::move(paramNames), executor, std::move(bodySink)};
+  (wildcard ? current->wildcardMask_ : current->routeMask_) |= 1u << methodIndex;
+  return true;
+}
+
+const RouteNode* RouteNode::FindStaticChild(std::string_view path, size_t pos) const {
+  const char first = ToLowerAscii(path[pos]);
+  for (size_t i = 0; i < indices_.size(); ++i) {
+    if (indices_[i] != first) continue;
+    const RouteNode* child = children_[i].get();
+    const std::string& prefix = child->prefix_;
+    if (path.size() - pos >= prefix.size() && EqualsLowered(path.substr(pos, prefix.size()), prefix)) {
+      return child;
     }
+    return nullptr;  // 首字节相同的子节点至多一个
   }
-  
-  current->exactRoutes_["/"][method] = {handler, paramNames}; // 存储 handler 和 paramNames
+  return nullptr;
 }
 
-// 递归匹配辅助函数（优化版：一次性收集所有允许的方法）
-RouteResult RouteNode::MatchRouteRecursive(
-    HttpMethod method, const std::vector<std::string_view>& segments, 
-    size_t segmentIndex, RouteParams& params, 
-    std::vector<std::string>& currentParamValues) const {
+const RouteEntry* RouteNode::MatchFrom(size_t method, std::string_view path, size_t pos,
+                                       RouteParams& params) const {
+  if (pos == path.size()) {
+    if (const RouteEntry* entry = routes_[method].get()) {
+      return entry;
+    }
+    // 通配符也可以匹配空的剩余部分，如 /* 匹配 /
+    if (const RouteEntry* entry = wildcardRoutes_[method].get()) {
+      params.wildcard_ = std::string_view();
+      return entry;
+    }
+    return nullptr;
+  }
   
-  RouteResult result;
+  // 1. 优先尝试静态匹配（更具体的路由优先）
+  if (const RouteNode* child = FindStaticChild(path, pos)) {
+    if (const RouteEntry* entry = child->MatchFrom(method, path, pos + child->prefix_.size(), params)) {
+      return entry;
+    }
+  }
   
-  // 如果已经处理完所有段，检查当前节点是否有匹配的路由
-  if (segmentIndex >= segments.size()) {
-    auto exactIt = exactRoutes_.find("/");
-    if (exactIt != exactRoutes_.end()) {
-      // 收集该节点支持的所有方法
-      result.allowedMethods.reserve(exactIt->second.size());
-      for (const auto& methodPair : exactIt->second) {
-        result.allowedMethods.push_back(methodPair.first);
-      }
-      result.pathMatched = true;
-      
-      // 查找匹配的方法
-      auto methodIt = exactIt->second.find(method);
-      if (methodIt != exactIt->second.end()) {
-        result.handler = methodIt->second.first; // 获取 handler
-        // 根据存储的参数名列表填充params
-        const auto& storedParamNames = methodIt->second.second;
-        for (size_t i = 0; i < storedParamNames.size() && i < currentParamValues.size(); ++i) {
-          result.params.params_[storedParamNames[i]] = currentParamValues[i];
-        }
-        result.params.queryParams_ = params.queryParams_; // 复制查询参数
-      }
+  // 2. 尝试参数匹配：参数值为到下一个 '/' 为止的非空段
+  if (paramChild_ && path[pos] != '/' && params.paramCount_ < kMaxRouteParams) {
+    size_t end = path.find('/', pos);
+    if (end == std::string_view::npos) end = path.size();
+    params.params_[params.paramCount_++].value = path.substr(pos, end - pos);
+    if (const RouteEntry* entry = paramChild_->MatchFrom(method, path, end, params)) {
+      return entry;
     }
-    return result;
+    --params.paramCount_;  // 回溯
   }
   
-  std::string_view segment = segments[segmentIndex];
+  // 3. 尝试通配符匹配（最后尝试），匹配所有剩余部分
+  if (const RouteEntry* entry = wildcardRoutes_[method].get()) {
+    params.wildcard_ = path.substr(pos);
+    return entry;
+  }
+  return nullptr;
+}
+
+const RouteEntry* RouteNode::MatchRoute(HttpMethod method, std::string_view path, RouteParams& params) const {
+  const size_t methodIndex = static_cast<size_t>(method);
+  params.paramCount_ = 0;
+  params.wildcard_ = std::string_view();
+  if (methodIndex >= kRouteMethodCount) {
+    return nullptr;
+  }
   
-  // 1. 优先尝试精确匹配（更具体的路由优先）
-  std::string segmentStr(segment); // 转换为 std::string 用于查找
-  auto childIt = children_.find(segmentStr);
-  if (childIt != children_.end()) {
-    auto childResult = childIt->second->MatchRouteRecursive(method, segments, segmentIndex + 1, params, currentParamValues);
-    if (childResult.IsSuccess()) {
-      return childResult;
-    }
-    // 即使处理器未匹配，如果路径匹配了，也要保留该信息和允许的方法
-    if (childResult.pathMatched) {
-      result.pathMatched = true;
-      result.allowedMethods = std::move(childResult.allowedMethods);
-    }
+  const RouteEntry* entry = MatchFrom(methodIndex, path, prefix_.size(), params);
+  if (!entry) {
+    params.paramCount_ = 0;
+    return nullptr;
   }
   
-  // 2. 尝试参数匹配
-  if (paramNode_) {
-    // 暂存当前路径段值（转换为 std::string）
-    currentParamValues.push_back(std::string(segment));
-    
-    auto paramResult = paramNode_->MatchRouteRecursive(method, segments, segmentIndex + 1, params, currentParamValues);
-    if (paramResult.IsSuccess()) {
-      return paramResult;
-    }
-    
-    // 回溯：移除暂存的参数值
-    currentParamValues.pop_back();
-    
-    // 合并路径匹配信息和支持的方法（避免重复）
-    if (paramResult.pathMatched) {
-      result.pathMatched = true;
-      // 如果result还没有方法列表，直接移动
-      if (result.allowedMethods.empty()) {
-        result.allowedMethods = std::move(paramResult.allowedMethods);
-      } else {
-        // 否则合并（去重）
-        for (const auto& m : paramResult.allowedMethods) {
-          if (std::find(result.allowedMethods.begin(), result.allowedMethods.end(), m) == result.allowedMethods.end()) {
-            result.allowedMethods.push_back(m);
-          }
-        }
-      }
+  // 参数名来自命中的路由表项：共享同一参数节点的不同路由可以使用不同的参数名
+  const size_t count = std::min(params.paramCount_, entry->paramNames.size());
+  for (size_t i = 0; i < count; ++i) {
+    params.params_[i].name = entry->paramNames[i];
+  }
+  params.paramCount_ = count;
+  return entry;
+}
+
+void RouteNode::CollectAllowed(std::string_view path, size_t pos, uint32_t& mask) const {
+  mask |= wildcardMask_;
+  if (pos == path.size()) {
+    mask |= routeMask_;
+    return;
+  }
+  if (const RouteNode* child = FindStaticChild(path, pos)) {
+    child->CollectAllowed(path, pos + child->prefix_.size(), mask);
+  }
+  if (paramChild_ && path[pos] != '/') {
+    size_t end = path.find('/', pos);
+    paramChild_->CollectAllowed(path, end == std::string_view::npos ? path.size() : end, mask);
+  }
+}
+
+uint32_t RouteNode::AllowedMethodMask(std::string_view path) const {
+  uint32_t mask = 0;
+  CollectAllowed(path, prefix_.size(), mask);
+  return mask;
+}
+
+std::unique_ptr<RouteNode> RouteNode::Clone() const {
+  auto copy = std::make_unique<RouteNode>();
+  copy->prefix_ = prefix_;
+  copy->indices_ = indices_;
+  copy->children_.reserve(children_.size());
+  for (const auto& child : children_) {
+    copy->children_.push_back(child->Clone());
+  }
+  if (paramChild_) {
+    copy->paramChild_ = paramChild_->Clone();
+  }
+  for (size_t i = 0; i < kRouteMethodCount; ++i) {
+    if (routes_[i]) copy->routes_[i] = std::make_unique<RouteEntry>(*routes_[i]);
+    if (wildcardRoutes_[i]) copy->wildcardRoutes_[i] = std::make_unique<RouteEntry>(*wildcardRoutes_[i]);
+  }
+  copy->routeMask_ = routeMask_;
+  copy->wildcardMask_ = wildcardMask_;
+  return copy;
+}
+
+std::vector<HttpMethod> RouteNode::GetAllowedMethods(std::string_view path) const {
+  std::vector<HttpMethod> methods;
+  const uint32_t mask = AllowedMethodMask(path);
+  for (size_t i = 0; i < kRouteMethodCount; ++i) {
+    if (mask & (1u << i)) {
+      methods.push_back(static_cast<HttpMethod>(i));
     }
   }
-  
-  // 3. 尝试通配符匹配（最后尝试）
-  if (wildcardNode_) {
-    // 通配符匹配所有剩余的段
-    std::vector<std::string> wildcardParts;
-    wildcardParts.reserve(segments.size() - segmentIndex);
-    for (size_t j = segmentIndex; j < segments.size(); ++j) {
-      wildcardParts.push_back(std::string(segments[j]));
+  return methods;
+}
+
+// ========== RouteTable 实现 ==========
+
+std::shared_ptr<RouteTable> RouteTable::Clone() const {
+  auto copy = std::make_shared<RouteTable>();
+  copy->root = root->Clone();
+  copy->globalMiddlewares = globalMiddlewares;
+  copy->pathMiddlewares = pathMiddlewares;
+  return copy;
+}
+
+// ========== StaticRouteIndex 实现 ==========
+
+namespace {
+
+constexpr int kStaticIndexSeedAttempts = 16;
+constexpr uint32_t kMaxDisplacement = 1u << 16;
+
+
+// 把 8 个字节中的 'A'-'Z' 同时转为小写（SWAR），高位为 1 的字节保持不变
+inline uint64_t LowerAsciiWord(uint64_t w) {
+  constexpr uint64_t kOnes = 0x0101010101010101ull;
+  const uint64_t low7 = w & (0x7f * kOnes);
+  const uint64_t geA = low7 + ((0x80 - 'A') * kOnes);
+  const uint64_t gtZ = low7 + ((0x80 - 'Z' - 1) * kOnes);
+  const uint64_t upper = geA & ~gtZ & ~w & (0x80 * kOnes);
+  return w | (upper >> 2);
+}
+
+// 把 64 位值均匀映射到 [0, n)，用乘法代替取模
+inline size_t ReduceRange(uint64_t x, size_t n) {
+  return static_cast<size_t>((static_cast<unsigned __int128>(x) * n) >> 64);
+}
+
+}  // namespace
+
+uint64_t StaticRouteIndex::Hash(std::string_view path, uint64_t seed) {
+  // 每次处理 8 字节（先折叠为小写）再乘法混合，fmix64 收尾，让高低 32 位都分布均匀
+  uint64_t h = 0x9E3779B97F4A7C15ull ^ (seed * 0xff51afd7ed558ccdull) ^ path.size();
+  size_t i = 0;
+  for (; i + 8 <= path.size(); i += 8) {
+    uint64_t w;
+    std::memcpy(&w, path.data() + i, 8);
+    h = (h ^ LowerAsciiWord(w)) * 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 29;
+  }
+  if (i < path.size()) {
+    // 不足 8 字节的尾部逐字节拼装（变长 memcpy 会退化为库函数调用）
+    uint64_t w = 0;
+    for (size_t k = 0; i + k < path.size(); ++k) {
+      w |= static_cast<uint64_t>(static_cast<unsigned char>(path[i + k])) << (8 * k);
     }
-    params.wildcards_ = wildcardParts;
-    
-    result.pathMatched = true;
-    
-    // 收集通配符节点支持的所有方法
-    if (result.allowedMethods.empty()) {
-      result.allowedMethods.reserve(wildcardNode_->wildcardRoutes_.size());
-      for (const auto& methodPair : wildcardNode_->wildcardRoutes_) {
-        result.allowedMethods.push_back(methodPair.first);
-      }
-    } else {
-      // 合并方法列表（去重）
-      for (const auto& methodPair : wildcardNode_->wildcardRoutes_) {
-        if (std::find(result.allowedMethods.begin(), result.allowedMethods.end(), methodPair.first) == result.allowedMethods.end()) {
-          result.allowedMethods.push_back(methodPair.first);
+    h = (h ^ LowerAsciiWord(w)) * 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 29;
+  }
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return h;
+}
+
+size_t StaticRouteIndex::SlotOf(uint64_t hash, uint32_t displacement, size_t slotCount) {
+  uint64_t x = hash ^ (static_cast<uint64_t>(displacement) * 0x9E3779B97F4A7C15ull);
+  x ^= x >> 31;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 29;
+  return ReduceRange(x, slotCount);
+}
+
+void StaticRouteIndex::Collect(const RouteNode& node, std::string& path, std::vector<Slot>& out) {
+  const size_t base = path.size();
+  path += node.prefix_;
+  if (node.routeMask_ != 0) {
+    Slot slot;
+    slot.path = path;
+    for (size_t i = 0; i < kRouteMethodCount; ++i) {
+      slot.methods[i] = node.routes_[i].get();
+    }
+    out.push_back(std::move(slot));
+  }
+  // 只沿静态子节点展开：经过参数节点的路径不是精确路径
+  for (const auto& child : node.children_) {
+    Collect(*child, path, out);
+  }
+  path.resize(base);
+}
+
+bool StaticRouteIndex::TryBuild(std::vector<Slot>& slots, uint64_t seed) {
+  const size_t n = slots.size();
+  std::vector<uint64_t> hashes(n);
+  std::vector<std::vector<size_t>> buckets(n);
+  for (size_t i = 0; i < n; ++i) {
+    hashes[i] = Hash(slots[i].path, seed);
+    buckets[ReduceRange(hashes[i], n)].push_back(i);
+  }
+  
+  // 先安置大桶：大桶可选的位移更少
+  std::vector<size_t> order(n);
+  for (size_t i = 0; i < n; ++i) order[i] = i;
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return buckets[a].size() > buckets[b].size(); });
+  
+  std::vector<uint32_t> displacements(n, 0);
+  std::vector<int64_t> placed(n, -1);  // 槽位 -> 原始下标
+  std::vector<size_t> candidate;
+  for (size_t b : order) {
+    const auto& keys = buckets[b];
+    if (keys.empty()) break;
+    bool found = false;
+    for (uint32_t d = 0; d < kMaxDisplacement && !found; ++d) {
+      candidate.clear();
+      found = true;
+      for (size_t key : keys) {
+        size_t slot = SlotOf(hashes[key], d, n);
+        if (placed[slot] >= 0 || std::find(candidate.begin(), candidate.end(), slot) != candidate.end()) {
+          found = false;
+          break;
         }
+        candidate.push_back(slot);
       }
-    }
-    
-    auto wildcardIt = wildcardNode_->wildcardRoutes_.find(method);
-    if (wildcardIt != wildcardNode_->wildcardRoutes_.end()) {
-      result.handler = wildcardIt->second.first; // 获取 handler
-      // 根据存储的参数名列表填充params
-      const auto& storedParamNames = wildcardIt->second.second;
-      for (size_t i = 0; i < storedParamNames.size() && i < currentParamValues.size(); ++i) {
-        result.params.params_[storedParamNames[i]] = currentParamValues[i];
+      if (found) {
+        displacements[b] = d;
+        for (size_t k = 0; k < keys.size(); ++k) placed[candidate[k]] = static_cast<int64_t>(keys[k]);
       }
-      result.params.wildcards_ = params.wildcards_; // 复制通配符
-      result.params.queryParams_ = params.queryParams_; // 复制查询参数
     }
+    if (!found) return false;
   }
   
-  return result;
+  slots_.clear();
+  slots_.reserve(n);
+  for (size_t i = 0; i < n; ++i) slots_.push_back(std::move(slots[static_cast<size_t>(placed[i])]));
+  displacements_ = std::move(displacements);
+  seed_ = seed;
+  return true;
 }
 
-RouteResult RouteNode::MatchRoute(HttpMethod method, const std::string& path) const {
-  RouteParams params; // 注意：params 在 MatchRouteRecursive 中会被修改
-  std::vector<std::string_view> segments;
-  SplitPathToViews(path, segments);
-  if (segments.empty()) {
-    return RouteResult{};
-  }
-  
-  std::vector<std::string> currentParamValues; // 用于收集匹配到的参数值
-  RouteResult result = MatchRouteRecursive(method, segments, 0, params, currentParamValues);
+void StaticRouteIndex::Build(const RouteNode& root) {
+  slots_.clear();
+  displacements_.clear();
+  seed_ = 0;
   
-  // 注意：查询参数不在 MatchRoute 中提取，而是在 Router::Handle 中通过 ExtractQueryParams 提取
-  // 因为查询参数需要从 HttpRequest 中获取，而不是从路径字符串中解析
-
-  return result;
+  std::vector<Slot> slots;
+  std::string path;
+  Collect(root, path, slots);
+  if (slots.empty()) {
+    return;
+  }
+  for (int attempt = 0; attempt < kStaticIndexSeedAttempts; ++attempt) {
+    // TryBuild 失败时不会移动 slots 中的内容，可以换一个种子重试
+    if (TryBuild(slots, static_cast<uint64_t>(attempt))) {
+      return;
+    }
+  }
+  #ifdef DEBUG_ROUTER
+  fprintf(stderr, "[Router Warning] Static route index build failed, falling back to radix tree\n");
+  #endif
 }
 
-std::vector<HttpMethod> RouteNode::GetAllowedMethods(const std::string& path) const {
-  std::vector<HttpMethod> methods;
-  std::vector<std::string_view> segments;
-  SplitPathToViews(path, segments);
-  if (segments.empty()) {
-    return methods;
+const RouteEntry* StaticRouteIndex::Find(HttpMethod method, std::string_view path) const {
+  const size_t methodIndex = static_cast<size_t>(method);
+  if (slots_.empty() || methodIndex >= kRouteMethodCount) {
+    return nullptr;
   }
-  
-  const RouteNode* current = this;
-  std::vector<std::string> tempParamValues; // 临时参数值，不用于填充
-  RouteParams tempParams; // 临时参数，不用于填充
-  
-  RouteResult result = MatchRouteRecursive(HttpMethod::UNKNOWN, segments, 0, tempParams, tempParamValues); // 使用 UNKNOWN 方法来收集所有允许的方法
-  return result.allowedMethods;
+  const uint64_t h = Hash(path, seed_);
+  const uint32_t d = displacements_[ReduceRange(h, displacements_.size())];
+  const Slot& slot = slots_[SlotOf(h, d, slots_.size())];
+  if (slot.path.size() != path.size()) {
+    return nullptr;
+  }
+  // 请求路径通常已是小写，先整体比较，不相等时再逐字节忽略大小写比较
+  if (std::memcmp(slot.path.data(), path.data(), path.size()) != 0 && !EqualsLowered(path, slot.path)) {
+    return nullptr;
+  }
+  return slot.methods[methodIndex];
 }
 
 // ========== RouteGroup 实现 ==========
@@ -391,7 +568,39 @@ void RouteGroup::AddMiddleware(Middleware middleware) {
 // ========== Router 实现 ==========
 
 Router::Router() {
-  rootNode_ = std::make_unique<RouteNode>();
+  current_.store(new PublishedTable{std::make_shared<const RouteTable>()}, std::memory_order_release);
+}
+
+Router::~Router() {
+  // 析构时不应再有并发的匹配；已退休的旧表由 RouteEpoch 回收
+  delete current_.load(std::memory_order_acquire);
+}
+
+std::shared_ptr<const RouteTable> Router::Snapshot() const {
+  // 纪元临界区只覆盖 读发布点 + 复制 shared_ptr（一次原子自增），之后的匹配不再持有任何锁
+  RouteEpoch::Guard guard;
+  return current_.load(std::memory_order_seq_cst)->table;
+}
+
+void Router::Publish(std::shared_ptr<const RouteTable> table) {
+  if (!table) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(writeMutex_);
+  PublishLocked(std::move(table));
+}
+
+void Router::PublishLocked(std::shared_ptr<const RouteTable> table) {
+  PublishedTable* old = current_.exchange(new PublishedTable{std::move(table)}, std::memory_order_seq_cst);
+  RouteEpoch::Instance().Retire([old]() { delete old; });
+}
+
+void Router::Modify(const std::function<void(RouteTable&)>& fn) {
+  std::lock_guard<std::mutex> lock(writeMutex_);
+  std::shared_ptr<RouteTable> next = current_.load(std::memory_order_acquire)->table->Clone();
+  fn(*next);
+  next->BuildIndex();
+  PublishLocked(std::move(next));
 }
 
 // 路由匹配：返回匹配结果信息（不执行处理器）
@@ -399,8 +608,11 @@ RouteMatchInfo Router::MatchRoute(HttpRequest& request) {
   RouteMatchInfo matchInfo;
   matchInfo.result = RouteMatchResult::NOT_FOUND;
   
-  std::string rawPath = ExtractPath(request);
-  std::string path = NormalizePath(rawPath, true);  // 规范化路径
+  // 解析得到的路径已经规范化，直接在其上匹配；只有调用方手动设置的非规范路径才需要整理
+  if (!IsCanonicalPath(request.GetPath())) {
+    request.SetPath(NormalizePath(request.GetPath(), true));
+  }
+  const std::string& path = request.GetPath();
   HttpMethod method = request.GetMethod();
   
   // 验证路径
@@ -409,92 +621,49 @@ RouteMatchInfo Router::MatchRoute(HttpRequest& request) {
     return matchInfo;
   }
   
-  // 获取中间件列表
-  std::vector<Middleware> globalMws;
-  std::vector<Middleware> pathMws;
-  
-  {
-    std::shared_lock<std::shared_mutex> lock(mutex_);
-    globalMws = globalMiddlewares_;
-    auto pathIt = pathMiddlewares_.find(path);
-    if (pathIt != pathMiddlewares_.end()) {
-      pathMws = pathIt->second;
-    }
-  }
+  // 固定当前路由表快照：中间件直接在快照上执行，不加锁也不拷贝；热更新不影响本次请求
+  matchInfo.table = Snapshot();
+  const RouteTable& table = *matchInfo.table;
   
   // 执行中间件（调用ExecuteMiddlewares）
   IHttpMessage& message = request;
-  if (!ExecuteMiddlewares(message, globalMws)) {
+  if (!ExecuteMiddlewares(message, table.globalMiddlewares)) {
     matchInfo.result = RouteMatchResult::MIDDLEWARE_REJECTED;
     return matchInfo;
   }
   
-  if (!ExecuteMiddlewares(message, pathMws)) {
-    matchInfo.result = RouteMatchResult::MIDDLEWARE_REJECTED;
-    return matchInfo;
+  if (!table.pathMiddlewares.empty()) {
+    auto pathIt = table.pathMiddlewares.find(std::string_view(path));
+    if (pathIt != table.pathMiddlewares.end() && !ExecuteMiddlewares(message, pathIt->second)) {
+      matchInfo.result = RouteMatchResult::MIDDLEWARE_REJECTED;
+      return matchInfo;
+    }
   }
   
-  // 【优化】获取一次读锁，覆盖整个查找过程
-  std::shared_lock<std::shared_mutex> lock(mutex_);
-  
-  // 先尝试静态路由快速查找（O(1)）
-  RouteParams matchedParams;
-  std::vector<HttpMethod> allowedMethods;
-  bool pathMatched = false;
-  RouteHandler matchedHandler = nullptr;
-  
-  auto staticIt = staticRoutes_.find(path);
-  if (staticIt != staticRoutes_.end()) {
-    pathMatched = true;
-    // 收集允许的方法
-    allowedMethods.reserve(staticIt->second.size());
-    for (const auto& methodPair : staticIt->second) {
-      allowedMethods.push_back(methodPair.first);
-    }
-    
-    auto methodIt = staticIt->second.find(method);
-    if (methodIt != staticIt->second.end()) {
-      matchedHandler = methodIt->second.first; // 获取静态路由的 handler
-      // 静态路由没有路径参数和通配符，只需提取查询参数
-      ExtractQueryParams(request, matchedParams);
-    } else {
-      RouteResult dyn = rootNode_->MatchRoute(method, path);
-      if (dyn.IsSuccess()) {
-        pathMatched = dyn.pathMatched;
-        allowedMethods = std::move(dyn.allowedMethods);
-        matchedHandler = dyn.handler;
-        matchedParams = std::move(dyn.params);
-        ExtractQueryParams(request, matchedParams);
-      }
-    }
-  } else {
-    // 静态路由未找到，尝试Trie树匹配（支持参数和通配符）
-    RouteResult result = rootNode_->MatchRoute(method, path);
-    
-    if (result.IsSuccess() || result.pathMatched) {
-      pathMatched = result.pathMatched;
-      allowedMethods = std::move(result.allowedMethods);
-      
-      if (result.IsSuccess()) {
-        matchedHandler = result.handler;
-        matchedParams = std::move(result.params); // 将 result.params 移动到 matchedParams
-        ExtractQueryParams(request, matchedParams); // 提取查询参数
-      }
-    }
+  // 精确静态路由走完美哈希（一次哈希、一次比较），其余路由或方法未注册时再走前缀树
+  const RouteEntry* entry = table.statics.Find(method, path);
+  if (!entry) {
+    entry = table.root->MatchRoute(method, path, matchInfo.params);
+  }
+  if (entry) {
+    matchInfo.result = RouteMatchResult::SUCCESS;
+    matchInfo.handler = &entry->handler;
+    matchInfo.executor = entry->executor;
+    matchInfo.bodySink = entry->bodySink ? &entry->bodySink : nullptr;
+    ExtractQueryParams(request, matchInfo.params);
+    return matchInfo;
   }
   
-  lock.unlock();
+  // 未命中：再走一遍树收集该路径支持的方法，用于405
+  const uint32_t allowedMask = table.root->AllowedMethodMask(path);
   
-  // 根据匹配结果设置RouteMatchInfo
-  if (matchedHandler) {
-    matchInfo.result = RouteMatchResult::SUCCESS;
-    matchInfo.handler = matchedHandler;
-    matchInfo.params = std::move(matchedParams);
-  } else if (pathMatched && !allowedMethods.empty()) {
+  if (allowedMask != 0) {
     matchInfo.result = RouteMatchResult::METHOD_NOT_ALLOWED;
-    matchInfo.allowedMethods = std::move(allowedMethods);
-  } else {
-    matchInfo.result = RouteMatchResult::NOT_FOUND;
+    for (size_t i = 0; i < kRouteMethodCount; ++i) {
+      if (allowedMask & (1u << i)) {
+        matchInfo.allowedMethods.push_back(static_cast<HttpMethod>(i));
+      }
+    }
   }
   
   return matchInfo;
@@ -505,7 +674,7 @@ bool Router::Handle(IHttpMessage& message, HttpResponse& response) {
     return false;
   }
   
-  auto* request = dynamic_cast<HttpRequest*>(&message);
+  auto* request = AsHttpRequest(&message);
   if (!request) {
     return false;
   }
@@ -516,14 +685,15 @@ bool Router::Handle(IHttpMessage& message, HttpResponse& response) {
   // 根据匹配结果处理
   if (matchInfo.result == RouteMatchResult::SUCCESS && matchInfo.handler) {
     // 匹配成功，执行处理器
-    return matchInfo.handler(message, response, matchInfo.params);
+    return (*matchInfo.handler)(*request, response, matchInfo.params);
   }
   
   // 其他情况返回false，让上层根据MatchRoute结果进行错误处理
   return false;
 }
 
-void Router::AddRoute(HttpMethod method, const std::string& path, RouteHandler handler) {
+void Router::AddRoute(HttpMethod method, const std::string& path, RouteHandler handler,
+                      const std::string& executor) {
   if (!handler || !ValidatePath(path)) {
     return;
   }
@@ -531,43 +701,50 @@ void Router::AddRoute(HttpMethod method, const std::string& path, RouteHandler h
   // 路径规范化
   std::string normalizedPath = NormalizePath(path, true);
   
-  std::unique_lock<std::shared_mutex> lock(mutex_);
-  
-  // 如果是静态路径（不含参数和通配符），添加到快速查找表
-  if (IsStaticPath(normalizedPath)) {
-    staticRoutes_[normalizedPath][method] = {handler, {}}; // 静态路由没有参数名
+  // 静态、参数与通配符路由统一编译进压缩前缀树
+  Modify([&](RouteTable& table) {
+    table.root->AddRoute(method, normalizedPath, std::move(handler), executor);
+  });
+}
+
+void Router::AddStreamingRoute(HttpMethod method, const std::string& path, RouteHandler handler,
+                               BodySinkFactory bodySink, const std::string& executor) {
+  if (!handler || !bodySink || !ValidatePath(path)) {
+    return;
   }
   
-  // 同时添加到Trie树（作为备份和兼容性保证）
-  rootNode_->AddRoute(method, normalizedPath, handler);
+  std::string normalizedPath = NormalizePath(path, true);
+  Modify([&](RouteTable& table) {
+    table.root->AddRoute(method, normalizedPath, std::move(handler), executor, std::move(bodySink));
+  });
 }
 
-void Router::Get(const std::string& path, RouteHandler handler) {
-  AddRoute(HttpMethod::GET, path, handler);
+void Router::Get(const std::string& path, RouteHandler handler, const std::string& executor) {
+  AddRoute(HttpMethod::GET, path, handler, executor);
 }
 
-void Router::Post(const std::string& path, RouteHandler handler) {
-  AddRoute(HttpMethod::POST, path, handler);
+void Router::Post(const std::string& path, RouteHandler handler, const std::string& executor) {
+  AddRoute(HttpMethod::POST, path, handler, executor);
 }
 
-void Router::Put(const std::string& path, RouteHandler handler) {
-  AddRoute(HttpMethod::PUT, path, handler);
+void Router::Put(const std::string& path, RouteHandler handler, const std::string& executor) {
+  AddRoute(HttpMethod::PUT, path, handler, executor);
 }
 
-void Router::Delete(const std::string& path, RouteHandler handler) {
-  AddRoute(HttpMethod::DELETE, path, handler);
+void Router::Delete(const std::string& path, RouteHandler handler, const std::string& executor) {
+  AddRoute(HttpMethod::DELETE, path, handler, executor);
 }
 
-void Router::Patch(const std::string& path, RouteHandler handler) {
-  AddRoute(HttpMethod::PATCH, path, handler);
+void Router::Patch(const std::string& path, RouteHandler handler, const std::string& executor) {
+  AddRoute(HttpMethod::PATCH, path, handler, executor);
 }
 
-void Router::Head(const std::string& path, RouteHandler handler) {
-  AddRoute(HttpMethod::HEAD, path, handler);
+void Router::Head(const std::string& path, RouteHandler handler, const std::string& executor) {
+  AddRoute(HttpMethod::HEAD, path, handler, executor);
 }
 
-void Router::Options(const std::string& path, RouteHandler handler) {
-  AddRoute(HttpMethod::OPTIONS, path, handler);
+void Router::Options(const std::string& path, RouteHandler handler, const std::string& executor) {
+  AddRoute(HttpMethod::OPTIONS, path, handler, executor);
 }
 
 std::shared_ptr<RouteGroup> Router::CreateGroup(const std::string& prefix) {
@@ -575,7 +752,8 @@ std::shared_ptr<RouteGroup> Router::CreateGroup(const std::string& prefix) {
 }
 
 void Router::AddRouteInGroup(std::shared_ptr<RouteGroup> group, HttpMethod method,
-                             const std::string& path, RouteHandler handler) {
+                             const std::string& path, RouteHandler handler,
+                             const std::string& executor) {
   if (!group || !handler) {
     return;
   }
@@ -590,18 +768,18 @@ void Router::AddRouteInGroup(std::shared_ptr<RouteGroup> group, HttpMethod metho
   }
   
   // 先执行组的中间件，再执行路由处理器
-  auto wrappedHandler = [group, handler](IHttpMessage& message, HttpResponse& response, const RouteParams& params) {
+  auto wrappedHandler = [group, handler](HttpRequest& request, HttpResponse& response, const RouteParams& params) {
     // 执行组的中间件
     for (const auto& middleware : group->GetMiddlewares()) {
-      if (!middleware(message)) {
+      if (!middleware(request)) {
         return false;
       }
     }
     // 执行路由处理器
-    return handler(message, response, params);
+    return handler(request, response, params);
   };
   
-  AddRoute(method, fullPath, wrappedHandler);
+  AddRoute(method, fullPath, wrappedHandler, executor);
 }
 
 void Router::AddMiddleware(Middleware middleware) {
@@ -609,8 +787,9 @@ void Router::AddMiddleware(Middleware middleware) {
     return;
   }
   
-  std::unique_lock<std::shared_mutex> lock(mutex_);
-  globalMiddlewares_.push_back(middleware);
+  Modify([&](RouteTable& table) {
+    table.globalMiddlewares.push_back(std::move(middleware));
+  });
 }
 
 void Router::AddMiddlewareForPath(const std::string& path, Middleware middleware) {
@@ -619,17 +798,14 @@ void Router::AddMiddlewareForPath(const std::string& path, Middleware middleware
   }
   
   std::string normalizedPath = NormalizePath(path, true);
-  std::unique_lock<std::shared_mutex> lock(mutex_);
-  pathMiddlewares_[normalizedPath].push_back(middleware);
+  Modify([&](RouteTable& table) {
+    table.pathMiddlewares[normalizedPath].push_back(std::move(middleware));
+  });
 }
 
 
 void Router::Clear() {
-  std::unique_lock<std::shared_mutex> lock(mutex_);
-  rootNode_ = std::make_unique<RouteNode>();
-  staticRoutes_.clear();
-  globalMiddlewares_.clear();
-  pathMiddlewares_.clear();
+  Publish(std::make_shared<const RouteTable>());
 }
 
 bool Router::ValidatePath(const std::string& path) {
@@ -674,22 +850,9 @@ bool Router::ExecuteMiddlewares(IHttpMessage& message,
 }
 
 
-std::string Router::ExtractPath(const HttpRequest& request) {
-  std::string path = request.GetPath();
-  // 路径已经由HttpRequest解析，不包含查询字符串
-  return path;
-}
-
 void Router::ExtractQueryParams(const HttpRequest& request, RouteParams& params) {
-  // 【优化】直接获取HttpRequest已经解析好的查询参数，避免重复解析URL字符串
-  // 这大大提高了效率，特别是对于包含大量查询参数的请求
-  const auto& queryParams = request.GetAllQueryParams();
-  
-  // 转换为unordered_map以提高后续查找效率
-  params.queryParams_.reserve(queryParams.size());
-  for (const auto& [key, values] : queryParams) {
-    params.queryParams_[key] = values;
-  }
+  // 【优化】直接引用HttpRequest已经解析好的查询参数，既不重复解析URL字符串也不拷贝
+  params.queryParams_ = &request.GetAllQueryParams();
 }
 
 // 【新增】辅助函数：将HttpMethod转换为字符串
@@ -0,0 +1,230 @@
+#include "security/PatternScanner.h"
+
+#include <cctype>
+#include <deque>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+unsigned char FoldByte(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c - 'A' + 'a') : c;
+}
+
+std::string Trim(const std::string& s) {
+    size_t b = 0;
+    size_t e = s.size();
+    while (b < e && std::isspace(static_cast<unsigned char>(s[b]))) ++b;
+    while (e > b && std::isspace(static_cast<unsigned char>(s[e - 1]))) --e;
+    return s.substr(b, e - b);
+}
+
+bool ParseScopes(const std::string& text, uint8_t& scopes) {
+    scopes = 0;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (item == "path") {
+            scopes |= PatternScanner::kScopePath;
+        } else if (item == "url") {
+            scopes |= PatternScanner::kScopeUrl;
+        } else if (item == "header") {
+            scopes |= PatternScanner::kScopeHeader;
+        } else {
+            return false;
+        }
+    }
+    return scopes != 0;
+}
+
+}  // namespace
+
+PatternScanner::PatternScanner(std::vector<Rule> rules, std::vector<std::string> scanned_headers)
+    : rules_(std::move(rules)), scanned_headers_(std::move(scanned_headers)) {
+    for (auto& name : scanned_headers_) {
+        for (auto& ch : name) ch = static_cast<char>(FoldByte(static_cast<unsigned char>(ch)));
+    }
+
+    // 字符类：只为模式中出现的（折叠后）字节分配类号，转移表宽度随之收缩
+    for (auto& rule : rules_) {
+        for (auto& ch : rule.pattern) {
+            ch = static_cast<char>(FoldByte(static_cast<unsigned char>(ch)));
+            unsigned char c = static_cast<unsigned char>(ch);
+            if (class_[c] == 0) {
+                class_[c] = static_cast<uint16_t>(alphabet_++);
+            }
+        }
+    }
+    for (int c = 'A'; c <= 'Z'; ++c) {
+        class_[c] = class_[c - 'A' + 'a'];
+    }
+
+    // 字典树
+    std::vector<std::vector<int32_t>> trie(1, std::vector<int32_t>(alphabet_, -1));
+    terminals_.assign(1, {});
+    for (size_t i = 0; i < rules_.size(); ++i) {
+        const Rule& rule = rules_[i];
+        if (rule.pattern.empty() || rule.scopes == 0) continue;
+        int32_t s = 0;
+        for (char ch : rule.pattern) {
+            uint16_t cls = class_[static_cast<unsigned char>(ch)];
+            if (trie[s][cls] < 0) {
+                trie[s][cls] = static_cast<int32_t>(trie.size());
+                trie.emplace_back(alphabet_, -1);
+                terminals_.emplace_back();
+            }
+            s = trie[s][cls];
+        }
+        terminals_[s].push_back(static_cast<int32_t>(i));
+        scopes_ |= rule.scopes;
+        if (rule.kind == RuleKind::Traversal) {
+            traversal_scopes_ |= rule.scopes;
+        }
+    }
+
+    // 按层 BFS 计算失败指针，并把缺失的转移补全为 DFA 转移
+    const size_t states = trie.size();
+    next_.assign(states * alphabet_, 0);
+    fail_.assign(states, 0);
+    out_scopes_.assign(states, 0);
+    for (size_t s = 0; s < states; ++s) {
+        for (int32_t rule : terminals_[s]) out_scopes_[s] |= rules_[rule].scopes;
+    }
+    std::deque<int32_t> queue;
+    for (size_t c = 0; c < alphabet_; ++c) {
+        int32_t child = trie[0][c];
+        if (child > 0) {
+            next_[c] = child;
+            queue.push_back(child);
+        }
+    }
+    while (!queue.empty()) {
+        int32_t s = queue.front();
+        queue.pop_front();
+        out_scopes_[s] |= out_scopes_[fail_[s]];
+        for (size_t c = 0; c < alphabet_; ++c) {
+            int32_t child = trie[s][c];
+            if (child > 0) {
+                fail_[child] = next_[fail_[s] * alphabet_ + c];
+                next_[s * alphabet_ + c] = child;
+                queue.push_back(child);
+            } else {
+                next_[s * alphabet_ + c] = next_[fail_[s] * alphabet_ + c];
+            }
+        }
+    }
+}
+
+const PatternScanner::Rule* PatternScanner::Scan(std::string_view text, Scope scope) const {
+    if (!(scopes_ & scope)) return nullptr;
+    const int32_t* next = next_.data();
+    const uint8_t* out = out_scopes_.data();
+    const bool traversal_possible = (traversal_scopes_ & scope) != 0;
+    const Rule* first = nullptr;
+    int32_t s = 0;
+    for (unsigned char c : text) {
+        s = next[static_cast<size_t>(s) * alphabet_ + class_[c]];
+        if (out[s] & scope) {
+            const Rule* hit = ResolveHit(s, scope);
+            if (!traversal_possible || hit->kind == RuleKind::Traversal) {
+                return hit;
+            }
+            if (!first) {
+                first = hit;
+            }
+        }
+    }
+    return first;
+}
+
+// 命中后沿失败链找出具体规则（同一位置结束的多条规则中 Traversal 优先），只在拒绝请求时执行
+const PatternScanner::Rule* PatternScanner::ResolveHit(int32_t state, uint8_t scope) const {
+    const Rule* first = nullptr;
+    for (int32_t s = state;; s = fail_[s]) {
+        for (int32_t rule : terminals_[s]) {
+            const Rule& r = rules_[rule];
+            if (!(r.scopes & scope)) continue;
+            if (r.kind == RuleKind::Traversal) return &r;
+            if (!first) first = &r;
+        }
+        if (s == 0) return first;
+    }
+}
+
+std::vector<PatternScanner::Rule> PatternScanner::DefaultRules() {
+    const uint8_t path_url = kScopePath | kScopeUrl;
+    return {
+        // 路径遍历：../、..\ 及其百分号编码形式（路径已解码一次，这里拦截的是二次编码）
+        {"../", kScopePath, RuleKind::Traversal},
+        {"..\\", kScopePath, RuleKind::Traversal},
+        {"%2e%2e%2f", kScopePath, RuleKind::Traversal},
+        {"%2e%2e%5c", kScopePath, RuleKind::Traversal},
+        {"..%2f", kScopePath, RuleKind::Traversal},
+        {"..%5c", kScopePath, RuleKind::Traversal},
+        // SQL 注入常见关键词（简单检测）
+        {"union select", path_url, RuleKind::Suspicious},
+        {"drop table", path_url, RuleKind::Suspicious},
+        {"delete from", path_url, RuleKind::Suspicious},
+        {"insert into", path_url, RuleKind::Suspicious},
+        {"update set", path_url, RuleKind::Suspicious},
+        {"exec(", path_url, RuleKind::Suspicious},
+        {"script>", path_url, RuleKind::Suspicious},
+        // XSS 常见片段
+        {"<script", path_url, RuleKind::Suspicious},
+        {"javascript:", path_url, RuleKind::Suspicious},
+        {"onerror=", path_url, RuleKind::Suspicious},
+        {"onload=", path_url, RuleKind::Suspicious},
+    };
+}
+
+std::shared_ptr<const PatternScanner> PatternScanner::LoadFromFile(const std::string& file, std::string* error) {
+    std::ifstream in(file);
+    if (!in) {
+        if (error) *error = "cannot open " + file;
+        return nullptr;
+    }
+    std::vector<Rule> rules;
+    std::vector<std::string> headers;
+    bool has_headers = false;
+    std::string line;
+    size_t line_no = 0;
+    while (std::getline(in, line)) {
+        ++line_no;
+        line = Trim(line);
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        std::string kind;
+        fields >> kind;
+        if (kind == "headers") {
+            has_headers = true;
+            std::string name;
+            while (fields >> name) headers.push_back(name);
+            continue;
+        }
+
+        Rule rule;
+        std::string scopes;
+        fields >> scopes;
+        std::string rest;
+        std::getline(fields, rest);
+        rule.pattern = Trim(rest);
+        if (kind == "traversal") {
+            rule.kind = RuleKind::Traversal;
+        } else if (kind == "suspicious") {
+            rule.kind = RuleKind::Suspicious;
+        } else {
+            if (error) *error = file + ":" + std::to_string(line_no) + ": unknown rule kind '" + kind + "'";
+            return nullptr;
+        }
+        if (!ParseScopes(scopes, rule.scopes) || rule.pattern.empty()) {
+            if (error) *error = file + ":" + std::to_string(line_no) + ": expected '<kind> <scopes> <pattern>'";
+            return nullptr;
+        }
+        rules.push_back(std::move(rule));
+    }
+    if (!has_headers) {
+        headers = {"referer", "user-agent"};
+    }
+    return std::make_shared<const PatternScanner>(std::move(rules), std::move(headers));
+}
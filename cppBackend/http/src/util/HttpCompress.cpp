@@ -0,0 +1,150 @@
+#include "util/HttpCompress.h"
+#include "util/HttpStringUtil.h"
+
+#include <cstdlib>
+#include <zlib.h>
+
+namespace {
+
+// gzip 使用 gzip 封装（windowBits + 16）；HTTP 的 "deflate" 指 zlib 封装（RFC 1950），不是裸 deflate
+int WindowBitsFor(HttpContentEncoding encoding) {
+  return encoding == HttpContentEncoding::GZIP ? 15 + 16 : 15;
+}
+
+bool InitDeflate(z_stream& zs, HttpContentEncoding encoding, int level) {
+  zs = z_stream{};
+  if (level < Z_BEST_SPEED) level = Z_BEST_SPEED;
+  if (level > Z_BEST_COMPRESSION) level = Z_BEST_COMPRESSION;
+  return deflateInit2(&zs, level, Z_DEFLATED, WindowBitsFor(encoding), 8, Z_DEFAULT_STRATEGY) == Z_OK;
+}
+
+// 把 in 送入 zs，输出追加到 out，直到 flush 所要求的输出全部写出
+bool DeflateInto(z_stream& zs, std::string_view in, int flush, std::string& out) {
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+  zs.avail_in = static_cast<uInt>(in.size());
+  while (true) {
+    const size_t before = out.size();
+    const size_t room = deflateBound(&zs, zs.avail_in) + 64;
+    out.resize(before + room);
+    zs.next_out = reinterpret_cast<Bytef*>(&out[before]);
+    zs.avail_out = static_cast<uInt>(room);
+    const int rc = deflate(&zs, flush);
+    out.resize(before + (room - zs.avail_out));
+    if (rc == Z_STREAM_ERROR) return false;
+    if (flush == Z_FINISH) {
+      if (rc == Z_STREAM_END) return true;
+    } else if (zs.avail_in == 0 && zs.avail_out != 0) {
+      return true;
+    }
+  }
+}
+
+// 解析 q 值："q=0.5" 之类；格式不对的参数按 1 处理
+double ParseQuality(std::string_view params) {
+  while (!params.empty()) {
+    const size_t semi = params.find(';');
+    std::string_view p = TrimAsciiWhitespace(params.substr(0, semi));
+    params = semi == std::string_view::npos ? std::string_view() : params.substr(semi + 1);
+    if (p.size() >= 2 && ToLowerAscii(p[0]) == 'q' && p[1] == '=') {
+      const std::string v(p.substr(2));
+      char* end = nullptr;
+      const double q = std::strtod(v.c_str(), &end);
+      if (end != v.c_str()) return q;
+    }
+  }
+  return 1.0;
+}
+
+class CompressingProducer : public BodyProducer {
+public:
+  CompressingProducer(std::shared_ptr<BodyProducer> inner, HttpContentEncoding encoding, int level)
+      : inner_(std::move(inner)) {
+    ok_ = InitDeflate(zs_, encoding, level);
+  }
+  ~CompressingProducer() override {
+    if (ok_) deflateEnd(&zs_);
+  }
+
+  Status Produce(std::string& out, size_t max_bytes) override {
+    if (!ok_) return Status::Error;
+    raw_.clear();
+    const Status status = inner_->Produce(raw_, max_bytes);
+    if (status == Status::Error) return Status::Error;
+    const int flush = status == Status::Done ? Z_FINISH : Z_SYNC_FLUSH;
+    if (!DeflateInto(zs_, raw_, flush, out)) return Status::Error;
+    return status;
+  }
+
+private:
+  std::shared_ptr<BodyProducer> inner_;
+  z_stream zs_;
+  bool ok_{false};
+  std::string raw_;
+};
+
+}  // namespace
+
+HttpContentEncoding NegotiateContentEncoding(std::string_view accept_encoding) {
+  double gzip_q = -1;
+  double deflate_q = -1;
+  double any_q = -1;
+  while (!accept_encoding.empty()) {
+    const size_t comma = accept_encoding.find(',');
+    std::string_view item = accept_encoding.substr(0, comma);
+    accept_encoding = comma == std::string_view::npos ? std::string_view() : accept_encoding.substr(comma + 1);
+
+    const size_t semi = item.find(';');
+    const std::string_view coding = TrimAsciiWhitespace(item.substr(0, semi));
+    const double q = semi == std::string_view::npos ? 1.0 : ParseQuality(item.substr(semi + 1));
+    if (EqualsIgnoreCaseAscii(coding, "gzip") || EqualsIgnoreCaseAscii(coding, "x-gzip")) {
+      gzip_q = q;
+    } else if (EqualsIgnoreCaseAscii(coding, "deflate")) {
+      deflate_q = q;
+    } else if (coding == "*") {
+      any_q = q;
+    }
+  }
+  // 没有单独列出的编码取 "*" 的 q 值
+  if (gzip_q < 0) gzip_q = any_q;
+  if (deflate_q < 0) deflate_q = any_q;
+  if (gzip_q > 0 && gzip_q >= deflate_q) return HttpContentEncoding::GZIP;
+  if (deflate_q > 0) return HttpContentEncoding::DEFLATE;
+  return HttpContentEncoding::IDENTITY;
+}
+
+bool IsCompressibleContentType(std::string_view content_type) {
+  const std::string_view media = TrimAsciiWhitespace(content_type.substr(0, content_type.find(';')));
+  auto starts_with = [media](std::string_view prefix) {
+    return media.size() >= prefix.size() && EqualsIgnoreCaseAscii(media.substr(0, prefix.size()), prefix);
+  };
+  auto ends_with = [media](std::string_view suffix) {
+    return media.size() >= suffix.size() &&
+           EqualsIgnoreCaseAscii(media.substr(media.size() - suffix.size()), suffix);
+  };
+  return starts_with("text/") || EqualsIgnoreCaseAscii(media, "application/json") ||
+         EqualsIgnoreCaseAscii(media, "application/javascript") || EqualsIgnoreCaseAscii(media, "application/xml") ||
+         EqualsIgnoreCaseAscii(media, "image/svg+xml") || ends_with("+json") || ends_with("+xml");
+}
+
+const char* ContentEncodingToken(HttpContentEncoding encoding) {
+  switch (encoding) {
+    case HttpContentEncoding::GZIP: return "gzip";
+    case HttpContentEncoding::DEFLATE: return "deflate";
+    case HttpContentEncoding::BR: return "br";
+    default: return "identity";
+  }
+}
+
+bool CompressBody(std::string_view in, HttpContentEncoding encoding, int level, std::string& out) {
+  z_stream zs;
+  if (!InitDeflate(zs, encoding, level)) return false;
+  out.reserve(out.size() + deflateBound(&zs, static_cast<uLong>(in.size())));
+  const bool ok = DeflateInto(zs, in, Z_FINISH, out);
+  deflateEnd(&zs);
+  return ok;
+}
+
+std::shared_ptr<BodyProducer> MakeCompressingProducer(std::shared_ptr<BodyProducer> inner,
+                                                      HttpContentEncoding encoding, int level) {
+  return std::make_shared<CompressingProducer>(std::move(inner), encoding, level);
+}
@@ -0,0 +1,76 @@
+#include "util/HttpDate.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+constexpr char kWeekdays[7][4] = {"Thu", "Fri", "Sat", "Sun", "Mon", "Tue", "Wed"};  // 1970-01-01 为周四
+constexpr char kMonths[12][4] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                 "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+void Put2(char* p, unsigned v) {
+  p[0] = static_cast<char>('0' + v / 10);
+  p[1] = static_cast<char>('0' + v % 10);
+}
+
+}  // namespace
+
+void FormatHttpDate(time_t t, char* out) {
+  int64_t secs = static_cast<int64_t>(t);
+  int64_t days = secs / 86400;
+  int64_t rem = secs % 86400;
+  if (rem < 0) {
+    rem += 86400;
+    --days;
+  }
+  const unsigned weekday = static_cast<unsigned>(((days % 7) + 7) % 7);
+
+  // 由 1970-01-01 起的天数换算公历年月日（以 0000-03-01 为纪元的 400 年周期算法）
+  const int64_t z = days + 719468;
+  const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const unsigned doe = static_cast<unsigned>(z - era * 146097);
+  const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const unsigned mp = (5 * doy + 2) / 153;
+  const unsigned day = doy - (153 * mp + 2) / 5 + 1;
+  const unsigned month = mp < 10 ? mp + 3 : mp - 9;
+  int64_t year = static_cast<int64_t>(yoe) + era * 400 + (month <= 2 ? 1 : 0);
+  if (year < 0) year = 0;
+  if (year > 9999) year = 9999;
+
+  std::memcpy(out, kWeekdays[weekday], 3);
+  out[3] = ',';
+  out[4] = ' ';
+  Put2(out + 5, day);
+  out[7] = ' ';
+  std::memcpy(out + 8, kMonths[month - 1], 3);
+  out[11] = ' ';
+  Put2(out + 12, static_cast<unsigned>(year / 100));
+  Put2(out + 14, static_cast<unsigned>(year % 100));
+  out[16] = ' ';
+  Put2(out + 17, static_cast<unsigned>(rem / 3600));
+  out[19] = ':';
+  Put2(out + 20, static_cast<unsigned>(rem / 60 % 60));
+  out[22] = ':';
+  Put2(out + 23, static_cast<unsigned>(rem % 60));
+  std::memcpy(out + 25, " GMT", 4);
+}
+
+std::string FormatHttpDate(time_t t) {
+  char buf[kHttpDateLen];
+  FormatHttpDate(t, buf);
+  return std::string(buf, kHttpDateLen);
+}
+
+std::string_view CachedHttpDate() {
+  thread_local time_t cached_sec = -1;
+  thread_local char cached[kHttpDateLen];
+  // time() 在 Linux 上走 vDSO，不陷入内核
+  const time_t now = ::time(nullptr);
+  if (now != cached_sec) {
+    FormatHttpDate(now, cached);
+    cached_sec = now;
+  }
+  return std::string_view(cached, kHttpDateLen);
+}
@@ -0,0 +1,302 @@
+#include "util/HttpScan.h"
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define HTTP_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+struct ScanKernels {
+  HttpScanIsa isa;
+  size_t (*find_crlf)(const char*, size_t);
+  bool (*is_token)(const char*, size_t);
+  bool (*is_field_value)(const char*, size_t);
+  void (*lower_ascii)(char*, size_t);
+};
+
+// RFC 9110 tchar 查找表
+struct TokenTable {
+  bool valid[256] = {};
+  constexpr TokenTable() {
+    for (int c = '0'; c <= '9'; ++c) valid[c] = true;
+    for (int c = 'a'; c <= 'z'; ++c) valid[c] = true;
+    for (int c = 'A'; c <= 'Z'; ++c) valid[c] = true;
+    const char extra[] = "!#$%&'*+-.^_`|~";
+    for (size_t i = 0; i + 1 < sizeof(extra); ++i) valid[static_cast<unsigned char>(extra[i])] = true;
+  }
+};
+constexpr TokenTable kTokenTable;
+
+// ---- 标量实现：也用于各向量实现处理不足一个向量宽度的尾部 ----
+
+size_t FindCrlfScalar(const char* data, size_t len) {
+  for (size_t i = 0; i + 1 < len; ++i) {
+    if (data[i] == '\r' && data[i + 1] == '\n') return i;
+  }
+  return len;
+}
+
+bool IsTokenTail(const char* data, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    if (!kTokenTable.valid[static_cast<unsigned char>(data[i])]) return false;
+  }
+  return true;
+}
+
+bool IsTokenScalar(const char* data, size_t len) {
+  return len > 0 && IsTokenTail(data, len);
+}
+
+bool IsFieldValueTail(const char* data, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    unsigned char c = static_cast<unsigned char>(data[i]);
+    if ((c < 0x20 && c != '\t') || c == 0x7F) return false;
+  }
+  return true;
+}
+
+void LowerAsciiTail(char* data, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    if (data[i] >= 'A' && data[i] <= 'Z') data[i] = static_cast<char>(data[i] + ('a' - 'A'));
+  }
+}
+
+constexpr ScanKernels kScalarKernels{HttpScanIsa::Scalar, FindCrlfScalar, IsTokenScalar,
+                                     IsFieldValueTail, LowerAsciiTail};
+
+#ifdef HTTP_SCAN_X86
+
+// token 校验的半字节查表：低 4 位查出一个位图，高 4 位决定取哪一位（高位 >= 8 的字节一律非法）
+struct NibbleTables {
+  alignas(16) uint8_t lo[16] = {};
+  alignas(16) uint8_t hi_bit[16] = {};
+  constexpr NibbleTables() {
+    for (int c = 0; c < 128; ++c) {
+      if (kTokenTable.valid[c]) lo[c & 0x0F] = static_cast<uint8_t>(lo[c & 0x0F] | (1u << (c >> 4)));
+    }
+    for (int h = 0; h < 8; ++h) hi_bit[h] = static_cast<uint8_t>(1u << h);
+  }
+};
+constexpr NibbleTables kNibble;
+
+// ---- SSE4.2：16 字节一组，头部值校验使用 PCMPESTRI 的区间匹配 ----
+
+__attribute__((target("sse4.2")))
+size_t FindCrlfSse42(const char* data, size_t len) {
+  const __m128i cr = _mm_set1_epi8('\r');
+  const __m128i lf = _mm_set1_epi8('\n');
+  size_t i = 0;
+  for (; i + 17 <= len; i += 16) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+    int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, cr), _mm_cmpeq_epi8(b, lf)));
+    if (mask != 0) return i + static_cast<size_t>(__builtin_ctz(static_cast<unsigned>(mask)));
+  }
+  size_t rest = FindCrlfScalar(data + i, len - i);
+  return i + rest;
+}
+
+__attribute__((target("sse4.2")))
+bool IsTokenSse42(const char* data, size_t len) {
+  if (len == 0) return false;
+  const __m128i lo_table = _mm_load_si128(reinterpret_cast<const __m128i*>(kNibble.lo));
+  const __m128i hi_table = _mm_load_si128(reinterpret_cast<const __m128i*>(kNibble.hi_bit));
+  const __m128i nibble = _mm_set1_epi8(0x0F);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    __m128i lo = _mm_shuffle_epi8(lo_table, _mm_and_si128(v, nibble));
+    __m128i hi = _mm_shuffle_epi8(hi_table, _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+    __m128i hit = _mm_and_si128(lo, hi);
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(hit, _mm_setzero_si128())) != 0) return false;
+  }
+  return IsTokenTail(data + i, len - i);
+}
+
+__attribute__((target("sse4.2")))
+bool IsFieldValueSse42(const char* data, size_t len) {
+  // 非法区间：0x00-0x08、0x0A-0x1F、0x7F
+  static const char kRanges[16] = {'\x00', '\x08', '\x0A', '\x1F', '\x7F', '\x7F'};
+  const __m128i ranges = _mm_loadu_si128(reinterpret_cast<const __m128i*>(kRanges));
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    if (_mm_cmpestrc(ranges, 6, v, 16, _SIDD_UBYTE_OPS | _SIDD_CMP_RANGES)) return false;
+  }
+  return IsFieldValueTail(data + i, len - i);
+}
+
+__attribute__((target("sse4.2")))
+void LowerAsciiSse42(char* data, size_t len) {
+  const __m128i before_a = _mm_set1_epi8('A' - 1);
+  const __m128i after_z = _mm_set1_epi8('Z' + 1);
+  const __m128i bit = _mm_set1_epi8(0x20);
+  size_t i = 0;
+  for (; i + 16 <= len; i += 16) {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    // 有符号比较：0x80 以上的字节为负数，不会落入 'A'-'Z'
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, before_a), _mm_cmpgt_epi8(after_z, v));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(data + i), _mm_or_si128(v, _mm_and_si128(upper, bit)));
+  }
+  LowerAsciiTail(data + i, len - i);
+}
+
+constexpr ScanKernels kSse42Kernels{HttpScanIsa::Sse42, FindCrlfSse42, IsTokenSse42,
+                                    IsFieldValueSse42, LowerAsciiSse42};
+
+// ---- AVX2：32 字节一组 ----
+
+__attribute__((target("avx2")))
+size_t FindCrlfAvx2(const char* data, size_t len) {
+  const __m256i cr = _mm256_set1_epi8('\r');
+  const __m256i lf = _mm256_set1_epi8('\n');
+  size_t i = 0;
+  for (; i + 33 <= len; i += 32) {
+    __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 1));
+    unsigned mask = static_cast<unsigned>(
+        _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, cr), _mm256_cmpeq_epi8(b, lf))));
+    if (mask != 0) return i + static_cast<size_t>(__builtin_ctz(mask));
+  }
+  // 尾部交给非 VEX 编码的 SSE 实现前先清空 ymm 高位，避免 AVX/SSE 切换惩罚（编译器不会在尾调用前插入）
+  _mm256_zeroupper();
+  return i + FindCrlfSse42(data + i, len - i);
+}
+
+__attribute__((target("avx2")))
+bool IsTokenAvx2(const char* data, size_t len) {
+  if (len == 0) return false;
+  const __m256i lo_table = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(kNibble.lo)));
+  const __m256i hi_table = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(kNibble.hi_bit)));
+  const __m256i nibble = _mm256_set1_epi8(0x0F);
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    __m256i lo = _mm256_shuffle_epi8(lo_table, _mm256_and_si256(v, nibble));
+    __m256i hi = _mm256_shuffle_epi8(hi_table, _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+    __m256i hit = _mm256_and_si256(lo, hi);
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(hit, _mm256_setzero_si256())) != 0) return false;
+  }
+  _mm256_zeroupper();
+  return len - i == 0 || IsTokenSse42(data + i, len - i);
+}
+
+__attribute__((target("avx2")))
+bool IsFieldValueAvx2(const char* data, size_t len) {
+  const __m256i space = _mm256_set1_epi8(0x20);
+  const __m256i minus_one = _mm256_set1_epi8(-1);
+  const __m256i tab = _mm256_set1_epi8('\t');
+  const __m256i del = _mm256_set1_epi8(0x7F);
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    // 有符号比较下 0x00-0x1F 满足 -1 < v < 0x20，obs-text 为负数被排除
+    __m256i ctl = _mm256_and_si256(_mm256_cmpgt_epi8(v, minus_one), _mm256_cmpgt_epi8(space, v));
+    __m256i bad = _mm256_or_si256(_mm256_andnot_si256(_mm256_cmpeq_epi8(v, tab), ctl),
+                                  _mm256_cmpeq_epi8(v, del));
+    if (!_mm256_testz_si256(bad, bad)) return false;
+  }
+  _mm256_zeroupper();
+  return IsFieldValueSse42(data + i, len - i);
+}
+
+__attribute__((target("avx2")))
+void LowerAsciiAvx2(char* data, size_t len) {
+  const __m256i before_a = _mm256_set1_epi8('A' - 1);
+  const __m256i after_z = _mm256_set1_epi8('Z' + 1);
+  const __m256i bit = _mm256_set1_epi8(0x20);
+  size_t i = 0;
+  for (; i + 32 <= len; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(v, before_a), _mm256_cmpgt_epi8(after_z, v));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(data + i), _mm256_or_si256(v, _mm256_and_si256(upper, bit)));
+  }
+  _mm256_zeroupper();
+  LowerAsciiSse42(data + i, len - i);
+}
+
+constexpr ScanKernels kAvx2Kernels{HttpScanIsa::Avx2, FindCrlfAvx2, IsTokenAvx2,
+                                   IsFieldValueAvx2, LowerAsciiAvx2};
+
+#endif  // HTTP_SCAN_X86
+
+const ScanKernels* KernelsFor(HttpScanIsa isa) {
+#ifdef HTTP_SCAN_X86
+  if (isa == HttpScanIsa::Avx2) return &kAvx2Kernels;
+  if (isa == HttpScanIsa::Sse42) return &kSse42Kernels;
+#endif
+  (void)isa;
+  return &kScalarKernels;
+}
+
+const ScanKernels* DetectKernels() {
+  if (HttpScanIsaSupported(HttpScanIsa::Avx2)) return KernelsFor(HttpScanIsa::Avx2);
+  if (HttpScanIsaSupported(HttpScanIsa::Sse42)) return KernelsFor(HttpScanIsa::Sse42);
+  return &kScalarKernels;
+}
+
+// 首次使用时探测 CPU 特性；之后每次调用只多一次 relaxed 读与间接调用
+std::atomic<const ScanKernels*>& ActiveKernels() {
+  static std::atomic<const ScanKernels*> active{DetectKernels()};
+  return active;
+}
+
+inline const ScanKernels& Active() {
+  return *ActiveKernels().load(std::memory_order_relaxed);
+}
+
+}  // namespace
+
+const char* HttpScanIsaName(HttpScanIsa isa) {
+  switch (isa) {
+    case HttpScanIsa::Scalar: return "scalar";
+    case HttpScanIsa::Sse42:  return "sse4.2";
+    case HttpScanIsa::Avx2:   return "avx2";
+    default:                  return "unknown";
+  }
+}
+
+bool HttpScanIsaSupported(HttpScanIsa isa) {
+  switch (isa) {
+    case HttpScanIsa::Scalar:
+      return true;
+#ifdef HTTP_SCAN_X86
+    case HttpScanIsa::Sse42:
+      return __builtin_cpu_supports("sse4.2");
+    case HttpScanIsa::Avx2:
+      return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("sse4.2");
+#endif
+    default:
+      return false;
+  }
+}
+
+HttpScanIsa HttpScanActiveIsa() {
+  return Active().isa;
+}
+
+bool HttpScanForceIsa(HttpScanIsa isa) {
+  if (!HttpScanIsaSupported(isa)) return false;
+  ActiveKernels().store(KernelsFor(isa), std::memory_order_relaxed);
+  return true;
+}
+
+size_t HttpScanFindCrlf(const char* data, size_t len) {
+  return Active().find_crlf(data, len);
+}
+
+bool HttpScanIsToken(const char* data, size_t len) {
+  return Active().is_token(data, len);
+}
+
+bool HttpScanIsFieldValue(const char* data, size_t len) {
+  return Active().is_field_value(data, len);
+}
+
+void HttpScanLowerAscii(char* data, size_t len) {
+  Active().lower_ascii(data, len);
+}
@@ -97,6 +97,7 @@ void Logger::Init_Thread(){
 							batch.push_back(std::move(workqueue_.front()));
 							workqueue_.pop();
 						}
+						queue_size_.store(workqueue_.size(), std::memory_order_relaxed);
 
 						using namespace std::chrono;
 						const std::int64_t now_ms = duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
@@ -143,20 +144,24 @@ void Logger::AddWorkLog(std::string&& log){
 			return;
 		}
 		workqueue_.push(std::move(log));
+		queue_size_.store(workqueue_.size(), std::memory_order_relaxed);
 	}
 
 	cond_.notify_one();
 }
 
 size_t Logger::GetQueueSize() const {
-	std::unique_lock<std::mutex> lock(const_cast<std::mutex&>(mutex_));
-	return workqueue_.size();
+	return queue_size_.load(std::memory_order_relaxed);
 }
 
 size_t Logger::GetTotalProcessed() const {
 	return total_processed_.load();
 }
 
+size_t Logger::GetTotalDropped() const {
+	return total_dropped_.load(std::memory_order_relaxed);
+}
+
 bool Logger::IsWorkerThreadRunning() const {
 	return thread_initialized_.load() && !th_stop_.load();
 }
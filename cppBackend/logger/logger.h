@@ -56,6 +56,9 @@ public:
 	
 	/// 获取处理的日志总数
 	size_t GetTotalProcessed() const;
+
+	/// 获取因队列满而丢弃的日志总数
+	size_t GetTotalDropped() const;
 	
 	/// 检查工作线程是否正在运行
 	bool IsWorkerThreadRunning() const;
@@ -90,6 +93,8 @@ private:
 	//处理的日志总数
 	std::atomic<size_t> total_processed_{0};
 	std::atomic<size_t> total_dropped_{0};
+	//队列长度的原子镜像，供指标读取，避免与写日志的线程争用 mutex_
+	std::atomic<size_t> queue_size_{0};
 	std::atomic<size_t> dropped_pending_{0};
 	std::atomic<std::int64_t> last_drop_report_ms_{0};
 };
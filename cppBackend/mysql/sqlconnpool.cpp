@@ -38,7 +38,9 @@ void SqlConnPool::Init(const char* host,int port,const char* user,const char* pw
 
 MYSQL* SqlConnPool::GetConn(){
   MYSQL *sql = nullptr;
+  waitCount_.fetch_add(1, std::memory_order_relaxed);
   sem_wait(&semId_);
+  waitCount_.fetch_sub(1, std::memory_order_relaxed);
   {
     lock_guard<mutex> lock(mutex_);
     if(connque_.empty()){
@@ -49,12 +51,14 @@ MYSQL* SqlConnPool::GetConn(){
     sql = connque_.front();
     connque_.pop();
   }
+  useCount_.fetch_add(1, std::memory_order_relaxed);
   return sql;
 }
 void SqlConnPool::FreeConn(MYSQL *sql){
   assert(sql);
   lock_guard<mutex> lock(mutex_);
   connque_.push(sql);
+  useCount_.fetch_sub(1, std::memory_order_relaxed);
   sem_post(&semId_);
 }
 int SqlConnPool::GetFreeConnCount(){
@@ -75,6 +79,7 @@ void SqlConnPool::ClosePool(){
 
 
 SqlConnPool::SqlConnPool(){
+  MAX_CONN_ = 0;
   useCount_ = 0;
   freeCount_ = 0;
 }
@@ -6,6 +6,7 @@
 #include<mutex>
 #include<semaphore.h>
 #include<thread>
+#include<atomic>
 #include <assert.h>
 #include "../logger/log_fac.h"
 
@@ -16,6 +17,10 @@ public:
   MYSQL *GetConn();
   void FreeConn(MYSQL *sql);
   int GetFreeConnCount();
+  //以下计数为原子读取，不与 GetConn/FreeConn 争锁，供指标采集使用
+  int GetUsedConnCount() const { return useCount_.load(std::memory_order_relaxed); }
+  int GetWaitingCount() const { return waitCount_.load(std::memory_order_relaxed); }
+  int GetMaxConnCount() const { return MAX_CONN_; }
 
   void Init(const char* host,int port,const char* user,const char* pwd, const char* dbName, int connSize);
   void ClosePool();
@@ -25,7 +30,8 @@ private:
   ~SqlConnPool();
 
   int MAX_CONN_;
-  int useCount_;
+  std::atomic<int> useCount_{0};   //已借出的连接数
+  std::atomic<int> waitCount_{0};  //阻塞在 sem_wait 上的线程数
   int freeCount_;
 
   std::queue<MYSQL *> connque_;
@@ -0,0 +1,103 @@
+#include "AdmissionController.h"
+
+#include <chrono>
+
+const char* AdmissionPriorityName(AdmissionPriority priority) {
+  switch (priority) {
+    case AdmissionPriority::High:   return "high";
+    case AdmissionPriority::Normal: return "normal";
+    case AdmissionPriority::Low:    return "low";
+    default:                        return "unknown";
+  }
+}
+
+AdmissionController::AdmissionController(const Options& opts) : opts_(opts) {}
+
+uint64_t AdmissionController::NowUs() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void AdmissionController::Observe(uint64_t sojourn_us, uint64_t now_us) {
+  uint64_t cur = window_min_us_.load(std::memory_order_relaxed);
+  while (sojourn_us < cur &&
+         !window_min_us_.compare_exchange_weak(cur, sojourn_us, std::memory_order_relaxed)) {
+  }
+  window_observed_.fetch_add(1, std::memory_order_relaxed);
+  last_observe_us_.store(now_us, std::memory_order_relaxed);
+  MaybeCloseWindow(now_us);
+}
+
+void AdmissionController::MaybeCloseWindow(uint64_t now_us) {
+  uint64_t start = window_start_us_.load(std::memory_order_relaxed);
+  if (start == 0) {
+    window_start_us_.compare_exchange_strong(start, now_us, std::memory_order_relaxed);
+    return;
+  }
+  if (now_us < start + opts_.interval_us) {
+    return;
+  }
+  // 只有一个线程负责结算窗口
+  if (!window_start_us_.compare_exchange_strong(start, now_us, std::memory_order_relaxed)) {
+    return;
+  }
+  const uint64_t min_us = window_min_us_.exchange(UINT64_MAX, std::memory_order_relaxed);
+  const uint64_t observed = window_observed_.exchange(0, std::memory_order_relaxed);
+  const uint64_t elapsed_us = now_us - start;
+  dequeue_per_sec_.store(observed * 1000000 / (elapsed_us ? elapsed_us : 1), std::memory_order_relaxed);
+  if (observed == 0) {
+    return;   // 没有出队的窗口交给 Admit 中的 Little 定律估算
+  }
+  last_min_sojourn_us_.store(min_us, std::memory_order_relaxed);
+
+  uint32_t level = shed_level_.load(std::memory_order_relaxed);
+  if (min_us > opts_.target_us) {
+    if (level < kMaxShedLevel) level++;
+  } else if (level > 0) {
+    level--;
+  }
+  shed_level_.store(level, std::memory_order_relaxed);
+}
+
+bool AdmissionController::Admit(AdmissionPriority priority, size_t queue_len, uint64_t now_us) {
+  uint32_t level = shed_level_.load(std::memory_order_relaxed);
+  if (queue_len == 0) {
+    // 队列已排空：上一轮过载的影响已经消失
+    if (level != 0) {
+      shed_level_.store(0, std::memory_order_relaxed);
+      level = 0;
+    }
+  } else if (level < kMaxShedLevel) {
+    // Little 定律：新请求的等待时间约为 队列长度 / 出队速率，超过一个窗口时不必等窗口结算，直接拒绝到最高级
+    // 一整个窗口都没有出队（worker 全部阻塞）时速率按 0 处理
+    const uint64_t last = last_observe_us_.load(std::memory_order_relaxed);
+    if (last != 0) {
+      const uint64_t rate = now_us > last + opts_.interval_us
+          ? 0 : dequeue_per_sec_.load(std::memory_order_relaxed);
+      const uint64_t est_wait_us = rate == 0 ? UINT64_MAX : queue_len * 1000000 / rate;
+      if (est_wait_us > opts_.interval_us) {
+        level = kMaxShedLevel;
+        shed_level_.store(level, std::memory_order_relaxed);
+      }
+    }
+  }
+
+  const uint32_t rank = static_cast<uint32_t>(priority);
+  if (level > 0 && rank + level > kMaxShedLevel) {
+    shed_[rank].fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+  admitted_.fetch_add(1, std::memory_order_relaxed);
+  return true;
+}
+
+AdmissionController::Stats AdmissionController::stats() const {
+  Stats st;
+  st.admitted = admitted_.load(std::memory_order_relaxed);
+  for (size_t i = 0; i < static_cast<size_t>(AdmissionPriority::Count); i++) {
+    st.shed[i] = shed_[i].load(std::memory_order_relaxed);
+  }
+  st.shed_level = shed_level_.load(std::memory_order_relaxed);
+  st.last_min_sojourn_us = last_min_sojourn_us_.load(std::memory_order_relaxed);
+  return st;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// 请求的准入优先级：过载时按 Low -> Normal 的顺序逐级拒绝，High 不被延迟控制拒绝
+enum class AdmissionPriority : uint8_t {
+  High = 0,    // 交互关键路径（登录注册、页面）与内部端点
+  Normal,      // 普通 API
+  Low,         // 静态资源、下载等可重试的大流量请求
+  Count
+};
+
+const char* AdmissionPriorityName(AdmissionPriority priority);
+
+/**
+ * AdmissionController：按排队逗留时间自适应拒绝请求（CoDel 风格）
+ *  - worker 出队时调用 Observe() 上报任务的排队逗留时间；每个 interval 统计一次窗口内的最小逗留时间，
+ *    最小值仍超过 target 说明队列已形成"坏队列"（持续积压而非突发），拒绝级别升一级；
+ *    最小值低于 target 时降一级，逐级恢复避免在拒绝/放行之间来回抖动
+ *  - IO 线程分发前调用 Admit()：优先级低于当前拒绝级别的请求直接拒绝
+ *  - 窗口结算前按 Little 定律用 队列长度 / 上一窗口出队速率 估算新请求的等待时间，超过 interval 时
+ *    直接升到最高级，突发积压不必等若干窗口才生效；worker 全部阻塞（一个窗口内没有出队）时同样适用
+ *  - 队列为空时立即恢复放行
+ * 全部状态为原子变量：Observe 可在任意 worker 线程并发调用，Admit 可在任意 IO 线程调用
+ */
+class AdmissionController {
+public:
+  struct Options {
+    uint64_t target_us{5000};       // 可接受的排队逗留时间
+    uint64_t interval_us{100000};   // 评估窗口，应覆盖一次典型的突发
+  };
+
+  struct Stats {
+    uint64_t admitted{0};
+    uint64_t shed[static_cast<size_t>(AdmissionPriority::Count)] = {};
+    uint32_t shed_level{0};         // 0 表示全部放行；1 拒绝 Low；2 拒绝 Low 与 Normal
+    uint64_t last_min_sojourn_us{0};
+  };
+
+  explicit AdmissionController(const Options& opts);
+  AdmissionController() : AdmissionController(Options{}) {}
+
+  AdmissionController(const AdmissionController&) = delete;
+  AdmissionController& operator=(const AdmissionController&) = delete;
+
+  // worker 出队时上报逗留时间；now_us 为单调时钟（微秒）
+  void Observe(uint64_t sojourn_us, uint64_t now_us);
+  // queue_len 为执行池当前积压的任务数；返回 false 表示应拒绝该请求
+  bool Admit(AdmissionPriority priority, size_t queue_len, uint64_t now_us);
+
+  uint32_t shed_level() const { return shed_level_.load(std::memory_order_relaxed); }
+  Stats stats() const;
+
+  static uint64_t NowUs();
+
+private:
+  static constexpr uint32_t kMaxShedLevel = static_cast<uint32_t>(AdmissionPriority::Count) - 1;
+
+  void MaybeCloseWindow(uint64_t now_us);
+
+  const Options opts_;
+  std::atomic<uint64_t> window_start_us_{0};
+  std::atomic<uint64_t> window_min_us_{UINT64_MAX};
+  std::atomic<uint64_t> window_observed_{0};
+  std::atomic<uint64_t> last_observe_us_{0};
+  std::atomic<uint64_t> dequeue_per_sec_{0};     // 上一窗口的出队速率
+  std::atomic<uint32_t> shed_level_{0};
+  std::atomic<uint64_t> last_min_sojourn_us_{0};
+  std::atomic<uint64_t> admitted_{0};
+  std::atomic<uint64_t> shed_[static_cast<size_t>(AdmissionPriority::Count)] = {};
+};
@@ -0,0 +1,108 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+/**
+ * ChaseLevDeque：单生产者（owner）/多窃取者的无锁工作窃取双端队列
+ * 参考 Lê, Pop, Cohen, Zappa Nardelli,
+ * "Correct and Efficient Work-Stealing for Weak Memory Models" (PPoPP'13) 的 C11 版本
+ *  - push()/pop() 只能由 owner 线程调用，在 bottom 端 LIFO 操作
+ *  - steal() 可被任意线程调用，在 top 端 FIFO 窃取
+ * 元素必须是可平凡拷贝的（通常是指针）：失败的窃取可能读到被覆盖的槽位，随后会被 CAS 丢弃
+ * 容量固定（向上取整为 2 的幂），满时 push() 返回 false，由调用方回退到其他队列
+ */
+template <typename T>
+class ChaseLevDeque {
+  static_assert(std::is_trivially_copyable<T>::value, "ChaseLevDeque 元素必须可平凡拷贝");
+
+public:
+  explicit ChaseLevDeque(size_t capacity) {
+    size_t cap = 2;
+    while (cap < capacity) cap <<= 1;
+    mask_ = static_cast<int64_t>(cap - 1);
+    buffer_ = std::make_unique<std::atomic<T>[]>(cap);
+  }
+
+  ChaseLevDeque(const ChaseLevDeque&) = delete;
+  ChaseLevDeque& operator=(const ChaseLevDeque&) = delete;
+
+  // owner 线程：压入 bottom 端
+  bool push(T value) {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_acquire);
+    if (b - t > mask_) {
+      return false;
+    }
+    buffer_[b & mask_].store(value, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // owner 线程：从 bottom 端弹出
+  bool pop(T& out) {
+    int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top_.load(std::memory_order_relaxed);
+
+    if (t > b) {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+      return false;
+    }
+
+    out = buffer_[b & mask_].load(std::memory_order_relaxed);
+    if (t != b) {
+      return true;
+    }
+
+    // 只剩最后一个元素，与窃取者竞争
+    bool won = top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                            std::memory_order_relaxed);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+    return won;
+  }
+
+  // 任意线程：从 top 端窃取；与其他窃取者或 owner 冲突时返回 false
+  bool steal(T& out) {
+    int64_t t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+      return false;
+    }
+
+    T value = buffer_[t & mask_].load(std::memory_order_relaxed);
+    if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                      std::memory_order_relaxed)) {
+      return false;
+    }
+    out = value;
+    return true;
+  }
+
+  // 近似长度，仅用于统计与空闲判断
+  size_t size_approx() const {
+    int64_t b = bottom_.load(std::memory_order_relaxed);
+    int64_t t = top_.load(std::memory_order_relaxed);
+    return b > t ? static_cast<size_t>(b - t) : 0;
+  }
+
+  bool empty_approx() const { return size_approx() == 0; }
+
+  // owner 线程：下一次 push() 写入的环形下标，供调用方把元素本体存放在同下标的预分配槽位中
+  size_t next_push_index() const {
+    return static_cast<size_t>(bottom_.load(std::memory_order_relaxed) & mask_);
+  }
+
+  size_t capacity() const { return static_cast<size_t>(mask_) + 1; }
+
+private:
+  alignas(64) std::atomic<int64_t> top_{0};
+  alignas(64) std::atomic<int64_t> bottom_{0};
+  int64_t mask_{0};
+  std::unique_ptr<std::atomic<T>[]> buffer_;
+};
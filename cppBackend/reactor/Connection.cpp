@@ -8,6 +8,23 @@
 #include "TlsContext.h"
 #include "TlsSession.h"
 
+namespace {
+
+// 把 iovec 列表截断到总长不超过 limit 字节
+size_t ClampIOVecs(struct iovec* iovs, size_t count, size_t limit){
+  size_t total = 0;
+  for(size_t i = 0; i < count; ++i){
+    if(total + iovs[i].iov_len >= limit){
+      iovs[i].iov_len = limit - total;
+      return iovs[i].iov_len > 0 ? i + 1 : i;
+    }
+    total += iovs[i].iov_len;
+  }
+  return count;
+}
+
+}  // namespace
+
 
 Connection::Connection(EventLoop* loop,std::unique_ptr<Socket>clientsock)
 :loop_(loop),clientsock_(std::move(clientsock)),disconnect_(false),close_on_send_complete_(false),clientchannel_(new Channel(loop_,clientsock_->fd())){
@@ -119,6 +136,7 @@ void Connection::writecallback(){
           }
         }
         if (wr == TlsIoResult::WANT_WRITE) {
+          CheckLowWater();
           return;
         }
         if (wr == TlsIoResult::WANT_READ) {
@@ -132,38 +150,43 @@ void Connection::writecallback(){
         return;
       }
 
-      if (outputbuffer_.readableBytes() > 0) {
-        size_t take = std::min<size_t>(16384, outputbuffer_.readableBytes());
+      const size_t buffered_limit = OutputBytesBeforeFile();
+      if (outputbuffer_.readableBytes() > 0 && buffered_limit > 0) {
+        size_t take = std::min<size_t>({16384, outputbuffer_.readableBytes(), buffered_limit});
         tls_out_pending_.assign(take, '\0');
         outputbuffer_.peekFromBlock(&tls_out_pending_[0], take);
         outputbuffer_.consumeBytes(take);
+        output_sent_ += take;
         continue;
       }
 
-      if (sendfile_.active) {
-        if (sendfile_.remaining == 0) {
-          ClearSendFile();
+      if (!sendfile_queue_.empty()) {
+        SendFileState& sf = sendfile_queue_.front();
+        if (sf.remaining == 0) {
+          PopSendFile();
           continue;
         }
 
         if (pread_count >= kMaxPreadsPerEvent) {
           clientchannel_->enablewriting();
+          CheckLowWater();
           return;
         }
 
-        size_t to_read = std::min<size_t>(16384, sendfile_.remaining);
+        size_t to_read = std::min<size_t>(16384, sf.remaining);
         tls_out_pending_.assign(to_read, '\0');
-        ssize_t n = ::pread(sendfile_.file_fd, &tls_out_pending_[0], to_read, sendfile_.offset);
+        ssize_t n = ::pread(sf.file_fd, &tls_out_pending_[0], to_read, sf.offset);
         if (n > 0) {
           tls_out_pending_.resize(static_cast<size_t>(n));
-          sendfile_.offset += static_cast<off_t>(n);
-          sendfile_.remaining -= static_cast<size_t>(n);
+          sf.offset += static_cast<off_t>(n);
+          sf.remaining -= static_cast<size_t>(n);
+          sendfile_bytes_ -= static_cast<size_t>(n);
           pread_count++;
           continue;
         }
         if (n == 0) {
-          sendfile_.remaining = 0;
-          ClearSendFile();
+          tls_out_pending_.clear();
+          PopSendFile();
           continue;
         }
         if (errno == EINTR) {
@@ -176,6 +199,7 @@ void Connection::writecallback(){
       }
 
       clientchannel_->disablewriting();
+      CheckLowWater();
       if (sendcompletecallback_ && !disconnect_) {
         sendcompletecallback_(shared_from_this());
       }
@@ -194,16 +218,23 @@ LOGDEBUG("准备发送数据");
   size_t total_written = 0;
 
   while(total_written < kMaxBytesPerEvent){
+    // 队首文件区间之前的字节先发，文件区间发完后再发其后追加的字节
+    const size_t buffered_limit = OutputBytesBeforeFile();
     size_t iov_count = 0;
-    iov_count = outputbuffer_.getIOVecs(iovs,max_ioves,outputbuffer_.read_pos_);
+    if(buffered_limit > 0){
+      iov_count = outputbuffer_.getIOVecs(iovs,max_ioves,outputbuffer_.read_pos_);
+      iov_count = ClampIOVecs(iovs, iov_count, buffered_limit);
+    }
     if(iov_count > 0){
       ssize_t nwritten = ::writev(fd(),iovs,iov_count);
       if(nwritten > 0){
         total_written += static_cast<size_t>(nwritten);
         outputbuffer_.consumeBytes(nwritten);
+        output_sent_ += static_cast<uint64_t>(nwritten);
         continue;
       }else if(nwritten == -1){
         if(errno ==EAGAIN || errno == EWOULDBLOCK){
+          CheckLowWater();
           return;
         }else{
           LOGERROR("writev failed, fd: "+std::to_string(fd())+" error: "+strerror(errno));
@@ -213,35 +244,42 @@ LOGDEBUG("准备发送数据");
       }
     }
 
-    if(sendfile_.active){
-      if(sendfile_.remaining == 0){
-        ClearSendFile();
+    if(!sendfile_queue_.empty() && OutputBytesBeforeFile() == 0){
+      SendFileState& sf = sendfile_queue_.front();
+      if(sf.remaining == 0){
+        PopSendFile();
+        continue;
+      }
+      off_t off = sf.offset;
+      ssize_t n = ::sendfile(fd(), sf.file_fd, &off, sf.remaining);
+      if(n > 0){
+        total_written += static_cast<size_t>(n);
+        sf.offset = off;
+        sf.remaining -= static_cast<size_t>(n);
+        sendfile_bytes_ -= static_cast<size_t>(n);
+        if(sf.remaining == 0){
+          PopSendFile();
+        }
+        continue;
+      }else if(n == 0){
+        PopSendFile();
+        continue;
       }else{
-        off_t off = sendfile_.offset;
-        ssize_t n = ::sendfile(fd(), sendfile_.file_fd, &off, sendfile_.remaining);
-        if(n > 0){
-          total_written += static_cast<size_t>(n);
-          sendfile_.offset = off;
-          sendfile_.remaining -= static_cast<size_t>(n);
-          continue;
-        }else if(n == 0){
-          sendfile_.remaining = 0;
-          ClearSendFile();
+        if(errno ==EAGAIN || errno == EWOULDBLOCK){
+          CheckLowWater();
+          return;
         }else{
-          if(errno ==EAGAIN || errno == EWOULDBLOCK){
-            return;
-          }else{
-            LOGERROR("sendfile failed, fd: "+std::to_string(fd())+" error: "+strerror(errno));
-            errorcallback();
-            return;
-          }
+          LOGERROR("sendfile failed, fd: "+std::to_string(fd())+" error: "+strerror(errno));
+          errorcallback();
+          return;
         }
       }
     }
 
-    if(outputbuffer_.readableBytes() == 0 && !sendfile_.active){
+    if(outputbuffer_.readableBytes() == 0 && sendfile_queue_.empty()){
       clientchannel_->disablewriting();
 LOGDEBUG("发送数据完毕");
+      CheckLowWater();
       if(sendcompletecallback_ && !disconnect_){
         sendcompletecallback_(shared_from_this());
       }
@@ -253,9 +291,19 @@ LOGDEBUG("发送数据完毕");
     }
   }
 
-  if(outputbuffer_.readableBytes() > 0 || sendfile_.active){
+  if(outputbuffer_.readableBytes() > 0 || !sendfile_queue_.empty()){
     clientchannel_->enablewriting();
   }
+  CheckLowWater();
+}
+
+// 低水位回调可能再次设置回调或追加输出，先解除再调用
+void Connection::CheckLowWater(){
+  if(lowwatercallback_ && !disconnect_ && PendingSendBytes() < low_water_){
+    auto fn = std::move(lowwatercallback_);
+    lowwatercallback_ = nullptr;
+    fn(shared_from_this());
+  }
 }
 
 void Connection::onmessage(){
@@ -291,7 +339,8 @@ void Connection::onmessage(){
       for (char& c : s) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
       return s.rfind("GET ", 0) == 0 || s.rfind("POST", 0) == 0 || s.rfind("PUT ", 0) == 0 ||
              s.rfind("HEAD", 0) == 0 || s.rfind("HTTP", 0) == 0 || s.rfind("OPTI", 0) == 0 ||
-             s.rfind("DELE", 0) == 0 || s.rfind("PATC", 0) == 0;
+             s.rfind("DELE", 0) == 0 || s.rfind("PATC", 0) == 0 ||
+             s.rfind("PRI ", 0) == 0;   // HTTP/2 明文前言（h2c prior knowledge）
     };
 
     if (looks_like_tls(probe, static_cast<size_t>(n))) {
@@ -411,6 +460,10 @@ void Connection::setonmessagecallback(std::function<void(spConnection/*暂且先
 void Connection::setsendcompletecallback(std::function<void(spConnection)> fn){
   sendcompletecallback_=fn;
 }
+void Connection::setlowwatercallback(size_t low_water, std::function<void(spConnection)> fn){
+  low_water_=low_water;
+  lowwatercallback_=std::move(fn);
+}
 
 //时间戳
 // bool Connection::timeout(time_t now,int val){
@@ -426,19 +479,63 @@ void Connection::setclosetimercallback(std::function<void(spConnection)>fn){
   closetimercallback_=fn;
 }
 
+void Connection::PauseReading(){
+  if(!disconnect_){
+    clientchannel_->disablereading();
+  }
+}
+
+void Connection::ResumeReading(){
+  // 水平触发：套接字中已有的数据会在下一轮 epoll_wait 立即报告
+  if(!disconnect_){
+    clientchannel_->enablereading();
+  }
+}
+
 void Connection::StartSendFile(int file_fd, off_t offset, size_t count, bool close_fd){
-  ClearSendFile();
-  sendfile_.file_fd = file_fd;
-  sendfile_.offset = offset;
-  sendfile_.remaining = count;
-  sendfile_.close_fd = close_fd;
-  sendfile_.active = (file_fd >= 0);
+  if(file_fd < 0){
+    return;
+  }
+  if(count == 0){
+    if(close_fd){
+      ::close(file_fd);
+    }
+    return;
+  }
+  SendFileState sf;
+  sf.file_fd = file_fd;
+  sf.offset = offset;
+  sf.remaining = count;
+  sf.close_fd = close_fd;
+  sf.start_mark = output_sent_ + outputbuffer_.readableBytes();
+  sendfile_queue_.push_back(sf);
+  sendfile_bytes_ += count;
   clientchannel_->enablewriting();
 }
 
 void Connection::ClearSendFile(){
-  if(sendfile_.file_fd >= 0 && sendfile_.close_fd){
-    ::close(sendfile_.file_fd);
+  while(!sendfile_queue_.empty()){
+    PopSendFile();
+  }
+  sendfile_bytes_ = 0;
+}
+
+void Connection::PopSendFile(){
+  SendFileState& sf = sendfile_queue_.front();
+  if(sf.file_fd >= 0 && sf.close_fd){
+    ::close(sf.file_fd);
   }
-  sendfile_ = SendFileState{};
+  sendfile_bytes_ -= sf.remaining;
+  sendfile_queue_.pop_front();
+}
+
+size_t Connection::OutputBytesBeforeFile() const{
+  if(sendfile_queue_.empty()){
+    return SIZE_MAX;
+  }
+  return static_cast<size_t>(sendfile_queue_.front().start_mark - output_sent_);
+}
+
+std::string_view Connection::AlpnProtocol() const{
+  return tls_ ? tls_->AlpnProtocol() : std::string_view();
 }
@@ -14,6 +14,8 @@
 #include"Buffer.h"
 #include<memory>
 #include<utility>
+#include<deque>
+#include<string_view>
 //#include"Timestamp.h"
 
 class Connection;
@@ -32,6 +34,8 @@ private:
   std::function<void(spConnection)> errorcallback_;  //关闭fd_的回调函数,将回调TcpServer::errorconnection()
   std::function<void(spConnection/*暂且先注释了等后面需要用到工作线程在开出来,BufferBlock&*/)> onmessagecallback_;  //处理报文的回调函数，将回调TcpServer::message()
   std::function<void(spConnection)>sendcompletecallback_;   //发送完数据后的回调函数，将回调TcpServer::sendcomplete()
+  std::function<void(spConnection)>lowwatercallback_;       //待发送字节降到 low_water_ 以下时回调一次，触发后自动解除
+  size_t low_water_{0};
   std::function<void(spConnection)>closetimercallback_;
   std::atomic_bool disconnect_;    //客户端连接是否断开，如果断开设置为true
   std::atomic_bool close_on_send_complete_;  //发送完成后是否关闭连接
@@ -44,15 +48,19 @@ private:
 
   std::any context_;
 
+  // 待发送的文件区间：输出缓冲累计发出 start_mark 字节后才轮到它，之后追加的字节排在它后面，
+  // 因此文件区间可以与缓冲中的字节交错（HTTP/1 流水线的多个文件响应、HTTP/2 DATA 帧头与文件负载）
   struct SendFileState{
     int file_fd{-1};
     off_t offset{0};
     size_t remaining{0};
     bool close_fd{true};
-    bool active{false};
+    uint64_t start_mark{0};
   };
 
-  SendFileState sendfile_;
+  std::deque<SendFileState> sendfile_queue_;
+  size_t sendfile_bytes_{0};          // 队列中文件区间的剩余字节数之和
+  uint64_t output_sent_{0};           // 输出缓冲累计已发出的字节数
 
   std::shared_ptr<TlsContext> tls_ctx_;
   std::unique_ptr<TlsSession> tls_;
@@ -60,6 +68,10 @@ private:
   bool tls_plaintext_{false};
   std::string tls_out_pending_;
 
+  void PopSendFile();
+  size_t OutputBytesBeforeFile() const;   // 队首文件区间之前还可以发送的输出缓冲字节数
+  void CheckLowWater();
+
   //定时器
   int tc_fd;
   int tc_timer_id{ -1 };
@@ -86,6 +98,9 @@ public:
   
   void setonmessagecallback(std::function<void(spConnection/*暂且先注释了等后面需要用到工作线程在开出来,BufferBlock&*/)> fn);
   void setsendcompletecallback(std::function<void(spConnection)> fn);
+  // 一次性的输出低水位回调：之后某次写出使待发送字节低于 low_water 时回调并解除，只能在 IO 线程设置。
+  // 上层在高水位暂停生成数据时设置，输出未完全排空前就恢复生成，使生成与发送重叠
+  void setlowwatercallback(size_t low_water, std::function<void(spConnection)> fn);
   
   void connectEstablished();
 
@@ -105,9 +120,18 @@ public:
   void setCloseOnSendComplete(bool close) { close_on_send_complete_ = close; }
   bool getCloseOnSendComplete() const { return close_on_send_complete_; }
 
+  // 暂停/恢复读取连接（上层处理积压时的背压），只能在连接所属的 IO 线程调用
+  void PauseReading();
+  void ResumeReading();
+
+  // 在输出缓冲当前内容之后排队发送文件区间（明文连接用 sendfile，TLS 连接 pread 后加密发送）
   void StartSendFile(int file_fd, off_t offset, size_t count, bool close_fd = true);
   void ClearSendFile();
-  bool HasSendFile() const { return sendfile_.active; }
+  bool HasSendFile() const { return !sendfile_queue_.empty(); }
+  // 尚未发出的字节数：输出缓冲 + 排队的文件区间
+  size_t PendingSendBytes() const { return outputbuffer_.readableBytes() + tls_out_pending_.size() + sendfile_bytes_; }
+  // TLS 握手协商出的 ALPN 协议（如 "h2"），明文连接或未协商时为空
+  std::string_view AlpnProtocol() const;
 
   void SetTlsContext(std::shared_ptr<TlsContext> ctx) { tls_ctx_ = std::move(ctx); }
 
@@ -42,6 +42,8 @@ void EventLoop::run(){
     //相当于把由channel封装后的fd，将其发生事件的fd提取出来，并根据其发生的事件设置其revent
     //再将这些fd以数组形式返回
     std::vector<Channel*> vcn=ep_->loop(10*1000);
+    iterations_.store(iterations_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    events_.store(events_.load(std::memory_order_relaxed) + vcn.size(), std::memory_order_relaxed);
     
     //如果channel为空，表示超时，回调TcpServer::sepolltimeout()
     if(vcn.empty()) {
@@ -76,13 +78,14 @@ bool EventLoop::isinloopthread(){
   return threadid_==syscall(SYS_gettid);
 }
 
-void EventLoop::queueinloop(std::function<void()> fn){
+void EventLoop::queueinloop(Functor fn){
   bool need_wakeup = false;
   {
     std::lock_guard<std::mutex> lock(mutex_); //加锁
     need_wakeup = taskqueue_.empty();
-    taskqueue_.push(std::move(fn));    //任务入队
+    taskqueue_.push_back(std::move(fn));    //任务入队
   }
+  pending_tasks_.fetch_add(1, std::memory_order_relaxed);
   //唤醒事件
   if (need_wakeup) {
 LOGDEBUG("有任务入队，唤醒事件");
@@ -101,17 +104,27 @@ LOGDEBUG("处理因事件管道唤起的事件");
   read(wakeupfd_,&val,sizeof(val)); //从eventfd读出数据，如果不读，则会一直触发eventfd的读事件
   
   
-  std::queue<std::function<void()>> tasks;
+  //交换两个vector而不是移动，双方的容量都得以保留，稳态下入队不再分配内存
   {
     std::lock_guard<std::mutex> lock(mutex_);
-    tasks = std::move(taskqueue_);
+    runningtasks_.swap(taskqueue_);
   }
   
-  while(!tasks.empty()){
-    auto fn = std::move(tasks.front());
-    tasks.pop();
+  for(auto &fn:runningtasks_){
     fn();
   }
+  tasks_run_.store(tasks_run_.load(std::memory_order_relaxed) + runningtasks_.size(), std::memory_order_relaxed);
+  pending_tasks_.fetch_sub(runningtasks_.size(), std::memory_order_relaxed);
+  runningtasks_.clear();
+}
+
+EventLoop::Stats EventLoop::stats() const {
+  Stats st;
+  st.iterations = iterations_.load(std::memory_order_relaxed);
+  st.events = events_.load(std::memory_order_relaxed);
+  st.tasks_run = tasks_run_.load(std::memory_order_relaxed);
+  st.pending_tasks = pending_tasks_.load(std::memory_order_relaxed);
+  return st;
 }
 
 //时间戳
@@ -5,12 +5,13 @@
 #include<sys/syscall.h>
 #include<memory>
 #include<sys/syscall.h>
-#include<queue>
+#include<vector>
 #include<mutex>
 #include<sys/eventfd.h>
 #include<sys/timerfd.h>
 #include<map>
 #include"Connection.h"
+#include"InplaceTask.h"
 #include<atomic>
 #include"../logger/log_fac.h"
 class Channel;
@@ -19,12 +20,26 @@ class Connection;
 using spConnection = std::shared_ptr<Connection>;
 
 class EventLoop{
+public:
+  // 跨线程投递到事件循环的任务；容量需容纳 HttpServer::PostResultToIoLoop 捕获的 WorkResult
+  static constexpr size_t kFunctorInlineSize = 384;
+  using Functor = InplaceTask<void(), kFunctorInlineSize>;
+
+  // 事件循环运行指标，由循环线程单写，其他线程可随时读取
+  struct Stats {
+    uint64_t iterations{0};     // epoll_wait 返回次数
+    uint64_t events{0};         // 处理的 fd 事件数
+    uint64_t tasks_run{0};      // 执行的跨线程任务数
+    size_t pending_tasks{0};    // 已投递尚未执行的跨线程任务数
+  };
+
 private:
   std::unique_ptr<Epoll> ep_;    //每一个事件循环有一个epoll
   std::function<void(EventLoop*)>epolltimeoutcallback_;   //epoll_wait()超时的回调函数
   pid_t threadid_;              //事件循环所在线程id,事件循环有一个线程id，但是不是所有线程都有一个事件循环
                                 //所有事件循环都会分配到io线程中,而不会分配到工作线程中,所以获得都是io线程 
-  std::queue<std::function<void()>> taskqueue_; //事件循环被eventfd唤醒后执行的任务队列
+  std::vector<Functor> taskqueue_; //事件循环被eventfd唤醒后执行的任务队列
+  std::vector<Functor> runningtasks_; //handlewakeup()交换出来正在执行的任务，复用容量避免反复分配
   std::mutex mutex_;            //任务队列同步的互斥锁
   int wakeupfd_;                //用于唤醒事件循环线程的eventfd
   std::unique_ptr<Channel> wakeupchannel_;  //eventfd的channel
@@ -42,6 +57,11 @@ private:
   
   std::atomic_bool stop_;
 
+  std::atomic<uint64_t> iterations_{0};
+  std::atomic<uint64_t> events_{0};
+  std::atomic<uint64_t> tasks_run_{0};
+  std::atomic<size_t> pending_tasks_{0};
+
 public:
   EventLoop(/*bool mainloop,int timetvl=30,int timeout=60*/);    //在构造函数创建Epoll对象ep_
   ~EventLoop();   //销毁ep_
@@ -54,10 +74,12 @@ public:
 
   bool isinloopthread();  //判断当前线程是否为事件循环线程
 
-  void queueinloop(std::function<void()> fn);   //把任务添加到队列中
+  void queueinloop(Functor fn);   //把任务添加到队列中
   void wakeup();      //唤醒线程
   void handlewakeup();    //事件循环线程被eventfd唤醒后执行的函数
 
+  Stats stats() const;
+
 
   //时间戳
   //void handletimer();   //闹钟响时执行的函数
@@ -5,8 +5,10 @@
 #include"../http/include/error/HttpErrorUtil.h"
 #include"../http/include/util/HttpHeadersUtil.h"
 #include"../http/include/util/HttpStringUtil.h"
+#include"../http/include/util/HttpCompress.h"
 #include"../http/include/router/Router.h"
 #include"TlsContext.h"
+#include"../MemoryPool/DeferDeallocate.h"
 #include"../services/include/AuthService.h"
 #include"../auth/jwt/JwtUtil.h"
 #include"../services/include/DownloadService.h"
@@ -21,8 +23,11 @@
 #include"../views/include/VideoPageHandler.h"
 #include"../views/include/IPageHandler.h"
 #include"RouteMetricsUtil.h"
+#include"PrometheusText.h"
+#include"../MemoryPool/MemoryPool.h"
 #include<algorithm>
 #include<cerrno>
+#include<cstdlib>
 #include<cstring>
 #include<fcntl.h>
 #include<unistd.h>
@@ -30,13 +35,210 @@
 #include<atomic>
 #include<chrono>
 
+namespace {
+long ElapsedUs(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to) {
+  return static_cast<long>(std::chrono::duration_cast<std::chrono::microseconds>(to - from).count());
+}
+
+bool EnvIsOff(const char* name) {
+  const char* v = std::getenv(name);
+  if (!v) return false;
+  return std::string(v) == "0" || std::string(v) == "false" || std::string(v) == "FALSE";
+}
+
+bool EnvIsOn(const char* name) {
+  const char* v = std::getenv(name);
+  if (!v) return false;
+  return std::string(v) == "1" || std::string(v) == "true" || std::string(v) == "TRUE";
+}
+
+constexpr const char* kMetricsPath = "/metrics";
+
+// 过载时按优先级拒绝：页面与登录注册保持可用，静态资源与下载最先被拒绝
+// /metrics 只有白名单连接能走到准入（其他连接在路由阶段已得到 404），过载时仍保证可抓取
+AdmissionPriority AdmissionPriorityForPath(const std::string& path) {
+  if (path == kMetricsPath) {
+    return AdmissionPriority::High;
+  }
+  switch (ClassifyRouteBucketId(path)) {
+    case RouteBucket::Page:
+    case RouteBucket::Auth:
+      return AdmissionPriority::High;
+    case RouteBucket::Api:
+      return AdmissionPriority::Normal;
+    default:
+      return AdmissionPriority::Low;
+  }
+}
+
+// 各类路由的压缩级别：接口 JSON 每次现压，取最快的级别；页面次之；静态文件优先发送预压缩副本，
+// 现压只发生在错误页等小响应上；下载与其他路由不压缩（0）
+int CompressionLevelForPath(const std::string& path) {
+  switch (ClassifyRouteBucketId(path)) {
+    case RouteBucket::Api:
+    case RouteBucket::Auth:
+      return 1;
+    case RouteBucket::Page:
+      return 5;
+    case RouteBucket::Static:
+      return 6;
+    default:
+      return 0;
+  }
+}
+
+// 按 Accept-Encoding 压缩文本类响应：内存 body 整体压缩（结果不更小时保留原文），按需生成的 body 逐段压缩；
+// 文件响应（sendfile）由 StaticFileService 选择预压缩副本，这里不处理
+void MaybeCompressResponse(const HttpRequest& request, HttpResponse& response, int level) {
+  if (level <= 0 || request.GetMethod() == HttpMethod::HEAD || response.HasSendFile()) {
+    return;
+  }
+  const int status = response.getStatusCodeInt();
+  if (status < 200 || status == 204 || status == 206 || status == 304) {
+    return;
+  }
+  if (response.Headers().Has(KnownHeader::ContentEncoding)) {
+    return;
+  }
+  auto content_type = response.GetHeaderView(KnownHeader::ContentType);
+  if (!content_type || !IsCompressibleContentType(*content_type)) {
+    return;
+  }
+  const bool streamed = response.HasBodyProducer();
+  if (!streamed && response.GetBodyLength() < kMinCompressBytes) {
+    return;
+  }
+
+  // 表示形式随 Accept-Encoding 变化，共享缓存必须按它区分
+  auto vary = response.GetHeaderView(KnownHeader::Vary);
+  if (!vary) {
+    response.SetHeader(KnownHeader::Vary, "Accept-Encoding");
+  } else if (vary->find("Accept-Encoding") == std::string_view::npos) {
+    response.SetHeader(KnownHeader::Vary, std::string(*vary) + ", Accept-Encoding");
+  }
+
+  auto accept = request.GetHeaderView(KnownHeader::AcceptEncoding);
+  const HttpContentEncoding encoding = accept ? NegotiateContentEncoding(*accept) : HttpContentEncoding::IDENTITY;
+  if (encoding == HttpContentEncoding::IDENTITY) {
+    return;
+  }
+
+  if (streamed) {
+    response.SetBodyProducer(MakeCompressingProducer(response.TakeBodyProducer(), encoding, level));
+  } else {
+    std::string compressed;
+    if (!CompressBody(response.GetBodyView(), encoding, level, compressed) ||
+        compressed.size() >= response.GetBodyLength()) {
+      return;
+    }
+    response.RemoveHeader("Content-Length");
+    response.SetBody(std::move(compressed));
+  }
+  response.SetHeader(KnownHeader::ContentEncoding, ContentEncodingToken(encoding));
+  response.SetContentEncoding(encoding);
+}
+
+std::string BuildShedResponse(bool keep_alive) {
+  HttpResponse response;
+  response.SetStatusCode(HttpStatusCode::SERVICE_UNAVAILABLE);
+  response.SetHeader("Content-Type", "application/json; charset=utf-8");
+  response.SetHeader("Retry-After", "1");
+  response.SetHeader("Connection", keep_alive ? "keep-alive" : "close");
+  response.SetBody("{\"success\":false,\"message\":\"Service busy: overloaded\"}");
+  return response.Serialize();
+}
+
+void BuildShedResponseHttp2(std::string& head, std::string& body) {
+  HttpResponse response;
+  response.SetStatusCode(HttpStatusCode::SERVICE_UNAVAILABLE);
+  response.SetHeader("Content-Type", "application/json; charset=utf-8");
+  response.SetHeader("Retry-After", "1");
+  response.SetBody("{\"success\":false,\"message\":\"Service busy: overloaded\"}");
+  Http2Parser::EncodeResponseHead(response, head);
+  body = response.TakeBody();
+}
+
+// Http2Parser 的输出目标：帧字节追加到连接输出缓冲，文件负载排入连接的 sendfile 队列
+class ConnectionHttp2Sink : public Http2Parser::OutputSink {
+public:
+  explicit ConnectionHttp2Sink(Connection& conn) : conn_(conn) {}
+  void Write(const char* data, size_t len) override {
+    conn_.getOutputBuffer().append(data, len);
+  }
+  void WriteFile(int fd, off_t offset, size_t len, bool close_fd) override {
+    conn_.StartSendFile(fd, offset, len, close_fd);
+  }
+
+private:
+  Connection& conn_;
+};
+
+// 每个响应都相同的头部只渲染一次，序列化时整块拷贝
+PrerenderedHeaders BuildPrerenderedHeaders() {
+  PrerenderedHeaders headers;
+  HeaderTable common;
+  common.Append("Server", "WebServer");
+  common.Append("X-Content-Type-Options", "nosniff");
+  common.Append("X-Frame-Options", "SAMEORIGIN");
+  common.AppendTo(headers.common);
+
+  HeaderTable cors;
+  cors.Append("Access-Control-Allow-Credentials", "true");
+  cors.Append("Access-Control-Expose-Headers", "X-Request-Id");
+  cors.Append("Access-Control-Max-Age", "600");
+  cors.AppendTo(headers.cors);
+  headers.date = true;
+  return headers;
+}
+
+ThreadPool::Options MakeWorkPoolOptions(int workthreadnum, int maxworkthreadnum) {
+  ThreadPool::Options opts;
+  opts.min_threads = static_cast<size_t>(std::max(1, workthreadnum));
+  opts.max_threads = std::max(opts.min_threads, static_cast<size_t>(std::max(0, maxworkthreadnum)));
+  return opts;
+}
+}
+
 HttpServer::HttpServer(const std::string &ip,uint16_t port,int timeoutS,bool OptLinger,
                        int sqlPort,const char*sqlUser,const char*sqlPwd,const char*dbName,
-                       int subthreadnum,int workthreadnum,int connpoolnum,const std::string&static_path)
+                       int subthreadnum,int workthreadnum,int connpoolnum,const std::string&static_path,
+                       int maxworkthreadnum)
       :tcpserver_(ip,port,subthreadnum,timeoutS,OptLinger),
-       threadpool_(static_cast<size_t>(std::max(1, workthreadnum)), "WORKS"),
+       threadpool_("WORKS", MakeWorkPoolOptions(workthreadnum, maxworkthreadnum)),
        static_path_(static_path)
 {
+  // 阻塞型执行池：线程数与队列上限各自独立，注册/登录洪峰只会占满 blocking-db，
+  // 不会拖慢在 cpu 池中执行的静态资源与轻量 API
+  ThreadPool::Options db_opts;
+  db_opts.min_threads = 1;
+  db_opts.max_threads = static_cast<size_t>(std::max(1, connpoolnum));  // 超过连接池大小的线程只会阻塞在取连接上
+  db_opts.max_queue_size = 1024;
+  executor_pools_[kExecutorBlockingDb] = std::make_unique<ThreadPool>("DB", db_opts);
+
+  ThreadPool::Options disk_opts;
+  disk_opts.min_threads = 1;
+  disk_opts.max_threads = 8;
+  disk_opts.max_queue_size = 1024;
+  executor_pools_[kExecutorBlockingDisk] = std::make_unique<ThreadPool>("DISK", disk_opts);
+
+  // 准入控制：cpu 池的任务都很短，排队超过 5ms 即视为积压；阻塞池单个任务本身就要数十毫秒，目标放宽
+  AdmissionController::Options cpu_admission;
+  AdmissionController::Options blocking_admission;
+  blocking_admission.target_us = 50000;
+  blocking_admission.interval_us = 500000;
+  admission_[kExecutorCpu] = std::make_unique<AdmissionController>(cpu_admission);
+  admission_[kExecutorBlockingDb] = std::make_unique<AdmissionController>(blocking_admission);
+  admission_[kExecutorBlockingDisk] = std::make_unique<AdmissionController>(blocking_admission);
+  prerendered_headers_ = BuildPrerenderedHeaders();
+  shed_response_keep_alive_ = BuildShedResponse(true);
+  shed_response_close_ = BuildShedResponse(false);
+  BuildShedResponseHttp2(shed_h2_head_, shed_h2_body_);
+
+  // worker 线程可能释放 IO 线程分配的 Buffer 块，空闲退出前归还延迟释放的内存
+  threadpool_.SetThreadExitHook([] { FlushDeferredFrees(); });
+  for (auto& [name, pool] : executor_pools_) {
+    pool->SetThreadExitHook([] { FlushDeferredFrees(); });
+  }
   // 以下代码不是必须的，业务关心什么事件，就指定相应的回调函数。
   tcpserver_.setnewconnection(std::bind(&HttpServer::HandleNewConnection, this, std::placeholders::_1));
   tcpserver_.setcloseconnection(std::bind(&HttpServer::HandleClose, this, std::placeholders::_1));
@@ -46,6 +248,19 @@ HttpServer::HttpServer(const std::string &ip,uint16_t port,int timeoutS,bool Opt
   //tcpserver_.settimeout(std::bind(&HttpServer::HandleTimeOut, this, std::placeholders::_1));
   SqlConnPool::Instance()->Init("localhost", sqlPort, sqlUser, sqlPwd, dbName, connpoolnum);
   
+  metrics_enabled_ = EnvIsOn("WEBSERVER_METRICS");
+  if (const char* allow = std::getenv("WEBSERVER_METRICS_ALLOW")) {
+    std::stringstream ss(allow);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+      item = std::string(TrimAsciiWhitespace(item));
+      if (!item.empty()) {
+        metrics_allow_.push_back(item);
+      }
+    }
+  }
+  http2_enabled_ = !EnvIsOff("WEBSERVER_HTTP2");
+  compression_enabled_ = !EnvIsOff("WEBSERVER_COMPRESSION");
   router_ = std::make_shared<Router>();
   SetupRoutes(*router_);
   tls_ctx_ = TlsContext::CreateFromEnv();
@@ -61,11 +276,22 @@ void HttpServer::start(){
   tcpserver_.start();
 }
 
+void HttpServer::ReloadRoutes() {
+  // 在临时 Router 上完整重建路由表，再一次性发布到正在服务的 router_，匹配侧无需加锁
+  Router staging;
+  SetupRoutes(staging);
+  router_->Publish(staging.Snapshot());
+  LOGINFO("路由表已热更新");
+}
+
 void HttpServer::Stop(){
   LOGINFO("Http服务器关闭");
   SqlConnPool::Instance()->ClosePool();
   //停止工作线程
   threadpool_.stop();
+  for (auto& [name, pool] : executor_pools_) {
+    pool->stop();
+  }
   //停止IO线程
   tcpserver_.stop();
 }
@@ -75,31 +301,118 @@ void HttpServer::HandleNewConnection(spConnection conn){
     if (tls_ctx_) {
       conn->SetTlsContext(tls_ctx_);
     }
-    auto ctx = std::make_shared<ConnectionWorkContext>();
-    ctx->facade = std::make_shared<HttpFacade>();
-    ctx->max_concurrent_workers = max_concurrent_workers_per_conn_;
-    if (router_) {
-      ctx->facade->SetRouter(router_);
-    }
+    auto ctx = CreateWorkContext();
+    ctx->metrics_allowed = metrics_enabled_ && MetricsPeerAllowed(conn->ip());
     conn->SetContext(std::move(ctx));
   }
 }
+
+// /metrics 暴露连接池、执行池与日志队列等内部状态，只对回环地址和显式配置的地址开放
+bool HttpServer::MetricsPeerAllowed(const std::string& ip) const {
+  if (ip.rfind("127.", 0) == 0 || ip == "::1" || ip.rfind("::ffff:127.", 0) == 0) {
+    return true;
+  }
+  for (const auto& allowed : metrics_allow_) {
+    if (allowed.back() == '.' ? ip.rfind(allowed, 0) == 0 : ip == allowed) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::shared_ptr<HttpServer::ConnectionWorkContext> HttpServer::CreateWorkContext() {
+  auto ctx = std::make_shared<ConnectionWorkContext>();
+  ctx->facade = std::make_shared<HttpFacade>();
+  ctx->facade->SetCancelToken(ctx->cancel);
+  ctx->facade->SetDeferRouting(true);   // 处理器由 PhaseBusiness 在路由声明的执行池中执行
+  ctx->facade->SetBodyDeferThreshold(body_defer_threshold_);
+  ctx->reorder.Reset(max_pipeline_depth_);
+  if (router_) {
+    ctx->facade->SetRouter(router_);
+  }
+  return ctx;
+}
+
+void HttpServer::RequestContext::Reset() {
+  request = nullptr;
+  response.Clear();
+  err = HttpError{};
+  result = HttpServerResult::SUCCESS;
+  request_id.clear();
+  method.clear();
+  path.clear();
+  keep_alive = false;
+  h2_stream = 0;
+  response_seq = 0;
+  // 路由表快照必须释放，否则回收的上下文会一直延后旧路由表的回收
+  route.result = RouteMatchResult{};
+  route.table.reset();
+  route.handler = nullptr;
+  route.params = RouteParams{};
+  route.allowedMethods.clear();
+  route.executor.clear();
+  route.bodySink = nullptr;
+  enqueue_tp = {};
+  admission = nullptr;
+  file_fd = -1;
+  file_offset = 0;
+  file_length = 0;
+  parse_begin = {};
+  parse_end = {};
+  business_begin = {};
+  serialize_begin = {};
+  next_phase = RequestPhase::PARSE_AND_ROUTE;
+  suspended = false;
+  body_rejected = false;
+  head_buffer.clear();
+}
+
+std::shared_ptr<HttpServer::RequestContext> HttpServer::AcquireRequestContext(ConnectionWorkContext& ctx) {
+  if (ctx.spare_requests.empty()) {
+    return std::make_shared<RequestContext>();
+  }
+  std::shared_ptr<RequestContext> req_ctx = std::move(ctx.spare_requests.back());
+  ctx.spare_requests.pop_back();
+  return req_ctx;
+}
+
+void HttpServer::RecycleRequestContext(ConnectionWorkContext& ctx, std::shared_ptr<RequestContext> req_ctx) {
+  // 仍被其他任务引用（请求体流、挂起的 IO 阶段等）时不能复用，随最后一个引用释放
+  if (!req_ctx || req_ctx.use_count() != 1 || ctx.spare_requests.size() >= max_spare_request_contexts_) {
+    return;
+  }
+  ctx.facade->RecycleMessage(std::move(req_ctx->message));
+  req_ctx->Reset();
+  ctx.spare_requests.push_back(std::move(req_ctx));
+}
+
+void HttpServer::RecycleRequestContext(ConnectionWorkContext& ctx, WorkResult& result) {
+  if (!result.req_ctx || result.req_ctx.use_count() != 1) {
+    result.req_ctx.reset();
+    return;
+  }
+  // 结果中的字符串由上下文移交而来，连同容量一起换回
+  RequestContext& req_ctx = *result.req_ctx;
+  req_ctx.head_buffer.swap(result.response_data);
+  req_ctx.request_id.swap(result.request_id);
+  req_ctx.method.swap(result.method);
+  req_ctx.path.swap(result.path);
+  RecycleRequestContext(ctx, std::move(result.req_ctx));
+}
+
 void HttpServer::HandleClose(spConnection conn){
   if (conn) {
     auto ctx_ptr = conn->GetContext<std::shared_ptr<ConnectionWorkContext>>();
     if (ctx_ptr && *ctx_ptr) {
       auto work_ctx = *ctx_ptr;
-      std::lock_guard<std::mutex> lock(work_ctx->mutex);
+      // 先置位取消令牌：已分发的任务在出队时被丢弃，执行中的处理器可轮询提前退出
+      work_ctx->cancel->store(true, std::memory_order_release);
+      // 关闭回调运行在连接所属的 IO 线程，可直接修改连接状态
       work_ctx->draining = true;
-      work_ctx->queued_chunks.clear();
-      work_ctx->queued_bytes = 0;
-      for (auto& [seq, result] : work_ctx->pending_results) {
-        if (result.sendfile_fd >= 0) {
-          ::close(result.sendfile_fd);
-          result.sendfile_fd = -1;
-        }
-      }
-      work_ctx->pending_results.clear();
+      work_ctx->facade->ClearPending();
+      work_ctx->body.reset();
+      work_ctx->response_body.reset();
+      work_ctx->reorder.Clear([this](WorkResult& result) { CloseSendFileFd(result); });
     }
   }
   LOGINFO("connection close(fd=" + std::to_string(conn->fd()) + ",ip=" + conn->ip() + ",port=" + std::to_string(conn->port()) + ")");
@@ -127,163 +440,368 @@ void HttpServer::HandleMessage(spConnection conn){
   if (auto* existing = conn->GetContext<std::shared_ptr<ConnectionWorkContext>>(); existing && *existing) {
     ctx = *existing;
   } else {
-    ctx = std::make_shared<ConnectionWorkContext>();
-    ctx->facade = std::make_shared<HttpFacade>();
-    ctx->max_concurrent_workers = max_concurrent_workers_per_conn_;
-    if (router_) {
-      ctx->facade->SetRouter(router_);
-    }
+    ctx = CreateWorkContext();
     conn->SetContext(ctx);
   }
 
-  std::string new_data = inputbuffer.bufferToString();
-  inputbuffer.consumeBytes(readable_bytes);
+  if (ctx->draining || ctx->parse_closed) {
+    inputbuffer.consumeBytes(readable_bytes);
+    return;
+  }
+
+  if (!ctx->protocol_decided && !DecideProtocol(conn, ctx)) {
+    return;
+  }
+  if (ctx->h2) {
+    ParseAndDispatchHttp2(conn, ctx);
+    return;
+  }
 
-  if (threadpool_.queue_size() > max_work_queue_depth_) {
-    LOGERROR("工作队列过长，触发背压 fd=" + std::to_string(conn->fd()) +
-             " queue_size=" + std::to_string(threadpool_.queue_size()));
-    SendServiceUnavailable(conn, "work queue overloaded");
+  // 未解析的数据留在连接输入缓冲中，由解析器直接在其内存块上解析
+  // 在途请求已达流水线深度时暂停解析，此时继续堆积的数据受 max_conn_pending_bytes_ 限制
+  // （正在接收的请求体不受此限制：它由 PumpRequestBody 取走，积压过多时暂停读连接）
+  const size_t unparsed_bytes = ctx->facade->GetPendingSize() + readable_bytes;
+  if (!ctx->body && ctx->inflight >= max_pipeline_depth_ && unparsed_bytes > max_conn_pending_bytes_) {
+    LOGERROR("连接待处理数据过大，触发背压 fd=" + std::to_string(conn->fd()) +
+             " pending_bytes=" + std::to_string(unparsed_bytes));
+    SendServiceUnavailable(conn, "connection pending data overloaded");
+    DiscardUnparsed(conn, ctx);
     return;
   }
 
-  bool should_start_worker = false;
-  {
-    std::lock_guard<std::mutex> lock(ctx->mutex);
-    if (ctx->queued_bytes + new_data.size() > max_conn_pending_bytes_) {
-      LOGERROR("连接待处理数据过大，触发背压 fd=" + std::to_string(conn->fd()) +
-               " queued_bytes=" + std::to_string(ctx->queued_bytes + new_data.size()));
-      SendServiceUnavailable(conn, "connection pending data overloaded");
-      ctx->queued_chunks.clear();
-      ctx->pending_results.clear();
-      ctx->queued_bytes = 0;
-      ctx->last_applied_response_seq = 0;
-      ctx->next_response_seq = 1;
-      ctx->next_enqueue_seq = 1;
-      ctx->facade->ClearPending();
+  ParseAndDispatch(conn, ctx);
+}
+
+void HttpServer::ParseAndDispatch(spConnection conn, std::shared_ptr<ConnectionWorkContext> ctx) {
+  while (!ctx->draining && !ctx->parse_closed &&
+         (ctx->facade->GetPendingSize() > 0 || conn->getInputBuffer().readableBytes() > 0)) {
+    // 上一个请求的 body 收齐之前，连接上的字节都属于它
+    if (ctx->body) {
+      if (!PumpRequestBody(conn, ctx)) {
+        return;
+      }
+      continue;
+    }
+    if (ctx->inflight >= max_pipeline_depth_) {
+      return;
+    }
+    auto req_ctx = AcquireRequestContext(*ctx);
+    if (!PhaseParseAndRoute(conn, ctx, req_ctx)) {
+      RecycleRequestContext(*ctx, std::move(req_ctx));
       return;
     }
-    PendingChunk chunk;
-    chunk.data = std::move(new_data);
-    chunk.enqueue_seq = ctx->next_enqueue_seq++;
-    chunk.enqueue_tp = std::chrono::steady_clock::now();
-    ctx->queued_bytes += chunk.data.size();
-    ctx->queued_chunks.push_back(std::move(chunk));
-    if (!ctx->worker_running && !ctx->draining) {
-      ctx->worker_running = true;
-      ctx->active_worker_count = 1;
-      should_start_worker = true;
+    ctx->inflight++;
+    if (req_ctx->result == HttpServerResult::SUCCESS && req_ctx->request &&
+        req_ctx->request->DeferredBodyLength() > 0) {
+      StartRequestBody(ctx, std::move(req_ctx));
+      continue;
     }
+    DispatchToExecutor(conn, ctx, req_ctx);
   }
+}
 
-  if (!should_start_worker) {
-    return;
+void HttpServer::StartRequestBody(const std::shared_ptr<ConnectionWorkContext>& ctx,
+                                  std::shared_ptr<RequestContext> req_ctx) {
+  HttpRequest* request = req_ctx->request;
+  auto stream = std::make_shared<RequestBodyStream>();
+  stream->length = request->DeferredBodyLength();
+  // 没有声明接收器的路由仍拿到完整的 body，只是不再经过解析器的暂存缓冲
+  stream->streaming = req_ctx->route.bodySink != nullptr;
+  if (!stream->streaming) {
+    request->ReserveBody(static_cast<size_t>(stream->length));
   }
-
-  std::weak_ptr<Connection> weak_conn = conn;
-  threadpool_.addtask([this, weak_conn, ctx]() mutable {
-    HandleMessageInWorker(std::move(weak_conn), std::move(ctx));
-  });
+  stream->req_ctx = std::move(req_ctx);
+  ctx->body = std::move(stream);
 }
 
-void HttpServer::HandleMessageInWorker(std::weak_ptr<Connection> weak_conn, std::shared_ptr<ConnectionWorkContext> ctx) {
-  auto conn = weak_conn.lock();
-  if (!conn || conn->IsDisconnected()) {
-    OnWorkerExit(ctx, nullptr);
-    return;
-  }
+bool HttpServer::PumpRequestBody(const spConnection& conn, const std::shared_ptr<ConnectionWorkContext>& ctx) {
+  constexpr size_t kBodyChunkBytes = 256 * 1024;
+  std::shared_ptr<RequestBodyStream> stream = ctx->body;
+  BufferBlock& input = conn->getInputBuffer();
+
+  while (stream->received < stream->length && input.readableBytes() > 0) {
+    const size_t take = static_cast<size_t>(
+        std::min<uint64_t>(stream->length - stream->received, input.readableBytes()));
+
+    if (!stream->streaming) {
+      HttpRequest* request = stream->req_ctx->request;
+      struct iovec iov[16];
+      const size_t iovcnt = input.getIOVecs(iov, sizeof(iov) / sizeof(iov[0]), input.read_pos_);
+      size_t copied = 0;
+      for (size_t i = 0; i < iovcnt && copied < take; ++i) {
+        const size_t n = std::min(iov[i].iov_len, take - copied);
+        request->AppendBodyChunk(static_cast<const char*>(iov[i].iov_base), n);
+        copied += n;
+      }
+      input.consumeBytes(copied);
+      stream->received += copied;
+      continue;
+    }
 
-  {
-    std::lock_guard<std::mutex> lock(ctx->mutex);
-    if (ctx->draining) {
-      ctx->active_worker_count--;
-      if (ctx->active_worker_count == 0) {
-        ctx->worker_running = false;
+    bool overloaded = false;
+    bool paused = false;
+    {
+      std::lock_guard<std::mutex> lock(stream->mutex);
+      overloaded = stream->overloaded;
+      if (!overloaded && stream->queued_bytes >= max_body_stream_buffered_) {
+        // 接收器写得比客户端发得慢：停止读连接，让 TCP 窗口把压力传回客户端
+        stream->read_paused = true;
       }
-      return;
+      paused = stream->read_paused;
+    }
+    if (overloaded) {
+      input.consumeBytes(take);
+      stream->received += take;
+      continue;
+    }
+    if (paused) {
+      conn->PauseReading();
+      return false;
     }
+
+    const size_t n = std::min(take, kBodyChunkBytes);
+    std::string chunk;
+    chunk.resize(n);
+    input.peekFromBlock(&chunk[0], n);
+    input.consumeBytes(n);
+    {
+      std::lock_guard<std::mutex> lock(stream->mutex);
+      stream->chunks.emplace_back(stream->received, std::move(chunk));
+      stream->queued_bytes += n;
+    }
+    stream->received += n;
+    ScheduleBodyWrites(conn, ctx, stream);
   }
 
-  PendingChunk chunk;
-  bool should_chain = false;
+  if (stream->received < stream->length) {
+    return false;
+  }
+
+  ctx->body.reset();
+  if (!stream->streaming) {
+    DispatchToExecutor(conn, ctx, stream->req_ctx);
+    return true;
+  }
+
+  bool overloaded = false;
   {
-    std::lock_guard<std::mutex> lock(ctx->mutex);
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    stream->input_done = true;
+    overloaded = stream->overloaded;
+  }
+  if (!overloaded) {
+    ScheduleBodyWrites(conn, ctx, stream);
+    return true;
+  }
+
+  // 写入任务未能投递：已创建的接收器不会再被执行池访问，在此丢弃其结果
+  if (stream->sink) {
+    stream->sink->Cancel();
+  }
+  FailExecutorOverloaded(*stream->req_ctx);
+  DiscardUnparsed(conn, ctx);
+  PhaseSerializeAndSend(conn, ctx, stream->req_ctx);
+  return true;
+}
 
-    if (ctx->queued_chunks.empty()) {
-      OnWorkerExit(ctx, conn);
+void HttpServer::ScheduleBodyWrites(const spConnection& conn, const std::shared_ptr<ConnectionWorkContext>& ctx,
+                                    const std::shared_ptr<RequestBodyStream>& stream) {
+  {
+    std::lock_guard<std::mutex> lock(stream->mutex);
+    if (stream->running || stream->overloaded || (stream->chunks.empty() && !stream->input_done)) {
       return;
     }
+    stream->running = true;
+  }
 
-    chunk = std::move(ctx->queued_chunks.front());
-    ctx->queued_chunks.pop_front();
-    ctx->queued_bytes -= chunk.data.size();
+  ThreadPool* pool = FindExecutor(stream->req_ctx->route.executor);
+  std::weak_ptr<Connection> weak_conn = conn;
+  Task task([this, weak_conn, ctx, stream]() mutable {
+    DrainRequestBody(std::move(weak_conn), std::move(ctx), std::move(stream));
+  });
+  task.cancel = ctx->cancel;
+  if (pool->addTask(std::move(task))) {
+    return;
+  }
 
-    if (!ctx->queued_chunks.empty() &&
-        ctx->active_worker_count < ctx->max_concurrent_workers &&
-        !ctx->draining) {
-      ctx->active_worker_count++;
-      should_chain = true;
+  // 执行池已满：剩余 body 照常读完后丢弃，请求以 503 结束
+  LOGERROR("执行池已满，放弃写入请求体 path=" + stream->req_ctx->path +
+           " queue_size=" + std::to_string(pool->queue_size()));
+  std::lock_guard<std::mutex> lock(stream->mutex);
+  stream->overloaded = true;
+  stream->running = false;
+  stream->chunks.clear();
+  stream->queued_bytes = 0;
+  if (stream->read_paused) {
+    stream->read_paused = false;
+    conn->ResumeReading();
+  }
+}
+
+// 执行池：同一个 body 同一时刻只有一个写入任务，片段按偏移顺序到达接收器
+void HttpServer::DrainRequestBody(std::weak_ptr<Connection> weak_conn,
+                                  std::shared_ptr<ConnectionWorkContext> ctx,
+                                  std::shared_ptr<RequestBodyStream> stream) {
+  RequestContext& req_ctx = *stream->req_ctx;
+  HttpRequest* request = req_ctx.request;
+  if (!stream->sink_created) {
+    stream->sink_created = true;
+    std::unique_ptr<RequestBodySink> sink =
+        (*req_ctx.route.bodySink)(*request, req_ctx.route.params, stream->length, req_ctx.response);
+    if (sink) {
+      stream->sink = std::move(sink);
+      request->SetBodySink(stream->sink);
+    } else {
+      // 工厂已在 response 中填好拒绝原因；剩余片段照常取走后丢弃
+      req_ctx.body_rejected = true;
     }
   }
 
-  if (should_chain) {
-    threadpool_.addtask([this, weak_conn, ctx]() mutable {
-      HandleMessageInWorker(std::move(weak_conn), std::move(ctx));
+  const size_t resume_below = max_body_stream_buffered_ / 2;
+  bool finish = false;
+  while (true) {
+    std::pair<uint64_t, std::string> chunk;
+    {
+      std::lock_guard<std::mutex> lock(stream->mutex);
+      if (stream->chunks.empty()) {
+        // input_done 之后不会再有写入任务被投递，running 保持置位即可
+        finish = stream->input_done;
+        if (!finish) {
+          stream->running = false;
+        }
+        break;
+      }
+      chunk = std::move(stream->chunks.front());
+      stream->chunks.pop_front();
+    }
+
+    if (stream->sink) {
+      if (ctx->cancel->load(std::memory_order_acquire)) {
+        stream->sink->Cancel();
+      } else {
+        stream->sink->Deliver(chunk.first, chunk.second.data(), chunk.second.size());
+      }
+    }
+
+    bool resume = false;
+    {
+      std::lock_guard<std::mutex> lock(stream->mutex);
+      stream->queued_bytes -= chunk.second.size();
+      if (stream->read_paused && !stream->resume_posted && stream->queued_bytes <= resume_below) {
+        stream->resume_posted = true;
+        resume = true;
+      }
+    }
+    if (!resume) {
+      continue;
+    }
+    auto conn = weak_conn.lock();
+    if (!conn) {
+      continue;
+    }
+    conn->getLoop()->queueinloop([this, weak_conn, ctx, stream]() {
+      auto c = weak_conn.lock();
+      if (!c || c->IsDisconnected() || ctx->draining) {
+        return;
+      }
+      {
+        std::lock_guard<std::mutex> lock(stream->mutex);
+        stream->read_paused = false;
+        stream->resume_posted = false;
+      }
+      c->ResumeReading();
+      ParseAndDispatch(c, ctx);
     });
   }
 
-  ProcessSingleRequest(weak_conn, ctx, std::move(chunk));
+  if (!finish) {
+    return;
+  }
+  if (stream->sink) {
+    if (ctx->cancel->load(std::memory_order_acquire)) {
+      stream->sink->Cancel();
+    } else {
+      stream->sink->Complete(stream->length);
+    }
+  }
 
-  OnWorkerExit(ctx, conn);
+  // body 已落到接收器，回到 IO 线程按普通请求分发处理器（准入控制在此时生效）
+  auto conn = weak_conn.lock();
+  if (!conn) {
+    return;
+  }
+  conn->getLoop()->queueinloop([this, weak_conn, ctx, stream]() {
+    auto c = weak_conn.lock();
+    if (!c || c->IsDisconnected() || ctx->draining) {
+      return;
+    }
+    DispatchToExecutor(c, ctx, stream->req_ctx);
+  });
 }
 
-void HttpServer::PhaseParseAndRoute(
-    std::weak_ptr<Connection> weak_conn,
+// IO 线程：解析出一个完整请求并匹配路由；数据不完整时返回 false
+bool HttpServer::PhaseParseAndRoute(
+    const spConnection& conn,
     std::shared_ptr<ConnectionWorkContext> ctx,
-    PendingChunk& chunk,
     std::shared_ptr<RequestContext> req_ctx) {
 
-  auto conn = weak_conn.lock();
-  if (!conn || conn->IsDisconnected()) {
-    return;
+  req_ctx->parse_begin = std::chrono::steady_clock::now();
+  BufferBlock& input = conn->getInputBuffer();
+  // 连接输入缓冲的各内存块直接作为解析输入，块数通常很少，超出栈上数组时才分配
+  struct iovec stack_iov[16];
+  std::vector<struct iovec> heap_iov;
+  struct iovec* iov = stack_iov;
+  size_t iov_cap = sizeof(stack_iov) / sizeof(stack_iov[0]);
+  if (input.blocks_.size() > iov_cap) {
+    heap_iov.resize(input.blocks_.size());
+    iov = heap_iov.data();
+    iov_cap = heap_iov.size();
+  }
+  const size_t iovcnt = input.readableBytes() > 0 ? input.getIOVecs(iov, iov_cap, input.read_pos_) : 0;
+  size_t consumed = 0;
+  req_ctx->result = ctx->facade->ProcessSegments(iov, iovcnt, consumed, req_ctx->message,
+                                                 req_ctx->response, req_ctx->err);
+  input.consumeBytes(consumed);
+  req_ctx->parse_end = req_ctx->parse_begin;
+
+  if (req_ctx->result == HttpServerResult::NEED_MORE_DATA) {
+    LOGINFO("HTTP请求数据不完整，等待更多数据");
+    return false;
   }
 
-  {
-    std::lock_guard<std::mutex> facade_lock(ctx->facade_mutex);
-    if (!chunk.data.empty()) {
-      ctx->facade->AppendPending(std::move(chunk.data));
-      chunk.data.clear();
-    }
+  // 按解析顺序分配响应序号：处理器可能在不同执行池中乱序完成
+  req_ctx->response_seq = ctx->next_response_seq++;
+  req_ctx->next_phase = RequestPhase::BUSINESS;
 
-    req_ctx->parse_begin = std::chrono::steady_clock::now();
-    req_ctx->result = ctx->facade->ProcessPending(req_ctx->message, req_ctx->response, req_ctx->err);
-    auto parse_end = std::chrono::steady_clock::now();
+  RouteParsedRequest(conn, ctx, req_ctx);
+  req_ctx->parse_end = std::chrono::steady_clock::now();
 
-    if (req_ctx->result == HttpServerResult::SUCCESS && req_ctx->message) {
-      size_t consumed_bytes = ctx->facade->GetConsumedBytes();
-      ctx->facade->ErasePending(consumed_bytes);
-    }
-
-    if (req_ctx->result == HttpServerResult::NEED_MORE_DATA) {
-      LOGINFO("HTTP请求数据不完整，等待更多数据");
-      req_ctx->suspended = true;
-      return;
-    }
+  // 出错的请求以错误响应结束并关闭连接，其后的流水线数据不再解析
+  if (req_ctx->result != HttpServerResult::SUCCESS) {
+    DiscardUnparsed(conn, ctx);
   }
+  return true;
+}
+
+void HttpServer::RouteParsedRequest(
+    const spConnection& conn,
+    std::shared_ptr<ConnectionWorkContext> ctx,
+    std::shared_ptr<RequestContext> req_ctx) {
 
   if (req_ctx->result != HttpServerResult::SUCCESS || !req_ctx->message) {
     return;
   }
-
   if (!req_ctx->message->IsRequest()) {
     LOGERROR("收到的不是HTTP请求消息");
     return;
   }
 
-  HttpRequest* request = dynamic_cast<HttpRequest*>(req_ctx->message.get());
+  HttpRequest* request = AsHttpRequest(req_ctx->message.get());
   if (!request) {
     LOGERROR("无法将消息转换为HttpRequest");
     return;
   }
+  req_ctx->request = request;
 
   req_ctx->request_id =
       std::to_string(conn->fd()) + "-" +
@@ -293,17 +811,275 @@ void HttpServer::PhaseParseAndRoute(
   req_ctx->method = request->GetMethodString();
   LOGINFO("请求方法: " + req_ctx->method + ", 路径: " + req_ctx->path);
 
-  auto connection_header = request->GetHeader("Connection");
-  if (connection_header.has_value()) {
-    std::string conn_value = connection_header.value();
-    LowerAsciiInPlace(conn_value);
-    req_ctx->keep_alive = (conn_value == "keep-alive");
+  // HTTP/2 没有 Connection 头部，连接的生命周期由 GOAWAY 决定
+  if (req_ctx->h2_stream != 0) {
+    req_ctx->keep_alive = true;
+  } else {
+    auto connection_header = request->GetHeaderView(KnownHeader::Connection);
+    if (connection_header.has_value()) {
+      req_ctx->keep_alive = EqualsIgnoreCaseAscii(*connection_header, "keep-alive");
+    }
+  }
+
+  // 非白名单连接看不到 /metrics，按未注册路由处理
+  if (!ctx->metrics_allowed && req_ctx->path == kMetricsPath) {
+    req_ctx->result = HttpServerResult::ROUTING_FAILED;
+    req_ctx->err.code = HttpErrc::ROUTE_NOT_FOUND;
+    req_ctx->err.status = HttpStatusCode::NOT_FOUND;
+    req_ctx->err.message = "Not Found";
+    req_ctx->err.ctx.stage = HttpErrorStage::ROUTING;
+    req_ctx->err.ctx.method = req_ctx->method;
+    req_ctx->err.ctx.path = req_ctx->path;
+    return;
+  }
+
+  req_ctx->result = ctx->facade->MatchRoute(*request, req_ctx->response, req_ctx->route, req_ctx->err);
+}
+
+// IO 线程：连接不再解析后续数据，丢弃 facade 与输入缓冲中尚未解析的字节
+void HttpServer::DiscardUnparsed(const spConnection& conn, const std::shared_ptr<ConnectionWorkContext>& ctx) {
+  ctx->facade->ClearPending();
+  BufferBlock& input = conn->getInputBuffer();
+  input.consumeBytes(input.readableBytes());
+  ctx->parse_closed = true;
+}
+
+bool HttpServer::DecideProtocol(const spConnection& conn, const std::shared_ptr<ConnectionWorkContext>& ctx) {
+  bool h2 = false;
+  if (http2_enabled_) {
+    if (conn->AlpnProtocol() == "h2") {
+      h2 = true;
+    } else {
+      // 明文 h2c（prior knowledge）：内部代理直接以 HTTP/2 连接前言开始
+      BufferBlock& input = conn->getInputBuffer();
+      char head[kHttp2ClientPreface.size()];
+      const size_t n = std::min(input.readableBytes(), kHttp2ClientPreface.size());
+      input.peekFromBlock(head, n);
+      if (std::string_view(head, n) == kHttp2ClientPreface.substr(0, n)) {
+        if (n < kHttp2ClientPreface.size()) {
+          return false;
+        }
+        h2 = true;
+      }
+    }
+  }
+
+  ctx->protocol_decided = true;
+  if (h2) {
+    ctx->h2 = std::make_unique<Http2Parser>();
+    LOGINFO("HTTP/2 连接(fd=" + std::to_string(conn->fd()) + ")");
+  }
+  return true;
+}
+
+void HttpServer::ParseAndDispatchHttp2(spConnection conn, std::shared_ptr<ConnectionWorkContext> ctx) {
+  BufferBlock& input = conn->getInputBuffer();
+  struct iovec stack_iov[16];
+  std::vector<struct iovec> heap_iov;
+  struct iovec* iov = stack_iov;
+  size_t iov_cap = sizeof(stack_iov) / sizeof(stack_iov[0]);
+  if (input.blocks_.size() > iov_cap) {
+    heap_iov.resize(input.blocks_.size());
+    iov = heap_iov.data();
+    iov_cap = heap_iov.size();
+  }
+  const size_t iovcnt = input.readableBytes() > 0 ? input.getIOVecs(iov, iov_cap, input.read_pos_) : 0;
+  bool ok = true;
+  for (size_t i = 0; i < iovcnt && ok; ++i) {
+    ok = ctx->h2->Feed(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+  }
+  input.consumeBytes(input.readableBytes());
+
+  if (!ok) {
+    // 连接级错误：GOAWAY 发出后关闭，在途请求的结果随连接关闭丢弃
+    LOGERROR("HTTP/2 连接错误(fd=" + std::to_string(conn->fd()) + ")，发送 GOAWAY 后关闭");
+    ctx->parse_closed = true;
+    FlushHttp2(conn, ctx);
+    return;
+  }
+  DispatchHttp2Streams(conn, ctx);
+}
+
+void HttpServer::DispatchHttp2Streams(spConnection conn, std::shared_ptr<ConnectionWorkContext> ctx) {
+  Http2Parser& h2 = *ctx->h2;
+  // 与 HTTP/1 流水线共用在途上限；超出的流留在解析器的就绪队列中，结果回写后继续分发
+  while (!ctx->draining && ctx->inflight < max_pipeline_depth_ && h2.HasReadyRequest()) {
+    auto req_ctx = AcquireRequestContext(*ctx);
+    req_ctx->parse_begin = std::chrono::steady_clock::now();
+    if (!h2.PopRequest(req_ctx->message, req_ctx->h2_stream)) {
+      RecycleRequestContext(*ctx, std::move(req_ctx));
+      break;
+    }
+    req_ctx->result = ctx->facade->ValidateMessage(req_ctx->message, req_ctx->response, req_ctx->err);
+    req_ctx->next_phase = RequestPhase::BUSINESS;
+    RouteParsedRequest(conn, ctx, req_ctx);
+    req_ctx->parse_end = std::chrono::steady_clock::now();
+    ctx->inflight++;
+    DispatchToExecutor(conn, ctx, req_ctx);
+  }
+  FlushHttp2(conn, ctx);
+}
+
+void HttpServer::FlushHttp2(const spConnection& conn, const std::shared_ptr<ConnectionWorkContext>& ctx) {
+  if (!ctx->h2 || ctx->draining || conn->IsDisconnected()) {
+    return;
+  }
+  Http2Parser& h2 = *ctx->h2;
+  // DATA 帧按输出高水位限量生成，剩余部分在发送完成回调中继续；控制帧与 HEADERS 总是立即写出
+  const size_t pending = conn->PendingSendBytes();
+  const size_t budget = pending < h2_output_high_water_ ? h2_output_high_water_ - pending : 0;
+  ConnectionHttp2Sink sink(*conn);
+  const bool wrote = h2.Flush(sink, budget);
+  if (h2.ShouldClose()) {
+    conn->setCloseOnSendComplete(true);
+  }
+  if (wrote || h2.ShouldClose()) {
+    conn->send();
+  }
+  if (!ctx->h2_response_bodies.empty()) {
+    PullHttp2ResponseBodies(conn, ctx);
+  }
+}
+
+ThreadPool* HttpServer::FindExecutor(const std::string& name) {
+  if (name.empty() || name == kExecutorCpu) {
+    return &threadpool_;
+  }
+  auto it = executor_pools_.find(name);
+  if (it == executor_pools_.end()) {
+    return &threadpool_;
+  }
+  return it->second.get();
+}
+
+AdmissionController* HttpServer::FindAdmission(const std::string& name) {
+  auto it = admission_.find(name.empty() ? kExecutorCpu : name);
+  if (it == admission_.end()) {
+    it = admission_.find(kExecutorCpu);
+  }
+  return it->second.get();
+}
+
+// IO 线程：把解析完成的请求投递到路由声明的执行池（出错的请求在 cpu 池中生成错误响应）
+void HttpServer::DispatchToExecutor(
+    const spConnection& conn,
+    std::shared_ptr<ConnectionWorkContext> ctx,
+    std::shared_ptr<RequestContext> req_ctx) {
+
+  ThreadPool* pool = req_ctx->result == HttpServerResult::SUCCESS
+                         ? FindExecutor(req_ctx->route.executor)
+                         : &threadpool_;
+  std::weak_ptr<Connection> weak_conn = conn;
+  req_ctx->enqueue_tp = std::chrono::steady_clock::now();
+
+  // 出错的请求只生成很小的错误响应，不参与准入控制
+  if (req_ctx->result == HttpServerResult::SUCCESS) {
+    AdmissionController* admission = FindAdmission(req_ctx->route.executor);
+    const uint64_t now_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        req_ctx->enqueue_tp.time_since_epoch()).count());
+    if (!admission->Admit(AdmissionPriorityForPath(req_ctx->path), pool->queue_size(), now_us)) {
+      ShedRequest(weak_conn, ctx, req_ctx);
+      return;
+    }
+    req_ctx->admission = admission;
+  }
+
+  Task task([this, weak_conn, ctx, req_ctx]() mutable {
+    ProcessSingleRequest(std::move(weak_conn), std::move(ctx), std::move(req_ctx));
+  });
+  task.cancel = ctx->cancel;
+  if (pool->addTask(std::move(task))) {
+    return;
+  }
+
+  // 执行池已满：只拒绝落在该池上的请求，其他路由不受影响
+  LOGERROR("执行池已满，拒绝请求 executor=" +
+           (req_ctx->route.executor.empty() ? std::string(kExecutorCpu) : req_ctx->route.executor) +
+           " path=" + req_ctx->path + " queue_size=" + std::to_string(pool->queue_size()));
+  FailExecutorOverloaded(*req_ctx);
+  if (req_ctx->h2_stream == 0) {
+    DiscardUnparsed(conn, ctx);
   }
 
+  // 错误响应很小，直接在 IO 线程序列化，仍经由重排环按序回写
+  PhaseSerializeAndSend(weak_conn, ctx, req_ctx);
+}
+
+void HttpServer::FailExecutorOverloaded(RequestContext& req_ctx) {
+  const std::string executor = req_ctx.route.executor.empty() ? kExecutorCpu : req_ctx.route.executor;
+  req_ctx.result = HttpServerResult::ROUTING_FAILED;
+  req_ctx.err.code = HttpErrc::ROUTE_EXECUTOR_OVERLOADED;
+  req_ctx.err.status = HttpStatusCode::SERVICE_UNAVAILABLE;
+  req_ctx.err.message = "Service Unavailable";
+  req_ctx.err.ctx.stage = HttpErrorStage::ROUTING;
+  req_ctx.err.ctx.path = req_ctx.path;
+  req_ctx.err.ctx.detail = "executor " + executor + " overloaded";
+}
+
+void HttpServer::ShedRequest(
+    std::weak_ptr<Connection> weak_conn,
+    std::shared_ptr<ConnectionWorkContext> ctx,
+    std::shared_ptr<RequestContext> req_ctx) {
+
+  WorkResult work_result;
+  work_result.response_seq = req_ctx->response_seq;
+  work_result.request_id = req_ctx->request_id;
+  work_result.method = req_ctx->method;
+  work_result.path = req_ctx->path;
+  work_result.route_bucket = ClassifyRouteBucketId(req_ctx->path);
+  work_result.is_error = true;
+  work_result.has_response = true;
+  // 连接保持可用，客户端按 Retry-After 重试时不必重新建连
+  work_result.h2_stream_id = req_ctx->h2_stream;
+  if (req_ctx->h2_stream != 0) {
+    work_result.response_data = shed_h2_head_;
+    work_result.response_body = shed_h2_body_;
+  } else {
+    work_result.response_data = req_ctx->keep_alive ? shed_response_keep_alive_ : shed_response_close_;
+    work_result.close_after_send = !req_ctx->keep_alive;
+  }
+  work_result.parse_route_us = ElapsedUs(req_ctx->parse_begin, req_ctx->parse_end);
+  work_result.req_ctx = std::move(req_ctx);
+  PostResultToIoLoop(std::move(weak_conn), std::move(ctx), std::move(work_result));
+}
+
+void HttpServer::PhaseBusiness(
+    std::shared_ptr<ConnectionWorkContext> ctx,
+    std::shared_ptr<RequestContext> req_ctx) {
+
+  if (req_ctx->result != HttpServerResult::SUCCESS || !req_ctx->message) {
+    return;
+  }
+  HttpRequest* request = req_ctx->request;
+  if (!request) {
+    return;
+  }
+
+  // 请求体被接收器工厂拒绝时不执行处理器，response 中已是工厂填好的错误
+  if (!req_ctx->body_rejected) {
+    req_ctx->result = ctx->facade->RunRoute(*request, req_ctx->response, req_ctx->route, req_ctx->err);
+    if (req_ctx->result != HttpServerResult::SUCCESS) {
+      return;
+    }
+  }
+
+  req_ctx->response.SetPrerenderedHeaders(&prerendered_headers_);
   ProcessRequest(request, req_ctx->response);
   ApplyCorsHeaders(req_ctx->response, request);
   ApplyCommonResponseHeaders(req_ctx->response, req_ctx->request_id);
+  if (compression_enabled_) {
+    MaybeCompressResponse(*request, req_ctx->response, CompressionLevelForPath(req_ctx->path));
+  }
 
+  if (req_ctx->h2_stream != 0) {
+    return;
+  }
+  // HTTP/1.0 客户端不认识 chunked：长度未知的按需 body 改为以关闭连接作为结束
+  if (req_ctx->response.HasBodyProducer() && request->GetVersion() == HttpVersion::HTTP_1_0 &&
+      req_ctx->response.Headers().Has(KnownHeader::TransferEncoding)) {
+    req_ctx->response.RemoveHeader("Transfer-Encoding");
+    req_ctx->keep_alive = false;
+  }
   if (req_ctx->keep_alive) {
     req_ctx->response.SetHeader("Connection", "keep-alive");
   } else {
@@ -348,7 +1124,7 @@ void HttpServer::PhaseIoOperation(
   // future io_uring extension point:
   // if (io_uring_submit(...) == -EAGAIN) {
   //   req_ctx->suspended = true;
-  //   RegisterResumeCallback(weak_conn, ctx, chunk, req_ctx);
+  //   RegisterResumeCallback(weak_conn, ctx, req_ctx);
   //   return;
   // }
 }
@@ -356,11 +1132,10 @@ void HttpServer::PhaseIoOperation(
 void HttpServer::PhaseSerializeAndSend(
     std::weak_ptr<Connection> weak_conn,
     std::shared_ptr<ConnectionWorkContext> ctx,
-    PendingChunk& chunk,
     std::shared_ptr<RequestContext> req_ctx) {
 
   auto conn = weak_conn.lock();
-  if (!conn || conn->IsDisconnected()) {
+  if (!conn || conn->IsDisconnected() || ctx->cancel->load(std::memory_order_acquire)) {
     if (req_ctx->file_fd >= 0) {
       ::close(req_ctx->file_fd);
       req_ctx->file_fd = -1;
@@ -368,27 +1143,37 @@ void HttpServer::PhaseSerializeAndSend(
     return;
   }
 
-  auto worker_begin = std::chrono::steady_clock::now();
-
   WorkResult work_result;
-  work_result.method = req_ctx->method;
-  work_result.path = req_ctx->path;
-  work_result.route_bucket = ClassifyRouteBucket(req_ctx->path);
+  work_result.route_bucket = ClassifyRouteBucketId(req_ctx->path);
   work_result.is_download = IsDownloadRoute(req_ctx->path);
-  work_result.parse_route_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-      std::chrono::steady_clock::now() - req_ctx->parse_begin).count();
-  work_result.request_id = req_ctx->request_id;
-  work_result.close_after_send = !req_ctx->keep_alive;
+  work_result.parse_route_us = ElapsedUs(req_ctx->parse_begin, req_ctx->parse_end);
+  work_result.h2_stream_id = req_ctx->h2_stream;
+  work_result.close_after_send = req_ctx->h2_stream == 0 && !req_ctx->keep_alive;
+
+  // 按需生成的 body：首段在 worker 上生成，随响应头一起发出，降低首字节时间
+  std::shared_ptr<BodyProducerFramer> body_stream;
+  std::string body_first;
+  if (req_ctx->result == HttpServerResult::SUCCESS && req_ctx->response.HasBodyProducer()) {
+    body_stream = BeginResponseBody(*req_ctx, body_first);
+  }
 
   if (req_ctx->result == HttpServerResult::SUCCESS && req_ctx->message) {
-    work_result.business_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        std::chrono::steady_clock::now() - req_ctx->business_begin).count();
-
     req_ctx->serialize_begin = std::chrono::steady_clock::now();
-    std::string response_data = req_ctx->response.Serialize();
-    auto serialize_end = std::chrono::steady_clock::now();
-    work_result.serialize_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        serialize_end - req_ctx->serialize_begin).count();
+    work_result.business_us = ElapsedUs(req_ctx->business_begin, req_ctx->serialize_begin);
+    // 头部按精确长度一次写成，body 直接移交给 IO 线程，只在写入输出缓冲时拷贝一次
+    // HTTP/2 头部在 worker 上编码为 HPACK 头部块（只用静态表，与连接的编码状态无关）
+    std::string response_data = std::move(req_ctx->head_buffer);
+    response_data.clear();
+    if (req_ctx->h2_stream != 0) {
+      Http2Parser::EncodeResponseHead(req_ctx->response, response_data);
+    } else {
+      req_ctx->response.SerializeHeadTo(response_data);
+    }
+    work_result.response_body = req_ctx->response.TakeBody();
+    if (!body_first.empty()) {
+      work_result.response_body = std::move(body_first);
+    }
+    work_result.serialize_us = ElapsedUs(req_ctx->serialize_begin, std::chrono::steady_clock::now());
 
     if (response_data.empty()) {
       LOGERROR("响应数据为空，无法发送响应");
@@ -396,7 +1181,8 @@ void HttpServer::PhaseSerializeAndSend(
       req_ctx->response.SetHeader("Content-Type", "text/plain");
       req_ctx->response.SetHeader("Connection", "close");
       req_ctx->response.SetBody("Not Found");
-      response_data = req_ctx->response.Serialize();
+      req_ctx->response.SerializeHeadTo(response_data);
+      work_result.response_body = req_ctx->response.TakeBody();
       work_result.close_after_send = true;
     }
 
@@ -408,12 +1194,16 @@ void HttpServer::PhaseSerializeAndSend(
       work_result.sendfile_bytes = req_ctx->file_length;
       req_ctx->file_fd = -1;
     }
+    if (body_stream) {
+      work_result.body_stream = std::move(body_stream);
+      work_result.body_executor = req_ctx->route.executor;
+    }
 
     work_result.has_response = true;
     work_result.response_data = std::move(response_data);
   } else {
     work_result.is_error = true;
-    work_result.route_bucket = "parse_error";
+    work_result.route_bucket = RouteBucket::ParseError;
     if (!req_ctx->err.IsOk()) {
       req_ctx->err.code = HttpErrc::INTERNAL_ERROR;
       req_ctx->err.status = HttpStatusCode::INTERNAL_SERVER_ERROR;
@@ -442,42 +1232,45 @@ void HttpServer::PhaseSerializeAndSend(
     }
 
     auto error_resp = ResponseFactory::CreateHttpError(req_ctx->err, req_ctx->request_id, true);
-    if (auto* req = dynamic_cast<HttpRequest*>(req_ctx->message.get())) {
-      ApplyCorsHeaders(*error_resp, req);
+    error_resp->SetPrerenderedHeaders(&prerendered_headers_);
+    if (req_ctx->request) {
+      ApplyCorsHeaders(*error_resp, req_ctx->request);
     }
     ApplyCommonResponseHeaders(*error_resp, req_ctx->request_id);
     error_resp->SetHeader("Connection", "close");
 
     work_result.has_response = true;
-    work_result.close_after_send = true;
     req_ctx->serialize_begin = std::chrono::steady_clock::now();
-    work_result.response_data = error_resp->Serialize();
-    auto serialize_end = std::chrono::steady_clock::now();
-    work_result.serialize_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        serialize_end - req_ctx->serialize_begin).count();
-    work_result.business_ms = 0;
-
-    {
-      std::lock_guard<std::mutex> facade_lock(ctx->facade_mutex);
-      ctx->facade->ClearPending();
+    if (req_ctx->h2_stream != 0) {
+      // HTTP/2 的请求级错误只结束所属的流，连接上的其他流不受影响
+      Http2Parser::EncodeResponseHead(*error_resp, work_result.response_data);
+    } else {
+      work_result.close_after_send = true;
+      error_resp->SerializeHeadTo(work_result.response_data);
     }
+    work_result.response_body = error_resp->TakeBody();
+    work_result.serialize_us = ElapsedUs(req_ctx->serialize_begin, std::chrono::steady_clock::now());
+    work_result.business_us = 0;
   }
 
-  {
-    std::lock_guard<std::mutex> lock(ctx->mutex);
-    work_result.response_seq = ctx->next_response_seq++;
-  }
-  work_result.queue_wait_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-      worker_begin - chunk.enqueue_tp).count();
-  work_result.worker_exec_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-      std::chrono::steady_clock::now() - worker_begin).count();
+  work_result.response_seq = req_ctx->response_seq;
+  // 执行池已满时错误响应直接在 IO 线程生成，没有排队与 worker 执行阶段
+  const bool ran_in_worker = req_ctx->business_begin != std::chrono::steady_clock::time_point{};
+  work_result.queue_wait_us = ran_in_worker ? ElapsedUs(req_ctx->enqueue_tp, req_ctx->business_begin) : 0;
+  work_result.worker_exec_us = ran_in_worker
+      ? ElapsedUs(req_ctx->business_begin, std::chrono::steady_clock::now())
+      : ElapsedUs(req_ctx->serialize_begin, std::chrono::steady_clock::now());
+  // 上下文不再使用：字符串移交给结果，上下文随结果回到 IO 线程回收
+  work_result.method = std::move(req_ctx->method);
+  work_result.path = std::move(req_ctx->path);
+  work_result.request_id = std::move(req_ctx->request_id);
+  work_result.req_ctx = std::move(req_ctx);
   PostResultToIoLoop(weak_conn, ctx, std::move(work_result));
 }
 
 void HttpServer::ProcessSingleRequest(
     std::weak_ptr<Connection> weak_conn,
     std::shared_ptr<ConnectionWorkContext> ctx,
-    PendingChunk chunk,
     std::shared_ptr<RequestContext> req_ctx) {
 
   auto conn = weak_conn.lock();
@@ -485,45 +1278,30 @@ void HttpServer::ProcessSingleRequest(
     return;
   }
 
-  if (!req_ctx) {
-    req_ctx = std::make_shared<RequestContext>();
+  // 连接已关闭：跳过处理器、文件打开与序列化
+  if (ctx->cancel->load(std::memory_order_acquire)) {
+    return;
   }
 
-  if (req_ctx->next_phase == RequestPhase::PARSE_AND_ROUTE) {
-    PhaseParseAndRoute(weak_conn, ctx, chunk, req_ctx);
-    if (req_ctx->suspended) return;
+  if (req_ctx->next_phase == RequestPhase::BUSINESS) {
+    req_ctx->business_begin = std::chrono::steady_clock::now();
+    if (req_ctx->admission) {
+      const uint64_t now_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+          req_ctx->business_begin.time_since_epoch()).count());
+      req_ctx->admission->Observe(static_cast<uint64_t>(ElapsedUs(req_ctx->enqueue_tp, req_ctx->business_begin)), now_us);
+    }
+    PhaseBusiness(ctx, req_ctx);
     req_ctx->next_phase = RequestPhase::IO_OPERATION;
   }
 
   if (req_ctx->next_phase == RequestPhase::IO_OPERATION) {
-    req_ctx->business_begin = std::chrono::steady_clock::now();
     PhaseIoOperation(weak_conn, ctx, req_ctx);
     if (req_ctx->suspended) return;
     req_ctx->next_phase = RequestPhase::SERIALIZE_AND_SEND;
   }
 
   if (req_ctx->next_phase == RequestPhase::SERIALIZE_AND_SEND) {
-    PhaseSerializeAndSend(weak_conn, ctx, chunk, req_ctx);
-  }
-}
-
-void HttpServer::OnWorkerExit(
-    std::shared_ptr<ConnectionWorkContext> ctx,
-    std::shared_ptr<Connection> conn) {
-
-  std::lock_guard<std::mutex> lock(ctx->mutex);
-  ctx->active_worker_count--;
-
-  if (ctx->active_worker_count == 0) {
-    if (!ctx->queued_chunks.empty() && !ctx->draining) {
-      ctx->active_worker_count = 1;
-      threadpool_.addtask(
-          [this, weak_conn = std::weak_ptr<Connection>(conn), ctx]() mutable {
-            HandleMessageInWorker(std::move(weak_conn), std::move(ctx));
-          });
-    } else {
-      ctx->worker_running = false;
-    }
+    PhaseSerializeAndSend(weak_conn, ctx, std::move(req_ctx));
   }
 }
 
@@ -536,95 +1314,326 @@ void HttpServer::PostResultToIoLoop(std::weak_ptr<Connection> weak_conn, std::sh
 
   EventLoop* io_loop = conn->getLoop();
   result.io_enqueue_tp = std::chrono::steady_clock::now();
-  io_loop->queueinloop([this, io_loop, weak_conn, ctx, result = std::move(result)]() mutable {
+  io_loop->queueinloop([this, weak_conn, ctx, result = std::move(result)]() mutable {
     auto strong_conn = weak_conn.lock();
     if (!strong_conn || strong_conn->IsDisconnected()) {
       CloseSendFileFd(result);
       return;
     }
 
-    auto apply_result = [&strong_conn](WorkResult& r) {
-      BufferBlock& outputbuffer = strong_conn->getOutputBuffer();
-      if (r.has_response && !r.response_data.empty()) {
-        outputbuffer.append(r.response_data.c_str(), r.response_data.size());
-      }
-      if (r.close_after_send) {
-        strong_conn->setCloseOnSendComplete(true);
-      }
-      if (r.has_sendfile && r.sendfile_fd >= 0) {
-        strong_conn->StartSendFile(r.sendfile_fd, r.sendfile_offset, r.sendfile_length, true);
-        r.sendfile_fd = -1;
-      }
-      strong_conn->send();
-    };
+    // 重排环由连接所属的 IO 线程独占，结果按序号落槽，无需加锁
+    if (ctx->draining) {
+      CloseSendFileFd(result);
+      return;
+    }
+    if (result.h2_stream_id != 0) {
+      ApplyHttp2Result(strong_conn, ctx, result);
+      return;
+    }
+    if (!ctx->reorder.Put(result.response_seq, result)) {
+      CloseSendFileFd(result);
+      return;
+    }
+    ApplyReadyResults(strong_conn, ctx);
+  });
+}
 
-    std::vector<WorkResult> to_apply;
-    {
-      std::lock_guard<std::mutex> lock(ctx->mutex);
+void HttpServer::ApplyReadyResults(spConnection conn, std::shared_ptr<ConnectionWorkContext> ctx) {
+  auto apply_result = [&conn, &ctx](WorkResult& r) {
+    BufferBlock& outputbuffer = conn->getOutputBuffer();
+    if (r.has_response && !r.response_data.empty()) {
+      outputbuffer.append(r.response_data.c_str(), r.response_data.size());
+      outputbuffer.append(r.response_body.data(), r.response_body.size());
+    }
+    if (r.body_stream) {
+      auto stream = std::make_shared<ResponseBodyStream>();
+      stream->framer = std::move(r.body_stream);
+      stream->executor = std::move(r.body_executor);
+      stream->close_after_send = r.close_after_send;
+      ctx->response_body = std::move(stream);
+    } else if (r.close_after_send) {
+      conn->setCloseOnSendComplete(true);
+    }
+    if (r.has_sendfile && r.sendfile_fd >= 0) {
+      conn->StartSendFile(r.sendfile_fd, r.sendfile_offset, r.sendfile_length, true);
+      r.sendfile_fd = -1;
+    }
+    conn->send();
+  };
+
+  size_t applied = 0;
+  WorkResult r;
+  // 正在逐段发送的响应占住连接：其后的响应等它的 body 发完再写
+  while (!ctx->response_body && applied < max_apply_per_batch_ && ctx->reorder.PopReady(r)) {
+    apply_result(r);
+    applied++;
+    ctx->inflight--;
+    LogWorkResult(r);
+    RecycleRequestContext(*ctx, r);
+  }
+
+  // 在途请求减少：继续解析因流水线深度而暂停的数据
+  if (applied > 0) {
+    ParseAndDispatch(conn, ctx);
+  }
 
-      if (result.response_seq <= ctx->last_applied_response_seq) {
-        CloseSendFileFd(result);
+  if (ctx->response_body) {
+    PullResponseBody(conn, ctx);
+    return;
+  }
+
+  // 单批应用数达到上限：剩余已就绪结果留在环中，让出 IO 线程后继续
+  if (ctx->reorder.HeadReady()) {
+    std::weak_ptr<Connection> weak_conn = conn;
+    conn->getLoop()->queueinloop([this, weak_conn, ctx]() {
+      auto strong_conn = weak_conn.lock();
+      if (!strong_conn || strong_conn->IsDisconnected() || ctx->draining) {
         return;
       }
+      ApplyReadyResults(strong_conn, ctx);
+    });
+  }
+}
 
-      if (ctx->draining) {
-        CloseSendFileFd(result);
-        return;
+std::shared_ptr<BodyProducerFramer> HttpServer::BeginResponseBody(RequestContext& req_ctx, std::string& first) {
+  HttpResponse& response = req_ctx.response;
+  std::shared_ptr<BodyProducer> producer = response.TakeBodyProducer();
+  if (req_ctx.method == "HEAD") {
+    return nullptr;
+  }
+
+  // HTTP/2 自带分帧：生产者的输出原样作为 DATA 负载，后续各段按流的发送窗口拉取
+  bool chunked = response.Headers().Has(KnownHeader::TransferEncoding);
+  if (req_ctx.h2_stream != 0) {
+    response.RemoveHeader("Transfer-Encoding");
+    chunked = false;
+  }
+  auto framer = std::make_shared<BodyProducerFramer>(std::move(producer), chunked);
+  const BodyProducer::Status status = framer->Next(first, response_body_chunk_bytes_);
+  if (status == BodyProducer::Status::More) {
+    return framer;
+  }
+  if (status == BodyProducer::Status::Done) {
+    return nullptr;
+  }
+
+  // 响应头尚未发出，生成失败可以改为完整的 500 响应
+  first.clear();
+  req_ctx.result = HttpServerResult::UNKNOWN_ERROR;
+  req_ctx.err.code = HttpErrc::INTERNAL_ERROR;
+  req_ctx.err.status = HttpStatusCode::INTERNAL_SERVER_ERROR;
+  req_ctx.err.message = "Internal Server Error";
+  req_ctx.err.ctx.stage = HttpErrorStage::UNKNOWN;
+  req_ctx.err.ctx.path = req_ctx.path;
+  req_ctx.err.ctx.detail = "response body producer failed";
+  return nullptr;
+}
+
+void HttpServer::PullResponseBody(const spConnection& conn, const std::shared_ptr<ConnectionWorkContext>& ctx) {
+  std::shared_ptr<ResponseBodyStream> stream = ctx->response_body;
+  if (!stream || stream->producing) {
+    return;
+  }
+  if (conn->PendingSendBytes() >= response_body_high_water_) {
+    // 输出积压：降到低水位时再拉取，下一段在剩余输出发送期间生成，套接字不必等一个往返
+    conn->setlowwatercallback(response_body_low_water_, [this](spConnection c) {
+      auto* low_ctx = c->GetContext<std::shared_ptr<ConnectionWorkContext>>();
+      if (low_ctx && *low_ctx && !(*low_ctx)->draining) {
+        PullResponseBody(c, *low_ctx);
       }
+    });
+    return;
+  }
+  stream->producing = true;
 
-      if (result.response_seq != ctx->last_applied_response_seq + 1) {
-        ctx->pending_results.emplace(result.response_seq, std::move(result));
+  ThreadPool* pool = FindExecutor(stream->executor);
+  std::weak_ptr<Connection> weak_conn = conn;
+  Task task([this, weak_conn, ctx, stream]() {
+    std::string piece;
+    BodyProducer::Status status = stream->framer->Next(piece, response_body_chunk_bytes_);
+    auto strong_conn = weak_conn.lock();
+    if (!strong_conn || strong_conn->IsDisconnected()) {
+      return;
+    }
+    strong_conn->getLoop()->queueinloop([this, weak_conn, ctx, status, piece = std::move(piece)]() mutable {
+      auto c = weak_conn.lock();
+      if (!c || c->IsDisconnected() || ctx->draining) {
         return;
       }
+      ApplyResponseBodyPiece(c, ctx, status, piece);
+    });
+  });
+  task.cancel = ctx->cancel;
+  if (pool->addTask(std::move(task))) {
+    return;
+  }
 
-      to_apply.push_back(std::move(result));
-      ctx->last_applied_response_seq++;
-      while (true) {
-        auto it = ctx->pending_results.find(ctx->last_applied_response_seq + 1);
-        if (it == ctx->pending_results.end()) {
-          break;
-        }
-        to_apply.push_back(std::move(it->second));
-        ctx->pending_results.erase(it);
-        ctx->last_applied_response_seq++;
-      }
-    }
+  // 执行池已满且响应头已经发出，无法再改为错误响应：中止这个响应
+  LOGERROR("执行池已满，中止按需生成的响应体 fd=" + std::to_string(conn->fd()));
+  std::string none;
+  ApplyResponseBodyPiece(conn, ctx, BodyProducer::Status::Error, none);
+}
+
+void HttpServer::ApplyResponseBodyPiece(const spConnection& conn, const std::shared_ptr<ConnectionWorkContext>& ctx,
+                                        BodyProducer::Status status, std::string& piece) {
+  std::shared_ptr<ResponseBodyStream> stream = ctx->response_body;
+  if (!stream) {
+    return;
+  }
+  stream->producing = false;
+  if (!piece.empty()) {
+    conn->getOutputBuffer().append(piece.data(), piece.size());
+  }
 
-    const size_t kMaxApplyPerBatch = max_apply_per_batch_;
-    size_t applied = 0;
-    for (auto& r : to_apply) {
-      if (applied >= kMaxApplyPerBatch) {
-        io_loop->queueinloop(
-            [this, weak_conn, ctx, result = std::move(r)]() mutable {
-              PostResultToIoLoop(weak_conn, ctx, std::move(result));
-            });
-        continue;
+  if (status == BodyProducer::Status::More) {
+    conn->send();
+    PullResponseBody(conn, ctx);
+    return;
+  }
+
+  ctx->response_body.reset();
+  if (status == BodyProducer::Status::Error) {
+    // body 已部分发出，只能以关闭连接告知对端响应不完整；其后的响应全部丢弃
+    LOGERROR("按需生成的响应体失败，关闭连接 fd=" + std::to_string(conn->fd()));
+    ctx->draining = true;
+    ctx->reorder.Clear([this](WorkResult& result) { CloseSendFileFd(result); });
+    DiscardUnparsed(conn, ctx);
+    conn->setCloseOnSendComplete(true);
+    conn->send();
+    return;
+  }
+
+  if (stream->close_after_send) {
+    conn->setCloseOnSendComplete(true);
+  }
+  conn->send();
+  // 响应发完：写出排在它之后的已就绪响应
+  ApplyReadyResults(conn, ctx);
+}
+
+void HttpServer::ApplyHttp2Result(spConnection conn, std::shared_ptr<ConnectionWorkContext> ctx, WorkResult& result) {
+  ctx->inflight--;
+  if (ctx->h2 && result.has_response && result.body_stream) {
+    // 首段随头部提交，其余各段在 FlushHttp2 中按该流的发送窗口拉取
+    auto stream = std::make_shared<ResponseBodyStream>();
+    stream->framer = std::move(result.body_stream);
+    stream->executor = std::move(result.body_executor);
+    ctx->h2_response_bodies[result.h2_stream_id] = std::move(stream);
+    ctx->h2->SubmitStreamingResponse(result.h2_stream_id, std::move(result.response_data),
+                                     std::move(result.response_body));
+  } else if (ctx->h2 && result.has_response) {
+    const int file_fd = result.has_sendfile ? result.sendfile_fd : -1;
+    result.sendfile_fd = -1;
+    ctx->h2->SubmitResponse(result.h2_stream_id, std::move(result.response_data), std::move(result.response_body),
+                            file_fd, result.sendfile_offset, result.sendfile_length);
+  } else {
+    CloseSendFileFd(result);
+  }
+  LogWorkResult(result);
+  RecycleRequestContext(*ctx, result);
+  // 在途请求减少：继续分发因在途上限而等待的流，并写出新提交的响应
+  DispatchHttp2Streams(conn, ctx);
+}
+
+void HttpServer::PullHttp2ResponseBodies(const spConnection& conn, const std::shared_ptr<ConnectionWorkContext>& ctx) {
+  Http2Parser& h2 = *ctx->h2;
+  // 流已结束（对端重置等）：丢弃其生产者，执行池中正在生成的一段回来后也会被丢弃
+  for (auto it = ctx->h2_response_bodies.begin(); it != ctx->h2_response_bodies.end();) {
+    it = h2.HasStream(it->first) ? std::next(it) : ctx->h2_response_bodies.erase(it);
+  }
+  // 输出积压：降到低水位时再写出与拉取，下一段在剩余输出发送期间生成
+  if (conn->PendingSendBytes() >= h2_output_high_water_) {
+    conn->setlowwatercallback(response_body_low_water_, [this](spConnection c) {
+      auto* low_ctx = c->GetContext<std::shared_ptr<ConnectionWorkContext>>();
+      if (low_ctx && *low_ctx && (*low_ctx)->h2) {
+        FlushHttp2(c, *low_ctx);
       }
-      apply_result(r);
-      applied++;
-      const auto io_flush_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-          std::chrono::steady_clock::now() - r.io_enqueue_tp).count();
-      const long pipeline_ms = (r.queue_wait_ms > 0 ? r.queue_wait_ms : 0) + r.worker_exec_ms + io_flush_ms;
-      LOGINFO("worker链路 request_id=" + r.request_id +
-              " seq=" + std::to_string(r.response_seq) +
-              " route=" + r.route_bucket +
-              " queue_wait_ms=" + std::to_string(r.queue_wait_ms) +
-              " parse_route_ms=" + std::to_string(r.parse_route_ms) +
-              " business_ms=" + std::to_string(r.business_ms) +
-              " serialize_ms=" + std::to_string(r.serialize_ms) +
-              " worker_exec_ms=" + std::to_string(r.worker_exec_ms) +
-              " io_flush_ms=" + std::to_string(io_flush_ms) +
-              " pipeline_ms=" + std::to_string(pipeline_ms));
-      if (pipeline_ms >= slow_request_ms_threshold_) {
-        LOGWARNING("慢请求 request_id=" + r.request_id +
-                   " method=" + r.method +
-                   " path=" + r.path +
-                   " route=" + r.route_bucket +
-                   " pipeline_ms=" + std::to_string(pipeline_ms));
+    });
+    return;
+  }
+  std::vector<uint32_t> demand;
+  h2.CollectBodyDemand(demand);
+  for (uint32_t stream_id : demand) {
+    auto it = ctx->h2_response_bodies.find(stream_id);
+    if (it == ctx->h2_response_bodies.end() || it->second->producing) {
+      continue;
+    }
+    std::shared_ptr<ResponseBodyStream> stream = it->second;
+    stream->producing = true;
+
+    ThreadPool* pool = FindExecutor(stream->executor);
+    std::weak_ptr<Connection> weak_conn = conn;
+    Task task([this, weak_conn, ctx, stream, stream_id]() {
+      std::string piece;
+      BodyProducer::Status status = stream->framer->Next(piece, response_body_chunk_bytes_);
+      auto strong_conn = weak_conn.lock();
+      if (!strong_conn || strong_conn->IsDisconnected()) {
+        return;
       }
-      RecordPhase3Metrics(r, io_flush_ms, pipeline_ms);
+      strong_conn->getLoop()->queueinloop(
+          [this, weak_conn, ctx, stream_id, status, piece = std::move(piece)]() mutable {
+            auto c = weak_conn.lock();
+            if (!c || c->IsDisconnected() || ctx->draining) {
+              return;
+            }
+            ApplyHttp2BodyPiece(c, ctx, stream_id, status, piece);
+          });
+    });
+    task.cancel = ctx->cancel;
+    if (pool->addTask(std::move(task))) {
+      continue;
     }
-  });
+    // 执行池已满且响应头已经发出：只重置这个流，连接上的其他流不受影响
+    LOGERROR("执行池已满，重置按需生成响应体的 HTTP/2 流 fd=" + std::to_string(conn->fd()) +
+             " stream=" + std::to_string(stream_id));
+    std::string none;
+    ApplyHttp2BodyPiece(conn, ctx, stream_id, BodyProducer::Status::Error, none);
+  }
+}
+
+void HttpServer::ApplyHttp2BodyPiece(const spConnection& conn, const std::shared_ptr<ConnectionWorkContext>& ctx,
+                                     uint32_t stream_id, BodyProducer::Status status, std::string& piece) {
+  auto it = ctx->h2_response_bodies.find(stream_id);
+  if (it == ctx->h2_response_bodies.end() || !ctx->h2) {
+    return;
+  }
+  it->second->producing = false;
+  if (status == BodyProducer::Status::Error) {
+    // 响应头已经发出：以 RST_STREAM(INTERNAL_ERROR) 告知对端这个流的响应不完整
+    LOGERROR("按需生成的响应体失败，重置 HTTP/2 流 fd=" + std::to_string(conn->fd()) +
+             " stream=" + std::to_string(stream_id));
+    ctx->h2_response_bodies.erase(it);
+    ctx->h2->ResetStream(stream_id, Http2ErrorCode::INTERNAL_ERROR);
+  } else {
+    const bool done = status == BodyProducer::Status::Done;
+    if (!ctx->h2->AppendResponseBody(stream_id, std::move(piece), done) || done) {
+      ctx->h2_response_bodies.erase(it);
+    }
+  }
+  FlushHttp2(conn, ctx);
+}
+
+void HttpServer::LogWorkResult(const WorkResult& result) {
+  const long io_flush_us = ElapsedUs(result.io_enqueue_tp, std::chrono::steady_clock::now());
+  const long pipeline_us = result.parse_route_us + result.queue_wait_us + result.worker_exec_us + io_flush_us;
+  LOGINFO("worker链路 request_id=" + result.request_id +
+          " seq=" + std::to_string(result.response_seq) +
+          " route=" + RouteBucketName(result.route_bucket) +
+          " queue_wait_us=" + std::to_string(result.queue_wait_us) +
+          " parse_route_us=" + std::to_string(result.parse_route_us) +
+          " business_us=" + std::to_string(result.business_us) +
+          " serialize_us=" + std::to_string(result.serialize_us) +
+          " worker_exec_us=" + std::to_string(result.worker_exec_us) +
+          " io_flush_us=" + std::to_string(io_flush_us) +
+          " pipeline_us=" + std::to_string(pipeline_us));
+  if (pipeline_us >= slow_request_ms_threshold_ * 1000) {
+    LOGWARNING("慢请求 request_id=" + result.request_id +
+               " method=" + result.method +
+               " path=" + result.path +
+               " route=" + RouteBucketName(result.route_bucket) +
+               " pipeline_us=" + std::to_string(pipeline_us));
+  }
+  RecordPhase3Metrics(result, io_flush_us, pipeline_us);
 }
 
 void HttpServer::CloseSendFileFd(WorkResult& result) {
@@ -649,26 +1658,20 @@ void HttpServer::SendServiceUnavailable(spConnection conn, const std::string& re
   conn->send();
 }
 
-void HttpServer::RecordPhase3Metrics(const WorkResult& result, long io_flush_ms, long pipeline_ms) {
-  const std::string bucket = result.route_bucket.empty() ? "other" : result.route_bucket;
-  {
-    std::lock_guard<std::mutex> lock(metrics_mutex_);
-    auto& metric = route_metrics_[bucket];
-    metric.requests++;
-    if (result.is_error) metric.errors++;
-    metric.total_pipeline_ms += static_cast<uint64_t>(pipeline_ms > 0 ? pipeline_ms : 0);
-    metric.max_pipeline_ms = std::max<uint64_t>(metric.max_pipeline_ms, pipeline_ms > 0 ? static_cast<uint64_t>(pipeline_ms) : 0);
-    metric.total_queue_wait_ms += static_cast<uint64_t>(result.queue_wait_ms > 0 ? result.queue_wait_ms : 0);
-    metric.total_worker_exec_ms += static_cast<uint64_t>(result.worker_exec_ms > 0 ? result.worker_exec_ms : 0);
-    metric.total_io_flush_ms += static_cast<uint64_t>(io_flush_ms > 0 ? io_flush_ms : 0);
-    metric.total_parse_route_ms += static_cast<uint64_t>(result.parse_route_ms > 0 ? result.parse_route_ms : 0);
-    metric.total_business_ms += static_cast<uint64_t>(result.business_ms > 0 ? result.business_ms : 0);
-    metric.total_serialize_ms += static_cast<uint64_t>(result.serialize_ms > 0 ? result.serialize_ms : 0);
-    if (result.has_sendfile) {
-      metric.sendfile_requests++;
-      metric.sendfile_bytes += result.sendfile_bytes;
-    }
-  }
+void HttpServer::RecordPhase3Metrics(const WorkResult& result, long io_flush_us, long pipeline_us) {
+  auto clamp = [](long us) { return static_cast<uint64_t>(us > 0 ? us : 0); };
+  LatencyRecorder::Sample sample;
+  sample.stage_us[static_cast<size_t>(LatencyStage::QueueWait)] = clamp(result.queue_wait_us);
+  sample.stage_us[static_cast<size_t>(LatencyStage::ParseRoute)] = clamp(result.parse_route_us);
+  sample.stage_us[static_cast<size_t>(LatencyStage::Business)] = clamp(result.business_us);
+  sample.stage_us[static_cast<size_t>(LatencyStage::Serialize)] = clamp(result.serialize_us);
+  sample.stage_us[static_cast<size_t>(LatencyStage::IoFlush)] = clamp(io_flush_us);
+  sample.stage_us[static_cast<size_t>(LatencyStage::Total)] = clamp(pipeline_us);
+  sample.error = result.is_error;
+  sample.sendfile = result.has_sendfile;
+  sample.sendfile_bytes = result.sendfile_bytes;
+  // 只写当前线程的分片，不加锁
+  latency_.Record(static_cast<size_t>(result.route_bucket), sample);
   MaybeLogPhase3Snapshot();
 }
 
@@ -680,33 +1683,181 @@ void HttpServer::MaybeLogPhase3Snapshot() {
 
   std::ostringstream oss;
   oss << "Phase3指标快照 total_observed=" << observed;
-  {
-    std::lock_guard<std::mutex> lock(metrics_mutex_);
-    for (const auto& kv : route_metrics_) {
-      const auto& bucket = kv.first;
-      const auto& m = kv.second;
-      if (m.requests == 0) continue;
-      const uint64_t avg_pipeline = m.total_pipeline_ms / m.requests;
-      const uint64_t avg_queue_wait = m.total_queue_wait_ms / m.requests;
-      const uint64_t avg_worker_exec = m.total_worker_exec_ms / m.requests;
-      const uint64_t avg_io_flush = m.total_io_flush_ms / m.requests;
-      oss << " | route=" << bucket
-          << ", req=" << m.requests
-          << ", err=" << m.errors
-          << ", avg_pipeline_ms=" << avg_pipeline
-          << ", max_pipeline_ms=" << m.max_pipeline_ms
-          << ", avg_queue_wait_ms=" << avg_queue_wait
-          << ", avg_worker_exec_ms=" << avg_worker_exec
-          << ", avg_io_flush_ms=" << avg_io_flush;
-      if (m.sendfile_requests > 0) {
-        oss << ", sendfile_req=" << m.sendfile_requests
-            << ", sendfile_bytes=" << m.sendfile_bytes;
-      }
+  const auto buckets = latency_.Snapshot();
+  for (size_t i = 0; i < buckets.size(); i++) {
+    const auto& m = buckets[i];
+    if (m.requests == 0) continue;
+    oss << " | route=" << RouteBucketName(static_cast<RouteBucket>(i))
+        << ", req=" << m.requests
+        << ", err=" << m.errors;
+    // 各阶段 p50/p99/p999/max（微秒）
+    for (size_t s = 0; s < static_cast<size_t>(LatencyStage::Count); s++) {
+      const LatencyHistogram& h = m.stages[s];
+      oss << ", " << LatencyStageName(static_cast<LatencyStage>(s)) << "_us="
+          << h.Percentile(0.50) << "/" << h.Percentile(0.99) << "/"
+          << h.Percentile(0.999) << "/" << h.Max();
+    }
+    if (m.sendfile_requests > 0) {
+      oss << ", sendfile_req=" << m.sendfile_requests
+          << ", sendfile_bytes=" << m.sendfile_bytes;
     }
   }
+
+  // 各执行池分别输出饱和度，便于定位是哪类负载在排队
+  auto append_pool = [this, &oss](const char* name, const ThreadPool& pool) {
+    ThreadPool::Stats st = pool.stats();
+    oss << " | executor=" << name
+        << ", shed_level=" << FindAdmission(name)->shed_level()
+        << ", live=" << st.live_threads
+        << ", parked=" << st.parked_workers
+        << ", blocked=" << st.blocked_workers
+        << ", pending=" << st.pending
+        << ", queue_wait_us=" << st.queue_wait_ns / 1000
+        << ", cancelled=" << st.cancelled;
+  };
+  append_pool(kExecutorCpu, threadpool_);
+  for (const auto& [name, pool] : executor_pools_) {
+    append_pool(name.c_str(), *pool);
+  }
   LOGINFO(oss.str());
 }
 
+std::string HttpServer::RenderMetrics() const {
+  PrometheusText out;
+  const auto& bounds = PrometheusText::DefaultLatencyBoundsUs();
+
+  // 路由桶：请求/错误计数与各阶段延迟直方图
+  const auto buckets = latency_.Snapshot();
+  out.Family("webserver_requests_total", "counter", "Requests completed, by route bucket.");
+  for (size_t i = 0; i < buckets.size(); i++) {
+    out.Sample("webserver_requests_total", {{"route", RouteBucketName(static_cast<RouteBucket>(i))}}, buckets[i].requests);
+  }
+  out.Family("webserver_request_errors_total", "counter", "Requests answered with an error response, by route bucket.");
+  for (size_t i = 0; i < buckets.size(); i++) {
+    out.Sample("webserver_request_errors_total", {{"route", RouteBucketName(static_cast<RouteBucket>(i))}}, buckets[i].errors);
+  }
+  out.Family("webserver_sendfile_bytes_total", "counter", "Bytes sent with sendfile, by route bucket.");
+  for (size_t i = 0; i < buckets.size(); i++) {
+    out.Sample("webserver_sendfile_bytes_total", {{"route", RouteBucketName(static_cast<RouteBucket>(i))}}, buckets[i].sendfile_bytes);
+  }
+  out.Family("webserver_request_stage_seconds", "histogram", "Per-stage request latency, by route bucket.");
+  for (size_t i = 0; i < buckets.size(); i++) {
+    if (buckets[i].requests == 0) continue;   // 未出现过的路由桶不输出，避免空直方图
+    const char* route = RouteBucketName(static_cast<RouteBucket>(i));
+    for (size_t s = 0; s < static_cast<size_t>(LatencyStage::Count); s++) {
+      out.Histogram("webserver_request_stage_seconds",
+                    {{"route", route}, {"stage", LatencyStageName(static_cast<LatencyStage>(s))}},
+                    buckets[i].stages[s], buckets[i].stage_sum_us[s], bounds);
+    }
+  }
+
+  // 执行池
+  std::vector<std::pair<std::string, ThreadPool::Stats>> pools;
+  pools.emplace_back(kExecutorCpu, threadpool_.stats());
+  for (const auto& [name, pool] : executor_pools_) {
+    pools.emplace_back(name, pool->stats());
+  }
+  out.Family("webserver_executor_threads", "gauge", "Executor worker threads, by state.");
+  for (const auto& [name, st] : pools) {
+    out.Sample("webserver_executor_threads", {{"executor", name}, {"state", "live"}}, static_cast<uint64_t>(st.live_threads));
+    out.Sample("webserver_executor_threads", {{"executor", name}, {"state", "parked"}}, static_cast<uint64_t>(st.parked_workers));
+    out.Sample("webserver_executor_threads", {{"executor", name}, {"state", "blocked"}}, static_cast<uint64_t>(st.blocked_workers));
+  }
+  out.Family("webserver_executor_pending_tasks", "gauge", "Tasks submitted to the executor and not yet finished.");
+  for (const auto& [name, st] : pools) {
+    out.Sample("webserver_executor_pending_tasks", {{"executor", name}}, static_cast<uint64_t>(st.pending));
+  }
+  out.Family("webserver_executor_tasks_total", "counter", "Tasks executed by the executor.");
+  for (const auto& [name, st] : pools) {
+    out.Sample("webserver_executor_tasks_total", {{"executor", name}}, st.executed);
+  }
+  out.Family("webserver_executor_steals_total", "counter", "Tasks stolen from another worker's deque.");
+  for (const auto& [name, st] : pools) {
+    out.Sample("webserver_executor_steals_total", {{"executor", name}}, st.steals);
+  }
+  out.Family("webserver_executor_cancelled_total", "counter", "Tasks dropped at dequeue because their connection was gone.");
+  for (const auto& [name, st] : pools) {
+    out.Sample("webserver_executor_cancelled_total", {{"executor", name}}, st.cancelled);
+  }
+  out.Family("webserver_executor_queue_wait_seconds", "gauge", "Smoothed queue wait of the executor.");
+  for (const auto& [name, st] : pools) {
+    out.Sample("webserver_executor_queue_wait_seconds", {{"executor", name}}, static_cast<double>(st.queue_wait_ns) / 1e9);
+  }
+
+  // 准入控制
+  out.Family("webserver_admission_admitted_total", "counter", "Requests admitted by the adaptive admission controller.");
+  for (const auto& [name, admission] : admission_) {
+    out.Sample("webserver_admission_admitted_total", {{"executor", name}}, admission->stats().admitted);
+  }
+  out.Family("webserver_admission_shed_total", "counter", "Requests rejected by the adaptive admission controller, by priority.");
+  for (const auto& [name, admission] : admission_) {
+    const AdmissionController::Stats st = admission->stats();
+    for (size_t p = 0; p < static_cast<size_t>(AdmissionPriority::Count); p++) {
+      out.Sample("webserver_admission_shed_total",
+                 {{"executor", name}, {"priority", AdmissionPriorityName(static_cast<AdmissionPriority>(p))}}, st.shed[p]);
+    }
+  }
+  out.Family("webserver_admission_shed_level", "gauge", "Current shed level: 0 admits all, 1 rejects low, 2 rejects low and normal.");
+  for (const auto& [name, admission] : admission_) {
+    out.Sample("webserver_admission_shed_level", {{"executor", name}}, static_cast<uint64_t>(admission->shed_level()));
+  }
+  out.Family("webserver_admission_min_sojourn_seconds", "gauge", "Minimum queue sojourn in the last evaluated window.");
+  for (const auto& [name, admission] : admission_) {
+    out.Sample("webserver_admission_min_sojourn_seconds", {{"executor", name}},
+               static_cast<double>(admission->stats().last_min_sojourn_us) / 1e6);
+  }
+
+  // 事件循环与连接
+  const auto loops = tcpserver_.loop_stats();
+  out.Family("webserver_eventloop_iterations_total", "counter", "epoll_wait returns, by event loop (0 is the acceptor loop).");
+  for (size_t i = 0; i < loops.size(); i++) {
+    out.Sample("webserver_eventloop_iterations_total", {{"loop", std::to_string(i)}}, loops[i].iterations);
+  }
+  out.Family("webserver_eventloop_events_total", "counter", "File descriptor events handled, by event loop.");
+  for (size_t i = 0; i < loops.size(); i++) {
+    out.Sample("webserver_eventloop_events_total", {{"loop", std::to_string(i)}}, loops[i].events);
+  }
+  out.Family("webserver_eventloop_tasks_total", "counter", "Cross-thread tasks run, by event loop.");
+  for (size_t i = 0; i < loops.size(); i++) {
+    out.Sample("webserver_eventloop_tasks_total", {{"loop", std::to_string(i)}}, loops[i].tasks_run);
+  }
+  out.Family("webserver_eventloop_pending_tasks", "gauge", "Cross-thread tasks queued and not yet run, by event loop.");
+  for (size_t i = 0; i < loops.size(); i++) {
+    out.Sample("webserver_eventloop_pending_tasks", {{"loop", std::to_string(i)}}, static_cast<uint64_t>(loops[i].pending_tasks));
+  }
+  out.Family("webserver_connections", "gauge", "Open client connections.");
+  out.Sample("webserver_connections", {}, static_cast<uint64_t>(tcpserver_.connection_count()));
+  out.Family("webserver_connections_accepted_total", "counter", "Client connections accepted.");
+  out.Sample("webserver_connections_accepted_total", {}, tcpserver_.accepted_total());
+
+  // MySQL 连接池
+  SqlConnPool* sql = SqlConnPool::Instance();
+  const int sql_used = sql->GetUsedConnCount();
+  out.Family("webserver_sql_pool_connections", "gauge", "MySQL pool connections, by state.");
+  out.Sample("webserver_sql_pool_connections", {{"state", "used"}}, static_cast<uint64_t>(std::max(0, sql_used)));
+  out.Sample("webserver_sql_pool_connections", {{"state", "idle"}}, static_cast<uint64_t>(std::max(0, sql->GetMaxConnCount() - sql_used)));
+  out.Family("webserver_sql_pool_waiters", "gauge", "Threads blocked waiting for a MySQL connection.");
+  out.Sample("webserver_sql_pool_waiters", {}, static_cast<uint64_t>(std::max(0, sql->GetWaitingCount())));
+
+  // 内存池
+  const pageCache::Stats mem = MemoryPool::stats();
+  out.Family("webserver_mempool_bytes", "gauge", "Memory pool page cache usage, by kind.");
+  out.Sample("webserver_mempool_bytes", {{"kind", "mapped"}}, static_cast<uint64_t>(mem.mappedBytes));
+  out.Sample("webserver_mempool_bytes", {{"kind", "span_in_use"}}, static_cast<uint64_t>(mem.spanInUseBytes));
+  out.Sample("webserver_mempool_bytes", {{"kind", "large"}}, static_cast<uint64_t>(mem.largeBytes));
+
+  // 日志
+  const Logger& logger = LogFac::Instance().logger();
+  out.Family("webserver_logger_queue_depth", "gauge", "Log lines queued for the async writer.");
+  out.Sample("webserver_logger_queue_depth", {}, static_cast<uint64_t>(logger.GetQueueSize()));
+  out.Family("webserver_logger_processed_total", "counter", "Log lines written by the async writer.");
+  out.Sample("webserver_logger_processed_total", {}, static_cast<uint64_t>(logger.GetTotalProcessed()));
+  out.Family("webserver_logger_dropped_total", "counter", "Log lines dropped because the queue was full.");
+  out.Sample("webserver_logger_dropped_total", {}, static_cast<uint64_t>(logger.GetTotalDropped()));
+
+  return out.Take();
+}
+
 /**
  * 路由处理器函数实现
  * 
@@ -727,39 +1878,42 @@ void HttpServer::SetupRoutes(Router& router) {
   (*pageHandlers)["/video.html"] = std::make_shared<VideoPageHandler>(static_path_);
   
   // 创建页面路由处理器（使用lambda捕获pageHandlers的shared_ptr）
-  auto pageRouteHandler = [pageHandlers](IHttpMessage& message, HttpResponse& response, const RouteParams& params) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request || request->GetMethod() != HttpMethod::GET) {
+  auto pageRouteHandler = [pageHandlers](HttpRequest& request, HttpResponse& response, const RouteParams& params) {
+    if (request.GetMethod() != HttpMethod::GET) {
       return false;
     }
     
-    std::string path = request->GetPath();
+    std::string path = request.GetPath();
     if (path == "/") path = "/index.html"; // 根路径映射到 index.html
     if (path.empty()) path = "/index.html";
     auto it = pageHandlers->find(path);
     if (it != pageHandlers->end() && it->second) {
-      it->second->Handle(request, response);
+      it->second->Handle(&request, response);
       return true;
     }
     
     return false;
   };
   
-  // 注册业务API路由
-  router.Post("/register", [](IHttpMessage& message, HttpResponse& response, const RouteParams& params) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request || request->GetMethod() != HttpMethod::POST) {
+  // 注册业务API路由（注册/登录涉及 PBKDF2 与 MySQL，放在 blocking-db 池，避免洪峰拖慢其他请求）
+  router.Post("/register", [](HttpRequest& request, HttpResponse& response, const RouteParams& params) {
+    if (request.GetMethod() != HttpMethod::POST) {
       return false;
     }
     
     // 解析POST表单数据
-    std::string body = request->GetBody();
+    std::string body = request.GetBody();
     auto form_data = ParseFormData(body);
     
     // 提取用户名和密码
     std::string username = form_data.count("username") > 0 ? form_data.at("username") : "";
     std::string password = form_data.count("password") > 0 ? form_data.at("password") : "";
     
+    // 连接已断开则跳过密码哈希与数据库访问
+    if (request.IsCancelled()) {
+      return true;
+    }
+    
     // 调用AuthService处理注册
     bool success = AuthService::HandleRegister(username, password);
     
@@ -771,22 +1925,26 @@ void HttpServer::SetupRoutes(Router& router) {
     }
     
     return true;
-  });
+  }, kExecutorBlockingDb);
   
-  router.Post("/login", [](IHttpMessage& message, HttpResponse& response, const RouteParams& params) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request || request->GetMethod() != HttpMethod::POST) {
+  router.Post("/login", [](HttpRequest& request, HttpResponse& response, const RouteParams& params) {
+    if (request.GetMethod() != HttpMethod::POST) {
       return false;
     }
     
     // 解析POST表单数据
-    std::string body = request->GetBody();
+    std::string body = request.GetBody();
     auto form_data = ParseFormData(body);
     
     // 提取用户名和密码
     std::string username = form_data.count("username") > 0 ? form_data.at("username") : "";
     std::string password = form_data.count("password") > 0 ? form_data.at("password") : "";
     
+    // 连接已断开则跳过密码哈希与数据库访问
+    if (request.IsCancelled()) {
+      return true;
+    }
+    
     // 调用AuthService处理登录
     auto login_result = AuthService::HandleLogin(username, password);
     
@@ -803,16 +1961,15 @@ void HttpServer::SetupRoutes(Router& router) {
     }
     
     return true;
-  });
+  }, kExecutorBlockingDb);
 
-  router.Post("/refresh-token", [](IHttpMessage& message, HttpResponse& response, const RouteParams& params) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request || request->GetMethod() != HttpMethod::POST) {
+  router.Post("/refresh-token", [](HttpRequest& request, HttpResponse& response, const RouteParams& params) {
+    if (request.GetMethod() != HttpMethod::POST) {
       return false;
     }
     
     // 解析POST表单数据
-    std::string body = request->GetBody();
+    std::string body = request.GetBody();
     auto form_data = ParseFormData(body);
     
     // 提取refresh_token
@@ -836,119 +1993,95 @@ void HttpServer::SetupRoutes(Router& router) {
     return true;
   });
 
-  router.Get("/api/files", [this](IHttpMessage& message, HttpResponse& response, const RouteParams&) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request) return false;
-    return FileApiService::HandleListFiles(request, response, static_path_);
-  });
-
-  router.Get("/api/files/preview", [this](IHttpMessage& message, HttpResponse& response, const RouteParams&) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request) return false;
-    return FileApiService::HandlePreview(request, response, static_path_);
-  });
+  router.Get("/api/files", [this](HttpRequest& request, HttpResponse& response, const RouteParams&) {
+    return FileApiService::HandleListFiles(&request, response, static_path_);
+  }, kExecutorBlockingDisk);
 
-  router.Post("/api/uploads/init", [this](IHttpMessage& message, HttpResponse& response, const RouteParams&) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request) return false;
-    return UploadService::HandleInit(request, response, static_path_);
+  router.Get("/api/files/preview", [this](HttpRequest& request, HttpResponse& response, const RouteParams&) {
+    return FileApiService::HandlePreview(&request, response, static_path_);
   });
 
-  router.Put("/api/uploads/:uploadId/parts/:partNo", [this](IHttpMessage& message, HttpResponse& response, const RouteParams& params) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request) return false;
-    return UploadService::HandleUploadPart(request, response, params, static_path_);
-  });
-
-  router.Post("/api/uploads/:uploadId/complete", [this](IHttpMessage& message, HttpResponse& response, const RouteParams& params) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request) return false;
-    return UploadService::HandleComplete(request, response, params, static_path_);
-  });
-  router.Get("/favicon.ico", [](IHttpMessage& message, HttpResponse& response, const RouteParams& params) {
+  router.Post("/api/uploads/init", [this](HttpRequest& request, HttpResponse& response, const RouteParams&) {
+    return UploadService::HandleInit(&request, response, static_path_);
+  }, kExecutorBlockingDisk);
+
+  // 分片 body 边接收边写入分片文件，处理器在写完之后只负责回复结果
+  router.AddStreamingRoute(HttpMethod::PUT, "/api/uploads/:uploadId/parts/:partNo",
+      [this](HttpRequest& request, HttpResponse& response, const RouteParams& params) {
+        return UploadService::HandleUploadPart(&request, response, params, static_path_);
+      },
+      [this](HttpRequest& request, const RouteParams& params, uint64_t length, HttpResponse& response) {
+        return UploadService::CreatePartSink(request, params, length, response, static_path_);
+      },
+      kExecutorBlockingDisk);
+
+  router.Post("/api/uploads/:uploadId/complete", [this](HttpRequest& request, HttpResponse& response, const RouteParams& params) {
+    return UploadService::HandleComplete(&request, response, params, static_path_);
+  }, kExecutorBlockingDisk);
+  router.Get("/favicon.ico", [](HttpRequest&, HttpResponse& response, const RouteParams& params) {
     response.SetStatusCode(HttpStatusCode::NO_CONTENT);
     response.SetHeader("Content-Type", "image/x-icon");
     return true;
   });
-  router.Get("/favicon.svg", [this](IHttpMessage& message, HttpResponse& response, const RouteParams&) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request) return false;
-    return StaticFileService::HandleStaticFile(request, response, static_path_);
+  router.Get("/favicon.svg", [this](HttpRequest& request, HttpResponse& response, const RouteParams&) {
+    return StaticFileService::HandleStaticFile(&request, response, static_path_);
   });
-  router.Head("/favicon.svg", [this](IHttpMessage& message, HttpResponse& response, const RouteParams&) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request) return false;
-    return StaticFileService::HandleStaticFile(request, response, static_path_);
+  router.Head("/favicon.svg", [this](HttpRequest& request, HttpResponse& response, const RouteParams&) {
+    return StaticFileService::HandleStaticFile(&request, response, static_path_);
   });
-  router.Get("/assets/*", [this](IHttpMessage& message, HttpResponse& response, const RouteParams&) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request) return false;
-    return StaticFileService::HandleStaticFile(request, response, static_path_);
+  router.Get("/assets/*", [this](HttpRequest& request, HttpResponse& response, const RouteParams&) {
+    return StaticFileService::HandleStaticFile(&request, response, static_path_);
   });
-  router.Head("/assets/*", [this](IHttpMessage& message, HttpResponse& response, const RouteParams&) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request) return false;
-    return StaticFileService::HandleStaticFile(request, response, static_path_);
+  router.Head("/assets/*", [this](HttpRequest& request, HttpResponse& response, const RouteParams&) {
+    return StaticFileService::HandleStaticFile(&request, response, static_path_);
   });
 
-  router.Options("/*", [](IHttpMessage& message, HttpResponse& response, const RouteParams&) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request) return false;
+  router.Options("/*", [](HttpRequest& request, HttpResponse& response, const RouteParams&) {
     response.SetStatusCode(HttpStatusCode::NO_CONTENT);
     response.SetHeader("Content-Type", "text/plain; charset=utf-8");
-    ApplyCorsHeaders(response, request);
+    ApplyCorsHeaders(response, &request);
     return true;
   });
-  router.Get("/download/*", [this](IHttpMessage& message, HttpResponse& response, const RouteParams& params) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request) return false;
-    // 添加静态路径到路由参数中，供处理器使用
-    RouteParams new_params = params;
-    new_params.params_["static_path"] = static_path_;
-    return DownloadService::HandleDownload(request, response, static_path_);
+  router.Get("/download/*", [this](HttpRequest& request, HttpResponse& response, const RouteParams& params) {
+    return DownloadService::HandleDownload(&request, response, static_path_);
   });
-  router.Head("/download/*", [this](IHttpMessage& message, HttpResponse& response, const RouteParams& params) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request) return false;
-    RouteParams new_params = params;
-    new_params.params_["static_path"] = static_path_;
-    return DownloadService::HandleDownload(request, response, static_path_);
+  router.Head("/download/*", [this](HttpRequest& request, HttpResponse& response, const RouteParams& params) {
+    return DownloadService::HandleDownload(&request, response, static_path_);
   });
   
   // 注册静态文件路由
-  router.Get("/images/*", [this](IHttpMessage& message, HttpResponse& response, const RouteParams& params) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request) return false;
-    return StaticFileService::HandleStaticFile(request, response, static_path_);
+  router.Get("/images/*", [this](HttpRequest& request, HttpResponse& response, const RouteParams& params) {
+    return StaticFileService::HandleStaticFile(&request, response, static_path_);
   });
-  router.Head("/images/*", [this](IHttpMessage& message, HttpResponse& response, const RouteParams& params) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request) return false;
-    return StaticFileService::HandleStaticFile(request, response, static_path_);
+  router.Head("/images/*", [this](HttpRequest& request, HttpResponse& response, const RouteParams& params) {
+    return StaticFileService::HandleStaticFile(&request, response, static_path_);
   });
   
-  router.Get("/video/*", [this](IHttpMessage& message, HttpResponse& response, const RouteParams& params) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request) return false;
-    return StaticFileService::HandleStaticFile(request, response, static_path_);
+  router.Get("/video/*", [this](HttpRequest& request, HttpResponse& response, const RouteParams& params) {
+    return StaticFileService::HandleStaticFile(&request, response, static_path_);
   });
-  router.Head("/video/*", [this](IHttpMessage& message, HttpResponse& response, const RouteParams& params) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request) return false;
-    return StaticFileService::HandleStaticFile(request, response, static_path_);
+  router.Head("/video/*", [this](HttpRequest& request, HttpResponse& response, const RouteParams& params) {
+    return StaticFileService::HandleStaticFile(&request, response, static_path_);
   });
 
-  router.Get("/uploads/*", [this](IHttpMessage& message, HttpResponse& response, const RouteParams& params) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request) return false;
-    return StaticFileService::HandleStaticFile(request, response, static_path_);
+  router.Get("/uploads/*", [this](HttpRequest& request, HttpResponse& response, const RouteParams& params) {
+    return StaticFileService::HandleStaticFile(&request, response, static_path_);
   });
-  router.Head("/uploads/*", [this](IHttpMessage& message, HttpResponse& response, const RouteParams& params) {
-    auto* request = dynamic_cast<HttpRequest*>(&message);
-    if (!request) return false;
-    return StaticFileService::HandleStaticFile(request, response, static_path_);
+  router.Head("/uploads/*", [this](HttpRequest& request, HttpResponse& response, const RouteParams& params) {
+    return StaticFileService::HandleStaticFile(&request, response, static_path_);
   });
   
+  // 指标抓取：只读原子计数与直方图分片，在 cpu 池执行，不占用阻塞型执行池
+  if (metrics_enabled_) {
+    router.Get(kMetricsPath, [this](HttpRequest&, HttpResponse& response, const RouteParams&) {
+      response.SetStatusCode(HttpStatusCode::OK);
+      response.SetHeader("Content-Type", PrometheusText::kContentType);
+      response.SetHeader("Cache-Control", "no-store");
+      response.SetBody(RenderMetrics());
+      return true;
+    });
+  }
+
   // 注册页面路由（使用lambda表达式）
   router.Get("/", pageRouteHandler);
   router.Get("/index.html", pageRouteHandler);
@@ -985,6 +2118,18 @@ void HttpServer::HandleSendComplete(spConnection conn){
 
   LOGINFO("Message send complete.");
 
+  auto* ctx = conn->GetContext<std::shared_ptr<ConnectionWorkContext>>();
+  if (!ctx || !*ctx) {
+    return;
+  }
+  // HTTP/2：输出缓冲已排空，继续写出因高水位暂停的 DATA 帧
+  if ((*ctx)->h2) {
+    FlushHttp2(conn, *ctx);
+  }
+  // 按需生成的响应体：通常已在低水位回调中拉取，这里兜底（如设置回调前输出已排空）
+  if ((*ctx)->response_body) {
+    PullResponseBody(conn, *ctx);
+  }
 }
 /*
 void HttpServer::HandleTimeOut(EventLoop*loop){
@@ -3,6 +3,10 @@
 #include"Eventloop.h"
 #include"Connection.h"
 #include"ThreadPool.h"
+#include"ReorderRing.h"
+#include"LatencyHistogram.h"
+#include"AdmissionController.h"
+#include"RouteMetricsUtil.h"
 #include"../logger/log_fac.h"
 #include"Buffer.h"
 #include"../http/include/core/HttpRequest.h"
@@ -10,6 +14,7 @@
 #include"../http/include/core/IHttpMessage.h"
 #include"../http/include/router/Router.h"
 #include"../http/include/HttpFacade.h"
+#include"../http/include/parsers/Http2Parser.h"
 #include"../http/include/handler/AppHandlers.h"
 #include"../services/include/AuthService.h"
 #include"../services/include/DownloadService.h"
@@ -34,87 +39,97 @@ class TlsContext;
  */
 class HttpServer{
 public:
-  struct WorkResult;
-
-  struct PendingChunk {
-    std::string data;
-    uint64_t enqueue_seq{0};
-    std::chrono::steady_clock::time_point enqueue_tp;
-  };
-
-  struct ConnectionWorkContext {
-    std::shared_ptr<HttpFacade> facade;             //连接级的 HTTP 协议处理对象，每个连接独立实例
-    std::mutex mutex;                               //保护队列和状态变量的线程安全
-    std::deque<PendingChunk> queued_chunks;         //待处理的 HTTP 请求数据块队列
-    size_t queued_bytes{0};                         //连接级待处理字节数，用于背压控制
-    bool worker_running{false};                     //标记是否有 worker 线程正在处理该连接的数据
-    uint64_t next_enqueue_seq{1};                   //保证入队顺序的序列号生成器
-    uint64_t next_response_seq{1};                  //保证响应顺序的序列号生成器
-    uint64_t last_applied_response_seq{0};          //记录最后应用的响应序列号
-    std::map<uint64_t, WorkResult> pending_results; //按序列号存储的待回写响应结果
-
-    size_t active_worker_count{0};                  //当前正在执行的 worker 数
-    size_t max_concurrent_workers{4};               //单连接最大并发 worker 数
-    bool draining{false};                           //排空模式：不再启动新 worker
-    std::mutex facade_mutex;                        //保护 facade 的独占访问
-  };
+  struct RequestContext;
 
   struct WorkResult {
     uint64_t response_seq{0};                          // 响应序列号
     std::string request_id;                            // 请求ID（调试用）
     std::string method;                                // HTTP方法
     std::string path;                                  // 请求路径
-    std::string route_bucket;                          // 路由桶（用于指标统计）
+    RouteBucket route_bucket{RouteBucket::Other};      // 路由桶（用于指标统计）
     bool has_response{false};                          // 是否有响应数据
-    std::string response_data;                         // 响应数据
+    uint32_t h2_stream_id{0};                          // HTTP/2 流 ID，0 表示 HTTP/1 响应
+    std::string response_data;                         // 响应数据：状态行与头部（或完整的预序列化响应）；HTTP/2 为 HPACK 头部块
+    std::string response_body;                         // 从响应对象移交的 body，IO 线程紧随 response_data 写入
     bool close_after_send{false};                      // 发送后是否关闭连接
     bool has_sendfile{false};                          // 是否包含文件发送
     int sendfile_fd{-1};                               // 文件描述符
     off_t sendfile_offset{0};                          // 文件偏移量
     size_t sendfile_length{0};                         // 文件长度
+    std::shared_ptr<BodyProducerFramer> body_stream;   // 按需生成的 body 尚未生成的部分，IO 线程在输出排空后逐段拉取
+    std::string body_executor;                         // 拉取 body_stream 的执行池（路由声明的池）
     bool is_error{false};                              // 是否是错误响应
     bool is_download{false};                           // 是否是下载请求
     size_t sendfile_bytes{0};                          // 已发送文件字节数
-    long queue_wait_ms{-1};                            // 队列等待时间（毫秒）
-    long worker_exec_ms{0};                            // worker执行时间（毫秒）
-    long parse_route_ms{0};                            // 解析路由时间（毫秒）
-    long business_ms{0};                               // 业务处理时间（毫秒）
-    long serialize_ms{0};                              // 序列化时间（毫秒）
+    long queue_wait_us{0};                             // 队列等待时间（微秒）
+    long worker_exec_us{0};                            // worker执行时间（微秒）
+    long parse_route_us{0};                            // 解析路由时间（微秒）
+    long business_us{0};                               // 业务处理时间（微秒）
+    long serialize_us{0};                              // 序列化时间（微秒）
     std::chrono::steady_clock::time_point io_enqueue_tp;// IO入队时间点
+    std::shared_ptr<RequestContext> req_ctx;           // 请求上下文随结果回到 IO 线程，应用后回收给连接复用
   };
 
-private:
+  struct RequestBodyStream;
+  struct ResponseBodyStream;
 
-  struct RouteMetric {
-    uint64_t requests{0};                            // 请求总数
-    uint64_t errors{0};                                // 错误数量
-    uint64_t total_pipeline_ms{0};                     // 总流水线时间（毫秒）
-    uint64_t max_pipeline_ms{0};                       // 最大流水线时间（毫秒）
-    uint64_t total_queue_wait_ms{0};                   // 总队列等待时间（毫秒）
-    uint64_t total_worker_exec_ms{0};                  // 总worker执行时间（毫秒）
-    uint64_t total_io_flush_ms{0};                     // 总IO刷新时间（毫秒）
-    uint64_t total_parse_route_ms{0};                  // 总解析路由时间（毫秒）
-    uint64_t total_business_ms{0};                     // 总业务处理时间（毫秒）
-    uint64_t total_serialize_ms{0};                    // 总序列化时间（毫秒）
-    uint64_t sendfile_requests{0};                     // 文件发送请求数
-    uint64_t sendfile_bytes{0};                        // 文件发送总字节数
+  // 连接上下文：除取消令牌外的所有状态只由连接所属的 IO 线程读写，不需要加锁
+  // IO 线程负责解析并分配响应序号，worker 只接收解析完成、彼此独立的请求
+  struct ConnectionWorkContext {
+    std::shared_ptr<HttpFacade> facade;             //连接级的 HTTP 协议处理对象，解析只在 IO 线程进行
+    uint64_t next_response_seq{1};                  //保证响应顺序的序列号生成器
+    ReorderRing<WorkResult> reorder;                //按序列号重排的待回写响应结果
+    size_t inflight{0};                             //已分发给 worker、尚未回写的请求数
+    bool parse_closed{false};                       //解析出错后不再解析后续数据，等待错误响应发出后关闭
+    bool draining{false};                           //连接已关闭：丢弃后续回写结果
+    std::shared_ptr<std::atomic_bool> cancel{std::make_shared<std::atomic_bool>(false)}; //连接级取消令牌，连接关闭时置位
+    bool protocol_decided{false};                   //是否已根据 ALPN 或连接前言确定协议
+    std::unique_ptr<Http2Parser> h2;                //HTTP/2 连接状态；非空时响应按流提交，不经过重排环
+    std::shared_ptr<RequestBodyStream> body;        //请求头已分发、body 仍在接收中的请求，收齐前不解析后续请求
+    std::shared_ptr<ResponseBodyStream> response_body; //正在逐段发送 body 的响应，发完之前其后的响应留在重排环中
+    std::unordered_map<uint32_t, std::shared_ptr<ResponseBodyStream>> h2_response_bodies; //HTTP/2 各流按需生成的响应体，按流的发送窗口逐段拉取
+    std::vector<std::shared_ptr<RequestContext>> spare_requests; //已回收的请求上下文，下一个请求直接复用其对象与各缓冲的容量
+    bool metrics_allowed{false};                    //对端地址在 /metrics 白名单中；其他连接访问 /metrics 一律返回 404
   };
 
+private:
+
+  // 执行池名称：路由在 SetupRoutes 中声明处理器运行的池，解析与轻量处理器默认在 cpu 池
+  static constexpr const char* kExecutorCpu = "cpu";
+  static constexpr const char* kExecutorBlockingDb = "blocking-db";       // MySQL 访问与密码哈希
+  static constexpr const char* kExecutorBlockingDisk = "blocking-disk";   // 上传写盘、目录遍历
+
   TcpServer tcpserver_;                   // TCP服务器实例
-  ThreadPool threadpool_;                 // 工作线程池
+  ThreadPool threadpool_;                 // 工作线程池（cpu 执行池）
+  std::unordered_map<std::string, std::unique_ptr<ThreadPool>> executor_pools_;  // 阻塞型执行池，彼此隔离
+  std::unordered_map<std::string, std::unique_ptr<AdmissionController>> admission_;  // 各执行池（含 cpu）的自适应准入控制
+  PrerenderedHeaders prerendered_headers_;  // Server、安全头部与固定 CORS 头部的预渲染块，附加按秒缓存的 Date
+  std::string shed_response_keep_alive_;  // 预先序列化的 503 响应，准入拒绝时直接复用
+  std::string shed_response_close_;
+  std::string shed_h2_head_;              // 准入拒绝的 503 响应的 HTTP/2 头部块与 body
+  std::string shed_h2_body_;
   std::string static_path_;               // 静态资源路径
   std::shared_ptr<Router> router_;
   std::shared_ptr<TlsContext> tls_ctx_;
   std::atomic<uint64_t> request_seq_{0};
-  std::mutex metrics_mutex_;
-  std::unordered_map<std::string, RouteMetric> route_metrics_;
+  LatencyRecorder latency_{kRouteBucketCount};  // 按线程分片的各路由桶、各阶段耗时直方图
   std::atomic<uint64_t> metrics_observed_{0};
   size_t metrics_snapshot_every_{200};
   long slow_request_ms_threshold_{300};
-  size_t max_work_queue_depth_{4096};
   size_t max_conn_pending_bytes_{512 * 1024};
-  size_t max_concurrent_workers_per_conn_{4};
   size_t max_apply_per_batch_{16};
+  size_t max_pipeline_depth_{32};           // 单连接允许在途的流水线请求数，即响应重排环的窗口
+  bool metrics_enabled_{false};             // 是否注册 /metrics，默认关闭，环境变量 WEBSERVER_METRICS=1 开启
+  std::vector<std::string> metrics_allow_;  // 除回环地址外允许抓取 /metrics 的对端地址，WEBSERVER_METRICS_ALLOW 逗号分隔，以 . 结尾表示前缀
+  bool http2_enabled_{true};                // 是否接受 HTTP/2（TLS ALPN h2 与明文 prior knowledge），环境变量 WEBSERVER_HTTP2=0 关闭
+  bool compression_enabled_{true};          // 是否按 Accept-Encoding 压缩文本响应，环境变量 WEBSERVER_COMPRESSION=0 关闭
+  size_t h2_output_high_water_{256 * 1024}; // HTTP/2 连接待发送字节超过此值时暂停生成 DATA 帧
+  size_t body_defer_threshold_{64 * 1024};  // Content-Length 不小于此值的 HTTP/1 请求先交付请求头，body 边到达边处理
+  size_t max_body_stream_buffered_{1024 * 1024};  // 单个流式请求体待写入接收器的字节上限，超过时暂停读连接
+  size_t response_body_chunk_bytes_{64 * 1024};   // 按需生成的响应体每次拉取的目标字节数
+  size_t response_body_high_water_{256 * 1024};   // 连接待发送字节不低于此值时暂停拉取
+  size_t response_body_low_water_{64 * 1024};     // 暂停后待发送字节降到此值以下即恢复拉取，不等输出完全排空
+  size_t max_spare_request_contexts_{4};          // 每个连接保留的已回收请求上下文个数，覆盖非流水线长连接的稳定状态
   
 public:
   /**
@@ -128,13 +143,15 @@ public:
    * @param sqlPwd MySQL密码
    * @param dbName 数据库名称
    * @param subthreadnum IO子线程数量
-   * @param workthreadnum 工作线程数量
+   * @param workthreadnum 工作线程数量（弹性扩缩容时为常驻线程数下限）
    * @param connpoolnum 数据库连接池大小
    * @param static_path 静态资源根路径
+   * @param maxworkthreadnum 工作线程数上限，handler 阻塞在 MySQL/磁盘时按需扩容；<=workthreadnum 时为固定大小
    */
   HttpServer(const std::string &ip,uint16_t port,int timeoutMS,bool OptLinger=true,
 int sqlPort=3306,const char*sqlUser="webuser",const char*sqlPwd="12589777",const char*dbName="webserver",
-int subthreadnum=6,int workthreadnum=0,int connpoolnum=12,const std::string&static_path="./html");
+int subthreadnum=6,int workthreadnum=0,int connpoolnum=12,const std::string&static_path="./html",
+int maxworkthreadnum=0);
   
   /**
    * 析构函数
@@ -151,6 +168,11 @@ int subthreadnum=6,int workthreadnum=0,int connpoolnum=12,const std::string&stat
    */
   void Stop();
   
+  /**
+   * 热更新路由表：重新注册全部路由并整体发布，正在处理的请求不受影响，新请求立即使用新表
+   */
+  void ReloadRoutes();
+  
   /**
    * 处理新客户端连接请求
    * @param conn 新连接对象
@@ -182,7 +204,6 @@ int subthreadnum=6,int workthreadnum=0,int connpoolnum=12,const std::string&stat
   void HandleSendComplete(spConnection conn);
   //void HandleTimeOut(EventLoop*loop);  //epoll_wait()超时处理
 
-private:
   /**
    * 处理HTTP请求
    * @param request HTTP请求对象
@@ -191,12 +212,15 @@ private:
   // === Phase 2: 多阶段请求处理 ===
   enum class RequestPhase {
     PARSE_AND_ROUTE,
+    BUSINESS,
     IO_OPERATION,
     SERIALIZE_AND_SEND
   };
 
+  // 请求上下文：由连接回收复用，Reset 清空各字段但保留字符串与容器的容量
   struct RequestContext {
     std::unique_ptr<IHttpMessage> message;
+    HttpRequest* request{nullptr};                // message 的具体类型，路由前确定，之后各阶段不再做类型转换
     HttpResponse response;
     HttpError err;
     HttpServerResult result;
@@ -204,38 +228,137 @@ private:
     std::string method;
     std::string path;
     bool keep_alive{false};
+    uint32_t h2_stream{0};                        // HTTP/2 流 ID，0 表示 HTTP/1 请求
+    uint64_t response_seq{0};                     // 解析完成时按顺序分配，跨执行池后仍保证响应顺序
+    RouteMatchInfo route;                         // 路由匹配结果，处理器在路由声明的执行池中执行
+    std::chrono::steady_clock::time_point enqueue_tp;  // 分发到执行池的时间点，用于统计排队等待
+    AdmissionController* admission{nullptr};      // 准入的执行池控制器，worker 出队时上报逗留时间
 
     int file_fd{-1};
     off_t file_offset{0};
     size_t file_length{0};
 
     std::chrono::steady_clock::time_point parse_begin;
+    std::chrono::steady_clock::time_point parse_end;
     std::chrono::steady_clock::time_point business_begin;
     std::chrono::steady_clock::time_point serialize_begin;
 
     RequestPhase next_phase{RequestPhase::PARSE_AND_ROUTE};
     bool suspended{false};
+    bool body_rejected{false};                    // 请求体未写入接收器：不执行处理器，直接回写 response 中已填好的错误
+    std::string head_buffer;                      // 序列化响应头的缓冲，随上下文回收后复用
+
+    // 清空 message 以外的全部状态（message 由连接交还给解析器）
+    void Reset();
   };
 
+  // 流式请求体：IO 线程把 body 片段按到达顺序排队，执行池中同一时刻至多一个任务按序写入接收器，
+  // 内存中只保留排队的片段（受 max_body_stream_buffered_ 限制），全部写完后才分发处理器
+  struct RequestBodyStream {
+    std::shared_ptr<RequestContext> req_ctx;
+    uint64_t length{0};
+    uint64_t received{0};                         // IO 线程：已从连接取走的 body 字节数
+    bool streaming{false};                        // 路由声明了接收器；否则 IO 线程直接补齐到请求对象
+
+    std::mutex mutex;                             // 以下成员由 IO 线程与执行池共享
+    std::deque<std::pair<uint64_t, std::string>> chunks;   // 片段在 body 中的偏移与数据
+    size_t queued_bytes{0};
+    bool running{false};                          // 执行池中已有写入任务
+    bool input_done{false};                       // body 已全部取走
+    bool read_paused{false};                      // 积压超过上限，IO 线程已暂停读连接
+    bool resume_posted{false};
+    bool overloaded{false};                       // 执行池已满，放弃写入，body 读完后以 503 结束
+
+    std::shared_ptr<RequestBodySink> sink;        // 执行池：首次写入前由路由声明的工厂创建
+    bool sink_created{false};
+  };
+
+  // 按需生成的响应体：只由连接所属的 IO 线程读写；同一时刻至多一个拉取任务在执行池中
+  struct ResponseBodyStream {
+    std::shared_ptr<BodyProducerFramer> framer;
+    std::string executor;
+    bool close_after_send{false};                 // body 发完后关闭连接（不能在首段发完时就关闭）
+    bool producing{false};
+  };
+
+private:
+
   void ProcessRequest(HttpRequest* request, HttpResponse& response);
-  void HandleMessageInWorker(std::weak_ptr<Connection> weak_conn, std::shared_ptr<ConnectionWorkContext> ctx);
-  void ProcessSingleRequest(std::weak_ptr<Connection> weak_conn, std::shared_ptr<ConnectionWorkContext> ctx, PendingChunk chunk, std::shared_ptr<RequestContext> req_ctx = nullptr);
-  void OnWorkerExit(std::shared_ptr<ConnectionWorkContext> ctx, std::shared_ptr<Connection> conn);
+  std::shared_ptr<ConnectionWorkContext> CreateWorkContext();
+  bool MetricsPeerAllowed(const std::string& ip) const;
+  // IO 线程：优先取连接回收的请求上下文；结果应用后交还，仍被其他任务引用时直接释放
+  std::shared_ptr<RequestContext> AcquireRequestContext(ConnectionWorkContext& ctx);
+  void RecycleRequestContext(ConnectionWorkContext& ctx, std::shared_ptr<RequestContext> req_ctx);
+  // 结果应用后：把结果中取自上下文的字符串换回，再回收上下文
+  void RecycleRequestContext(ConnectionWorkContext& ctx, WorkResult& result);
+  // IO 线程：从连接输入缓冲（及 facade 的 pending 缓冲）中依次解析出完整请求并分发，在途请求达到 max_pipeline_depth_ 时暂停
+  void ParseAndDispatch(spConnection conn, std::shared_ptr<ConnectionWorkContext> ctx);
+  void DiscardUnparsed(const spConnection& conn, const std::shared_ptr<ConnectionWorkContext>& ctx);
+  // IO 线程：首批数据到达时确定协议（ALPN h2 或 HTTP/2 连接前言）；前言尚不完整时返回 false
+  bool DecideProtocol(const spConnection& conn, const std::shared_ptr<ConnectionWorkContext>& ctx);
+  // IO 线程：HTTP/2 连接的输入交给 Http2Parser，完成的流作为独立请求分发
+  void ParseAndDispatchHttp2(spConnection conn, std::shared_ptr<ConnectionWorkContext> ctx);
+  void DispatchHttp2Streams(spConnection conn, std::shared_ptr<ConnectionWorkContext> ctx);
+  // IO 线程：在输出高水位以内把 HTTP/2 帧写入连接，文件负载以 sendfile 区间排队
+  void FlushHttp2(const spConnection& conn, const std::shared_ptr<ConnectionWorkContext>& ctx);
+  // IO 线程：请求头已解析、body 仍在连接上时开始接收 body
+  void StartRequestBody(const std::shared_ptr<ConnectionWorkContext>& ctx, std::shared_ptr<RequestContext> req_ctx);
+  // IO 线程：把输入缓冲中属于当前 body 的字节排队给接收器（或补齐到请求对象）；body 收齐时返回 true
+  bool PumpRequestBody(const spConnection& conn, const std::shared_ptr<ConnectionWorkContext>& ctx);
+  void ScheduleBodyWrites(const spConnection& conn, const std::shared_ptr<ConnectionWorkContext>& ctx,
+                          const std::shared_ptr<RequestBodyStream>& stream);
+  // 执行池：按序把排队的片段写入接收器，body 全部写完后回到 IO 线程分发处理器
+  void DrainRequestBody(std::weak_ptr<Connection> weak_conn, std::shared_ptr<ConnectionWorkContext> ctx,
+                        std::shared_ptr<RequestBodyStream> stream);
+  // worker：取出响应的 body 生产者并生成首段（HEAD 请求不生成）。
+  // 还有后续数据时返回分帧器（HTTP/1 按 chunked 或原样分帧，HTTP/2 只取原始字节），生成失败时把请求转为 500
+  std::shared_ptr<BodyProducerFramer> BeginResponseBody(RequestContext& req_ctx, std::string& first);
+  // IO 线程：输出低于高水位且没有拉取任务时，到执行池中生成下一段
+  void PullResponseBody(const spConnection& conn, const std::shared_ptr<ConnectionWorkContext>& ctx);
+  void ApplyResponseBodyPiece(const spConnection& conn, const std::shared_ptr<ConnectionWorkContext>& ctx,
+                              BodyProducer::Status status, std::string& piece);
+  // IO 线程：HTTP/2 流的排队 body 已写出且窗口有余量、输出低于高水位时，到执行池中生成该流的下一段
+  void PullHttp2ResponseBodies(const spConnection& conn, const std::shared_ptr<ConnectionWorkContext>& ctx);
+  void ApplyHttp2BodyPiece(const spConnection& conn, const std::shared_ptr<ConnectionWorkContext>& ctx,
+                           uint32_t stream_id, BodyProducer::Status status, std::string& piece);
+  // 把请求标记为执行池已满（503），之后按错误响应回写
+  void FailExecutorOverloaded(RequestContext& req_ctx);
+  // IO 线程：为解析完成的请求分配请求 ID 并匹配路由（HTTP/1 与 HTTP/2 共用）
+  void RouteParsedRequest(const spConnection& conn,
+                          std::shared_ptr<ConnectionWorkContext> ctx,
+                          std::shared_ptr<RequestContext> req_ctx);
+  void ProcessSingleRequest(std::weak_ptr<Connection> weak_conn, std::shared_ptr<ConnectionWorkContext> ctx, std::shared_ptr<RequestContext> req_ctx);
   void PostResultToIoLoop(std::weak_ptr<Connection> weak_conn, std::shared_ptr<ConnectionWorkContext> ctx, WorkResult result);
+  // IO 线程：按序应用重排环中已就绪的结果，单批最多 max_apply_per_batch_ 个
+  void ApplyReadyResults(spConnection conn, std::shared_ptr<ConnectionWorkContext> ctx);
+  // IO 线程：HTTP/2 结果直接提交到所属的流，各流互不等待
+  void ApplyHttp2Result(spConnection conn, std::shared_ptr<ConnectionWorkContext> ctx, WorkResult& result);
+  void LogWorkResult(const WorkResult& result);
   void CloseSendFileFd(WorkResult& result);
   void SendServiceUnavailable(spConnection conn, const std::string& reason);
-  void RecordPhase3Metrics(const WorkResult& result, long io_flush_ms, long pipeline_ms);
+  void RecordPhase3Metrics(const WorkResult& result, long io_flush_us, long pipeline_us);
   void MaybeLogPhase3Snapshot();
-  void PhaseParseAndRoute(std::weak_ptr<Connection> weak_conn,
-                           std::shared_ptr<ConnectionWorkContext> ctx,
-                           PendingChunk& chunk,
-                           std::shared_ptr<RequestContext> req_ctx);
+  // 生成 Prometheus 文本格式的指标；只读各组件的原子计数与分片直方图，不占用请求路径上的锁
+  std::string RenderMetrics() const;
+  bool PhaseParseAndRoute(const spConnection& conn,
+                          std::shared_ptr<ConnectionWorkContext> ctx,
+                          std::shared_ptr<RequestContext> req_ctx);
+  void PhaseBusiness(std::shared_ptr<ConnectionWorkContext> ctx,
+                     std::shared_ptr<RequestContext> req_ctx);
+  void DispatchToExecutor(const spConnection& conn,
+                          std::shared_ptr<ConnectionWorkContext> ctx,
+                          std::shared_ptr<RequestContext> req_ctx);
+  ThreadPool* FindExecutor(const std::string& name);
+  AdmissionController* FindAdmission(const std::string& name);
+  // IO 线程：准入控制拒绝的请求直接以预序列化的 503 响应结束，仍经由重排环按序回写
+  void ShedRequest(std::weak_ptr<Connection> weak_conn,
+                   std::shared_ptr<ConnectionWorkContext> ctx,
+                   std::shared_ptr<RequestContext> req_ctx);
   void PhaseIoOperation(std::weak_ptr<Connection> weak_conn,
                          std::shared_ptr<ConnectionWorkContext> ctx,
                          std::shared_ptr<RequestContext> req_ctx);
   void PhaseSerializeAndSend(std::weak_ptr<Connection> weak_conn,
                               std::shared_ptr<ConnectionWorkContext> ctx,
-                              PendingChunk& chunk,
                               std::shared_ptr<RequestContext> req_ctx);
   
   /**
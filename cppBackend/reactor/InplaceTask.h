@@ -0,0 +1,110 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * InplaceTask：只可移动、无堆分配的可调用对象包装
+ * 与 std::function 的区别：
+ *  - 可调用对象直接构造在内联缓冲区中，容量由模板参数 Capacity 指定，超出容量在编译期报错
+ *  - 只要求可调用对象可移动，因此可以捕获 unique_ptr 等只可移动的对象
+ * 用于 ThreadPool 任务与 EventLoop 跨线程任务，避免每次投递都触发一次 new/delete
+ */
+template <typename Signature, size_t Capacity = 64>
+class InplaceTask;
+
+template <typename R, typename... Args, size_t Capacity>
+class InplaceTask<R(Args...), Capacity> {
+public:
+  static constexpr size_t kCapacity = Capacity;
+
+  InplaceTask() noexcept = default;
+  InplaceTask(std::nullptr_t) noexcept {}
+
+  template <typename F,
+            typename Fn = std::decay_t<F>,
+            typename = std::enable_if_t<!std::is_same<Fn, InplaceTask>::value &&
+                                        std::is_invocable_r<R, Fn&, Args...>::value>>
+  InplaceTask(F&& f) {
+    static_assert(sizeof(Fn) <= Capacity, "可调用对象超出 InplaceTask 内联容量，请增大 Capacity");
+    static_assert(alignof(Fn) <= alignof(std::max_align_t), "可调用对象对齐要求过高");
+    static_assert(std::is_nothrow_move_constructible<Fn>::value, "可调用对象必须可无异常移动");
+    ::new (static_cast<void*>(storage_)) Fn(std::forward<F>(f));
+    ops_ = &OpsFor<Fn>::kOps;
+  }
+
+  InplaceTask(InplaceTask&& other) noexcept {
+    moveFrom(other);
+  }
+
+  InplaceTask& operator=(InplaceTask&& other) noexcept {
+    if (this != &other) {
+      reset();
+      moveFrom(other);
+    }
+    return *this;
+  }
+
+  InplaceTask& operator=(std::nullptr_t) noexcept {
+    reset();
+    return *this;
+  }
+
+  InplaceTask(const InplaceTask&) = delete;
+  InplaceTask& operator=(const InplaceTask&) = delete;
+
+  ~InplaceTask() { reset(); }
+
+  // 与 std::function 一致：调用空任务（默认构造或已被移走）抛出 std::bad_function_call
+  R operator()(Args... args) {
+    if (!ops_) {
+      throw std::bad_function_call();
+    }
+    return ops_->invoke(storage_, std::forward<Args>(args)...);
+  }
+
+  explicit operator bool() const noexcept { return ops_ != nullptr; }
+
+  void reset() noexcept {
+    if (ops_) {
+      ops_->destroy(storage_);
+      ops_ = nullptr;
+    }
+  }
+
+private:
+  struct Ops {
+    R (*invoke)(void* self, Args&&... args);
+    void (*move)(void* dst, void* src) noexcept;   // 移动构造到 dst 并析构 src
+    void (*destroy)(void* self) noexcept;
+  };
+
+  template <typename Fn>
+  struct OpsFor {
+    static R Invoke(void* self, Args&&... args) {
+      return (*static_cast<Fn*>(self))(std::forward<Args>(args)...);
+    }
+    static void Move(void* dst, void* src) noexcept {
+      Fn* s = static_cast<Fn*>(src);
+      ::new (dst) Fn(std::move(*s));
+      s->~Fn();
+    }
+    static void Destroy(void* self) noexcept {
+      static_cast<Fn*>(self)->~Fn();
+    }
+    static constexpr Ops kOps{&Invoke, &Move, &Destroy};
+  };
+
+  void moveFrom(InplaceTask& other) noexcept {
+    if (other.ops_) {
+      other.ops_->move(storage_, other.storage_);
+      ops_ = other.ops_;
+      other.ops_ = nullptr;
+    }
+  }
+
+  alignas(std::max_align_t) unsigned char storage_[Capacity];
+  const Ops* ops_{nullptr};
+};
@@ -0,0 +1,202 @@
+#include "LatencyHistogram.h"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+constexpr size_t kStageCount = static_cast<size_t>(LatencyStage::Count);
+
+std::atomic<uint64_t> g_next_recorder_id{1};
+
+uint32_t HighestBit(uint64_t v) {
+  return 63u - static_cast<uint32_t>(__builtin_clzll(v));
+}
+}  // namespace
+
+const char* LatencyStageName(LatencyStage stage) {
+  switch (stage) {
+    case LatencyStage::QueueWait:  return "queue_wait";
+    case LatencyStage::ParseRoute: return "parse_route";
+    case LatencyStage::Business:   return "business";
+    case LatencyStage::Serialize:  return "serialize";
+    case LatencyStage::IoFlush:    return "io_flush";
+    case LatencyStage::Total:      return "total";
+    default:                       return "unknown";
+  }
+}
+
+size_t LatencyHistogram::BucketIndex(uint64_t value_us) {
+  if (value_us < kLinearLimit) {
+    return static_cast<size_t>(value_us);
+  }
+  uint32_t msb = HighestBit(value_us);
+  if (msb >= kMaxMagnitude) {
+    return kBucketCount - 1;
+  }
+  // msb 之后取 kSubBucketBits 位作为子桶号
+  uint64_t sub = (value_us >> (msb - kSubBucketBits)) & ((1u << kSubBucketBits) - 1);
+  return static_cast<size_t>(kLinearLimit +
+                             (msb - kSubBucketBits - 1) * (1u << kSubBucketBits) + sub);
+}
+
+uint64_t LatencyHistogram::BucketUpperBound(size_t index) {
+  if (index < kLinearLimit) {
+    return index;
+  }
+  size_t rel = index - kLinearLimit;
+  uint32_t msb = static_cast<uint32_t>(rel >> kSubBucketBits) + kSubBucketBits + 1;
+  uint64_t sub = rel & ((1u << kSubBucketBits) - 1);
+  uint64_t width = 1ull << (msb - kSubBucketBits);
+  return (1ull << msb) + sub * width + (width - 1);
+}
+
+void LatencyHistogram::Add(size_t index, uint64_t count) {
+  if (index >= kBucketCount) index = kBucketCount - 1;
+  counts_[index] += count;
+  count_ += count;
+}
+
+void LatencyHistogram::Merge(const LatencyHistogram& other) {
+  for (size_t i = 0; i < kBucketCount; i++) {
+    counts_[i] += other.counts_[i];
+  }
+  count_ += other.count_;
+}
+
+uint64_t LatencyHistogram::Max() const {
+  for (size_t i = kBucketCount; i > 0; i--) {
+    if (counts_[i - 1] != 0) return BucketUpperBound(i - 1);
+  }
+  return 0;
+}
+
+uint64_t LatencyHistogram::Percentile(double q) const {
+  if (count_ == 0) return 0;
+  q = std::min(1.0, std::max(0.0, q));
+  uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(count_) + 0.5);
+  if (rank == 0) rank = 1;
+  uint64_t seen = 0;
+  for (size_t i = 0; i < kBucketCount; i++) {
+    seen += counts_[i];
+    if (seen >= rank) return BucketUpperBound(i);
+  }
+  return Max();
+}
+
+// 单个线程的分片：只有所属线程写入，读取方用 relaxed 读，计数可能略有滞后但不会撕裂
+struct LatencyRecorder::Shard {
+  struct Bucket {
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> errors{0};
+    std::atomic<uint64_t> sendfile_requests{0};
+    std::atomic<uint64_t> sendfile_bytes{0};
+    std::atomic<uint64_t> stage_sum_us[kStageCount] = {};
+    std::atomic<uint64_t> counts[kStageCount][LatencyHistogram::kBucketCount] = {};
+  };
+
+  explicit Shard(size_t bucket_count)
+    : owner(std::this_thread::get_id()), buckets(new Bucket[bucket_count]) {}
+
+  const std::thread::id owner;  // 线程 id 被复用时新线程沿用已退出线程的分片，仍是单写者
+  std::unique_ptr<Bucket[]> buckets;
+};
+
+namespace {
+// 单写者自增：不需要原子读改写
+inline void Bump(std::atomic<uint64_t>& a, uint64_t n) {
+  a.store(a.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// 每线程缓存最近使用的几个实例的分片，按 id 匹配，满了轮换覆盖；
+// 未命中时先到实例里找本线程已注册的分片，因此覆盖掉的条目不会导致重复注册
+constexpr size_t kShardCacheWays = 4;
+
+struct LocalShardCache {
+  struct Entry {
+    uint64_t owner_id{0};
+    void* shard{nullptr};
+  };
+  Entry entries[kShardCacheWays];
+  size_t victim{0};
+};
+thread_local LocalShardCache tls_shard_cache;
+}  // namespace
+
+LatencyRecorder::LatencyRecorder(size_t bucket_count)
+  : bucket_count_(bucket_count),
+    id_(g_next_recorder_id.fetch_add(1, std::memory_order_relaxed)) {}
+
+LatencyRecorder::~LatencyRecorder() = default;
+
+LatencyRecorder::Shard* LatencyRecorder::LocalShard() {
+  LocalShardCache& cache = tls_shard_cache;
+  for (const auto& entry : cache.entries) {
+    if (entry.owner_id == id_) {
+      return static_cast<Shard*>(entry.shard);
+    }
+  }
+  Shard* raw = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(shards_mutex_);
+    const std::thread::id self = std::this_thread::get_id();
+    for (const auto& shard : shards_) {
+      if (shard->owner == self) {
+        raw = shard.get();
+        break;
+      }
+    }
+    if (!raw) {
+      shards_.push_back(std::make_unique<Shard>(bucket_count_));
+      raw = shards_.back().get();
+    }
+  }
+  LocalShardCache::Entry& slot = cache.entries[cache.victim];
+  cache.victim = (cache.victim + 1) % kShardCacheWays;
+  slot.owner_id = id_;
+  slot.shard = raw;
+  return raw;
+}
+
+size_t LatencyRecorder::shard_count() const {
+  std::lock_guard<std::mutex> lock(shards_mutex_);
+  return shards_.size();
+}
+
+void LatencyRecorder::Record(size_t bucket, const Sample& sample) {
+  if (bucket >= bucket_count_) return;
+  Shard::Bucket& b = LocalShard()->buckets[bucket];
+  Bump(b.requests, 1);
+  if (sample.error) Bump(b.errors, 1);
+  if (sample.sendfile) {
+    Bump(b.sendfile_requests, 1);
+    Bump(b.sendfile_bytes, sample.sendfile_bytes);
+  }
+  for (size_t s = 0; s < kStageCount; s++) {
+    const uint64_t us = sample.stage_us[s];
+    Bump(b.stage_sum_us[s], us);
+    Bump(b.counts[s][LatencyHistogram::BucketIndex(us)], 1);
+  }
+}
+
+std::vector<LatencyRecorder::BucketSnapshot> LatencyRecorder::Snapshot() const {
+  std::vector<BucketSnapshot> out(bucket_count_);
+  std::lock_guard<std::mutex> lock(shards_mutex_);
+  for (const auto& shard : shards_) {
+    for (size_t i = 0; i < bucket_count_; i++) {
+      const Shard::Bucket& b = shard->buckets[i];
+      BucketSnapshot& snap = out[i];
+      snap.requests += b.requests.load(std::memory_order_relaxed);
+      snap.errors += b.errors.load(std::memory_order_relaxed);
+      snap.sendfile_requests += b.sendfile_requests.load(std::memory_order_relaxed);
+      snap.sendfile_bytes += b.sendfile_bytes.load(std::memory_order_relaxed);
+      for (size_t s = 0; s < kStageCount; s++) {
+        snap.stage_sum_us[s] += b.stage_sum_us[s].load(std::memory_order_relaxed);
+        for (size_t k = 0; k < LatencyHistogram::kBucketCount; k++) {
+          uint64_t c = b.counts[s][k].load(std::memory_order_relaxed);
+          if (c != 0) snap.stages[s].Add(k, c);
+        }
+      }
+    }
+  }
+  return out;
+}
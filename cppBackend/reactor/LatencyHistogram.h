@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// 请求链路中统计耗时的阶段
+enum class LatencyStage : uint8_t {
+  QueueWait = 0,   // 分发到执行池后的排队等待
+  ParseRoute,      // 解析 + 路由匹配（从开始解析到开始序列化）
+  Business,        // 处理器执行
+  Serialize,       // 响应序列化
+  IoFlush,         // 结果投递回 IO 线程到写入输出缓冲
+  Total,           // 整条流水线
+  Count
+};
+
+const char* LatencyStageName(LatencyStage stage);
+
+/**
+ * LatencyHistogram：HDR 风格的对数-线性直方图（微秒）
+ * [0, 32) 逐值计数；之后每个 2 的幂区间再均分为 16 个子桶，相对误差不超过 1/16
+ * 上限约 71 分钟，超出的值计入最后一个桶
+ * 本类不是线程安全的，用于合并后的快照；并发写入见 LatencyRecorder
+ */
+class LatencyHistogram {
+public:
+  static constexpr uint32_t kSubBucketBits = 4;                       // 每个 2 的幂区间 16 个子桶
+  static constexpr uint64_t kLinearLimit = 1ull << (kSubBucketBits + 1);  // 32 以下逐值计数
+  static constexpr uint32_t kMaxMagnitude = 32;                       // 最大记录 2^32 微秒
+  static constexpr size_t kBucketCount =
+      kLinearLimit + (kMaxMagnitude - kSubBucketBits - 1) * (1u << kSubBucketBits);
+
+  static size_t BucketIndex(uint64_t value_us);
+  // 桶内最大值，用于百分位的保守估计
+  static uint64_t BucketUpperBound(size_t index);
+
+  void Add(size_t index, uint64_t count);
+  void Record(uint64_t value_us) { Add(BucketIndex(value_us), 1); }
+  void Merge(const LatencyHistogram& other);
+
+  uint64_t Count() const { return count_; }
+  uint64_t CountAt(size_t index) const { return index < kBucketCount ? counts_[index] : 0; }
+  uint64_t Max() const;
+  // q 取值 [0, 1]，如 0.99；无样本时返回 0
+  uint64_t Percentile(double q) const;
+
+private:
+  uint64_t counts_[kBucketCount] = {};
+  uint64_t count_{0};
+};
+
+/**
+ * LatencyRecorder：按线程分片的各路由桶、各阶段耗时直方图
+ * 每个记录线程首次记录时注册一个分片，此后只写自己的分片（单写者，relaxed 原子存取），
+ * 热路径无锁、无哈希；Snapshot() 读取并合并所有分片
+ * 线程本地缓存按实例 id 保存最近使用的几个分片，多个实例交替记录时仍各自只有一个分片
+ * 线程退出后分片保留，其数据仍计入快照
+ */
+class LatencyRecorder {
+public:
+  struct Sample {
+    uint64_t stage_us[static_cast<size_t>(LatencyStage::Count)] = {};
+    bool error{false};
+    bool sendfile{false};
+    uint64_t sendfile_bytes{0};
+  };
+
+  struct BucketSnapshot {
+    uint64_t requests{0};
+    uint64_t errors{0};
+    uint64_t sendfile_requests{0};
+    uint64_t sendfile_bytes{0};
+    uint64_t stage_sum_us[static_cast<size_t>(LatencyStage::Count)] = {};
+    LatencyHistogram stages[static_cast<size_t>(LatencyStage::Count)];
+  };
+
+  explicit LatencyRecorder(size_t bucket_count);
+  ~LatencyRecorder();
+
+  LatencyRecorder(const LatencyRecorder&) = delete;
+  LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+
+  void Record(size_t bucket, const Sample& sample);
+
+  // 合并所有分片；结果按路由桶下标排列
+  std::vector<BucketSnapshot> Snapshot() const;
+
+  size_t bucket_count() const { return bucket_count_; }
+  size_t shard_count() const;
+
+private:
+  struct Shard;
+  Shard* LocalShard();
+
+  const size_t bucket_count_;
+  const uint64_t id_;                            // 区分实例，避免线程本地缓存命中已销毁的同址实例
+  mutable std::mutex shards_mutex_;              // 只在注册分片与读取快照时加锁
+  std::vector<std::unique_ptr<Shard>> shards_;
+};
@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+/**
+ * MpmcQueue：有界多生产者/多消费者无锁队列（Dmitry Vyukov 的序号槽位算法）
+ * 每个槽位带一个序号，生产者/消费者通过 CAS 推进位置后独占该槽位，
+ * 因此元素可以是非平凡类型（如 Task），直接在槽位内移动构造，入队出队都不分配内存
+ * 容量固定（向上取整为 2 的幂）
+ */
+template <typename T>
+class MpmcQueue {
+public:
+  explicit MpmcQueue(size_t capacity) {
+    size_t cap = 2;
+    while (cap < capacity) cap <<= 1;
+    mask_ = cap - 1;
+    cells_ = std::make_unique<Cell[]>(cap);
+    for (size_t i = 0; i < cap; i++) {
+      cells_[i].seq.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  MpmcQueue(const MpmcQueue&) = delete;
+  MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+  // 入队成功才会移走 value；队列满时返回 false，value 保持不变
+  bool push(T& value) {
+    Cell* cell = nullptr;
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->seq.load(std::memory_order_acquire);
+      intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+      if (dif == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (dif < 0) {
+        return false;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    cell->data = std::move(value);
+    cell->seq.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  bool pop(T& out) {
+    Cell* cell = nullptr;
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      cell = &cells_[pos & mask_];
+      size_t seq = cell->seq.load(std::memory_order_acquire);
+      intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+      if (dif == 0) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (dif < 0) {
+        return false;
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+    out = std::move(cell->data);
+    cell->data = T();   // 立即释放槽位中残留对象持有的资源
+    cell->seq.store(pos + mask_ + 1, std::memory_order_release);
+    return true;
+  }
+
+  // 近似长度，仅用于统计与空闲判断
+  size_t size_approx() const {
+    size_t e = enqueue_pos_.load(std::memory_order_relaxed);
+    size_t d = dequeue_pos_.load(std::memory_order_relaxed);
+    return e > d ? e - d : 0;
+  }
+
+  bool empty_approx() const { return size_approx() == 0; }
+
+  size_t capacity() const { return mask_ + 1; }
+
+private:
+  struct Cell {
+    std::atomic<size_t> seq{0};
+    T data;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_{0};
+  alignas(64) std::atomic<size_t> enqueue_pos_{0};
+  alignas(64) std::atomic<size_t> dequeue_pos_{0};
+};
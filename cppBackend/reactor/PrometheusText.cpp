@@ -0,0 +1,107 @@
+#include "PrometheusText.h"
+
+#include <cstdio>
+
+namespace {
+std::string FormatDouble(double v) {
+  char buf[32];
+  std::snprintf(buf, sizeof(buf), "%.9g", v);
+  return buf;
+}
+}  // namespace
+
+void PrometheusText::Family(const std::string& name, const char* type, const char* help) {
+  out_ += "# HELP ";
+  out_ += name;
+  out_ += ' ';
+  out_ += help;
+  out_ += "\n# TYPE ";
+  out_ += name;
+  out_ += ' ';
+  out_ += type;
+  out_ += '\n';
+}
+
+void PrometheusText::Sample(const std::string& name, const Labels& labels, uint64_t value) {
+  AppendSeries(name, labels);
+  out_ += ' ';
+  out_ += std::to_string(value);
+  out_ += '\n';
+}
+
+void PrometheusText::Sample(const std::string& name, const Labels& labels, double value) {
+  AppendSeries(name, labels);
+  out_ += ' ';
+  out_ += FormatDouble(value);
+  out_ += '\n';
+}
+
+void PrometheusText::Histogram(const std::string& name, const Labels& labels,
+                               const LatencyHistogram& hist, uint64_t sum_us,
+                               const std::vector<uint64_t>& bounds_us) {
+  const std::string bucket_name = name + "_bucket";
+  // 源桶与边界都升序，单次遍历即可得到所有累计计数
+  uint64_t cumulative = 0;
+  size_t index = 0;
+  for (uint64_t bound : bounds_us) {
+    const size_t last = LatencyHistogram::BucketIndex(bound);
+    for (; index <= last && index < LatencyHistogram::kBucketCount; index++) {
+      cumulative += hist.CountAt(index);
+    }
+    AppendSeries(bucket_name, labels, "le", FormatDouble(static_cast<double>(bound) / 1e6));
+    out_ += ' ';
+    out_ += std::to_string(cumulative);
+    out_ += '\n';
+  }
+  AppendSeries(bucket_name, labels, "le", "+Inf");
+  out_ += ' ';
+  out_ += std::to_string(hist.Count());
+  out_ += '\n';
+  Sample(name + "_sum", labels, static_cast<double>(sum_us) / 1e6);
+  Sample(name + "_count", labels, hist.Count());
+}
+
+const std::vector<uint64_t>& PrometheusText::DefaultLatencyBoundsUs() {
+  static const std::vector<uint64_t> bounds = {
+    100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000,
+    100000, 250000, 500000, 1000000, 2500000, 5000000, 10000000,
+  };
+  return bounds;
+}
+
+void PrometheusText::AppendSeries(const std::string& name, const Labels& labels,
+                                  const char* extra_key, const std::string& extra_value) {
+  out_ += name;
+  if (labels.empty() && !extra_key) {
+    return;
+  }
+  out_ += '{';
+  bool first = true;
+  for (const auto& [key, value] : labels) {
+    if (!first) out_ += ',';
+    first = false;
+    out_ += key;
+    out_ += "=\"";
+    AppendEscaped(value);
+    out_ += '"';
+  }
+  if (extra_key) {
+    if (!first) out_ += ',';
+    out_ += extra_key;
+    out_ += "=\"";
+    AppendEscaped(extra_value);
+    out_ += '"';
+  }
+  out_ += '}';
+}
+
+void PrometheusText::AppendEscaped(const std::string& value) {
+  for (char c : value) {
+    switch (c) {
+      case '\\': out_ += "\\\\"; break;
+      case '"':  out_ += "\\\""; break;
+      case '\n': out_ += "\\n"; break;
+      default:   out_ += c; break;
+    }
+  }
+}
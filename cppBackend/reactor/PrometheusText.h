@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "LatencyHistogram.h"
+
+/**
+ * PrometheusText：Prometheus 文本暴露格式（text/plain; version=0.0.4）的输出器
+ * 每个指标族先写 HELP/TYPE 再写样本，输出长度只与指标数有关，与请求量无关
+ * 不是线程安全的，每次抓取构造一个实例
+ */
+class PrometheusText {
+public:
+  using Labels = std::vector<std::pair<std::string, std::string>>;
+
+  static constexpr const char* kContentType = "text/plain; version=0.0.4; charset=utf-8";
+
+  // type 取 "counter" / "gauge" / "histogram"
+  void Family(const std::string& name, const char* type, const char* help);
+  void Sample(const std::string& name, const Labels& labels, uint64_t value);
+  void Sample(const std::string& name, const Labels& labels, double value);
+
+  // 把微秒直方图按 bounds_us（升序）聚合为累计桶，以秒为单位输出 _bucket/_sum/_count
+  // 源桶相对误差不超过 1/16，落在某个源桶内的边界按该桶上界归属
+  void Histogram(const std::string& name, const Labels& labels,
+                 const LatencyHistogram& hist, uint64_t sum_us,
+                 const std::vector<uint64_t>& bounds_us);
+
+  // 100us ~ 10s 的常用延迟边界
+  static const std::vector<uint64_t>& DefaultLatencyBoundsUs();
+
+  const std::string& str() const { return out_; }
+  std::string Take() { return std::move(out_); }
+
+private:
+  void AppendSeries(const std::string& name, const Labels& labels,
+                    const char* extra_key = nullptr, const std::string& extra_value = std::string());
+  void AppendEscaped(const std::string& value);
+
+  std::string out_;
+};
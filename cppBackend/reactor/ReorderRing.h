@@ -0,0 +1,108 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * ReorderRing：按序列号索引的响应重排环
+ * 流水线请求的处理结果可能乱序完成，结果按 seq & mask 直接落入槽位，
+ * 队头（applied + 1）就绪时依次弹出，替代 std::map 的查找/插入/删除
+ *  - 只由连接所属的 IO 线程访问，不加锁
+ *  - 窗口大小取连接允许的流水线深度（向上取整为 2 的幂）；
+ *    超出窗口的结果（处理器在其他执行池中长时间阻塞时可能出现）会使环翻倍扩容，不会丢失
+ */
+template <typename T>
+class ReorderRing {
+public:
+  explicit ReorderRing(size_t window = 16) { Reset(window); }
+
+  ReorderRing(const ReorderRing&) = delete;
+  ReorderRing& operator=(const ReorderRing&) = delete;
+
+  // 放入序号为 seq 的结果；seq 已应用过时返回 false，value 保持不变
+  bool Put(uint64_t seq, T& value) {
+    if (seq <= applied_) {
+      return false;
+    }
+    while (seq - applied_ > slots_.size()) {
+      Grow();
+    }
+    Slot& slot = slots_[seq & mask_];
+    slot.value = std::move(value);
+    slot.occupied = true;
+    count_++;
+    return true;
+  }
+
+  // 队头结果就绪时弹出并推进 applied
+  bool PopReady(T& out) {
+    Slot& slot = slots_[(applied_ + 1) & mask_];
+    if (!slot.occupied) {
+      return false;
+    }
+    out = std::move(slot.value);
+    slot.value = T();
+    slot.occupied = false;
+    count_--;
+    applied_++;
+    return true;
+  }
+
+  // 丢弃所有暂存结果，on_drop 用于释放结果持有的资源（如 sendfile fd）；applied 不变
+  template <typename F>
+  void Clear(F&& on_drop) {
+    if (count_ == 0) return;
+    for (auto& slot : slots_) {
+      if (slot.occupied) {
+        on_drop(slot.value);
+        slot.value = T();
+        slot.occupied = false;
+      }
+    }
+    count_ = 0;
+  }
+
+  // 清空并重置序号与窗口
+  void Reset(size_t window) {
+    size_t cap = 2;
+    while (cap < window) cap <<= 1;
+    slots_.clear();
+    slots_.resize(cap);
+    mask_ = cap - 1;
+    applied_ = 0;
+    count_ = 0;
+  }
+
+  // 队头结果是否已就绪
+  bool HeadReady() const { return slots_[(applied_ + 1) & mask_].occupied; }
+
+  uint64_t applied() const { return applied_; }
+  size_t size() const { return count_; }
+  size_t window() const { return slots_.size(); }
+
+private:
+  struct Slot {
+    bool occupied{false};
+    T value;
+  };
+
+  void Grow() {
+    std::vector<Slot> bigger(slots_.size() * 2);
+    const uint64_t new_mask = bigger.size() - 1;
+    for (uint64_t seq = applied_ + 1; seq <= applied_ + slots_.size(); seq++) {
+      Slot& old_slot = slots_[seq & mask_];
+      if (old_slot.occupied) {
+        bigger[seq & new_mask].value = std::move(old_slot.value);
+        bigger[seq & new_mask].occupied = true;
+      }
+    }
+    slots_.swap(bigger);
+    mask_ = new_mask;
+  }
+
+  std::vector<Slot> slots_;
+  uint64_t mask_{0};
+  uint64_t applied_{0};   // 最后一个已应用的序号
+  size_t count_{0};       // 暂存的结果数
+};
@@ -10,22 +10,38 @@ bool IsDownloadRoute(const std::string& path) {
   return StartsWith(path, "/download/");
 }
 
-std::string ClassifyRouteBucket(const std::string& path) {
-  if (path.empty() || path == "/") return "page";
+RouteBucket ClassifyRouteBucketId(const std::string& path) {
+  if (path.empty() || path == "/") return RouteBucket::Page;
 
   if (path == "/login" || path == "/register" || path == "/refresh-token") {
-    return "auth";
+    return RouteBucket::Auth;
   }
-  if (StartsWith(path, "/api/")) return "api";
-  if (IsDownloadRoute(path)) return "download";
+  if (StartsWith(path, "/api/")) return RouteBucket::Api;
+  if (IsDownloadRoute(path)) return RouteBucket::Download;
   if (StartsWith(path, "/assets/") || StartsWith(path, "/images/") ||
       StartsWith(path, "/video/") || StartsWith(path, "/uploads/")) {
-    return "static";
+    return RouteBucket::Static;
   }
   if (path == "/index.html" || path == "/welcome.html" || path == "/login.html" ||
       path == "/register.html" || path == "/picture.html" || path == "/video.html") {
-    return "page";
+    return RouteBucket::Page;
+  }
+  if (StartsWith(path, "/favicon")) return RouteBucket::Static;
+  return RouteBucket::Other;
+}
+
+const char* RouteBucketName(RouteBucket bucket) {
+  switch (bucket) {
+    case RouteBucket::Page:       return "page";
+    case RouteBucket::Auth:       return "auth";
+    case RouteBucket::Api:        return "api";
+    case RouteBucket::Download:   return "download";
+    case RouteBucket::Static:     return "static";
+    case RouteBucket::ParseError: return "parse_error";
+    default:                      return "other";
   }
-  if (StartsWith(path, "/favicon")) return "static";
-  return "other";
+}
+
+std::string ClassifyRouteBucket(const std::string& path) {
+  return RouteBucketName(ClassifyRouteBucketId(path));
 }
@@ -1,6 +1,24 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 
+// 指标统计使用的路由桶，数量固定，可直接作为数组下标
+enum class RouteBucket : uint8_t {
+  Page = 0,
+  Auth,
+  Api,
+  Download,
+  Static,
+  Other,
+  ParseError,
+  Count
+};
+
+constexpr size_t kRouteBucketCount = static_cast<size_t>(RouteBucket::Count);
+
+RouteBucket ClassifyRouteBucketId(const std::string& path);
+const char* RouteBucketName(RouteBucket bucket);
 std::string ClassifyRouteBucket(const std::string& path);
 bool IsDownloadRoute(const std::string& path);
@@ -1,20 +1,61 @@
 #include"ThreadPool.h"
 #include<chrono>
 #include<cstdlib>
+#include<linux/futex.h>
+#include<climits>
+#include<algorithm>
+#include<ctime>
 
+thread_local ThreadPool* ThreadPool::tls_pool_ = nullptr;
 thread_local int ThreadPool::tls_worker_id_ = -1;
+thread_local const std::atomic_bool* ThreadPool::tls_current_cancel_ = nullptr;
+
+namespace {
+void FutexWait(std::atomic<int32_t>* addr, int32_t expected, const timespec* timeout = nullptr) {
+  ::syscall(SYS_futex, reinterpret_cast<int32_t*>(addr), FUTEX_WAIT_PRIVATE, expected, timeout, nullptr, 0);
+}
+
+void FutexWake(std::atomic<int32_t>* addr, int count) {
+  ::syscall(SYS_futex, reinterpret_cast<int32_t*>(addr), FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+uint64_t NowNs() {
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+}  // namespace
+
+namespace {
+ThreadPool::Options FixedOptions(size_t threadnum, size_t max_queue_size) {
+  ThreadPool::Options opts;
+  opts.min_threads = threadnum;
+  opts.max_threads = threadnum;
+  opts.max_queue_size = max_queue_size;
+  return opts;
+}
+}  // namespace
 
 ThreadPool::ThreadPool(size_t threadnum, const std::string& threadtype, size_t max_queue_size)
-  : stop_(false), threadtype_(threadtype), max_queue_size_(max_queue_size)
+  : ThreadPool(threadtype, FixedOptions(threadnum, max_queue_size)) {}
+
+ThreadPool::ThreadPool(const std::string& threadtype, const Options& opts)
+  : stop_(false), threadtype_(threadtype), max_queue_size_(opts.max_queue_size),
+    inject_q_(opts.max_queue_size),   // 注入队列容量不小于任务上限，准入成功的任务总能入队
+    opts_(opts)
 {
-  workers_.reserve(threadnum);
-  for (size_t i = 0; i < threadnum; i++) {
+  opts_.max_threads = std::max(opts_.max_threads, opts_.min_threads);
+  elastic_ = opts_.max_threads > opts_.min_threads;
+
+  workers_.reserve(opts_.max_threads);
+  for (size_t i = 0; i < opts_.max_threads; i++) {
     workers_.emplace_back(std::make_unique<Worker>());
   }
-  for (size_t i = 0; i < threadnum; i++) {
-    threads_.emplace_back([this, i] {
-      workerLoop(static_cast<int>(i));
-    });
+  threads_.resize(opts_.max_threads);
+  for (size_t i = 0; i < opts_.min_threads; i++) {
+    startWorker(i);
+  }
+  if (elastic_) {
+    monitor_ = std::thread([this] { monitorLoop(); });
   }
 }
 
@@ -29,21 +70,26 @@ bool ThreadPool::addTask(Task t) {
     return false;
   }
 
+  // 弹性线程池记录入队时间，用于计算排队等待
+  if (elastic_) {
+    t.enqueue_ns = NowNs();
+  }
+
+  // worker 线程提交的任务优先压入自己的本地队列（只有 owner 线程可以压入）
   int wid = tls_worker_id_;
-  if (wid >= 0 && static_cast<size_t>(wid) < workers_.size()) {
-    auto& w = *workers_[static_cast<size_t>(wid)];
-    {
-      std::lock_guard<std::mutex> lk(w.m);
-      w.dq.push_back(std::move(t));
-    }
-  } else {
-    {
-      std::lock_guard<std::mutex> lk(inject_m_);
-      inject_q_.push_back(std::move(t));
+  if (tls_pool_ == this && wid >= 0 && static_cast<size_t>(wid) < workers_.size()) {
+    if (pushLocal(*workers_[static_cast<size_t>(wid)], t)) {
+      notifyOne();
+      return true;
     }
   }
 
-  cv_.notify_one();
+  if (!inject_q_.push(t)) {
+    pending_tasks_.fetch_sub(1, std::memory_order_acq_rel);
+    return false;
+  }
+
+  notifyOne();
   return true;
 }
 
@@ -52,39 +98,38 @@ void ThreadPool::addtask(std::function<void()> task) {
   addTask(std::move(t));
 }
 
-bool ThreadPool::tryPopLocal(int wid, Task& out) {
-  auto& w = *workers_[static_cast<size_t>(wid)];
-  std::lock_guard<std::mutex> lk(w.m);
-  if (w.dq.empty()) return false;
-  out = std::move(w.dq.front());
-  w.dq.pop_front();
+// owner 线程：把任务移入与下一个队列下标对应的槽位后压入本地队列；
+// 槽位仍被占用（队列已满，或窃取者尚未移出上一轮的任务）时返回 false，t 保持不变
+bool ThreadPool::pushLocal(Worker& w, Task& t) {
+  LocalSlot* slot = &w.slots[w.dq.next_push_index()];
+  if (slot->busy.load(std::memory_order_acquire)) {
+    return false;
+  }
+  slot->task = std::move(t);
+  slot->busy.store(true, std::memory_order_relaxed);
+  if (!w.dq.push(slot)) {
+    t = std::move(slot->task);
+    slot->busy.store(false, std::memory_order_relaxed);
+    return false;
+  }
   return true;
 }
 
-size_t ThreadPool::drainInjectToLocal(int wid, size_t max_n) {
-  if (max_n == 0) return 0;
-
-  Task tmp;
-  size_t count = 0;
+// 取得槽位所有权后移出任务并释放槽位，release 保证 owner 复用槽位时移出已完成
+void ThreadPool::takeSlot(LocalSlot* slot, Task& out) {
+  out = std::move(slot->task);
+  slot->busy.store(false, std::memory_order_release);
+}
 
-  {
-    std::lock_guard<std::mutex> lk(inject_m_);
-    while (count < max_n && !inject_q_.empty()) {
-      if (count == 0) {
-        auto& w = *workers_[static_cast<size_t>(wid)];
-        std::lock_guard<std::mutex> lk2(w.m);
-        size_t batch = std::min(max_n, inject_q_.size());
-        for (size_t i = 0; i < batch; i++) {
-          w.dq.push_back(std::move(inject_q_.front()));
-          inject_q_.pop_front();
-        }
-        count = batch;
-      }
-      break;
-    }
-  }
+bool ThreadPool::tryPopLocal(int wid, Task& out) {
+  LocalSlot* slot = nullptr;
+  if (!workers_[static_cast<size_t>(wid)]->dq.pop(slot)) return false;
+  takeSlot(slot, out);
+  return true;
+}
 
-  return count;
+bool ThreadPool::tryPopInject(Task& out) {
+  return inject_q_.pop(out);
 }
 
 bool ThreadPool::trySteal(int self_wid, Task& out) {
@@ -95,95 +140,335 @@ bool ThreadPool::trySteal(int self_wid, Task& out) {
       reinterpret_cast<uintptr_t>(&out) ^ static_cast<uintptr_t>(std::hash<std::thread::id>{}(std::this_thread::get_id())));
 
   size_t start = static_cast<size_t>(rand_r(&rng_seed)) % n;
-  for (size_t i = 1; i < n; i++) {
+  for (size_t i = 0; i < n; i++) {
     size_t victim = (start + i) % n;
     if (victim == static_cast<size_t>(self_wid)) continue;
 
-    auto& w = *workers_[victim];
-    std::lock_guard<std::mutex> lk(w.m);
-    if (!w.dq.empty()) {
-      out = std::move(w.dq.back());
-      w.dq.pop_back();
+    LocalSlot* slot = nullptr;
+    if (workers_[victim]->dq.steal(slot)) {
+      takeSlot(slot, out);
+      workers_[static_cast<size_t>(self_wid)]->steals.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ThreadPool::hasVisibleWork() const {
+  if (!inject_q_.empty_approx()) return true;
+  for (const auto& w : workers_) {
+    if (!w->dq.empty_approx()) return true;
+  }
+  return false;
+}
+
+// 只唤醒一个休眠的 worker，避免惊群
+void ThreadPool::notifyOne() {
+  // 与 parkWorker() 中的栅栏配对：要么提交方看到休眠计数，要么 worker 看到新任务
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (num_parked_.load(std::memory_order_relaxed) == 0) return;
+
+  size_t n = workers_.size();
+  size_t start = wake_cursor_.fetch_add(1, std::memory_order_relaxed);
+  for (size_t i = 0; i < n; i++) {
+    auto& w = *workers_[(start + i) % n];
+    int32_t expected = kParked;
+    if (w.park_state.compare_exchange_strong(expected, kNotified, std::memory_order_acq_rel)) {
+      FutexWake(&w.park_state, 1);
+      return;
+    }
+  }
+}
+
+// 返回 true 表示该 worker 已空闲超时并被回收，调用方应退出线程
+bool ThreadPool::parkWorker(int wid) {
+  auto& w = *workers_[static_cast<size_t>(wid)];
+  w.park_state.store(kParked, std::memory_order_relaxed);
+  num_parked_.fetch_add(1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  bool retired = false;
+  // 宣告休眠后再检查一次，避免与提交方交错导致丢失唤醒
+  if (!stop_.load(std::memory_order_acquire) && !hasVisibleWork()) {
+    uint64_t begin = NowNs();
+    uint64_t retire_ns = opts_.idle_retire_ms * 1000000ULL;
+    bool may_retire = elastic_;
+    while (w.park_state.load(std::memory_order_acquire) == kParked &&
+           !stop_.load(std::memory_order_acquire)) {
+      if (!may_retire) {
+        FutexWait(&w.park_state, kParked);
+        continue;
+      }
+      uint64_t idle = NowNs() - begin;
+      if (idle >= retire_ns) {
+        if (tryRetire(w)) {
+          retired = true;
+          break;
+        }
+        // 已达 min_threads 下限，改为无限期休眠
+        may_retire = false;
+        continue;
+      }
+      uint64_t remain = retire_ns - idle;
+      timespec ts{static_cast<time_t>(remain / 1000000000ULL),
+                  static_cast<long>(remain % 1000000000ULL)};
+      FutexWait(&w.park_state, kParked, &ts);
+    }
+    w.idle_ns.fetch_add(NowNs() - begin, std::memory_order_relaxed);
+    w.parks.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  if (!retired) {
+    w.park_state.store(kRunning, std::memory_order_relaxed);
+  }
+  num_parked_.fetch_sub(1, std::memory_order_relaxed);
+  return retired;
+}
+
+// 空闲超时的 worker 尝试退出：先摘掉可唤醒状态，再确认没有漏掉的任务，最后扣减存活线程数
+bool ThreadPool::tryRetire(Worker& w) {
+  // 已达 min_threads 下限时不进入 kRetired：该状态下提交方会跳过这个 worker
+  if (live_threads_.load(std::memory_order_acquire) <= opts_.min_threads) {
+    return false;
+  }
+  int32_t expected = kParked;
+  if (!w.park_state.compare_exchange_strong(expected, kRetired, std::memory_order_acq_rel)) {
+    return false;   // 恰好被唤醒
+  }
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (stop_.load(std::memory_order_acquire) || hasVisibleWork()) {
+    // 提交方可能因看到 kRetired 而跳过了唤醒，由当前线程接手
+    w.park_state.store(kRunning, std::memory_order_relaxed);
+    return false;
+  }
+
+  size_t live = live_threads_.load(std::memory_order_relaxed);
+  while (live > opts_.min_threads) {
+    if (live_threads_.compare_exchange_weak(live, live - 1, std::memory_order_acq_rel)) {
+      retired_threads_.fetch_add(1, std::memory_order_relaxed);
       return true;
     }
   }
+
+  // 其他 worker 抢先退出到了下限：恢复休眠状态。kRetired 期间提交的任务可能没有唤醒任何线程，
+  // 因此恢复后按 parkWorker() 的方式再检查一次，有任务时改为运行状态由当前线程接手
+  w.park_state.store(kParked, std::memory_order_release);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (stop_.load(std::memory_order_acquire) || hasVisibleWork()) {
+    expected = kParked;
+    w.park_state.compare_exchange_strong(expected, kRunning, std::memory_order_acq_rel);
+  }
   return false;
 }
 
+void ThreadPool::runTask(int wid, Task& task, bool stolen) {
+  // 取消的任务在出队时直接丢弃，不再执行
+  if (task.cancel && task.cancel->load(std::memory_order_acquire)) {
+    cancelled_tasks_.fetch_add(1, std::memory_order_relaxed);
+    pending_tasks_.fetch_sub(1, std::memory_order_acq_rel);
+    return;
+  }
+
+  auto& w = *workers_[static_cast<size_t>(wid)];
+  if (elastic_) {
+    uint64_t now = NowNs();
+    if (task.enqueue_ns != 0 && now > task.enqueue_ns) {
+      // EWMA(1/8)，多个 worker 并发更新时允许丢失个别样本
+      uint64_t wait = now - task.enqueue_ns;
+      uint64_t ewma = queue_wait_ewma_ns_.load(std::memory_order_relaxed);
+      queue_wait_ewma_ns_.store(ewma - ewma / 8 + wait / 8, std::memory_order_relaxed);
+    }
+    w.task_start_ns.store(now, std::memory_order_relaxed);
+  }
+
+  tls_current_cancel_ = task.cancel.get();
+  try {
+    task.fn();
+  } catch (const std::exception& e) {
+    std::cerr << "Exception in " << threadtype_ << " thread[" << wid
+              << "]" << (stolen ? " (stolen)" : "") << ": " << e.what() << std::endl;
+  } catch (...) {
+    std::cerr << "Unknown exception in " << threadtype_
+              << " thread[" << wid << "]" << (stolen ? " (stolen)" : "") << std::endl;
+  }
+  tls_current_cancel_ = nullptr;
+  if (elastic_) {
+    w.task_start_ns.store(0, std::memory_order_relaxed);
+  }
+  task = Task();   // 先释放捕获的资源，再宣告任务完成
+  w.executed.fetch_add(1, std::memory_order_relaxed);
+  pending_tasks_.fetch_sub(1, std::memory_order_acq_rel);
+}
+
 void ThreadPool::workerLoop(int wid) {
+  tls_pool_ = this;
   tls_worker_id_ = wid;
 
   while (!stop_.load(std::memory_order_acquire)) {
     Task task;
-    if (tryPopLocal(wid, task)) {
-      try {
-        task.fn();
-      } catch (const std::exception& e) {
-        std::cerr << "Exception in " << threadtype_ << " thread[" << wid
-                  << "]: " << e.what() << std::endl;
-      } catch (...) {
-        std::cerr << "Unknown exception in " << threadtype_
-                  << " thread[" << wid << "]" << std::endl;
-      }
-      pending_tasks_.fetch_sub(1, std::memory_order_acq_rel);
+    if (tryPopLocal(wid, task) || tryPopInject(task)) {
+      runTask(wid, task, false);
       continue;
     }
 
-    if (drainInjectToLocal(wid, 32) > 0) {
+    if (trySteal(wid, task)) {
+      runTask(wid, task, true);
       continue;
     }
 
-    if (trySteal(wid, task)) {
-      try {
-        task.fn();
-      } catch (const std::exception& e) {
-        std::cerr << "Exception in " << threadtype_ << " thread[" << wid
-                  << "] (stolen): " << e.what() << std::endl;
-      } catch (...) {
-        std::cerr << "Unknown exception in " << threadtype_
-                  << " thread[" << wid << "] (stolen)" << std::endl;
-      }
-      pending_tasks_.fetch_sub(1, std::memory_order_acq_rel);
+    if (parkWorker(wid)) {
+      break;
+    }
+  }
+
+  std::function<void()> hook;
+  {
+    std::lock_guard<std::mutex> lk(exit_hook_mutex_);
+    hook = exit_hook_;
+  }
+  if (hook) {
+    hook();
+  }
+  tls_pool_ = nullptr;
+  tls_worker_id_ = -1;
+  workers_[static_cast<size_t>(wid)]->live.store(false, std::memory_order_release);
+}
+
+// 在空槽位上启动 worker；只由构造函数和监控线程调用
+void ThreadPool::startWorker(size_t slot) {
+  if (threads_[slot].joinable()) {
+    threads_[slot].join();   // 回收已退出的旧线程
+  }
+  auto& w = *workers_[slot];
+  w.park_state.store(kRunning, std::memory_order_relaxed);
+  w.task_start_ns.store(0, std::memory_order_relaxed);
+  w.live.store(true, std::memory_order_release);
+  live_threads_.fetch_add(1, std::memory_order_acq_rel);
+  threads_[slot] = std::thread([this, slot] {
+    workerLoop(static_cast<int>(slot));
+  });
+}
+
+size_t ThreadPool::countBlocked(uint64_t now_ns) const {
+  uint64_t threshold = opts_.blocked_task_ms * 1000000ULL;
+  size_t blocked = 0;
+  for (const auto& w : workers_) {
+    if (!w->live.load(std::memory_order_acquire)) continue;
+    uint64_t start = w->task_start_ns.load(std::memory_order_relaxed);
+    if (start != 0 && now_ns > start && now_ns - start >= threshold) {
+      blocked++;
+    }
+  }
+  return blocked;
+}
+
+// 监控线程：周期性采样排队等待与阻塞线程数，有积压且没有空闲线程时每个周期最多扩容一个线程
+// 缩容由 worker 自身空闲超时完成
+void ThreadPool::monitorLoop() {
+  uint64_t target_ns = opts_.target_queue_wait_us * 1000ULL;
+  while (!stop_.load(std::memory_order_acquire)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(opts_.monitor_interval_ms));
+
+    size_t pending = pending_tasks_.load(std::memory_order_acquire);
+    if (pending == 0) {
+      // 无积压时让 EWMA 衰减，避免陈旧的高值触发扩容
+      uint64_t ewma = queue_wait_ewma_ns_.load(std::memory_order_relaxed);
+      queue_wait_ewma_ns_.store(ewma / 2, std::memory_order_relaxed);
       continue;
     }
 
-    std::unique_lock<std::mutex> lk(cv_m_);
-    cv_.wait(lk, [this] {
-      return stop_.load(std::memory_order_acquire) ||
-             pending_tasks_.load(std::memory_order_acquire) > 0;
-    });
+    size_t live = live_threads_.load(std::memory_order_acquire);
+    if (live >= opts_.max_threads || num_parked_.load(std::memory_order_relaxed) > 0) {
+      continue;
+    }
+
+    // 所有线程都阻塞时不会有任务出队，EWMA 不再更新，因此需要单独检测阻塞线程
+    bool slow_queue = queue_wait_ewma_ns_.load(std::memory_order_relaxed) > target_ns;
+    bool has_blocked = countBlocked(NowNs()) > 0;
+    if (!slow_queue && !has_blocked) {
+      continue;
+    }
+
+    for (size_t slot = 0; slot < workers_.size(); slot++) {
+      if (!workers_[slot]->live.load(std::memory_order_acquire)) {
+        startWorker(slot);
+        spawned_threads_.fetch_add(1, std::memory_order_relaxed);
+        break;
+      }
+    }
   }
 }
 
 size_t ThreadPool::size() {
-  return threads_.size();
+  return live_threads_.load(std::memory_order_acquire);
 }
 
 void ThreadPool::stop() {
   if (stop_.exchange(true)) return;
-  cv_.notify_all();
+  if (monitor_.joinable()) {
+    monitor_.join();   // 先停止扩容，之后 threads_ 不再变化
+  }
+  for (auto& w : workers_) {
+    w->park_state.store(kNotified, std::memory_order_release);
+    FutexWake(&w->park_state, INT_MAX);
+  }
   for (auto& thread : threads_) {
     if (thread.joinable()) {
       thread.join();
     }
   }
+
+  // 释放停止时仍留在本地队列中的任务所捕获的资源（注入队列中的任务随队列析构）
+  for (auto& w : workers_) {
+    LocalSlot* slot = nullptr;
+    while (w->dq.steal(slot)) {
+      Task dropped;
+      takeSlot(slot, dropped);
+    }
+  }
 }
 
 int ThreadPool::idl_thread_cnt() {
-  size_t idle = 0;
-  size_t n = workers_.size();
-  for (size_t i = 0; i < n; i++) {
-    auto& w = *workers_[i];
-    std::lock_guard<std::mutex> lk(w.m);
-    if (w.dq.empty()) idle++;
-  }
-  {
-    std::lock_guard<std::mutex> lk(inject_m_);
-    if (!inject_q_.empty()) idle = 0;
-  }
-  return static_cast<int>(idle);
+  return static_cast<int>(num_parked_.load(std::memory_order_relaxed));
 }
 
 size_t ThreadPool::queue_size() {
   return pending_tasks_.load(std::memory_order_acquire);
-}
\ No newline at end of file
+}
+
+uint64_t ThreadPool::cancelled_count() const {
+  return cancelled_tasks_.load(std::memory_order_relaxed);
+}
+
+ThreadPool::Stats ThreadPool::stats() const {
+  Stats s;
+  for (const auto& w : workers_) {
+    s.executed += w->executed.load(std::memory_order_relaxed);
+    s.steals += w->steals.load(std::memory_order_relaxed);
+    s.parks += w->parks.load(std::memory_order_relaxed);
+    s.idle_ns += w->idle_ns.load(std::memory_order_relaxed);
+  }
+  s.cancelled = cancelled_tasks_.load(std::memory_order_relaxed);
+  s.spawned = spawned_threads_.load(std::memory_order_relaxed);
+  s.retired = retired_threads_.load(std::memory_order_relaxed);
+  s.queue_wait_ns = queue_wait_ewma_ns_.load(std::memory_order_relaxed);
+  s.live_threads = live_threads_.load(std::memory_order_relaxed);
+  s.blocked_workers = elastic_ ? countBlocked(NowNs()) : 0;
+  s.parked_workers = num_parked_.load(std::memory_order_relaxed);
+  s.pending = pending_tasks_.load(std::memory_order_acquire);
+  return s;
+}
+
+void ThreadPool::SetThreadExitHook(std::function<void()> hook) {
+  std::lock_guard<std::mutex> lk(exit_hook_mutex_);
+  exit_hook_ = std::move(hook);
+}
+
+ThreadPool* ThreadPool::Current() {
+  return tls_pool_;
+}
+
+bool ThreadPool::IsCurrentTaskCancelled() {
+  return tls_current_cancel_ != nullptr &&
+         tls_current_cancel_->load(std::memory_order_acquire);
+}
@@ -14,11 +14,18 @@
 #include <atomic>
 #include <cstdint>
 #include <memory>
+#include "InplaceTask.h"
+#include "ChaseLevDeque.h"
+#include "MpmcQueue.h"
 
 enum class TaskPriority : uint8_t { Low, Normal, High };
 
+// 任务可调用对象的内联容量：HttpServer 的 worker 任务只捕获 this/weak_ptr/shared_ptr，64 字节足够
+constexpr size_t kTaskInlineSize = 64;
+using TaskFn = InplaceTask<void(), kTaskInlineSize>;
+
 struct Task {
-  std::function<void()> fn;
+  TaskFn fn;
   TaskPriority priority{TaskPriority::Normal};
   uint64_t enqueue_ns{0};
   uint64_t trace_id{0};
@@ -26,17 +33,72 @@ struct Task {
   std::shared_ptr<std::atomic_bool> cancel;
 
   Task() = default;
-  explicit Task(std::function<void()> f)
-    : fn(std::move(f)), enqueue_ns(0) {}
+  template <typename F,
+            typename = std::enable_if_t<!std::is_same<std::decay_t<F>, Task>::value>>
+  explicit Task(F&& f)
+    : fn(std::forward<F>(f)), enqueue_ns(0) {}
+
+  Task(Task&&) noexcept = default;
+  Task& operator=(Task&&) noexcept = default;
 };
 
 class ThreadPool {
+public:
+  // 弹性线程池配置：min_threads == max_threads 时为固定大小线程池，不启动监控线程
+  struct Options {
+    size_t min_threads{1};
+    size_t max_threads{1};
+    size_t max_queue_size{10000};
+    uint64_t target_queue_wait_us{2000};   // 排队等待时间（EWMA）超过该值时扩容
+    uint64_t blocked_task_ms{50};          // 单个任务执行超过该时长视为阻塞（MySQL/磁盘等）
+    uint64_t idle_retire_ms{10000};        // 超出 min_threads 的线程空闲该时长后退出
+    uint64_t monitor_interval_ms{10};      // 监控线程采样周期
+  };
+
+  // 线程池运行指标快照
+  struct Stats {
+    uint64_t executed{0};         // 已执行的任务数
+    uint64_t steals{0};           // 成功窃取的任务数
+    uint64_t cancelled{0};        // 出队时因取消被丢弃的任务数
+    uint64_t parks{0};            // worker 进入休眠的次数
+    uint64_t idle_ns{0};          // worker 累计休眠时长（纳秒）
+    uint64_t spawned{0};          // 弹性扩容启动的线程数
+    uint64_t retired{0};          // 空闲退出的线程数
+    uint64_t queue_wait_ns{0};    // 排队等待时间 EWMA（纳秒，仅弹性线程池统计）
+    size_t live_threads{0};       // 当前存活的 worker 线程数
+    size_t blocked_workers{0};    // 当前判定为阻塞的 worker 数
+    size_t parked_workers{0};     // 当前休眠的 worker 数
+    size_t pending{0};            // 已提交但尚未执行完成的任务数
+  };
+
 private:
-  struct Worker {
-    std::mutex m;
-    std::deque<Task> dq;
+  // worker 的休眠状态，同时作为 futex 字；kRetired 表示空闲线程正在退出，不再接受唤醒
+  enum ParkState : int32_t { kRunning = 0, kParked = 1, kNotified = 2, kRetired = 3 };
+
+  // worker 本地队列容量，满时回退到注入队列
+  static constexpr size_t kLocalQueueCapacity = 1024;
+
+  // 本地队列的任务槽位：任务按值存放在与队列环形下标对应的槽位中，队列本身只传递槽位指针。
+  // busy 在取走任务（pop 或窃取成功后移出）之后才清除，owner 只复用 busy 为 false 的槽位，
+  // 因此窃取者移出任务时槽位不会被覆盖；压入与弹出都不做堆分配
+  struct LocalSlot {
+    Task task;
+    std::atomic<bool> busy{false};
+  };
+
+  struct alignas(64) Worker {
+    ChaseLevDeque<LocalSlot*> dq{kLocalQueueCapacity};  // 本地无锁工作窃取队列，仅 owner 压入/弹出
+    std::unique_ptr<LocalSlot[]> slots{new LocalSlot[kLocalQueueCapacity]};
+    std::atomic<int32_t> park_state{kRunning};     // 休眠状态，通过 futex 精确唤醒
+    std::atomic<uint64_t> executed{0};
+    std::atomic<uint64_t> steals{0};
+    std::atomic<uint64_t> parks{0};
+    std::atomic<uint64_t> idle_ns{0};
+    std::atomic<bool> live{false};                 // 该槽位是否有存活线程
+    std::atomic<uint64_t> task_start_ns{0};        // 当前任务开始时间，0 表示空闲（用于阻塞检测）
   };
 
+  // workers_/threads_ 按 max_threads 预分配槽位，扩缩容只启停线程，不改变容器
   std::vector<std::unique_ptr<Worker>> workers_;
   std::vector<std::thread> threads_;
   std::atomic_bool stop_{false};
@@ -44,27 +106,61 @@ private:
   std::atomic<size_t> pending_tasks_{0};
   size_t max_queue_size_;
 
-  std::mutex inject_m_;
-  std::deque<Task> inject_q_;
+  MpmcQueue<Task> inject_q_;                  // 外部线程提交任务的无锁注入队列
+  std::atomic<size_t> num_parked_{0};         // 当前休眠的 worker 数，为 0 时提交方无需唤醒
+  std::atomic<size_t> wake_cursor_{0};        // 轮转唤醒起点，避免总是唤醒同一个 worker
+  std::atomic<uint64_t> cancelled_tasks_{0};
 
-  std::mutex cv_m_;
-  std::condition_variable cv_;
+  Options opts_;
+  bool elastic_{false};
+  std::thread monitor_;                       // 弹性线程池的监控线程，负责扩容
+  std::atomic<size_t> live_threads_{0};
+  std::atomic<uint64_t> queue_wait_ewma_ns_{0};
+  std::atomic<uint64_t> spawned_threads_{0};
+  std::atomic<uint64_t> retired_threads_{0};
+  std::mutex exit_hook_mutex_;
+  std::function<void()> exit_hook_;
 
+  static thread_local ThreadPool* tls_pool_;
   static thread_local int tls_worker_id_;
+  static thread_local const std::atomic_bool* tls_current_cancel_;
 
+  bool pushLocal(Worker& w, Task& t);
+  static void takeSlot(LocalSlot* slot, Task& out);
   bool tryPopLocal(int wid, Task& out);
+  bool tryPopInject(Task& out);
   bool trySteal(int self_wid, Task& out);
-  size_t drainInjectToLocal(int wid, size_t max_n);
+  bool hasVisibleWork() const;
+  void notifyOne();
+  bool parkWorker(int wid);
+  bool tryRetire(Worker& w);
+  void runTask(int wid, Task& task, bool stolen);
   void workerLoop(int wid);
+  void startWorker(size_t slot);
+  size_t countBlocked(uint64_t now_ns) const;
+  void monitorLoop();
 
 public:
   ThreadPool(size_t threadnum, const std::string& threadtype, size_t max_queue_size = 10000);
+  ThreadPool(const std::string& threadtype, const Options& opts);
 
   bool addTask(Task t);
   void addtask(std::function<void()> task);
   int idl_thread_cnt();
   size_t size();
   size_t queue_size();
+  uint64_t cancelled_count() const;
+  Stats stats() const;
   void stop();
+
+  // worker 线程退出前（空闲回收或 stop）调用，用于归还线程本地缓存（如延迟释放的内存块）
+  void SetThreadExitHook(std::function<void()> hook);
+
+  // 当前线程所属的线程池（非 worker 线程返回 nullptr），用于判断是否需要跨池切换
+  static ThreadPool* Current();
+
+  // 当前 worker 正在执行的任务是否已被取消（任务未携带 cancel 或不在 worker 线程中时返回 false）
+  // 供长耗时的处理逻辑轮询，以便连接断开后尽早释放 worker
+  static bool IsCurrentTaskCancelled();
   ~ThreadPool();
 };
\ No newline at end of file
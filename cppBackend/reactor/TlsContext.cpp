@@ -7,7 +7,8 @@
 
 #include <openssl/err.h>
 
-TlsContext::TlsContext(SSL_CTX* ctx, bool strict) : ctx_(ctx), strict_(strict) {}
+TlsContext::TlsContext(SSL_CTX* ctx, bool strict, bool http2)
+    : ctx_(ctx), strict_(strict), http2_(http2) {}
 
 static bool EnvIsOn(const char* name) {
   const char* v = std::getenv(name);
@@ -15,6 +16,29 @@ static bool EnvIsOn(const char* name) {
   return std::string(v) == "1" || std::string(v) == "true" || std::string(v) == "TRUE";
 }
 
+static bool EnvIsOff(const char* name) {
+  const char* v = std::getenv(name);
+  if (!v) return false;
+  return std::string(v) == "0" || std::string(v) == "false" || std::string(v) == "off";
+}
+
+int TlsContext::SelectAlpn(SSL*, const unsigned char** out, unsigned char* outlen,
+                           const unsigned char* in, unsigned int inlen, void* arg) {
+  static const unsigned char kH2AndHttp11[] = "\x02h2\x08http/1.1";
+  static const unsigned char kHttp11[] = "\x08http/1.1";
+  const TlsContext* self = static_cast<const TlsContext*>(arg);
+  const unsigned char* server = self->http2_ ? kH2AndHttp11 : kHttp11;
+  unsigned int server_len = self->http2_ ? sizeof(kH2AndHttp11) - 1 : sizeof(kHttp11) - 1;
+
+  unsigned char* selected = nullptr;
+  if (SSL_select_next_proto(&selected, outlen, server, server_len, in, inlen) != OPENSSL_NPN_NEGOTIATED) {
+    // 没有共同协议：不回应 ALPN，按 HTTP/1.1 处理
+    return SSL_TLSEXT_ERR_NOACK;
+  }
+  *out = selected;
+  return SSL_TLSEXT_ERR_OK;
+}
+
 std::shared_ptr<TlsContext> TlsContext::CreateFromEnv() {
   const char* cert = std::getenv("WEBSERVER_TLS_CERT");
   const char* key = std::getenv("WEBSERVER_TLS_KEY");
@@ -67,6 +91,9 @@ std::shared_ptr<TlsContext> TlsContext::CreateFromEnv() {
   }
 
   bool strict = EnvIsOn("WEBSERVER_TLS_STRICT");
-  return std::shared_ptr<TlsContext>(new TlsContext(ctx, strict));
+  bool http2 = !EnvIsOff("WEBSERVER_HTTP2");
+  std::shared_ptr<TlsContext> tls(new TlsContext(ctx, strict, http2));
+  SSL_CTX_set_alpn_select_cb(ctx, &TlsContext::SelectAlpn, tls.get());
+  return tls;
 }
 
@@ -11,15 +11,21 @@ public:
 
   SSL_CTX* Get() const { return ctx_.get(); }
   bool Strict() const { return strict_; }
+  bool Http2() const { return http2_; }
 
 private:
   struct CtxDeleter {
     void operator()(SSL_CTX* p) const noexcept { SSL_CTX_free(p); }
   };
 
-  explicit TlsContext(SSL_CTX* ctx, bool strict);
+  explicit TlsContext(SSL_CTX* ctx, bool strict, bool http2);
+
+  // ALPN 选择回调：按服务端偏好（h2 优先，其次 http/1.1）从客户端列表中选择
+  static int SelectAlpn(SSL* ssl, const unsigned char** out, unsigned char* outlen,
+                        const unsigned char* in, unsigned int inlen, void* arg);
 
   std::unique_ptr<SSL_CTX, CtxDeleter> ctx_;
   bool strict_{false};
+  bool http2_{true};
 };
 
@@ -115,3 +115,12 @@ TlsIoResult TlsSession::WritePlain(const char* data, size_t len, size_t& nwritte
   if (err == SSL_ERROR_WANT_WRITE) return TlsIoResult::WANT_WRITE;
   return TlsIoResult::ERROR;
 }
+
+std::string_view TlsSession::AlpnProtocol() const {
+  if (!ssl_) return std::string_view();
+  const unsigned char* proto = nullptr;
+  unsigned int len = 0;
+  SSL_get0_alpn_selected(ssl_, &proto, &len);
+  if (!proto || len == 0) return std::string_view();
+  return std::string_view(reinterpret_cast<const char*>(proto), len);
+}
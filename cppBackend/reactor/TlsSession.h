@@ -2,6 +2,7 @@
 
 #include <memory>
 #include <string>
+#include <string_view>
 
 #include <openssl/ssl.h>
 
@@ -23,6 +24,8 @@ public:
   bool HandshakeDone() const { return handshake_done_; }
   bool KtlsTx() const { return ktls_tx_; }
   bool KtlsRx() const { return ktls_rx_; }
+  // 握手时 ALPN 协商出的协议（如 "h2"），未协商时为空
+  std::string_view AlpnProtocol() const;
 
   TlsIoResult DriveHandshake();
   TlsIoResult ReadPlain(char* out, size_t cap, size_t& nread);
@@ -56,7 +56,8 @@ int main(int argc ,const char*argv[]){
   signal(SIGTERM,Stop);
   signal(SIGINT,Stop);
 
-  httpserver=new HttpServer(argv[1],atoi(argv[2]),360,true,3306,"webuser","12589777","webserver",6,4,12,ResolveStaticPath());
+  //工作线程常驻2个，handler阻塞在MySQL/磁盘时最多扩容到12个（与数据库连接池大小一致）
+  httpserver=new HttpServer(argv[1],atoi(argv[2]),360,true,3306,"webuser","12589777","webserver",6,2,12,ResolveStaticPath(),12);
   httpserver->start();
   
   return 0;
@@ -62,7 +62,9 @@ LOGDEBUG("设置新连接");
   {
     std::lock_guard<std::mutex> lock(mmutex_);
     conns_[fd]=conn; //把conn存放到map容器中
+    conn_count_.store(conns_.size(), std::memory_order_relaxed);
   }
+  accepted_total_.fetch_add(1, std::memory_order_relaxed);
 
   subloops_[loop_index]->queueinloop([conn]{
     conn->connectEstablished();
@@ -81,6 +83,7 @@ void TcpServer::closeconnection(spConnection conn){
   {
     std::lock_guard<std::mutex> lock(mmutex_);
     conns_.erase(conn->fd());
+    conn_count_.store(conns_.size(), std::memory_order_relaxed);
   }
 
 }
@@ -92,6 +95,7 @@ void TcpServer::errorconnection(spConnection conn){
   {
     std::lock_guard<std::mutex> lock(mmutex_);
     conns_.erase(conn->fd());
+    conn_count_.store(conns_.size(), std::memory_order_relaxed);
   }
 
 }
@@ -106,6 +110,16 @@ void TcpServer::sendcomplete(spConnection conn){
 
   if(sendcompletecb_)sendcompletecb_(conn);
 }
+std::vector<EventLoop::Stats> TcpServer::loop_stats() const {
+  std::vector<EventLoop::Stats> out;
+  out.reserve(subloops_.size() + 1);
+  out.push_back(mainloop_->stats());
+  for (const auto& loop : subloops_) {
+    out.push_back(loop->stats());
+  }
+  return out;
+}
+
 void TcpServer::epolltimeout(EventLoop*loop){
   if(timeoutcb_) timeoutcb_(loop);
 }
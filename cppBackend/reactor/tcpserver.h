@@ -13,6 +13,7 @@
 #include<memory>
 #include<mutex>
 #include<vector>
+#include<atomic>
 
 
 class TcpServer{
@@ -24,6 +25,8 @@ private:
   ThreadPool threadpool_;       //线程池
   std::mutex mmutex_;           //保护conns_的互斥锁
   std::map<int,spConnection> conns_;//一个TcpServer可以有多个Connection对象(因为封装的是connectfd)
+  std::atomic<size_t> conn_count_{0};        //conns_ 大小的原子镜像，指标读取时不加锁
+  std::atomic<uint64_t> accepted_total_{0};  //累计接受的连接数
   std::function<void(spConnection)> newconnectioncb_;      //回调HttpServer::HandleNewConnection()
   std::function<void(spConnection)> closeconnectioncb_;    //回调HttpServer::HandleClose()
   std::function<void(spConnection)> errorconnectioncb_;    //回调HttpServer::HandleError()
@@ -57,6 +60,11 @@ public:
   void seterrorconnection(std::function<void(spConnection)>);    
   void setonmessage(std::function<void(spConnection/*暂且先注释了等后面需要用到工作线程在开出来,BufferBlock*/)>);   
   void setsendcomplete(std::function<void(spConnection)>);       
+
+  //运行指标
+  size_t connection_count() const { return conn_count_.load(std::memory_order_relaxed); }
+  uint64_t accepted_total() const { return accepted_total_.load(std::memory_order_relaxed); }
+  std::vector<EventLoop::Stats> loop_stats() const;   //下标 0 为主事件循环，其后依次为从事件循环
   
   //时间戳
   //void settimeout(std::function<void(EventLoop*)> );    
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+
+/**
+ * PrecompressCache：静态文件的 gzip 预压缩副本（与 nginx gzip_static 相同，副本为 "<文件>.gz"）
+ * 请求命中可压缩的静态文件而副本缺失或过期时，只把文件排入后台队列，本次仍发送原文件；
+ * 后台线程以最高压缩级别生成副本，先写临时文件再 rename，并把副本的修改时间设为原文件的修改时间，
+ * 之后的请求直接用 sendfile 发送副本。原文件被修改后修改时间不再相同，副本随之失效并重新生成。
+ */
+class PrecompressCache {
+public:
+  static PrecompressCache& Instance();
+  ~PrecompressCache();
+
+  // 副本可用时返回 true 并给出路径与大小；否则排入后台生成（队列满或此前生成失败时跳过）
+  bool Lookup(const std::string& path, time_t mtime, uint64_t size, std::string& gz_path, uint64_t& gz_size);
+
+private:
+  PrecompressCache();
+  void Run();
+  // 生成 path 的副本；压缩后不更小或写入失败时返回 false
+  static bool Generate(const std::string& path, time_t mtime);
+
+  static constexpr size_t kMaxQueued = 256;
+  static constexpr uint64_t kMaxSourceBytes = 16 * 1024 * 1024;   // 更大的文件不预压缩，避免后台线程长时间占用内存
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::pair<std::string, time_t>> queue_;
+  std::unordered_set<std::string> pending_;            // 已在队列中的路径，重复请求不再排队
+  std::unordered_map<std::string, time_t> skipped_;    // 生成失败或不值得压缩的文件及其当时的修改时间
+  bool stop_{false};
+  std::thread worker_;
+};
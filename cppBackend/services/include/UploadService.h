@@ -1,15 +1,22 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
 
 class HttpRequest;
 class HttpResponse;
 class RouteParams;
+class RequestBodySink;
 
 class UploadService {
 public:
   static bool HandleInit(HttpRequest* request, HttpResponse& response, const std::string& static_path);
   static bool HandleUploadPart(HttpRequest* request, HttpResponse& response, const RouteParams& params, const std::string& static_path);
+  // 请求头到达后校验上传会话与分片大小，返回把 body 直接写入分片文件的接收器；
+  // 校验失败返回 nullptr，错误已写入 response
+  static std::unique_ptr<RequestBodySink> CreatePartSink(HttpRequest& request, const RouteParams& params, uint64_t length,
+                                                         HttpResponse& response, const std::string& static_path);
   static bool HandleComplete(HttpRequest* request, HttpResponse& response, const RouteParams& params, const std::string& static_path);
 };
 
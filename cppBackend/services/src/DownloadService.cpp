@@ -119,7 +119,7 @@ bool DownloadService::HandleDownload(HttpRequest* request, HttpResponse& respons
     response.SetHeader("ETag", etag);
     response.SetHeader("Cache-Control", "public, max-age=3600");
 
-    auto if_none_match = request->GetHeader("If-None-Match");
+    auto if_none_match = request->GetHeaderView(KnownHeader::IfNoneMatch);
     if (if_none_match && *if_none_match == etag) {
         response.SetStatusCode(HttpStatusCode::NOT_MODIFIED);
         response.SetBody("");
@@ -1,5 +1,6 @@
 #include "FileApiService.h"
 
+#include "../../http/include/core/BodyProducer.h"
 #include "../../http/include/core/HttpRequest.h"
 #include "../../http/include/core/HttpResponse.h"
 #include "../../http/include/error/HttpErrorUtil.h"
@@ -60,6 +61,70 @@ static bool IsAllowedInFolder(const std::string& folder, const std::string& name
   return false;
 }
 
+// 追加一个文件条目；不是允许列出的普通文件时跳过
+static void AppendFileEntry(std::string& out, bool& first, const std::string& folder, const std::string& dir_path,
+                            const std::string& name) {
+  if (name == "." || name == "..") return;
+  if (!IsSafeFileName(name)) return;
+  if (!IsAllowedInFolder(folder, name)) return;
+
+  const std::string full = dir_path + "/" + name;
+  struct stat st;
+  if (stat(full.c_str(), &st) != 0) return;
+  if (!S_ISREG(st.st_mode)) return;
+
+  if (!first) out += ",";
+  first = false;
+
+  const std::string url = "/" + folder + "/" + name;
+  const std::string downloadUrl = "/download/" + folder + "/" + name;
+  out += "{";
+  out += "\"folder\":\"" + JsonEscape(folder) + "\"";
+  out += ",\"name\":\"" + JsonEscape(name) + "\"";
+  out += ",\"size\":" + std::to_string(static_cast<long long>(st.st_size));
+  out += ",\"mimeType\":\"" + JsonEscape(GetContentType(full)) + "\"";
+  out += ",\"updatedAt\":\"" + JsonEscape(ToIso8601Utc(st.st_mtime)) + "\"";
+  out += ",\"url\":\"" + JsonEscape(url) + "\"";
+  out += ",\"downloadUrl\":\"" + JsonEscape(downloadUrl) + "\"";
+  out += "}";
+}
+
+// 目录列表按需生成：每次拉取只扫描到凑够一段 JSON，大目录不必先把全部条目拼进内存
+class FileListProducer : public BodyProducer {
+public:
+  FileListProducer(DIR* dir, std::string folder, std::string dir_path)
+      : dir_(dir), folder_(std::move(folder)), dir_path_(std::move(dir_path)) {}
+  ~FileListProducer() override {
+    if (dir_) closedir(dir_);
+  }
+
+  Status Produce(std::string& out, size_t max_bytes) override {
+    const size_t start = out.size();
+    if (!started_) {
+      out += "{\"success\":true,\"message\":\"操作成功\",\"data\":{\"files\":[";
+      started_ = true;
+    }
+    while (out.size() - start < max_bytes) {
+      auto* ent = readdir(dir_);
+      if (!ent) {
+        closedir(dir_);
+        dir_ = nullptr;
+        out += "]}}";
+        return Status::Done;
+      }
+      AppendFileEntry(out, first_, folder_, dir_path_, ent->d_name);
+    }
+    return Status::More;
+  }
+
+private:
+  DIR* dir_;
+  std::string folder_;
+  std::string dir_path_;
+  bool started_{false};
+  bool first_{true};
+};
+
 bool FileApiService::HandleListFiles(HttpRequest* request, HttpResponse& response, const std::string& static_path) {
   if (!request) {
     SetJsonErrorResponse(response, HttpStatusCode::BAD_REQUEST, "Bad Request");
@@ -87,41 +152,10 @@ bool FileApiService::HandleListFiles(HttpRequest* request, HttpResponse& respons
     return true;
   }
 
-  std::ostringstream data;
-  data << "{\"files\":[";
-
-  bool first = true;
-  while (auto* ent = readdir(dir)) {
-    std::string name = ent->d_name;
-    if (name == "." || name == "..") continue;
-    if (!IsSafeFileName(name)) continue;
-    if (!IsAllowedInFolder(folder, name)) continue;
-
-    const std::string full = dir_path + "/" + name;
-    struct stat st;
-    if (stat(full.c_str(), &st) != 0) continue;
-    if (!S_ISREG(st.st_mode)) continue;
-
-    if (!first) data << ",";
-    first = false;
-
-    const std::string url = "/" + folder + "/" + name;
-    const std::string downloadUrl = "/download/" + folder + "/" + name;
-    data << "{";
-    data << "\"folder\":\"" << JsonEscape(folder) << "\"";
-    data << ",\"name\":\"" << JsonEscape(name) << "\"";
-    data << ",\"size\":" << static_cast<long long>(st.st_size);
-    data << ",\"mimeType\":\"" << JsonEscape(GetContentType(full)) << "\"";
-    data << ",\"updatedAt\":\"" << JsonEscape(ToIso8601Utc(st.st_mtime)) << "\"";
-    data << ",\"url\":\"" << JsonEscape(url) << "\"";
-    data << ",\"downloadUrl\":\"" << JsonEscape(downloadUrl) << "\"";
-    data << "}";
-  }
-
-  closedir(dir);
-
-  data << "]}";
-  SetJsonSuccessResponseWithData(response, data.str(), "操作成功");
+  // 条目在发送时才逐段扫描生成（chunked），目录句柄随生产者释放
+  response.SetStatusCode(HttpStatusCode::OK);
+  response.SetHeader("Content-Type", "application/json; charset=utf-8");
+  response.SetBodyProducer(std::make_shared<FileListProducer>(dir, folder, dir_path));
   return true;
 }
 
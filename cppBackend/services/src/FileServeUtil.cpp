@@ -1,4 +1,5 @@
 #include "FileServeUtil.h"
+#include "../../http/include/util/HttpDate.h"
 
 #include <cerrno>
 #include <cstring>
@@ -102,11 +103,7 @@ bool FileServeUtil::ReadFileRange(const std::string& path, uint64_t start, uint6
 }
 
 std::string FileServeUtil::ToHttpDate(time_t t) {
-  char buf[100];
-  if (std::strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", std::gmtime(&t))) {
-    return std::string(buf);
-  }
-  return "";
+  return FormatHttpDate(t);
 }
 
 bool FileServeUtil::ParseHttpDate(const std::string& s, time_t& out) {
@@ -0,0 +1,133 @@
+#include "PrecompressCache.h"
+#include "../../http/include/util/HttpCompress.h"
+#include "../../logger/log_fac.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+PrecompressCache& PrecompressCache::Instance() {
+  static PrecompressCache instance;
+  return instance;
+}
+
+PrecompressCache::PrecompressCache() : worker_([this] { Run(); }) {}
+
+PrecompressCache::~PrecompressCache() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_one();
+  if (worker_.joinable()) {
+    worker_.join();
+  }
+}
+
+bool PrecompressCache::Lookup(const std::string& path, time_t mtime, uint64_t size, std::string& gz_path,
+                              uint64_t& gz_size) {
+  gz_path = path + ".gz";
+  struct stat st;
+  if (::stat(gz_path.c_str(), &st) == 0 && S_ISREG(st.st_mode) && st.st_mtime == mtime) {
+    gz_size = static_cast<uint64_t>(st.st_size);
+    return true;
+  }
+  if (size > kMaxSourceBytes) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto skipped = skipped_.find(path);
+  if (skipped != skipped_.end() && skipped->second == mtime) {
+    return false;
+  }
+  if (queue_.size() >= kMaxQueued || !pending_.insert(path).second) {
+    return false;
+  }
+  queue_.emplace_back(path, mtime);
+  cv_.notify_one();
+  return false;
+}
+
+void PrecompressCache::Run() {
+  while (true) {
+    std::pair<std::string, time_t> job;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+      if (stop_) {
+        return;
+      }
+      job = std::move(queue_.front());
+      queue_.pop_front();
+    }
+
+    const bool ok = Generate(job.first, job.second);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.erase(job.first);
+    if (ok) {
+      skipped_.erase(job.first);
+    } else {
+      skipped_[job.first] = job.second;
+    }
+  }
+}
+
+bool PrecompressCache::Generate(const std::string& path, time_t mtime) {
+  const int in_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (in_fd < 0) {
+    return false;
+  }
+  std::string content;
+  char buf[64 * 1024];
+  ssize_t n = 0;
+  while ((n = ::read(in_fd, buf, sizeof(buf))) != 0) {
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      ::close(in_fd);
+      return false;
+    }
+    content.append(buf, static_cast<size_t>(n));
+    if (content.size() > kMaxSourceBytes) {
+      ::close(in_fd);
+      return false;
+    }
+  }
+  ::close(in_fd);
+
+  std::string compressed;
+  if (!CompressBody(content, HttpContentEncoding::GZIP, 9, compressed) || compressed.size() >= content.size()) {
+    return false;
+  }
+
+  // 临时文件与副本在同一目录，rename 原子替换，正在发送旧副本的连接不受影响
+  const std::string gz_path = path + ".gz";
+  const std::string tmp_path = gz_path + ".tmp";
+  const int out_fd = ::open(tmp_path.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0644);
+  if (out_fd < 0) {
+    LOGWARNING("无法创建预压缩副本 path=" + tmp_path + " errno=" + std::to_string(errno));
+    return false;
+  }
+  const char* p = compressed.data();
+  size_t left = compressed.size();
+  while (left > 0) {
+    const ssize_t w = ::write(out_fd, p, left);
+    if (w < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    p += w;
+    left -= static_cast<size_t>(w);
+  }
+  const struct timespec times[2] = {{0, UTIME_OMIT}, {mtime, 0}};
+  const bool written = left == 0 && ::futimens(out_fd, times) == 0;
+  if (::close(out_fd) != 0 || !written || ::rename(tmp_path.c_str(), gz_path.c_str()) != 0) {
+    ::unlink(tmp_path.c_str());
+    return false;
+  }
+  LOGINFO("生成预压缩副本 " + gz_path + " " + std::to_string(content.size()) + " -> " +
+          std::to_string(compressed.size()));
+  return true;
+}
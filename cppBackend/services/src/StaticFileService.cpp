@@ -2,8 +2,10 @@
 #include "../../http/include/core/HttpRequest.h"
 #include "../../http/include/core/HttpResponse.h"
 #include "../../http/include/handler/AppHandlers.h"  // 使用AppHandlers中的GetContentType工具函数
+#include "../../http/include/util/HttpCompress.h"
 #include "../../logger/log_fac.h"
 #include "FileServeUtil.h"
+#include "PrecompressCache.h"
 #include <sys/stat.h>
 
 // 处理静态文件请求
@@ -51,13 +53,31 @@ bool StaticFileService::HandleStaticFile(HttpRequest* request, HttpResponse& res
             return true;
         }
 
+        // 可压缩的文本资源：客户端接受 gzip 时发送预压缩副本（Range 请求仍按原文件处理）
+        const std::string content_type = GetContentType(full_path);
+        std::string gz_path;
+        uint64_t gz_size = 0;
+        bool send_gzip = false;
+        if (IsCompressibleContentType(content_type) && file_size >= kMinCompressBytes) {
+            response.SetHeader("Vary", "Accept-Encoding");
+            auto accept_encoding = request->GetHeaderView(KnownHeader::AcceptEncoding);
+            if (accept_encoding && !request->GetHeaderView(KnownHeader::Range) &&
+                NegotiateContentEncoding(*accept_encoding) == HttpContentEncoding::GZIP) {
+                send_gzip = PrecompressCache::Instance().Lookup(full_path, file_stat.st_mtime, file_size, gz_path, gz_size);
+            }
+        }
+
         std::string last_modified = FileServeUtil::ToHttpDate(file_stat.st_mtime);
         std::string etag = FileServeUtil::BuildWeakEtag(file_stat.st_mtime, file_size);
+        if (send_gzip) {
+            // 压缩副本是另一种表示形式，ETag 与原文件区分
+            etag.insert(etag.size() - 1, "-gzip");
+        }
         response.SetHeader("Last-Modified", last_modified);
         response.SetHeader("ETag", etag);
         response.SetHeader("Cache-Control", "public, max-age=3600");
 
-        auto if_none_match = request->GetHeader("If-None-Match");
+        auto if_none_match = request->GetHeaderView(KnownHeader::IfNoneMatch);
         if (if_none_match && *if_none_match == etag) {
             response.SetStatusCode(HttpStatusCode::NOT_MODIFIED);
             response.SetBody("");
@@ -77,7 +97,19 @@ bool StaticFileService::HandleStaticFile(HttpRequest* request, HttpResponse& res
         }
 
         response.SetHeader("Accept-Ranges", "bytes");
-        response.SetHeader("Content-Type", GetContentType(full_path));
+        response.SetHeader("Content-Type", content_type);
+
+        if (send_gzip) {
+            response.SetStatusCode(HttpStatusCode::OK);
+            response.SetHeader("Content-Encoding", "gzip");
+            response.SetHeader("Content-Length", std::to_string(gz_size));
+            response.SetContentEncoding(HttpContentEncoding::GZIP);
+            response.SetBody("");
+            if (request->GetMethod() != HttpMethod::HEAD) {
+                response.SetSendFile(gz_path, 0, gz_size);
+            }
+            return true;
+        }
 
         FileRange range;
         auto range_value = request->GetHeader("Range");
@@ -1,6 +1,7 @@
 #include "UploadService.h"
 
 #include "../../http/include/core/HttpRequest.h"
+#include "../../http/include/core/RequestBodySink.h"
 #include "../../http/include/core/HttpResponse.h"
 #include "../../http/include/error/HttpErrorUtil.h"
 #include "../../http/include/handler/AppHandlers.h"
@@ -14,9 +15,11 @@
 #include <cstdio>
 #include <dirent.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <fstream>
 #include <sstream>
 #include <sys/stat.h>
+#include <unistd.h>
 
 static bool EnsureDir(const std::string& path) {
   if (::mkdir(path.c_str(), 0755) == 0) return true;
@@ -87,6 +90,80 @@ static std::string PartPath(const std::string& dir, int partNo) {
   return dir + "/part_" + std::to_string(partNo) + ".bin";
 }
 
+// 从 offset 起完整写入 len 字节；分片文件只由一个接收器顺序写入，不依赖文件偏移
+static bool WriteAt(int fd, uint64_t offset, const char* data, size_t len) {
+  while (len > 0) {
+    ssize_t n = ::pwrite(fd, data, len, static_cast<off_t>(offset));
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return false;
+    }
+    data += n;
+    len -= static_cast<size_t>(n);
+    offset += static_cast<uint64_t>(n);
+  }
+  return true;
+}
+
+// 校验路径参数并读取上传会话，失败时把错误写入 response
+static bool ResolvePart(const RouteParams& params, HttpResponse& response, const std::string& static_path,
+                        int& partNo, std::string& partPath, int& chunkSize) {
+  const auto uploadIdOpt = params.GetParam("uploadId");
+  const auto partNoOpt = params.GetParam("partNo");
+  if (!uploadIdOpt || !partNoOpt) {
+    SetJsonErrorResponse(response, HttpStatusCode::BAD_REQUEST, "缺少参数");
+    return false;
+  }
+  const std::string uploadId = *uploadIdOpt;
+  partNo = std::atoi(partNoOpt->c_str());
+  if (uploadId.empty() || partNo < 0) {
+    SetJsonErrorResponse(response, HttpStatusCode::BAD_REQUEST, "非法参数");
+    return false;
+  }
+
+  const std::string dir = static_path + "/uploads_tmp/" + uploadId;
+  std::string fileName;
+  long long fileSize = 0;
+  std::string folder;
+  if (!ReadMeta(dir, fileName, fileSize, chunkSize, folder)) {
+    SetJsonErrorResponse(response, HttpStatusCode::NOT_FOUND, "上传会话不存在");
+    return false;
+  }
+  partPath = PartPath(dir, partNo);
+  return true;
+}
+
+// 分片接收器：body 到达一段就 pwrite 一段，内存中不保留整个分片；未完整写入的分片文件被删除
+class UploadPartSink : public RequestBodySink {
+public:
+  UploadPartSink(std::string path, int fd) : path_(std::move(path)), fd_(fd) {}
+  ~UploadPartSink() override { Discard(); }
+
+protected:
+  bool Write(uint64_t offset, const char* data, size_t len) override {
+    return WriteAt(fd_, offset, data, len);
+  }
+  bool Finish(uint64_t) override {
+    const int fd = fd_;
+    fd_ = -1;
+    if (::close(fd) == 0) return true;
+    ::unlink(path_.c_str());
+    return false;
+  }
+  void Abort() override { Discard(); }
+
+private:
+  void Discard() {
+    if (fd_ < 0) return;
+    ::close(fd_);
+    fd_ = -1;
+    ::unlink(path_.c_str());
+  }
+
+  std::string path_;
+  int fd_;
+};
+
 static std::string ListUploadedPartsJson(const std::string& dir) {
   DIR* d = opendir(dir.c_str());
   if (!d) return "[]";
@@ -196,57 +273,89 @@ bool UploadService::HandleUploadPart(HttpRequest* request, HttpResponse& respons
     return true;
   }
 
-  const auto uploadIdOpt = params.GetParam("uploadId");
-  const auto partNoOpt = params.GetParam("partNo");
-  if (!uploadIdOpt || !partNoOpt) {
-    SetJsonErrorResponse(response, HttpStatusCode::BAD_REQUEST, "缺少参数");
-    return true;
-  }
-  const std::string uploadId = *uploadIdOpt;
-  const int partNo = std::atoi(partNoOpt->c_str());
-  if (uploadId.empty() || partNo < 0) {
-    SetJsonErrorResponse(response, HttpStatusCode::BAD_REQUEST, "非法参数");
-    return true;
-  }
-
-  const std::string dir = static_path + "/uploads_tmp/" + uploadId;
-  std::string fileName;
-  long long fileSize = 0;
+  int partNo = 0;
+  std::string partPath;
   int chunkSize = 0;
-  std::string folder;
-  if (!ReadMeta(dir, fileName, fileSize, chunkSize, folder)) {
-    SetJsonErrorResponse(response, HttpStatusCode::NOT_FOUND, "上传会话不存在");
+  if (!ResolvePart(params, response, static_path, partNo, partPath, chunkSize)) {
     return true;
   }
 
-  const std::string& body = request->GetBody();
-  if (body.empty()) {
-    SetJsonErrorResponse(response, HttpStatusCode::BAD_REQUEST, "分片为空");
-    return true;
-  }
-  if (static_cast<int>(body.size()) > chunkSize) {
-    SetJsonErrorResponse(response, HttpStatusCode::BAD_REQUEST, "分片过大");
-    return true;
-  }
+  uint64_t size = 0;
+  if (RequestBodySink* sink = request->GetBodySink()) {
+    // 大分片已由 CreatePartSink 的接收器边接收边写入分片文件
+    if (!sink->Completed()) {
+      SetJsonErrorResponse(response, HttpStatusCode::INTERNAL_SERVER_ERROR, "无法写入分片");
+      return true;
+    }
+    size = sink->Received();
+  } else {
+    const std::string_view body = request->GetBodyView();
+    if (body.empty()) {
+      SetJsonErrorResponse(response, HttpStatusCode::BAD_REQUEST, "分片为空");
+      return true;
+    }
+    if (body.size() > static_cast<size_t>(chunkSize)) {
+      SetJsonErrorResponse(response, HttpStatusCode::BAD_REQUEST, "分片过大");
+      return true;
+    }
 
-  const std::string partPath = PartPath(dir, partNo);
-  std::ofstream out(partPath, std::ios::binary | std::ios::trunc);
-  if (!out) {
-    SetJsonErrorResponse(response, HttpStatusCode::INTERNAL_SERVER_ERROR, "无法写入分片");
-    return true;
+    // 连接已断开，不再落盘，避免为已放弃的上传占用磁盘带宽
+    if (request->IsCancelled()) {
+      SetJsonErrorResponse(response, HttpStatusCode::SERVICE_UNAVAILABLE, "请求已取消");
+      return true;
+    }
+
+    const int fd = ::open(partPath.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      SetJsonErrorResponse(response, HttpStatusCode::INTERNAL_SERVER_ERROR, "无法写入分片");
+      return true;
+    }
+    const bool written = WriteAt(fd, 0, body.data(), body.size());
+    if (::close(fd) != 0 || !written) {
+      ::unlink(partPath.c_str());
+      SetJsonErrorResponse(response, HttpStatusCode::INTERNAL_SERVER_ERROR, "无法写入分片");
+      return true;
+    }
+    size = body.size();
   }
-  out.write(body.data(), static_cast<std::streamsize>(body.size()));
-  out.close();
 
   std::ostringstream data;
   data << "{";
   data << "\"partNo\":" << partNo;
-  data << ",\"size\":" << static_cast<long long>(body.size());
+  data << ",\"size\":" << static_cast<long long>(size);
   data << "}";
   SetJsonSuccessResponseWithData(response, data.str(), "操作成功");
   return true;
 }
 
+std::unique_ptr<RequestBodySink> UploadService::CreatePartSink(HttpRequest& request, const RouteParams& params,
+                                                              uint64_t length, HttpResponse& response,
+                                                              const std::string& static_path) {
+  int partNo = 0;
+  std::string partPath;
+  int chunkSize = 0;
+  if (!ResolvePart(params, response, static_path, partNo, partPath, chunkSize)) {
+    return nullptr;
+  }
+  // 按 Content-Length 在写入任何字节前拒绝超大分片
+  if (length > static_cast<uint64_t>(chunkSize)) {
+    SetJsonErrorResponse(response, HttpStatusCode::BAD_REQUEST, "分片过大");
+    return nullptr;
+  }
+  if (request.IsCancelled()) {
+    SetJsonErrorResponse(response, HttpStatusCode::SERVICE_UNAVAILABLE, "请求已取消");
+    return nullptr;
+  }
+
+  const int fd = ::open(partPath.c_str(), O_CREAT | O_TRUNC | O_WRONLY | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    LOGERROR("无法创建分片文件 path=" + partPath + " errno=" + std::to_string(errno));
+    SetJsonErrorResponse(response, HttpStatusCode::INTERNAL_SERVER_ERROR, "无法写入分片");
+    return nullptr;
+  }
+  return std::make_unique<UploadPartSink>(partPath, fd);
+}
+
 bool UploadService::HandleComplete(HttpRequest* request, HttpResponse& response, const RouteParams& params, const std::string& static_path) {
   if (!request) {
     SetJsonErrorResponse(response, HttpStatusCode::BAD_REQUEST, "Bad Request");
@@ -304,6 +413,13 @@ bool UploadService::HandleComplete(HttpRequest* request, HttpResponse& response,
 
   std::vector<char> buf(static_cast<size_t>(chunkSize));
   for (int i = 0; i < partCount; i += 1) {
+    if (request->IsCancelled()) {
+      // 合并中途连接断开：删除半成品，客户端重试时重新合并
+      out.close();
+      std::remove(finalPath.c_str());
+      SetJsonErrorResponse(response, HttpStatusCode::SERVICE_UNAVAILABLE, "请求已取消");
+      return true;
+    }
     std::ifstream in(PartPath(dir, i), std::ios::binary);
     if (!in) {
       SetJsonErrorResponse(response, HttpStatusCode::INTERNAL_SERVER_ERROR, "无法读取分片");
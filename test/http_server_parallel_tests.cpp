@@ -1,21 +1,64 @@
+#include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <cctype>
 #include <chrono>
 #include <condition_variable>
 #include <cstdint>
+#include <cstdlib>
 #include <deque>
 #include <fcntl.h>
+#include <fstream>
 #include <functional>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <mutex>
+#include <new>
+#include <optional>
+#include <sched.h>
+#include <shared_mutex>
 #include <string>
+#include <sys/uio.h>
 #include <thread>
+#include <time.h>
 #include <unistd.h>
+#include <unordered_map>
 #include <vector>
+#include <zlib.h>
 
 #include "reactor/ThreadPool.h"
+#include "reactor/InplaceTask.h"
+#include "reactor/ReorderRing.h"
+#include "reactor/LatencyHistogram.h"
+#include "reactor/PrometheusText.h"
+#include "reactor/AdmissionController.h"
+#include "reactor/RouteMetricsUtil.h"
+#include "parsers/Http1Parser.h"
+#include "core/HttpRequest.h"
+#include "core/HttpResponse.h"
+#include "core/BodyProducer.h"
+#include "util/HttpScan.h"
+#include "util/HttpDate.h"
+#include "util/HttpCompress.h"
+#include "router/Router.h"
+#include "router/RouteEpoch.h"
+#include "parsers/Hpack.h"
+#include "parsers/Http2Parser.h"
+#include "observer/IHttpObserver.h"
+#include "HttpFacade.h"
+#include "security/PatternScanner.h"
+
+// 统计全局堆分配次数，供任务投递分配基准使用
+static std::atomic<size_t> g_alloc_count{0};
+
+// 仅替换 operator new；libstdc++ 默认的 operator delete 以 free() 归还内存
+// noinline 避免 GCC 内联 malloc 后误报 -Wmismatched-new-delete
+__attribute__((noinline)) void* operator new(size_t n) {
+  g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(n ? n : 1)) return p;
+  throw std::bad_alloc();
+}
 
 struct PendingChunk {
   std::string data;
@@ -40,8 +83,7 @@ struct ConnectionWorkContext {
   size_t queued_bytes{0};
   bool worker_running{false};
   uint64_t next_response_seq{1};
-  uint64_t last_applied_response_seq{0};
-  std::map<uint64_t, WorkResult> pending_results;
+  ReorderRing<WorkResult> reorder;
 
   size_t active_worker_count{0};
   size_t max_concurrent_workers{4};
@@ -149,21 +191,10 @@ int main() {
 
     for (auto idx : insert_order) {
       auto& r = results[idx];
-      std::lock_guard<std::mutex> lk(ctx->mutex);
-
-      if (r.response_seq == ctx->last_applied_response_seq + 1) {
-        applied.push_back(r.response_data);
-        ctx->last_applied_response_seq++;
-
-        while (true) {
-          auto it = ctx->pending_results.find(ctx->last_applied_response_seq + 1);
-          if (it == ctx->pending_results.end()) break;
-          applied.push_back(it->second.response_data);
-          ctx->pending_results.erase(it);
-          ctx->last_applied_response_seq++;
-        }
-      } else {
-        ctx->pending_results.emplace(r.response_seq, std::move(r));
+      ctx->reorder.Put(r.response_seq, r);
+      WorkResult ready;
+      while (ctx->reorder.PopReady(ready)) {
+        applied.push_back(ready.response_data);
       }
     }
 
@@ -193,25 +224,22 @@ int main() {
 
     WorkResult wr;
     wr.sendfile_fd = test_fd;
-    wr.response_seq = 1;
+    wr.response_seq = 2;
     wr.has_sendfile = true;
 
+    // 序号 2 先到达，暂存在重排环中等待序号 1
+    ctx->reorder.Put(wr.response_seq, wr);
     {
       std::lock_guard<std::mutex> lk(ctx->mutex);
       ctx->draining = true;
-      ctx->pending_results.emplace(wr.response_seq, std::move(wr));
     }
 
-    {
-      std::lock_guard<std::mutex> lk(ctx->mutex);
-      for (auto& [seq, result] : ctx->pending_results) {
-        if (result.sendfile_fd >= 0) {
-          ::close(result.sendfile_fd);
-          result.sendfile_fd = -1;
-        }
+    ctx->reorder.Clear([](WorkResult& result) {
+      if (result.sendfile_fd >= 0) {
+        ::close(result.sendfile_fd);
+        result.sendfile_fd = -1;
       }
-      ctx->pending_results.clear();
-    }
+    });
 
     int fd_count_after = count_open_fds();
     check(fd_count_after <= fd_count_before + 5,
@@ -383,6 +411,2519 @@ int main() {
           "test_backpressure_with_parallel: 队列满时addTask返回false");
   }
 
+  std::cout << "\n[7] test_cancelled_task_discarded\n";
+  {
+    ThreadPool pool(1, "CANCEL_TEST", 128);
+    auto cancel = std::make_shared<std::atomic_bool>(false);
+
+    std::atomic<bool> gate_open{false};
+    std::atomic<size_t> executed{0};
+    std::atomic<bool> saw_cancel_inflight{false};
+
+    // 先占住唯一的 worker，保证后续任务停留在队列中
+    pool.addtask([&]() {
+      while (!gate_open.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+
+    Task inflight([&]() {
+      executed.fetch_add(1);
+      for (int i = 0; i < 200 && !ThreadPool::IsCurrentTaskCancelled(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+      saw_cancel_inflight.store(ThreadPool::IsCurrentTaskCancelled());
+    });
+    inflight.cancel = cancel;
+    pool.addTask(std::move(inflight));
+    gate_open.store(true);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    cancel->store(true);
+
+    for (int wait = 0; wait < 50 && !saw_cancel_inflight.load(); wait++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    // 取消之后再入队的同连接任务应在出队时被丢弃
+    for (int i = 0; i < 5; i++) {
+      Task queued([&]() { executed.fetch_add(1); });
+      queued.cancel = cancel;
+      pool.addTask(std::move(queued));
+    }
+    for (int wait = 0; wait < 50 && pool.queue_size() > 0; wait++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    pool.stop();
+
+    check(saw_cancel_inflight.load(),
+          "test_cancelled_task_discarded: 执行中的任务可轮询到取消");
+    check(executed.load() == 1,
+          "test_cancelled_task_discarded: 已取消的排队任务未被执行");
+    check(pool.cancelled_count() == 5,
+          "test_cancelled_task_discarded: 丢弃计数正确");
+    check(!ThreadPool::IsCurrentTaskCancelled(),
+          "test_cancelled_task_discarded: 非worker线程不受取消令牌影响");
+  }
+
+  std::cout << "\n[8] bench_task_hop_allocations\n";
+  {
+    // 模拟一次请求的两次跨线程投递：IO线程 -> worker（捕获 this/weak_ptr/shared_ptr），
+    // worker -> IO线程（额外捕获整个 WorkResult）
+    constexpr size_t kLoopInlineSize = 384;  // 与 EventLoop::kFunctorInlineSize 保持一致
+    constexpr int kRequests = 100000;
+    auto conn_owner = std::make_shared<int>(0);
+    std::weak_ptr<int> weak_conn = conn_owner;
+    auto ctx = std::make_shared<ConnectionWorkContext>();
+    void* self = &weak_conn;
+    size_t sink = 0;
+
+    auto run = [&](auto make_worker_task, auto make_loop_task) {
+      size_t before = g_alloc_count.load();
+      auto begin = std::chrono::steady_clock::now();
+      for (int i = 0; i < kRequests; i++) {
+        auto worker_task = make_worker_task([self, weak_conn, ctx, &sink]() mutable {
+          sink += (self != nullptr) + weak_conn.expired() + ctx->queued_bytes;
+        });
+        worker_task();
+        WorkResult result;
+        result.response_seq = static_cast<uint64_t>(i);
+        auto loop_task = make_loop_task([self, weak_conn, ctx, result = std::move(result), &sink]() mutable {
+          sink += result.response_seq + (self != nullptr) + weak_conn.expired() + ctx->queued_bytes;
+        });
+        loop_task();
+      }
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - begin).count();
+      return std::make_pair(static_cast<double>(g_alloc_count.load() - before) / kRequests,
+                            static_cast<double>(ns) / kRequests);
+    };
+
+    auto std_fn = run([](auto&& f) { return std::function<void()>(std::move(f)); },
+                      [](auto&& f) { return std::function<void()>(std::move(f)); });
+    auto inplace = run([](auto&& f) { return InplaceTask<void(), kTaskInlineSize>(std::move(f)); },
+                       [](auto&& f) { return InplaceTask<void(), kLoopInlineSize>(std::move(f)); });
+
+    std::cout << "  std::function: allocs/request=" << std_fn.first
+              << " ns/request=" << std_fn.second << "\n";
+    std::cout << "  InplaceTask:   allocs/request=" << inplace.first
+              << " ns/request=" << inplace.second << " (sink=" << (sink & 1) << ")\n";
+
+    check(std_fn.first >= 2.0,
+          "bench_task_hop_allocations: std::function每次投递均触发堆分配");
+    check(inplace.first == 0.0,
+          "bench_task_hop_allocations: InplaceTask投递零堆分配");
+
+    std::unique_ptr<int> move_only = std::make_unique<int>(7);
+    InplaceTask<void(), kTaskInlineSize> mo([p = std::move(move_only), &sink]() { sink += *p; });
+    InplaceTask<void(), kTaskInlineSize> moved = std::move(mo);
+    size_t sink_before = sink;
+    moved();
+    check(!mo && moved && sink == sink_before + 7,
+          "bench_task_hop_allocations: InplaceTask支持只可移动的捕获");
+
+    bool threw = false;
+    try {
+      mo();
+    } catch (const std::bad_function_call&) {
+      threw = true;
+    }
+    InplaceTask<void(), kTaskInlineSize> empty;
+    bool empty_threw = false;
+    try {
+      empty();
+    } catch (const std::bad_function_call&) {
+      empty_threw = true;
+    }
+    check(threw && empty_threw && sink == sink_before + 7,
+          "bench_task_hop_allocations: 调用已移走或空的InplaceTask抛出bad_function_call");
+  }
+
+  std::cout << "\n[9] bench_pool_contention\n";
+  {
+    // 多个外部生产者（模拟 IO 线程）经注入队列投递，每个任务再派生子任务压入 worker 本地队列，
+    // 空闲 worker 通过窃取分担派生出的子任务
+    // worker 数按“核数 - 1”配置，留一个核给 IO 线程；超额订阅时结果主要反映上下文切换开销
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    size_t usable_cores = ::sched_getaffinity(0, sizeof(cpus), &cpus) == 0
+                              ? static_cast<size_t>(CPU_COUNT(&cpus))
+                              : std::thread::hardware_concurrency();
+    const size_t kWorkers = std::max<size_t>(1, usable_cores > 0 ? usable_cores - 1 : 1);
+    constexpr size_t kProducers = 4;
+    constexpr size_t kRootsPerProducer = 10000;
+    constexpr size_t kChildren = 3;
+    constexpr size_t kExpected = kProducers * kRootsPerProducer * (1 + kChildren);
+
+    // 容量覆盖全部任务：worker 派生子任务时不能阻塞等待自身队列腾空
+    ThreadPool pool(kWorkers, "CONTENTION_TEST", kExpected);
+    std::atomic<size_t> executed{0};
+    std::atomic<size_t> rejected{0};
+
+    // addTask 失败时任务已被移走，重试需重新构造
+    auto submit = [&](auto fn) {
+      while (!pool.addTask(Task(fn))) {
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        std::this_thread::yield();
+      }
+    };
+
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for (size_t p = 0; p < kProducers; p++) {
+      producers.emplace_back([&]() {
+        for (size_t i = 0; i < kRootsPerProducer; i++) {
+          submit([&]() {
+            executed.fetch_add(1, std::memory_order_relaxed);
+            for (size_t c = 0; c < kChildren; c++) {
+              submit([&]() { executed.fetch_add(1, std::memory_order_relaxed); });
+            }
+          });
+        }
+      });
+    }
+    for (auto& t : producers) t.join();
+
+    for (int wait = 0; wait < 500 && pool.queue_size() > 0; wait++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+    ThreadPool::Stats st = pool.stats();
+
+    // 线程已预热：注入队列与本地队列的压入/弹出/窃取都不应再分配内存
+    constexpr size_t kHopRoots = 2000;
+    std::atomic<size_t> hop_done{0};
+    size_t allocs_before = g_alloc_count.load();
+    for (size_t i = 0; i < kHopRoots; i++) {
+      while (!pool.addTask(Task([&]() {
+        for (size_t c = 0; c < kChildren; c++) {
+          pool.addTask(Task([&]() { hop_done.fetch_add(1, std::memory_order_relaxed); }));
+        }
+        hop_done.fetch_add(1, std::memory_order_relaxed);
+      }))) {
+        std::this_thread::yield();
+      }
+    }
+    for (int wait = 0; wait < 500 && pool.queue_size() > 0; wait++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    size_t hop_allocs = g_alloc_count.load() - allocs_before;
+    pool.stop();
+
+    std::cout << "  tasks=" << kExpected << " throughput="
+              << static_cast<double>(kExpected) * 1e9 / static_cast<double>(ns) << " tasks/s"
+              << " steals=" << st.steals << " parks=" << st.parks
+              << " idle_ms=" << st.idle_ns / 1000000 << " rejected=" << rejected.load() << "\n";
+
+    check(executed.load() == kExpected,
+          "bench_pool_contention: 所有任务均被执行且仅执行一次");
+    check(st.executed == kExpected && st.pending == 0,
+          "bench_pool_contention: 线程池统计与实际执行数一致");
+    std::cout << "  hop_tasks=" << hop_done.load() << " allocs=" << hop_allocs << "\n";
+    check(hop_done.load() == kHopRoots * (1 + kChildren) && hop_allocs == 0,
+          "bench_pool_contention: 任务压入/弹出/窃取零堆分配");
+  }
+
+  std::cout << "\n[10] test_elastic_pool_grow_and_retire\n";
+  {
+    ThreadPool::Options opts;
+    opts.min_threads = 1;
+    opts.max_threads = 4;
+    opts.max_queue_size = 128;
+    opts.blocked_task_ms = 20;
+    opts.idle_retire_ms = 100;
+    opts.monitor_interval_ms = 5;
+    ThreadPool pool("ELASTIC_TEST", opts);
+
+    // 模拟阻塞在 MySQL/磁盘上的 handler：单线程需要 4*150ms 才能跑完
+    constexpr int kBlockingTasks = 4;
+    std::atomic<int> finished{0};
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kBlockingTasks; i++) {
+      pool.addtask([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        finished.fetch_add(1);
+      });
+    }
+
+    size_t peak_live = 0;
+    for (int wait = 0; wait < 200 && finished.load() < kBlockingTasks; wait++) {
+      peak_live = std::max(peak_live, pool.size());
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+
+    for (int wait = 0; wait < 200 && pool.size() > opts.min_threads; wait++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ThreadPool::Stats st = pool.stats();
+    pool.stop();
+
+    std::cout << "  elapsed_ms=" << elapsed_ms << " peak_live=" << peak_live
+              << " spawned=" << st.spawned << " retired=" << st.retired
+              << " live_after_idle=" << st.live_threads << "\n";
+
+    check(finished.load() == kBlockingTasks,
+          "test_elastic_pool_grow_and_retire: 阻塞任务全部完成");
+    check(peak_live > opts.min_threads && peak_live <= opts.max_threads && st.spawned > 0,
+          "test_elastic_pool_grow_and_retire: 检测到阻塞后在上限内扩容");
+    check(elapsed_ms < 150 * kBlockingTasks,
+          "test_elastic_pool_grow_and_retire: 扩容后阻塞任务并行执行");
+    check(st.live_threads == opts.min_threads && st.retired == st.spawned,
+          "test_elastic_pool_grow_and_retire: 空闲线程超时后回收到下限");
+
+    // 在 min_threads 下限处反复提交：唯一的 worker 每次休眠约 idle_retire_ms 后尝试退出并失败，
+    // 提交时机落在这一点附近；每个任务都必须在没有后续提交的情况下被执行
+    ThreadPool::Options edge = opts;
+    edge.min_threads = 1;
+    edge.max_threads = 2;
+    edge.idle_retire_ms = 1;
+    edge.monitor_interval_ms = 1000;   // 不扩容，始终停留在下限
+    ThreadPool edge_pool("RETIRE_EDGE_TEST", edge);
+    constexpr int kEdgeRounds = 1500;
+    std::atomic<int> edge_done{0};
+    int stranded = 0;
+    for (int i = 0; i < kEdgeRounds && stranded == 0; i++) {
+      // 间隔在 0.95ms~1.15ms 间变化，集中覆盖 1ms 空闲超时后的退出检查
+      auto target = std::chrono::steady_clock::now() + std::chrono::microseconds(950 + (i * 37) % 200);
+      while (std::chrono::steady_clock::now() < target) {
+      }
+      edge_pool.addtask([&]() { edge_done.fetch_add(1); });
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(500);
+      while (edge_done.load() < i + 1 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+      }
+      if (edge_done.load() < i + 1) stranded++;
+    }
+    ThreadPool::Stats edge_st = edge_pool.stats();
+    edge_pool.stop();
+    std::cout << "  retire_edge rounds=" << edge_done.load() << " parks=" << edge_st.parks
+              << " live=" << edge_st.live_threads << "\n";
+    check(stranded == 0 && edge_st.live_threads == 1,
+          "test_elastic_pool_grow_and_retire: 下限处的退出检查不会丢失唤醒");
+  }
+
+  std::cout << "\n[11] test_bulkhead_isolation\n";
+  {
+    // 模拟注册洪峰：blocking-db 池被慢任务占满并开始拒绝，cpu 池中的请求不受影响
+    ThreadPool cpu_pool(2, "CPU_TEST", 256);
+    ThreadPool db_pool(1, "DB_TEST", 8);
+
+    std::atomic<bool> release_db{false};
+    std::atomic<size_t> db_rejected{0};
+    std::atomic<bool> db_saw_own_pool{false};
+    for (int i = 0; i < 32; i++) {
+      bool ok = db_pool.addTask(Task([&]() {
+        db_saw_own_pool.store(ThreadPool::Current() == &db_pool);
+        while (!release_db.load()) {
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+      }));
+      if (!ok) db_rejected.fetch_add(1);
+    }
+
+    constexpr int kCpuRequests = 200;
+    std::atomic<int> cpu_done{0};
+    std::atomic<bool> cpu_saw_own_pool{true};
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kCpuRequests; i++) {
+      cpu_pool.addtask([&]() {
+        if (ThreadPool::Current() != &cpu_pool) cpu_saw_own_pool.store(false);
+        cpu_done.fetch_add(1);
+      });
+    }
+    for (int wait = 0; wait < 200 && cpu_done.load() < kCpuRequests; wait++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto cpu_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - begin).count();
+
+    release_db.store(true);
+    for (int wait = 0; wait < 200 && db_pool.queue_size() > 0; wait++) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ThreadPool::Stats db_stats = db_pool.stats();
+    cpu_pool.stop();
+    db_pool.stop();
+
+    std::cout << "  cpu_ms=" << cpu_ms << " db_rejected=" << db_rejected.load()
+              << " db_executed=" << db_stats.executed << "\n";
+
+    check(cpu_done.load() == kCpuRequests && cpu_ms < 200,
+          "test_bulkhead_isolation: db池饱和时cpu池请求照常完成");
+    check(db_rejected.load() > 0 && db_stats.executed + db_rejected.load() == 32,
+          "test_bulkhead_isolation: db池按自身队列上限拒绝");
+    check(db_saw_own_pool.load() && cpu_saw_own_pool.load() && ThreadPool::Current() == nullptr,
+          "test_bulkhead_isolation: Current()返回任务所在的执行池");
+  }
+
+  std::cout << "\n[12] test_reorder_ring_window\n";
+  {
+    // 窗口为 4：处理器在阻塞池中卡住时，后续 9 个响应先完成，超出窗口触发扩容而不是丢弃
+    ReorderRing<WorkResult> ring(4);
+    std::vector<uint64_t> applied;
+    for (uint64_t seq = 2; seq <= 10; seq++) {
+      WorkResult wr;
+      wr.response_seq = seq;
+      ring.Put(seq, wr);
+    }
+    WorkResult ready;
+    bool blocked_head = !ring.HeadReady() && !ring.PopReady(ready);
+    size_t parked = ring.size();
+    size_t grown_window = ring.window();
+
+    WorkResult first;
+    first.response_seq = 1;
+    ring.Put(1, first);
+    while (ring.PopReady(ready)) {
+      applied.push_back(ready.response_seq);
+    }
+    bool in_order = applied.size() == 10;
+    for (size_t i = 0; in_order && i < applied.size(); i++) {
+      in_order = applied[i] == i + 1;
+    }
+
+    WorkResult stale;
+    stale.response_seq = 3;
+    bool stale_rejected = !ring.Put(3, stale);
+
+    check(blocked_head && parked == 9 && grown_window >= 16,
+          "test_reorder_ring_window: 队头未就绪时结果暂存，超窗口自动扩容");
+    check(in_order && ring.applied() == 10 && ring.size() == 0,
+          "test_reorder_ring_window: 队头就绪后按序全部弹出");
+    check(stale_rejected, "test_reorder_ring_window: 已应用的序号被拒绝");
+  }
+
+  std::cout << "\n[13] bench_single_owner_connection\n";
+  {
+    // 对比两种连接处理模型的单核吞吐：
+    //  locked：IO线程把原始数据块排入连接队列，worker 在 ctx->mutex/facade_mutex 下出队、解析、分配序号，
+    //          IO线程在 ctx->mutex 下用 std::map 重排
+    //  owner ：IO线程解析并分配序号，worker 只处理解析好的请求，IO线程用 ReorderRing 无锁重排
+    constexpr int kConns = 8;
+    constexpr int kRequestsPerConn = 20000;
+    constexpr size_t kPipelineDepth = 32;
+    constexpr size_t kWorkers = 4;
+    const std::string raw = "GET /api/files?page=1 HTTP/1.1\r\nHost: localhost\r\nConnection: keep-alive\r\n\r\n";
+
+    auto parse = [](const std::string& data) {
+      uint64_t h = 1469598103934665603ull;
+      for (char c : data) h = (h ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+      return h;
+    };
+    auto business = [](uint64_t v) {
+      for (int i = 0; i < 64; i++) v = v * 6364136223846793005ull + 1442695040888963407ull;
+      return v;
+    };
+
+    struct LoopResult {
+      int conn{0};
+      WorkResult result;
+    };
+
+    struct LockedConn {
+      std::mutex mutex;
+      std::deque<std::string> chunks;
+      bool worker_running{false};
+      std::mutex facade_mutex;
+      uint64_t next_seq{1};
+      uint64_t last_applied{0};
+      std::map<uint64_t, WorkResult> pending;
+    };
+
+    struct OwnerConn {
+      uint64_t next_seq{1};
+      ReorderRing<WorkResult> reorder{kPipelineDepth};
+    };
+
+    auto run = [&](bool owner_model, bool& in_order) {
+      ThreadPool pool(kWorkers, owner_model ? "OWNER_BENCH" : "LOCKED_BENCH", 1 << 16);
+      MpmcQueue<LoopResult> loop_q(1 << 16);
+      std::vector<std::unique_ptr<LockedConn>> locked(kConns);
+      std::vector<std::unique_ptr<OwnerConn>> owned(kConns);
+      for (int c = 0; c < kConns; c++) {
+        locked[c] = std::make_unique<LockedConn>();
+        owned[c] = std::make_unique<OwnerConn>();
+      }
+      std::vector<size_t> inflight(kConns, 0);
+      std::vector<uint64_t> expect(kConns, 1);
+      std::vector<int> sent(kConns, 0);
+      size_t applied_total = 0;
+      in_order = true;
+
+      auto post = [&loop_q](int c, uint64_t seq, uint64_t v) {
+        LoopResult lr;
+        lr.conn = c;
+        lr.result.response_seq = seq;
+        lr.result.has_response = (v & 1) != 0;
+        while (!loop_q.push(lr)) std::this_thread::yield();
+      };
+
+      // 与原 HandleMessageInWorker/OnWorkerExit 一致：每个任务处理一个数据块，退出时若仍有积压再调度下一个任务
+      std::function<void(int)> locked_worker = [&](int c) {
+        LockedConn& lc = *locked[c];
+        std::string chunk;
+        {
+          std::lock_guard<std::mutex> lk(lc.mutex);
+          if (lc.chunks.empty()) {
+            lc.worker_running = false;
+            return;
+          }
+          chunk = std::move(lc.chunks.front());
+          lc.chunks.pop_front();
+        }
+        uint64_t parsed;
+        uint64_t seq;
+        {
+          std::lock_guard<std::mutex> fl(lc.facade_mutex);
+          parsed = parse(chunk);
+          std::lock_guard<std::mutex> lk(lc.mutex);
+          seq = lc.next_seq++;
+        }
+        post(c, seq, business(parsed));
+        std::lock_guard<std::mutex> lk(lc.mutex);
+        if (lc.chunks.empty()) {
+          lc.worker_running = false;
+        } else {
+          while (!pool.addTask(Task([&locked_worker, c]() { locked_worker(c); }))) {
+            std::this_thread::yield();
+          }
+        }
+      };
+
+      auto apply = [&](LoopResult& lr) {
+        const int c = lr.conn;
+        auto deliver = [&](const WorkResult& r) {
+          if (r.response_seq != expect[c]) in_order = false;
+          expect[c]++;
+          inflight[c]--;
+          applied_total++;
+        };
+        if (owner_model) {
+          OwnerConn& oc = *owned[c];
+          oc.reorder.Put(lr.result.response_seq, lr.result);
+          WorkResult ready;
+          while (oc.reorder.PopReady(ready)) deliver(ready);
+        } else {
+          LockedConn& lc = *locked[c];
+          std::vector<WorkResult> to_apply;
+          {
+            std::lock_guard<std::mutex> lk(lc.mutex);
+            if (lr.result.response_seq != lc.last_applied + 1) {
+              lc.pending.emplace(lr.result.response_seq, std::move(lr.result));
+              return;
+            }
+            to_apply.push_back(std::move(lr.result));
+            lc.last_applied++;
+            while (true) {
+              auto it = lc.pending.find(lc.last_applied + 1);
+              if (it == lc.pending.end()) break;
+              to_apply.push_back(std::move(it->second));
+              lc.pending.erase(it);
+              lc.last_applied++;
+            }
+          }
+          for (auto& r : to_apply) deliver(r);
+        }
+      };
+
+      const size_t total = static_cast<size_t>(kConns) * kRequestsPerConn;
+      auto cpu_now = []() {
+        timespec ts{};
+        ::clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+        return static_cast<double>(ts.tv_sec) * 1e9 + static_cast<double>(ts.tv_nsec);
+      };
+      const double cpu_begin = cpu_now();
+      while (applied_total < total) {
+        // IO线程：为每个连接补满流水线窗口
+        for (int c = 0; c < kConns; c++) {
+          while (sent[c] < kRequestsPerConn && inflight[c] < kPipelineDepth) {
+            sent[c]++;
+            inflight[c]++;
+            if (owner_model) {
+              uint64_t parsed = parse(raw);
+              uint64_t seq = owned[c]->next_seq++;
+              while (!pool.addTask(Task([&post, &business, c, seq, parsed]() { post(c, seq, business(parsed)); }))) {
+                std::this_thread::yield();
+              }
+            } else {
+              LockedConn& lc = *locked[c];
+              bool start = false;
+              {
+                std::lock_guard<std::mutex> lk(lc.mutex);
+                lc.chunks.push_back(raw);
+                if (!lc.worker_running) {
+                  lc.worker_running = true;
+                  start = true;
+                }
+              }
+              if (start) {
+                while (!pool.addTask(Task([&locked_worker, c]() { locked_worker(c); }))) {
+                  std::this_thread::yield();
+                }
+              }
+            }
+          }
+        }
+        LoopResult lr;
+        bool any = false;
+        while (loop_q.pop(lr)) {
+          apply(lr);
+          any = true;
+        }
+        if (!any) std::this_thread::yield();
+      }
+      const double cpu_ns = cpu_now() - cpu_begin;
+      pool.stop();
+      // 按进程消耗的 CPU 时间折算单核吞吐，与机器核数无关
+      return static_cast<double>(total) * 1e9 / cpu_ns;
+    };
+
+    bool locked_in_order = false;
+    bool owner_in_order = false;
+    double locked_rps = run(false, locked_in_order);
+    double owner_rps = run(true, owner_in_order);
+
+    std::cout << "  workers=" << kWorkers << "\n";
+    std::cout << "  locked: req/s/core=" << static_cast<uint64_t>(locked_rps) << "\n";
+    std::cout << "  owner:  req/s/core=" << static_cast<uint64_t>(owner_rps) << "\n";
+
+    check(locked_in_order && owner_in_order,
+          "bench_single_owner_connection: 两种模型下每个连接的响应均按序回写");
+  }
+
+  std::cout << "\n[14] test_latency_histogram_shards\n";
+  {
+    // 分桶误差：任意值落入的桶上界与真实值的相对误差不超过 1/16
+    bool bounded = true;
+    for (uint64_t v : {0ull, 1ull, 31ull, 32ull, 33ull, 100ull, 999ull, 12345ull, 1000000ull, 4000000000ull}) {
+      uint64_t ub = LatencyHistogram::BucketUpperBound(LatencyHistogram::BucketIndex(v));
+      if (ub < v || static_cast<double>(ub - v) > static_cast<double>(v) / 16.0 + 1.0) bounded = false;
+    }
+
+    // 4 个线程各自写入自己的分片：每线程 1000 个请求，耗时 1..1000 微秒
+    LatencyRecorder recorder(kRouteBucketCount);
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 1000;
+    std::vector<std::thread> writers;
+    for (int t = 0; t < kThreads; t++) {
+      writers.emplace_back([&recorder, t]() {
+        for (int i = 1; i <= kPerThread; i++) {
+          LatencyRecorder::Sample sample;
+          sample.stage_us[static_cast<size_t>(LatencyStage::Total)] = static_cast<uint64_t>(i);
+          sample.error = (i % 100 == 0);
+          recorder.Record(static_cast<size_t>(t % 2 == 0 ? RouteBucket::Api : RouteBucket::Static), sample);
+        }
+      });
+    }
+    for (auto& w : writers) w.join();
+
+    auto snap = recorder.Snapshot();
+    const auto& api = snap[static_cast<size_t>(RouteBucket::Api)];
+    const auto& total = api.stages[static_cast<size_t>(LatencyStage::Total)];
+    uint64_t p50 = total.Percentile(0.50);
+    uint64_t p99 = total.Percentile(0.99);
+    std::cout << "  api: req=" << api.requests << " p50_us=" << p50 << " p99_us=" << p99
+              << " max_us=" << total.Max() << "\n";
+
+    check(bounded, "test_latency_histogram_shards: 分桶相对误差不超过1/16");
+    check(api.requests == 2 * kPerThread && api.errors == 20 &&
+              snap[static_cast<size_t>(RouteBucket::Static)].requests == 2 * kPerThread,
+          "test_latency_histogram_shards: 各线程分片合并后计数完整");
+    check(p50 >= 500 && p50 <= 532 && p99 >= 990 && p99 <= 1055,
+          "test_latency_histogram_shards: 合并后的p50/p99落在真实值的桶内");
+
+    // 同一线程交替写入多个实例：两个实例交替命中线程本地缓存，超过缓存路数时回退到按线程查找，
+    // 每个实例都只注册一个分片
+    LatencyRecorder first(kRouteBucketCount);
+    LatencyRecorder second(kRouteBucketCount);
+    std::vector<std::unique_ptr<LatencyRecorder>> many;
+    for (int i = 0; i < 6; i++) many.push_back(std::make_unique<LatencyRecorder>(kRouteBucketCount));
+    LatencyRecorder::Sample one;
+    for (int i = 0; i < 1000; i++) {
+      first.Record(0, one);
+      second.Record(0, one);
+      many[static_cast<size_t>(i) % many.size()]->Record(0, one);
+    }
+    bool single_shard = first.shard_count() == 1 && second.shard_count() == 1;
+    for (const auto& r : many) single_shard = single_shard && r->shard_count() == 1;
+    check(single_shard && first.Snapshot()[0].requests == 1000 && second.Snapshot()[0].requests == 1000,
+          "test_latency_histogram_shards: 同一线程交替写入多个实例时每个实例只有一个分片");
+  }
+
+  std::cout << "\n[15] test_prometheus_histogram_export\n";
+  {
+    // 1..1000 微秒各一次：le 边界累计计数单调、+Inf 等于总数，sum 换算为秒
+    LatencyHistogram hist;
+    uint64_t sum_us = 0;
+    for (uint64_t v = 1; v <= 1000; v++) {
+      hist.Record(v);
+      sum_us += v;
+    }
+    PrometheusText out;
+    out.Family("t_seconds", "histogram", "test");
+    out.Histogram("t_seconds", {{"route", "a\"b"}}, hist, sum_us, {100, 500, 1000});
+    const std::string text = out.str();
+    std::cout << text;
+
+    auto count_for = [&text](const std::string& series) -> long {
+      size_t pos = text.find(series + " ");
+      if (pos == std::string::npos) return -1;
+      return std::atol(text.c_str() + pos + series.size() + 1);
+    };
+    const long le100 = count_for("t_seconds_bucket{route=\"a\\\"b\",le=\"0.0001\"}");
+    const long le500 = count_for("t_seconds_bucket{route=\"a\\\"b\",le=\"0.0005\"}");
+    const long le1000 = count_for("t_seconds_bucket{route=\"a\\\"b\",le=\"0.001\"}");
+    const long inf = count_for("t_seconds_bucket{route=\"a\\\"b\",le=\"+Inf\"}");
+
+    check(text.find("# TYPE t_seconds histogram\n") != std::string::npos,
+          "test_prometheus_histogram_export: 输出HELP/TYPE");
+    check(le100 >= 100 && le100 <= 104 && le500 >= 500 && le500 <= 512 && le1000 == 1000 && inf == 1000,
+          "test_prometheus_histogram_export: le累计计数落在分桶误差内");
+    check(text.find("t_seconds_sum{route=\"a\\\"b\"} 0.5005\n") != std::string::npos &&
+              count_for("t_seconds_count{route=\"a\\\"b\"}") == 1000,
+          "test_prometheus_histogram_export: sum/count正确且标签值已转义");
+  }
+
+  std::cout << "\n[16] test_admission_controller_codel\n";
+  {
+    AdmissionController::Options opts;
+    opts.target_us = 5000;
+    opts.interval_us = 100000;
+
+    // 逐级升降：窗口最小逗留时间超过 target 升一级，低于 target 降一级（队列很短，不触发 Little 定律估算）
+    AdmissionController ac(opts);
+    uint64_t now = 1000000;
+    auto run_window = [&](uint64_t sojourn_us) {
+      for (int i = 0; i < 10; i++) {
+        now += opts.interval_us / 10 + 1;
+        ac.Observe(sojourn_us, now);
+      }
+    };
+    run_window(20000);
+    run_window(20000);
+    const uint32_t level_one = ac.shed_level();
+    const bool low_shed = !ac.Admit(AdmissionPriority::Low, 1, now);
+    const bool normal_kept = ac.Admit(AdmissionPriority::Normal, 1, now);
+    run_window(20000);
+    const uint32_t level_two = ac.shed_level();
+    const bool normal_shed = !ac.Admit(AdmissionPriority::Normal, 1, now);
+    const bool high_kept = ac.Admit(AdmissionPriority::High, 1, now);
+    run_window(1000);
+    const uint32_t recovered_one = ac.shed_level();
+    const bool drained = ac.Admit(AdmissionPriority::Low, 0, now) && ac.shed_level() == 0;
+
+    // worker 全部阻塞：一个窗口内没有出队，按队列长度 / 出队速率估算后直接拒绝到最高级
+    AdmissionController stalled(opts);
+    uint64_t t = 1000000;
+    for (int i = 0; i < 20; i++) {
+      t += 10001;
+      stalled.Observe(100, t);
+    }
+    t += 2 * opts.interval_us;
+    const bool stall_shed = !stalled.Admit(AdmissionPriority::Normal, 10000, t) && stalled.shed_level() == 2;
+
+    check(level_one == 1 && low_shed && normal_kept,
+          "test_admission_controller_codel: 持续超过target后先拒绝Low");
+    check(level_two == 2 && normal_shed && high_kept,
+          "test_admission_controller_codel: 继续积压时拒绝Normal，High始终放行");
+    check(recovered_one == 1 && drained,
+          "test_admission_controller_codel: 低于target逐级恢复，队列排空立即放行");
+    check(stall_shed, "test_admission_controller_codel: 无出队时按Little定律判定过载");
+
+    // 单服务台仿真（虚拟时钟）：服务 1ms，每 0.5ms 到达一个请求（2 倍过载），三种优先级轮流
+    // 不做准入时排队无限增长；准入控制后被放行请求的 p99 逗留时间有界
+    auto simulate = [&opts](bool controlled, uint64_t& p99_us, uint64_t& shed) {
+      AdmissionController sim(opts);
+      std::deque<std::pair<uint64_t, int>> queue;
+      LatencyHistogram sojourn;
+      uint64_t busy_until = 0;
+      shed = 0;
+      for (uint64_t i = 0; i < 8000; i++) {
+        const uint64_t t_arrive = 1000000 + i * 500;
+        while (!queue.empty() && busy_until <= t_arrive) {
+          const uint64_t start = std::max(busy_until, queue.front().first);
+          sim.Observe(start - queue.front().first, start);
+          sojourn.Record(start - queue.front().first);
+          busy_until = start + 1000;
+          queue.pop_front();
+        }
+        const size_t queue_len = queue.size() + (busy_until > t_arrive ? 1 : 0);
+        const auto prio = static_cast<AdmissionPriority>(i % 3);
+        if (controlled && !sim.Admit(prio, queue_len, t_arrive)) {
+          shed++;
+          continue;
+        }
+        queue.emplace_back(t_arrive, static_cast<int>(prio));
+      }
+      p99_us = sojourn.Percentile(0.99);
+    };
+    uint64_t p99_uncontrolled = 0, p99_controlled = 0, shed_uncontrolled = 0, shed_controlled = 0;
+    simulate(false, p99_uncontrolled, shed_uncontrolled);
+    simulate(true, p99_controlled, shed_controlled);
+    std::cout << "  2x overload: p99_sojourn_us uncontrolled=" << p99_uncontrolled
+              << " controlled=" << p99_controlled << " shed=" << shed_controlled << "\n";
+    check(p99_uncontrolled > 1000000 && p99_controlled < 200000,
+          "test_admission_controller_codel: 过载时放行请求的p99逗留时间有界");
+  }
+
+  std::cout << "\n[17] test_segmented_http1_parse\n";
+  {
+    const std::string first =
+        "POST /api/items?id=7 HTTP/1.1\r\n"
+        "Host: example.com\r\n"
+        "Content-Type: text/plain\r\n"
+        "Content-Length: 11\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n"
+        "hello world";
+    const std::string second = "GET /next HTTP/1.1\r\nHost: example.com\r\n\r\n";
+    const std::string wire = first + second;
+
+    auto as_request = [](std::unique_ptr<IHttpMessage>& msg) {
+      return dynamic_cast<HttpRequest*>(msg.get());
+    };
+    auto request_ok = [](const HttpRequest* req) {
+      if (!req) return false;
+      auto conn = req->GetHeaderView("connection");
+      return req->GetMethod() == HttpMethod::POST && req->GetPath() == "/api/items" &&
+             req->GetBody() == "hello world" && conn && *conn == "keep-alive" &&
+             req->GetHeader("CONTENT-TYPE").value_or("") == "text/plain" && req->HeaderCount() == 4;
+    };
+
+    // 任意切分点拆成两段（模拟请求跨越输入缓冲的内存块边界）都得到相同结果，且只消费第一个请求
+    bool every_split_ok = true;
+    for (size_t k = 0; k <= wire.size(); k++) {
+      struct iovec iov[2] = {{const_cast<char*>(wire.data()), k},
+                             {const_cast<char*>(wire.data()) + k, wire.size() - k}};
+      Http1Parser parser;
+      std::unique_ptr<IHttpMessage> msg;
+      int rc = parser.ParseSegments(iov, 2, msg);
+      if (rc != static_cast<int>(ParseResult::SUCCESS) || parser.GetConsumeBytes() != first.size() ||
+          !request_ok(as_request(msg))) {
+        every_split_ok = false;
+      }
+    }
+
+    // 任何不完整的前缀都返回 NEEDMOREDATA 且不消费字节
+    bool prefix_needs_more = true;
+    for (size_t k = 1; k < first.size(); k++) {
+      struct iovec iov[1] = {{const_cast<char*>(first.data()), k}};
+      Http1Parser parser;
+      std::unique_ptr<IHttpMessage> msg;
+      if (parser.ParseSegments(iov, 1, msg) != static_cast<int>(ParseResult::NEEDMOREDATA) ||
+          parser.GetConsumeBytes() != 0 || msg) {
+        prefix_needs_more = false;
+      }
+    }
+
+    // chunked 与响应报文交给流式状态机；物化后的头部与流式路径一致
+    const std::string chunked = "POST /u HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n\r\n";
+    struct iovec chunked_iov[1] = {{const_cast<char*>(chunked.data()), chunked.size()}};
+    Http1Parser fallback_parser;
+    std::unique_ptr<IHttpMessage> fallback_msg;
+    const bool chunked_streams =
+        fallback_parser.ParseSegments(chunked_iov, 1, fallback_msg) == static_cast<int>(ParseResult::NEEDSTREAMING);
+
+    std::string legacy_input = first;
+    Http1Parser legacy_parser;
+    std::unique_ptr<IHttpMessage> legacy_msg;
+    legacy_parser.Parse(legacy_input, legacy_msg);
+    struct iovec one_iov[1] = {{const_cast<char*>(first.data()), first.size()}};
+    Http1Parser seg_parser;
+    std::unique_ptr<IHttpMessage> seg_msg;
+    seg_parser.ParseSegments(one_iov, 1, seg_msg);
+    const bool same_headers = legacy_msg && seg_msg && legacy_msg->GetAllHeaders() == seg_msg->GetAllHeaders();
+
+    const std::string bad = "GET / HTTP/1.1\r\nno-colon-here\r\n\r\n";
+    struct iovec bad_iov[1] = {{const_cast<char*>(bad.data()), bad.size()}};
+    Http1Parser bad_parser;
+    std::unique_ptr<IHttpMessage> bad_msg;
+    const bool bad_rejected =
+        bad_parser.ParseSegments(bad_iov, 1, bad_msg) == static_cast<int>(ParseResult::INVALIDHEADER);
+
+    check(every_split_ok, "test_segmented_http1_parse: 任意切分点跨段解析结果一致");
+    check(prefix_needs_more, "test_segmented_http1_parse: 不完整前缀返回NEEDMOREDATA且不消费");
+    check(chunked_streams && same_headers && bad_rejected,
+          "test_segmented_http1_parse: chunked回退流式解析，头部与流式路径一致，非法头部拒绝");
+
+    // 基准：典型浏览器 GET（约 700B、十余个头部），旧路径为 bufferToString 拷贝后流式解析
+    const std::string browser_get =
+        "GET /api/feed?page=2&size=20 HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "Connection: keep-alive\r\n"
+        "sec-ch-ua: \"Chromium\";v=\"124\", \"Google Chrome\";v=\"124\", \"Not-A.Brand\";v=\"99\"\r\n"
+        "sec-ch-ua-mobile: ?0\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) "
+        "Chrome/124.0.0.0 Safari/537.36\r\n"
+        "sec-ch-ua-platform: \"Linux\"\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+        "Sec-Fetch-Site: same-origin\r\n"
+        "Sec-Fetch-Mode: cors\r\n"
+        "Sec-Fetch-Dest: empty\r\n"
+        "Referer: https://www.example.com/feed\r\n"
+        "Accept-Encoding: gzip, deflate, br, zstd\r\n"
+        "Accept-Language: en-US,en;q=0.9,zh-CN;q=0.8\r\n"
+        "Cookie: session=4f9a1c2e7b3d4a5f8e6c0b1a2d3e4f5a; theme=dark; lang=en\r\n"
+        "\r\n";
+    constexpr int kIters = 20000;
+    size_t sink = 0;
+
+    const size_t legacy_alloc_before = g_alloc_count.load(std::memory_order_relaxed);
+    auto legacy_begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIters; i++) {
+      std::string data = browser_get;
+      Http1Parser parser;
+      std::unique_ptr<IHttpMessage> msg;
+      parser.Parse(data, msg);
+      sink += msg->GetHeader("Connection").value_or("").size();
+    }
+    auto legacy_end = std::chrono::steady_clock::now();
+    const size_t legacy_allocs = g_alloc_count.load(std::memory_order_relaxed) - legacy_alloc_before;
+
+    const size_t seg_alloc_before = g_alloc_count.load(std::memory_order_relaxed);
+    auto seg_begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kIters; i++) {
+      struct iovec iov[1] = {{const_cast<char*>(browser_get.data()), browser_get.size()}};
+      Http1Parser parser;
+      std::unique_ptr<IHttpMessage> msg;
+      parser.ParseSegments(iov, 1, msg);
+      sink += static_cast<HttpRequest*>(msg.get())->GetHeaderView("Connection").value_or("").size();
+    }
+    auto seg_end = std::chrono::steady_clock::now();
+    const size_t seg_allocs = g_alloc_count.load(std::memory_order_relaxed) - seg_alloc_before;
+
+    const double legacy_ns = std::chrono::duration<double, std::nano>(legacy_end - legacy_begin).count() / kIters;
+    const double seg_ns = std::chrono::duration<double, std::nano>(seg_end - seg_begin).count() / kIters;
+    std::cout << "  " << browser_get.size() << "B GET: legacy=" << static_cast<long>(legacy_ns)
+              << "ns/req allocs=" << legacy_allocs / kIters
+              << "  segmented=" << static_cast<long>(seg_ns) << "ns/req allocs=" << seg_allocs / kIters
+              << " (sink=" << sink << ")\n";
+    check(seg_allocs * 4 < legacy_allocs,
+          "test_segmented_http1_parse: 分段解析每请求的堆分配远少于流式路径");
+  }
+
+  std::cout << "\n[18] test_http_scan_kernels\n";
+  {
+    // 各向量实现与标量实现逐项对照：覆盖所有长度的尾部、不同对齐与每个字节值
+    const HttpScanIsa original = HttpScanActiveIsa();
+    std::vector<HttpScanIsa> isas;
+    for (HttpScanIsa isa : {HttpScanIsa::Scalar, HttpScanIsa::Sse42, HttpScanIsa::Avx2}) {
+      if (HttpScanIsaSupported(isa)) isas.push_back(isa);
+    }
+    std::cout << "  active=" << HttpScanIsaName(original) << " supported=" << isas.size() << "\n";
+
+    uint64_t rng = 0x9E3779B97F4A7C15ull;
+    auto next = [&rng]() {
+      rng ^= rng << 13;
+      rng ^= rng >> 7;
+      rng ^= rng << 17;
+      return rng;
+    };
+    const std::string token_chars = "abcXYZ019!#$%&'*+-.^_`|~";
+    std::vector<std::string> samples;
+    for (size_t len = 0; len <= 80; len++) {
+      std::string tok;
+      for (size_t i = 0; i < len; i++) tok.push_back(token_chars[next() % token_chars.size()]);
+      samples.push_back(tok);
+      // 在每个位置插入一个非法字节，验证向量块内任意偏移都能被发现
+      for (size_t pos = 0; pos < len; pos += 7) {
+        std::string bad = tok;
+        bad[pos] = static_cast<char>(next() % 256);
+        samples.push_back(bad);
+      }
+      std::string line = tok;
+      if (len >= 2) line[len / 2] = '\r', line[len / 2 + 1] = '\n';
+      samples.push_back(line);
+      std::string value;
+      for (size_t i = 0; i < len; i++) value.push_back(static_cast<char>(0x20 + next() % 0x5F));
+      samples.push_back(value);
+    }
+    std::string all_bytes;
+    for (int c = 0; c < 256; c++) all_bytes.push_back(static_cast<char>(c));
+    for (int c = 0; c < 256; c++) samples.push_back(std::string(40, 'a') + static_cast<char>(c) + "bc");
+    samples.push_back(all_bytes);
+
+    bool kernels_agree = true;
+    for (const std::string& sample : samples) {
+      for (size_t offset = 0; offset < 3 && offset <= sample.size(); offset++) {
+        const char* p = sample.data() + offset;
+        const size_t n = sample.size() - offset;
+        HttpScanForceIsa(HttpScanIsa::Scalar);
+        const size_t crlf = HttpScanFindCrlf(p, n);
+        const bool token = HttpScanIsToken(p, n);
+        const bool value = HttpScanIsFieldValue(p, n);
+        std::string lower(p, n);
+        HttpScanLowerAscii(lower.data(), lower.size());
+        for (HttpScanIsa isa : isas) {
+          HttpScanForceIsa(isa);
+          std::string l2(p, n);
+          HttpScanLowerAscii(l2.data(), l2.size());
+          if (HttpScanFindCrlf(p, n) != crlf || HttpScanIsToken(p, n) != token ||
+              HttpScanIsFieldValue(p, n) != value || l2 != lower) {
+            kernels_agree = false;
+          }
+        }
+      }
+    }
+    HttpScanForceIsa(HttpScanIsa::Scalar);
+    const bool scalar_semantics =
+        HttpScanIsToken("Content-Type", 12) && !HttpScanIsToken("Content Type", 12) && !HttpScanIsToken("", 0) &&
+        HttpScanIsFieldValue("a\tb \x80", 5) && !HttpScanIsFieldValue("a\nb", 3) && !HttpScanIsFieldValue("\x7f", 1) &&
+        HttpScanFindCrlf("ab\rc\r\n", 6) == 4 && HttpScanFindCrlf("ab\r", 3) == 3;
+    HttpScanForceIsa(original);
+
+    check(kernels_agree, "test_http_scan_kernels: 各指令集实现与标量实现结果一致");
+    check(scalar_semantics, "test_http_scan_kernels: token/字段值/CRLF语义正确");
+
+    // 基准：4KB 头部块（无 CRLF）上的行尾查找、token 校验与大小写折叠
+    std::string block;
+    while (block.size() < 4096) block += "Accept-Language-Extension-X";
+    block.resize(4096);
+    constexpr int kScanIters = 20000;
+    for (HttpScanIsa isa : isas) {
+      HttpScanForceIsa(isa);
+      size_t scan_sink = 0;
+      auto t0 = std::chrono::steady_clock::now();
+      for (int i = 0; i < kScanIters; i++) {
+        scan_sink += HttpScanFindCrlf(block.data(), block.size());
+        scan_sink += HttpScanIsToken(block.data(), block.size()) ? 1 : 0;
+        HttpScanLowerAscii(block.data(), block.size());
+      }
+      auto t1 = std::chrono::steady_clock::now();
+      const double ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / kScanIters;
+      std::cout << "  " << HttpScanIsaName(isa) << ": " << static_cast<long>(ns) << "ns per 4KB (sink="
+                << scan_sink << ")\n";
+    }
+    HttpScanForceIsa(original);
+  }
+
+  std::cout << "\n[19] test_header_table\n";
+  {
+    const std::string wire =
+        "GET /files/a.txt HTTP/1.1\r\n"
+        "Host: example.com\r\n"
+        "CONNECTION: keep-alive\r\n"
+        "Range: bytes=0-99\r\n"
+        "X-Trace-Id: abc\r\n"
+        "x-trace-id: def\r\n"
+        "If-None-Match: \"v1\"\r\n"
+        "\r\n";
+    struct iovec iov[1] = {{const_cast<char*>(wire.data()), wire.size()}};
+    Http1Parser parser;
+    std::unique_ptr<IHttpMessage> msg;
+    parser.ParseSegments(iov, 1, msg);
+    auto* req = dynamic_cast<HttpRequest*>(msg.get());
+
+    // 常用头部在解析时即解析为枚举，按枚举与按名称（任意大小写）读取结果一致；重复头部保持顺序
+    bool lookups_ok = req && req->GetHeaderView(KnownHeader::Host).value_or("") == "example.com" &&
+                      req->GetHeaderView(KnownHeader::Connection).value_or("") == "keep-alive" &&
+                      req->GetHeaderView("Range").value_or("") == "bytes=0-99" &&
+                      req->GetHeaderView(KnownHeader::IfNoneMatch).value_or("") == "\"v1\"" &&
+                      !req->GetHeaderView(KnownHeader::ContentLength) &&
+                      req->GetHeaderView(" X-TRACE-ID ").value_or("") == "abc" &&
+                      req->GetHeaders("x-trace-id") == std::vector<std::string>{"abc", "def"};
+    std::string keys;
+    if (req) req->ForEachHeader([&keys](std::string_view k, std::string_view) { keys.append(k).push_back(','); });
+    lookups_ok = lookups_ok && keys == "host,connection,range,x-trace-id,x-trace-id,if-none-match,";
+
+    // 修改：Set 替换全部同名头部，Remove 后枚举索引同步更新，拷贝后视图指向新对象自己的存储
+    bool mutate_ok = false;
+    if (req) {
+      req->SetHeader("X-Trace-Id", "zzz");
+      req->RemoveHeader("connection");
+      req->AppendHeader("Connection", "close");
+      HttpRequest copy(*req);
+      req->ClearHeaders();
+      mutate_ok = copy.GetHeaders("x-trace-id") == std::vector<std::string>{"zzz"} &&
+                  copy.GetHeaderView(KnownHeader::Connection).value_or("") == "close" &&
+                  copy.GetHeaderView(KnownHeader::Host).value_or("") == "example.com" &&
+                  copy.HeaderCount() == 5 && req->HeaderCount() == 0 && !req->GetHeaderView(KnownHeader::Host);
+    }
+
+    // 反复覆盖同一头部会触发 arena 整理，整理后所有头部仍然正确
+    HeaderTable table;
+    table.Append("Content-Type", "text/html");
+    for (int i = 0; i < 200; i++) {
+      table.Set("X-Counter", std::to_string(i) + std::string(32, 'x'));
+      table.Set(KnownHeader::ETag, *table.Get("x-counter"));
+    }
+    const bool compact_ok = table.Size() == 3 && table.Get(KnownHeader::ContentType).value_or("") == "text/html" &&
+                            table.Get("X-Counter").value_or("") == "199" + std::string(32, 'x') &&
+                            table.Get(KnownHeader::ETag) == table.Get("x-counter");
+
+    // 响应与请求共用头部表：序列化保持写入顺序与小写名称
+    HttpResponse resp(HttpStatusCode::OK);
+    resp.SetHeader("Content-Type", "text/plain");
+    resp.SetHeader("X-Request-Id", "r1");
+    resp.SetHeader(KnownHeader::Vary, "Origin");
+    resp.SetHeader("content-type", "application/json");
+    resp.SetBody("{}");
+    const bool response_ok =
+        resp.Serialize() ==
+            "HTTP/1.1 200 OK\r\ncontent-length: 2\r\nx-request-id: r1\r\nvary: Origin\r\n"
+            "content-type: application/json\r\n\r\n{}" &&
+        resp.GetHeaderView(KnownHeader::ContentType).value_or("") == "application/json" &&
+        resp.GetAllHeaders().size() == 3 && resp.GetAllHeaders()[0].first == "x-request-id";
+
+    check(lookups_ok, "test_header_table: 常用头部按枚举O(1)读取，名称查找忽略大小写，重复头部保序");
+    check(mutate_ok, "test_header_table: Set/Remove/Append后索引正确，拷贝独立");
+    check(compact_ok, "test_header_table: 反复覆盖后arena整理，值保持正确");
+    check(response_ok, "test_header_table: 响应共用头部表，序列化保持顺序与小写名称");
+
+    // 基准：每请求读取 5 个常用头部，旧接口按名称构造规范化 key 并返回 string 拷贝
+    HttpRequest bench;
+    bench.AppendHeader("Host", "www.example.com");
+    bench.AppendHeader("User-Agent", "Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 Chrome/124.0.0.0");
+    bench.AppendHeader("Accept", "text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8");
+    bench.AppendHeader("Accept-Encoding", "gzip, deflate, br, zstd");
+    bench.AppendHeader("Accept-Language", "en-US,en;q=0.9,zh-CN;q=0.8");
+    bench.AppendHeader("Cookie", "session=4f9a1c2e7b3d4a5f8e6c0b1a2d3e4f5a; theme=dark; lang=en");
+    bench.AppendHeader("Connection", "keep-alive");
+    bench.AppendHeader("If-None-Match", "W/\"5f1a-18c2b3\"");
+    constexpr int kLookupIters = 200000;
+    size_t header_sink = 0;
+
+    const size_t str_alloc_before = g_alloc_count.load(std::memory_order_relaxed);
+    auto str_begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kLookupIters; i++) {
+      header_sink += bench.GetHeader("Connection").value_or("").size();
+      header_sink += bench.GetHeader("Content-Length").value_or("").size();
+      header_sink += bench.GetHeader("Transfer-Encoding").value_or("").size();
+      header_sink += bench.GetHeader("If-None-Match").value_or("").size();
+      header_sink += bench.GetHeader("Range").value_or("").size();
+    }
+    auto str_end = std::chrono::steady_clock::now();
+    const size_t str_allocs = g_alloc_count.load(std::memory_order_relaxed) - str_alloc_before;
+
+    const size_t id_alloc_before = g_alloc_count.load(std::memory_order_relaxed);
+    auto id_begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kLookupIters; i++) {
+      header_sink += bench.GetHeaderView(KnownHeader::Connection).value_or("").size();
+      header_sink += bench.GetHeaderView(KnownHeader::ContentLength).value_or("").size();
+      header_sink += bench.GetHeaderView(KnownHeader::TransferEncoding).value_or("").size();
+      header_sink += bench.GetHeaderView(KnownHeader::IfNoneMatch).value_or("").size();
+      header_sink += bench.GetHeaderView(KnownHeader::Range).value_or("").size();
+    }
+    auto id_end = std::chrono::steady_clock::now();
+    const size_t id_allocs = g_alloc_count.load(std::memory_order_relaxed) - id_alloc_before;
+
+    const double str_ns = std::chrono::duration<double, std::nano>(str_end - str_begin).count() / kLookupIters;
+    const double id_ns = std::chrono::duration<double, std::nano>(id_end - id_begin).count() / kLookupIters;
+    std::cout << "  5 lookups/req: by-name string=" << static_cast<long>(str_ns) << "ns allocs=" << str_allocs / kLookupIters
+              << "  by-id view=" << static_cast<long>(id_ns) << "ns allocs=" << id_allocs / kLookupIters
+              << " (sink=" << header_sink << ")\n";
+    check(id_allocs == 0, "test_header_table: 按枚举读取头部不产生堆分配");
+  }
+
+  std::cout << "\n[20] test_response_serialize_once\n";
+  {
+    auto head_plus_body = [](HttpResponse resp) {
+      std::string out;
+      resp.SerializeHeadTo(out);
+      out += resp.TakeBody();
+      return out;
+    };
+
+    HttpResponse ok(HttpStatusCode::OK);
+    ok.SetHeader("Content-Type", "application/json");
+    ok.SetBody("{\"ok\":true}");
+    HttpResponse custom(HttpStatusCode::NOT_FOUND);
+    custom.SetStatusCodeWithReason(HttpStatusCode::NOT_FOUND, "Nope");
+    custom.SetVersion(HttpVersion::HTTP_1_0);
+    HttpResponse explicit_len(HttpStatusCode::PARTIAL_CONTENT);
+    explicit_len.SetHeader("Content-Length", "100");
+    explicit_len.SetHeader("Content-Range", "bytes 0-99/1000");
+
+    const bool format_ok =
+        ok.Serialize() == "HTTP/1.1 200 OK\r\ncontent-length: 11\r\ncontent-type: application/json\r\n\r\n{\"ok\":true}" &&
+        custom.Serialize() == "HTTP/1.0 404 Nope\r\ncontent-length: 0\r\n\r\n" &&
+        explicit_len.Serialize() ==
+            "HTTP/1.1 206 Partial Content\r\ncontent-length: 100\r\ncontent-range: bytes 0-99/1000\r\n\r\n";
+    bool size_exact = true;
+    for (HttpResponse* r : {&ok, &custom, &explicit_len}) {
+      const std::string full = r->Serialize();
+      size_exact = size_exact && r->SerializedSize() == full.size() && head_plus_body(*r) == full;
+    }
+    check(format_ok, "test_response_serialize_once: 状态行缓存与自定义原因短语、Content-Length补全格式正确");
+    check(size_exact, "test_response_serialize_once: SerializedSize精确，头部+移交body与完整序列化一致");
+
+    // 基准：典型 JSON 响应，旧实现逐段 std::string 拼接后再整体拷贝 body
+    HttpResponse bench(HttpStatusCode::OK);
+    bench.SetHeader("Content-Type", "application/json; charset=utf-8");
+    bench.SetHeader("Cache-Control", "no-store");
+    bench.SetHeader("X-Request-Id", "req-0123456789abcdef");
+    bench.SetHeader("Connection", "keep-alive");
+    bench.SetHeader("Vary", "Origin");
+    bench.SetBody(std::string(512, 'x'));
+    constexpr int kSerIters = 50000;
+    size_t ser_sink = 0;
+
+    const size_t concat_alloc_before = g_alloc_count.load(std::memory_order_relaxed);
+    auto concat_begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kSerIters; i++) {
+      std::string result = bench.GetVersionStr() + " " + std::to_string(bench.getStatusCodeInt()) + " " +
+                           bench.getStatusReason() + "\r\n";
+      result += "content-length: " + std::to_string(bench.GetBodyLength()) + "\r\n";
+      bench.ForEachHeader([&result](std::string_view k, std::string_view v) {
+        result += std::string(k) + ": " + std::string(v) + "\r\n";
+      });
+      result += "\r\n";
+      result += bench.GetBody();
+      ser_sink += result.size();
+    }
+    auto concat_end = std::chrono::steady_clock::now();
+    const size_t concat_allocs = g_alloc_count.load(std::memory_order_relaxed) - concat_alloc_before;
+
+    const size_t once_alloc_before = g_alloc_count.load(std::memory_order_relaxed);
+    auto once_begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < kSerIters; i++) {
+      std::string head;
+      bench.SerializeHeadTo(head);
+      ser_sink += head.size() + bench.GetBodyLength();
+    }
+    auto once_end = std::chrono::steady_clock::now();
+    const size_t once_allocs = g_alloc_count.load(std::memory_order_relaxed) - once_alloc_before;
+
+    const double concat_ns = std::chrono::duration<double, std::nano>(concat_end - concat_begin).count() / kSerIters;
+    const double once_ns = std::chrono::duration<double, std::nano>(once_end - once_begin).count() / kSerIters;
+    std::cout << "  " << bench.SerializedSize() << "B response: concat=" << static_cast<long>(concat_ns)
+              << "ns allocs=" << concat_allocs / kSerIters << "  head-once=" << static_cast<long>(once_ns)
+              << "ns allocs=" << once_allocs / kSerIters << " (sink=" << ser_sink << ")\n";
+    check(once_allocs == static_cast<size_t>(kSerIters),
+          "test_response_serialize_once: 头部序列化每响应只分配一次");
+  }
+
+  std::cout << "\n[21] test_cached_date_and_prerendered_headers\n";
+  {
+    auto strftime_date = [](time_t t) {
+      char buf[64];
+      struct tm tm_utc;
+      gmtime_r(&t, &tm_utc);
+      size_t n = strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &tm_utc);
+      return std::string(buf, n);
+    };
+    // 自行换算的日期与 gmtime/strftime 逐秒对照：纪元、闰日、世纪年与随机时间点
+    bool format_matches = true;
+    std::vector<time_t> instants = {0, 59, 86399, 86400, 951782400, 951868799, 4107542400LL, 1709164800, 2147483647};
+    uint64_t date_rng = 0x2545F4914F6CDD1Dull;
+    for (int i = 0; i < 20000; i++) {
+      date_rng ^= date_rng << 13;
+      date_rng ^= date_rng >> 7;
+      date_rng ^= date_rng << 17;
+      instants.push_back(static_cast<time_t>(date_rng % 7258118400ull));  // 1970 - 2200
+    }
+    for (time_t t : instants) {
+      if (FormatHttpDate(t) != strftime_date(t)) format_matches = false;
+    }
+    bool cached_ok = false;
+    for (int attempt = 0; attempt < 3 && !cached_ok; attempt++) {
+      cached_ok = CachedHttpDate() == FormatHttpDate(time(nullptr));
+    }
+    check(format_matches, "test_cached_date_and_prerendered_headers: IMF-fixdate格式化与strftime一致");
+    check(cached_ok, "test_cached_date_and_prerendered_headers: 线程缓存的Date与当前时间一致");
+
+    PrerenderedHeaders pre;
+    pre.common = "server: WebServer\r\nx-content-type-options: nosniff\r\n";
+    pre.cors = "access-control-max-age: 600\r\n";
+    HttpResponse with_pre(HttpStatusCode::OK);
+    with_pre.SetPrerenderedHeaders(&pre);
+    with_pre.SetHeader("Content-Type", "text/plain");
+    with_pre.SetBody("hi");
+    const std::string plain = with_pre.Serialize();
+    const bool cors_used = with_pre.UsePrerenderedCors();
+    const std::string with_cors = with_pre.Serialize();
+    HttpResponse fixed_date(HttpStatusCode::OK);
+    fixed_date.SetPrerenderedHeaders(&pre);
+    fixed_date.SetHeader("Date", "Thu, 01 Jan 1970 00:00:00 GMT");
+    const std::string fixed = fixed_date.Serialize();
+
+    const std::string date_line = "date: " + std::string(CachedHttpDate()) + "\r\n";
+    const bool splice_ok =
+        plain.find("content-length: 2\r\ndate: ") != std::string::npos &&
+        plain.find("\r\nserver: WebServer\r\nx-content-type-options: nosniff\r\ncontent-type: text/plain\r\n\r\nhi") !=
+            std::string::npos &&
+        plain.find("access-control-max-age") == std::string::npos && cors_used &&
+        with_cors.find("nosniff\r\naccess-control-max-age: 600\r\ncontent-type") != std::string::npos &&
+        fixed.find("date: ") == fixed.rfind("date: ") && fixed.find("date: Thu, 01 Jan 1970") != std::string::npos &&
+        with_pre.SerializedSize() == with_cors.size() && fixed_date.SerializedSize() == fixed.size();
+    check(splice_ok && date_line.size() == 37,
+          "test_cached_date_and_prerendered_headers: 预渲染头部整块拼入，已设置Date时不重复");
+
+    // 基准：每响应生成一次 Date 值
+    constexpr int kDateIters = 200000;
+    size_t date_sink = 0;
+    auto b0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kDateIters; i++) date_sink += strftime_date(time(nullptr)).size();
+    auto b1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kDateIters; i++) date_sink += CachedHttpDate().size();
+    auto b2 = std::chrono::steady_clock::now();
+    std::cout << "  Date per response: gmtime+strftime="
+              << static_cast<long>(std::chrono::duration<double, std::nano>(b1 - b0).count() / kDateIters)
+              << "ns  cached=" << static_cast<long>(std::chrono::duration<double, std::nano>(b2 - b1).count() / kDateIters)
+              << "ns (sink=" << date_sink << ")\n";
+  }
+
+  std::cout << "\n[22] test_radix_router\n";
+  {
+    // 与 HttpServer::SetupRoutes 一致的路由表，每条路由的处理器记录自己的编号
+    Router router;
+    int hit = -1;
+    int next_id = 0;
+    auto add = [&](HttpMethod m, const std::string& path) {
+      const int id = next_id++;
+      router.AddRoute(m, path, [id, &hit](HttpRequest&, HttpResponse&, const RouteParams&) {
+        hit = id;
+        return true;
+      });
+      return id;
+    };
+    const int r_register = add(HttpMethod::POST, "/register");
+    add(HttpMethod::POST, "/login");
+    add(HttpMethod::POST, "/refresh-token");
+    const int r_files = add(HttpMethod::GET, "/api/files");
+    add(HttpMethod::GET, "/api/files/preview");
+    const int r_init = add(HttpMethod::POST, "/api/uploads/init");
+    const int r_part = add(HttpMethod::PUT, "/api/uploads/:uploadId/parts/:partNo");
+    const int r_complete = add(HttpMethod::POST, "/api/uploads/:uploadId/complete");
+    add(HttpMethod::GET, "/favicon.ico");
+    add(HttpMethod::GET, "/favicon.svg");
+    add(HttpMethod::HEAD, "/favicon.svg");
+    const int r_options = add(HttpMethod::OPTIONS, "/*");
+    for (const char* prefix : {"/download", "/images", "/video", "/uploads"}) {
+      add(HttpMethod::GET, std::string(prefix) + "/*");
+      add(HttpMethod::HEAD, std::string(prefix) + "/*");
+    }
+    const int r_assets = add(HttpMethod::GET, "/assets/*");
+    add(HttpMethod::HEAD, "/assets/*");
+    add(HttpMethod::GET, "/metrics");
+    const int r_root = add(HttpMethod::GET, "/");
+    int r_index = -1;
+    for (const char* page : {"/index.html", "/welcome.html", "/login.html", "/register.html", "/picture.html", "/video.html"}) {
+      const int id = add(HttpMethod::GET, page);
+      if (r_index < 0) r_index = id;
+    }
+    // 超过 kMaxRouteParams 的路由注册失败，不影响其他路由
+    add(HttpMethod::GET, "/deep/:a/:b/:c/:d/:e/:f/:g/:h/:i");
+
+    auto make_request = [](HttpMethod m, const std::string& url) {
+      HttpRequest req;
+      req.SetMethod(m);
+      req.SetUrl(url);
+      return req;
+    };
+    HttpResponse route_resp;
+    auto route = [&](HttpRequest& req, RouteMatchInfo& info) {
+      hit = -1;
+      info = router.MatchRoute(req);
+      if (info.result == RouteMatchResult::SUCCESS && info.handler) (*info.handler)(req, route_resp, info.params);
+      return hit;
+    };
+    auto allows = [](const RouteMatchInfo& info, HttpMethod m) {
+      return std::find(info.allowedMethods.begin(), info.allowedMethods.end(), m) != info.allowedMethods.end();
+    };
+
+    RouteMatchInfo info;
+    HttpRequest part_req = make_request(HttpMethod::PUT, "/api/uploads/AbC123/parts/7?x=1");
+    const bool part_ok = route(part_req, info) == r_part && info.params.ParamCount() == 2 &&
+                         info.params.GetParam("uploadId") == std::optional<std::string>("AbC123") &&
+                         info.params.GetParamView("UPLOADID") == std::optional<std::string_view>("AbC123") &&
+                         info.params.GetParamView("partNo") == std::optional<std::string_view>("7") &&
+                         info.params.GetQueryParam("x") == std::optional<std::string>("1");
+    HttpRequest complete_req = make_request(HttpMethod::POST, "/api/uploads/abc/complete");
+    HttpRequest init_req = make_request(HttpMethod::POST, "/api/uploads/init");
+    const bool param_ok = part_ok && route(complete_req, info) == r_complete &&
+                          info.params.GetParamView("uploadid") == std::optional<std::string_view>("abc") &&
+                          route(init_req, info) == r_init && info.params.ParamCount() == 0;
+    check(param_ok, "test_radix_router: 参数路由提取原始大小写的参数值，静态段优先于参数段");
+
+    HttpRequest asset_req = make_request(HttpMethod::GET, "/assets/css/app.css");
+    HttpRequest upper_req = make_request(HttpMethod::GET, "/ASSETS/Logo.PNG");
+    HttpRequest options_req = make_request(HttpMethod::OPTIONS, "/api/files");
+    HttpRequest root_options = make_request(HttpMethod::OPTIONS, "/");
+    const bool wildcard_ok = route(asset_req, info) == r_assets && info.params.GetWildcardView() == "css/app.css" &&
+                             route(upper_req, info) == r_assets && info.params.GetWildcard() == "Logo.PNG" &&
+                             route(options_req, info) == r_options && info.params.GetWildcardView() == "api/files" &&
+                             route(root_options, info) == r_options && info.params.GetWildcardView().empty();
+    check(wildcard_ok, "test_radix_router: 通配符匹配剩余路径，静态前缀忽略大小写");
+
+    HttpRequest root_req = make_request(HttpMethod::GET, "/");
+    HttpRequest index_req = make_request(HttpMethod::GET, "/Index.HTML");
+    HttpRequest files_req = make_request(HttpMethod::GET, "/api/files?folder=a");
+    HttpRequest register_req = make_request(HttpMethod::POST, "/register");
+    HttpRequest messy_req = make_request(HttpMethod::GET, "/");
+    messy_req.SetPath("//api//files/");
+    const bool static_ok = route(root_req, info) == r_root && route(index_req, info) == r_index &&
+                           route(files_req, info) == r_files && info.params.GetQueryParam("folder") == std::optional<std::string>("a") &&
+                           route(register_req, info) == r_register && route(messy_req, info) == r_files;
+    check(static_ok, "test_radix_router: 静态路由与非规范路径匹配");
+
+    HttpRequest wrong_method = make_request(HttpMethod::GET, "/api/uploads/abc/parts/7");
+    HttpRequest assets_dir = make_request(HttpMethod::GET, "/assets");
+    HttpRequest deep_req = make_request(HttpMethod::GET, "/deep/1/2/3/4/5/6/7/8/9");
+    route(wrong_method, info);
+    const bool wrong_ok = info.result == RouteMatchResult::METHOD_NOT_ALLOWED && allows(info, HttpMethod::PUT) &&
+                          allows(info, HttpMethod::OPTIONS) && !allows(info, HttpMethod::GET);
+    route(assets_dir, info);
+    const bool dir_ok = info.result == RouteMatchResult::METHOD_NOT_ALLOWED && !allows(info, HttpMethod::GET);
+    route(deep_req, info);
+    const bool deep_ok = info.result == RouteMatchResult::METHOD_NOT_ALLOWED && info.allowedMethods.size() == 1;
+    check(wrong_ok && dir_ok && deep_ok, "test_radix_router: 方法不匹配时返回允许的方法列表");
+
+    // 基准：按真实流量的形态轮流匹配静态页面、参数路由与通配符路由
+    std::vector<HttpRequest> bench_reqs;
+    bench_reqs.push_back(make_request(HttpMethod::GET, "/index.html"));
+    bench_reqs.push_back(make_request(HttpMethod::GET, "/api/files?folder=docs"));
+    bench_reqs.push_back(make_request(HttpMethod::PUT, "/api/uploads/9f8e7d6c5b4a39281706f5e4d3c2b1a0/parts/12"));
+    bench_reqs.push_back(make_request(HttpMethod::POST, "/api/uploads/9f8e7d6c5b4a39281706f5e4d3c2b1a0/complete"));
+    bench_reqs.push_back(make_request(HttpMethod::GET, "/assets/js/vendor/app.bundle.min.js"));
+    bench_reqs.push_back(make_request(HttpMethod::GET, "/video/2024/holiday/clip-0001.mp4"));
+    bench_reqs.push_back(make_request(HttpMethod::POST, "/login"));
+    bench_reqs.push_back(make_request(HttpMethod::GET, "/favicon.svg"));
+
+    // 对照：按段切分为 std::string、unordered_map 逐段查找、参数值拷贝进 vector<std::string>
+    struct SegmentNode {
+      std::unordered_map<std::string, std::unique_ptr<SegmentNode>> children;
+      std::unique_ptr<SegmentNode> param;
+      std::unique_ptr<SegmentNode> wildcard;
+      bool terminal{false};
+    };
+    SegmentNode seg_root;
+    for (const char* pattern : {"/index.html", "/api/files", "/api/uploads/:id/parts/:no", "/api/uploads/:id/complete",
+                                "/assets/*", "/video/*", "/login", "/favicon.svg"}) {
+      SegmentNode* n = &seg_root;
+      std::string p(pattern);
+      size_t start = 1;
+      while (start <= p.size()) {
+        size_t end = p.find('/', start);
+        if (end == std::string::npos) end = p.size();
+        std::string seg = p.substr(start, end - start);
+        std::unique_ptr<SegmentNode>& next = seg[0] == ':' ? n->param : seg == "*" ? n->wildcard : n->children[seg];
+        if (!next) next = std::make_unique<SegmentNode>();
+        n = next.get();
+        start = end + 1;
+      }
+      n->terminal = true;
+    }
+    auto segment_match = [&](const std::string& raw_path, std::vector<std::string>& values) {
+      std::string path = raw_path;
+      for (char& c : path) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+      std::vector<std::string> segs;
+      size_t start = 1;
+      while (start <= path.size()) {
+        size_t end = path.find('/', start);
+        if (end == std::string::npos) end = path.size();
+        segs.push_back(path.substr(start, end - start));
+        start = end + 1;
+      }
+      values.clear();
+      const SegmentNode* n = &seg_root;
+      for (size_t i = 0; i < segs.size(); i++) {
+        auto it = n->children.find(segs[i]);
+        if (it != n->children.end()) {
+          n = it->second.get();
+        } else if (n->param) {
+          values.push_back(segs[i]);
+          n = n->param.get();
+        } else if (n->wildcard) {
+          return true;
+        } else {
+          return false;
+        }
+      }
+      return n->terminal;
+    };
+
+    constexpr int kRouteIters = 200000;
+    bool bench_ok = true;
+    std::vector<std::string> seg_values;
+    size_t router_sink = 0;
+    auto b0 = std::chrono::steady_clock::now();
+    size_t seg_allocs = g_alloc_count.load();
+    for (int i = 0; i < kRouteIters; i++) {
+      if (!segment_match(bench_reqs[i % bench_reqs.size()].GetPath(), seg_values)) bench_ok = false;
+      router_sink += seg_values.size();
+    }
+    seg_allocs = g_alloc_count.load() - seg_allocs;
+    auto b1 = std::chrono::steady_clock::now();
+    RouteMatchInfo bench_info;
+    size_t radix_allocs = g_alloc_count.load();
+    for (int i = 0; i < kRouteIters; i++) {
+      bench_info = router.MatchRoute(bench_reqs[i % bench_reqs.size()]);
+      if (bench_info.result != RouteMatchResult::SUCCESS) bench_ok = false;
+      router_sink += bench_info.params.ParamCount();
+    }
+    radix_allocs = g_alloc_count.load() - radix_allocs;
+    auto b2 = std::chrono::steady_clock::now();
+    std::cout << "  route match (" << next_id - 1 << " routes): segment-map="
+              << static_cast<long>(std::chrono::duration<double, std::nano>(b1 - b0).count() / kRouteIters) << "ns/"
+              << static_cast<double>(seg_allocs) / kRouteIters << " allocs  radix="
+              << static_cast<long>(std::chrono::duration<double, std::nano>(b2 - b1).count() / kRouteIters) << "ns/"
+              << static_cast<double>(radix_allocs) / kRouteIters << " allocs (sink=" << router_sink << ")\n";
+    check(bench_ok, "test_radix_router: 基准请求全部命中");
+    check(radix_allocs == 0, "test_radix_router: 路由匹配不做堆分配");
+
+    // 注册路径中间件后匹配仍不分配：按 string_view 忽略大小写查找，不复制小写路径
+    int path_mw_calls = 0;
+    router.AddMiddlewareForPath("/API/Files", [&path_mw_calls](IHttpMessage&) {
+      path_mw_calls++;
+      return true;
+    });
+    int files_matches = 0;
+    size_t mw_allocs = g_alloc_count.load();
+    for (int i = 0; i < 1000; i++) {
+      HttpRequest& req = bench_reqs[i % bench_reqs.size()];
+      if (req.GetPath() == "/api/files") files_matches++;
+      bench_info = router.MatchRoute(req);
+      if (bench_info.result != RouteMatchResult::SUCCESS) bench_ok = false;
+    }
+    mw_allocs = g_alloc_count.load() - mw_allocs;
+    check(bench_ok && mw_allocs == 0 && files_matches > 0 && path_mw_calls == files_matches,
+          "test_radix_router: 存在路径中间件时匹配仍不做堆分配");
+  }
+
+  std::cout << "\n[23] test_route_table_hot_reload\n";
+  {
+    std::atomic<size_t> mw_calls{0};
+    // 每个版本的路由表都带一个全局中间件和一个记录版本号的处理器，tracker 随路由表一起释放
+    auto build = [&mw_calls](Router& r, int version, std::shared_ptr<int> tracker) {
+      r.AddMiddleware([&mw_calls](IHttpMessage&) {
+        mw_calls.fetch_add(1, std::memory_order_relaxed);
+        return true;
+      });
+      r.Get("/ver", [version, tracker](HttpRequest&, HttpResponse& resp, const RouteParams&) {
+        resp.SetStatusCode(version == 1 ? HttpStatusCode::OK : HttpStatusCode::ACCEPTED);
+        return true;
+      });
+      r.Get("/api/uploads/:uploadId", [](HttpRequest&, HttpResponse&, const RouteParams&) { return true; });
+    };
+    auto v1_tracker = std::make_shared<int>(1);
+    std::weak_ptr<int> v1_weak = v1_tracker;
+    Router router;
+    build(router, 1, std::move(v1_tracker));
+    Router staging;
+    build(staging, 2, std::make_shared<int>(2));
+    const std::shared_ptr<const RouteTable> v2 = staging.Snapshot();
+
+    HttpRequest req;
+    req.SetMethod(HttpMethod::GET);
+    req.SetUrl("/ver");
+    HttpResponse resp;
+    RouteMatchInfo pinned = router.MatchRoute(req);
+    router.Publish(v2);
+    RouteMatchInfo fresh = router.MatchRoute(req);
+    (*pinned.handler)(req, resp, pinned.params);
+    const bool old_kept = resp.getStatusCode() == HttpStatusCode::OK && !v1_weak.expired();
+    (*fresh.handler)(req, resp, fresh.params);
+    const bool new_used = resp.getStatusCode() == HttpStatusCode::ACCEPTED;
+    pinned = RouteMatchInfo{};
+    RouteEpoch::Instance().Reclaim();
+    check(old_kept && new_used && v1_weak.expired() && mw_calls.load() == 2,
+          "test_route_table_hot_reload: 已匹配的请求继续使用旧表，旧表在最后一个请求结束后释放");
+
+    // 并发：读者持续匹配并执行处理器，写者不断在两个版本之间热更新
+    Router live;
+    std::vector<std::shared_ptr<const RouteTable>> versions;
+    std::vector<std::weak_ptr<int>> trackers;
+    for (int v = 1; v <= 2; v++) {
+      Router b;
+      auto tracker = std::make_shared<int>(v);
+      trackers.push_back(tracker);
+      build(b, v, std::move(tracker));
+      versions.push_back(b.Snapshot());
+    }
+    live.Publish(versions[0]);
+    constexpr int kReaders = 4;
+    constexpr int kReadsPerThread = 100000;
+    std::atomic<bool> reload_bad{false};
+    std::atomic<bool> readers_done{false};
+    std::atomic<size_t> reloads{0};
+    mw_calls.store(0);
+    auto reader = [&](Router& r, bool run_handler) {
+      HttpRequest rq;
+      rq.SetMethod(HttpMethod::GET);
+      rq.SetUrl("/ver");
+      HttpResponse rs;
+      for (int i = 0; i < kReadsPerThread; i++) {
+        RouteMatchInfo m = r.MatchRoute(rq);
+        if (m.result != RouteMatchResult::SUCCESS || !m.handler) {
+          reload_bad.store(true);
+          continue;
+        }
+        if (run_handler) (*m.handler)(rq, rs, m.params);
+      }
+    };
+    auto run_readers = [&](Router& r, bool with_writer) {
+      readers_done.store(false);
+      std::thread writer;
+      if (with_writer) {
+        writer = std::thread([&]() {
+          size_t n = 0;
+          while (!readers_done.load(std::memory_order_acquire)) {
+            live.Publish(versions[n++ & 1]);
+            std::this_thread::yield();
+          }
+          reloads.store(n);
+        });
+      }
+      auto t0 = std::chrono::steady_clock::now();
+      std::vector<std::thread> threads;
+      for (int t = 0; t < kReaders; t++) threads.emplace_back(reader, std::ref(r), true);
+      for (auto& th : threads) th.join();
+      auto t1 = std::chrono::steady_clock::now();
+      readers_done.store(true, std::memory_order_release);
+      if (writer.joinable()) writer.join();
+      return std::chrono::duration<double, std::nano>(t1 - t0).count() / kReadsPerThread;
+    };
+    const double reload_ns = run_readers(live, true);
+    const bool counted = mw_calls.load() == static_cast<size_t>(kReaders) * kReadsPerThread;
+    versions.clear();
+    live.Clear();
+    const size_t pending = RouteEpoch::Instance().Reclaim();
+    check(!reload_bad.load() && counted && reloads.load() > 0,
+          "test_route_table_hot_reload: 并发热更新期间每个请求都完整匹配到某一版本");
+    check(pending == 0 && trackers[0].expired() && trackers[1].expired(),
+          "test_route_table_hot_reload: 热更新后的旧路由表全部回收");
+
+    // 对照：读写锁保护的路由表，匹配时两次加读锁并拷贝中间件列表
+    struct LockedTable {
+      mutable std::shared_mutex mutex;
+      std::shared_ptr<const RouteTable> table;
+    } locked;
+    Router locked_builder;
+    build(locked_builder, 1, nullptr);
+    locked.table = locked_builder.Snapshot();
+    std::atomic<bool> locked_bad{false};
+    auto locked_reader = [&]() {
+      HttpRequest rq;
+      rq.SetMethod(HttpMethod::GET);
+      rq.SetUrl("/ver");
+      HttpResponse rs;
+      for (int i = 0; i < kReadsPerThread; i++) {
+        std::vector<Middleware> mws;
+        {
+          std::shared_lock<std::shared_mutex> lock(locked.mutex);
+          mws = locked.table->globalMiddlewares;
+        }
+        for (const auto& mw : mws) mw(rq);
+        std::shared_lock<std::shared_mutex> lock(locked.mutex);
+        RouteParams params;
+        const RouteEntry* entry = locked.table->root->MatchRoute(rq.GetMethod(), rq.GetPath(), params);
+        if (!entry) {
+          locked_bad.store(true);
+          continue;
+        }
+        entry->handler(rq, rs, params);
+      }
+    };
+    auto l0 = std::chrono::steady_clock::now();
+    {
+      std::vector<std::thread> threads;
+      for (int t = 0; t < kReaders; t++) threads.emplace_back(locked_reader);
+      for (auto& th : threads) th.join();
+    }
+    auto l1 = std::chrono::steady_clock::now();
+    const double locked_ns = std::chrono::duration<double, std::nano>(l1 - l0).count() / kReadsPerThread;
+    Router quiet;
+    build(quiet, 1, nullptr);
+    const double snapshot_ns = run_readers(quiet, false);
+    std::cout << "  " << kReaders << " readers: shared_mutex+copy=" << static_cast<long>(locked_ns)
+              << "ns/match  snapshot=" << static_cast<long>(snapshot_ns)
+              << "ns/match  snapshot+reload=" << static_cast<long>(reload_ns) << "ns/match (" << reloads.load()
+              << " reloads)\n";
+    check(!locked_bad.load(), "test_route_table_hot_reload: 对照组匹配正确");
+  }
+
+  std::cout << "\n[24] test_static_route_perfect_hash\n";
+  {
+    // 与 SetupRoutes 一致的静态路由，外加参数与通配符路由（不进入静态索引）
+    const std::vector<std::pair<HttpMethod, std::string>> static_routes = {
+        {HttpMethod::POST, "/register"},      {HttpMethod::POST, "/login"},
+        {HttpMethod::POST, "/refresh-token"}, {HttpMethod::GET, "/api/files"},
+        {HttpMethod::GET, "/api/files/preview"}, {HttpMethod::POST, "/api/uploads/init"},
+        {HttpMethod::GET, "/favicon.ico"},    {HttpMethod::GET, "/favicon.svg"},
+        {HttpMethod::HEAD, "/favicon.svg"},   {HttpMethod::GET, "/metrics"},
+        {HttpMethod::GET, "/"},               {HttpMethod::GET, "/index.html"},
+        {HttpMethod::GET, "/welcome.html"},   {HttpMethod::GET, "/login.html"},
+        {HttpMethod::GET, "/register.html"},  {HttpMethod::GET, "/picture.html"},
+        {HttpMethod::GET, "/video.html"}};
+    Router router;
+    int hit = -1;
+    for (size_t i = 0; i < static_routes.size(); i++) {
+      const int id = static_cast<int>(i);
+      router.AddRoute(static_routes[i].first, static_routes[i].second,
+                      [id, &hit](HttpRequest&, HttpResponse&, const RouteParams&) {
+                        hit = id;
+                        return true;
+                      });
+    }
+    auto noop = [](HttpRequest&, HttpResponse&, const RouteParams&) { return true; };
+    router.Put("/api/uploads/:uploadId/parts/:partNo", noop);
+    router.Post("/api/uploads/:uploadId/complete", noop);
+    router.Options("/*", noop);
+    for (const char* prefix : {"/assets/*", "/download/*", "/images/*", "/video/*", "/uploads/*"}) {
+      router.Get(prefix, noop);
+      router.Head(prefix, noop);
+    }
+    const std::shared_ptr<const RouteTable> table = router.Snapshot();
+    const StaticRouteIndex& index = table->statics;
+
+    HttpRequest dummy;
+    HttpResponse resp;
+    RouteParams no_params;
+    bool all_hit = true;
+    for (size_t i = 0; i < static_routes.size(); i++) {
+      const RouteEntry* entry = index.Find(static_routes[i].first, static_routes[i].second);
+      hit = -1;
+      if (entry) entry->handler(dummy, resp, no_params);
+      if (hit != static_cast<int>(i)) all_hit = false;
+    }
+    check(index.Size() == 16 && all_hit, "test_static_route_perfect_hash: 16个静态路径无冲突地占满16个槽位");
+
+    const bool misses_ok = index.Find(HttpMethod::GET, "/INDEX.html") != nullptr &&
+                           index.Find(HttpMethod::DELETE, "/login") == nullptr &&
+                           index.Find(HttpMethod::GET, "/login.htm") == nullptr &&
+                           index.Find(HttpMethod::GET, "/assets/app.js") == nullptr &&
+                           index.Find(HttpMethod::POST, "/api/uploads/abc/complete") == nullptr &&
+                           index.Find(HttpMethod::GET, "/nope") == nullptr;
+    HttpRequest options_login;
+    options_login.SetMethod(HttpMethod::OPTIONS);
+    options_login.SetUrl("/login");
+    RouteMatchInfo options_info = router.MatchRoute(options_login);
+    HttpRequest get_login;
+    get_login.SetMethod(HttpMethod::GET);
+    get_login.SetUrl("/login");
+    RouteMatchInfo get_info = router.MatchRoute(get_login);
+    check(misses_ok && options_info.result == RouteMatchResult::SUCCESS &&
+              get_info.result == RouteMatchResult::METHOD_NOT_ALLOWED,
+          "test_static_route_perfect_hash: 非静态路径与未注册方法退回前缀树");
+
+    // 基准：静态路由命中 —— 规范化拷贝 + 两层 unordered_map / 前缀树 / 完美哈希
+    std::unordered_map<std::string, std::unordered_map<HttpMethod, int>> nested;
+    for (size_t i = 0; i < static_routes.size(); i++) nested[static_routes[i].second][static_routes[i].first] = static_cast<int>(i);
+    constexpr int kStaticIters = 400000;
+    size_t static_sink = 0;
+    RouteParams bench_params;
+    auto s0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kStaticIters; i++) {
+      const auto& r = static_routes[i % static_routes.size()];
+      std::string normalized = r.second;
+      for (char& c : normalized) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+      auto it = nested.find(normalized);
+      if (it != nested.end()) {
+        auto mit = it->second.find(r.first);
+        if (mit != it->second.end()) static_sink += static_cast<size_t>(mit->second);
+      }
+    }
+    auto s1 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kStaticIters; i++) {
+      const auto& r = static_routes[i % static_routes.size()];
+      static_sink += table->root->MatchRoute(r.first, r.second, bench_params) != nullptr;
+    }
+    auto s2 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kStaticIters; i++) {
+      const auto& r = static_routes[i % static_routes.size()];
+      static_sink += index.Find(r.first, r.second) != nullptr;
+    }
+    auto s3 = std::chrono::steady_clock::now();
+    auto per = [](std::chrono::steady_clock::duration d) {
+      return static_cast<long>(std::chrono::duration<double, std::nano>(d).count() / kStaticIters);
+    };
+    std::cout << "  static hit: normalize+nested-map=" << per(s1 - s0) << "ns  radix=" << per(s2 - s1)
+              << "ns  perfect-hash=" << per(s3 - s2) << "ns (sink=" << static_sink << ")\n";
+  }
+
+  std::cout << "\n[25] test_http2_hpack_and_framing\n";
+  {
+    auto from_hex = [](const std::string& hex) {
+      std::string out;
+      for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        out.push_back(static_cast<char>(std::stoi(hex.substr(i, 2), nullptr, 16)));
+      }
+      return out;
+    };
+    auto decode_block = [](HpackDecoder& dec, const std::string& block) {
+      std::vector<std::pair<std::string, std::string>> fields;
+      bool ok = dec.Decode(reinterpret_cast<const uint8_t*>(block.data()), block.size(),
+                           [&fields](std::string_view n, std::string_view v) {
+                             fields.emplace_back(std::string(n), std::string(v));
+                             return true;
+                           });
+      if (!ok) fields.clear();
+      return fields;
+    };
+
+    // RFC 7541 C.4：三个带 Huffman 编码的请求共享同一个动态表
+    HpackDecoder dec;
+    auto f1 = decode_block(dec, from_hex("828684418cf1e3c2e5f23a6ba0ab90f4ff"));
+    check(f1.size() == 4 && f1[0].second == "GET" && f1[3].first == ":authority" &&
+              f1[3].second == "www.example.com" && dec.TableSize() == 57,
+          "hpack: C.4.1 解码并插入动态表");
+    auto f2 = decode_block(dec, from_hex("828684be5886a8eb10649cbf"));
+    check(f2.size() == 5 && f2[3].second == "www.example.com" && f2[4].first == "cache-control" &&
+              f2[4].second == "no-cache" && dec.TableSize() == 110,
+          "hpack: C.4.2 引用动态表条目");
+    auto f3 = decode_block(dec, from_hex("828785bf408825a849e95ba97d7f8925a849e95bb8e8b4bf"));
+    check(f3.size() == 5 && f3[1].second == "https" && f3[2].second == "/index.html" &&
+              f3[4].first == "custom-key" && f3[4].second == "custom-value" &&
+              dec.TableSize() == 164 && dec.TableEntries() == 3,
+          "hpack: C.4.3 动态表累计 164 字节");
+
+    std::string huff;
+    HpackHuffmanEncode("www.example.com", huff);
+    std::string huff_back;
+    check(huff == from_hex("f1e3c2e5f23a6ba0ab90f4ff") &&
+              HpackHuffmanDecode(reinterpret_cast<const uint8_t*>(huff.data()), huff.size(), huff_back) &&
+              huff_back == "www.example.com",
+          "hpack: Huffman 编解码与附录 B 一致");
+
+    std::string block;
+    HpackEncoder::EncodeStatus(200, block);
+    HpackEncoder::Encode("content-type", "text/html; charset=utf-8", block);
+    HpackEncoder::Encode("x-request-id", "abc-123", block);
+    HpackDecoder fresh;
+    auto rt = decode_block(fresh, block);
+    check(rt.size() == 3 && rt[0].first == ":status" && rt[0].second == "200" &&
+              rt[1].second == "text/html; charset=utf-8" && rt[2].first == "x-request-id" &&
+              fresh.TableEntries() == 0,
+          "hpack: 编码器只用静态表，解码往返一致");
+
+    // 帧级往返：客户端前言 + SETTINGS + 两个请求（GET 与带 body 的 POST），逐字节输入
+    auto frame = [](Http2FrameType type, uint8_t flags, uint32_t sid, const std::string& payload) {
+      std::string out;
+      AppendHttp2FrameHeader(out, static_cast<uint32_t>(payload.size()), type, flags, sid);
+      out += payload;
+      return out;
+    };
+    std::string get_block;
+    HpackEncoder::Encode(":method", "GET", get_block);
+    HpackEncoder::Encode(":scheme", "https", get_block);
+    HpackEncoder::Encode(":path", "/index.html", get_block);
+    HpackEncoder::Encode(":authority", "example.com", get_block);
+    std::string post_block;
+    HpackEncoder::Encode(":method", "POST", post_block);
+    HpackEncoder::Encode(":scheme", "https", post_block);
+    HpackEncoder::Encode(":path", "/login", post_block);
+    HpackEncoder::Encode(":authority", "example.com", post_block);
+    HpackEncoder::Encode("content-length", "5", post_block);
+
+    std::string client(kHttp2ClientPreface);
+    client += frame(Http2FrameType::SETTINGS, 0, 0, "");
+    client += frame(Http2FrameType::HEADERS, kHttp2FlagEndHeaders | kHttp2FlagEndStream, 1, get_block);
+    client += frame(Http2FrameType::HEADERS, kHttp2FlagEndHeaders, 3, post_block);
+    client += frame(Http2FrameType::DATA, kHttp2FlagEndStream, 3, "hello");
+    client += frame(Http2FrameType::PING, 0, 0, "pingpong");
+
+    Http2Parser h2;
+    bool fed = true;
+    for (char c : client) fed = fed && h2.Feed(&c, 1);
+    std::unique_ptr<IHttpMessage> msg1, msg2;
+    uint32_t sid1 = 0, sid2 = 0;
+    const bool popped = h2.PopRequest(msg1, sid1) && h2.PopRequest(msg2, sid2);
+    auto* req1 = dynamic_cast<HttpRequest*>(msg1.get());
+    auto* req2 = dynamic_cast<HttpRequest*>(msg2.get());
+    check(fed && popped && sid1 == 1 && sid2 == 3 && req1 && req2 &&
+              req1->GetMethod() == HttpMethod::GET && req1->GetPath() == "/index.html" &&
+              req1->GetHeaderView(KnownHeader::Host) == std::optional<std::string_view>("example.com") &&
+              req2->GetMethod() == HttpMethod::POST && req2->GetBody() == "hello",
+          "http2: 逐字节输入组装出两个独立请求");
+
+    struct CollectSink : Http2Parser::OutputSink {
+      std::string bytes;
+      std::vector<std::pair<size_t, bool>> files;   // 文件区间长度与是否转移 fd
+      size_t file_bytes{0};
+      void Write(const char* data, size_t len) override { bytes.append(data, len); }
+      void WriteFile(int, off_t, size_t len, bool close_fd) override {
+        // 文件负载以等长的占位字节记入输出，便于按帧解析
+        bytes.append(len, 'F');
+        files.emplace_back(len, close_fd);
+        file_bytes += len;
+      }
+    };
+    struct ParsedFrames {
+      std::vector<Http2FrameHeader> headers;
+      std::vector<std::string> payloads;
+    };
+    auto parse_frames = [](const std::string& bytes) {
+      ParsedFrames out;
+      size_t pos = 0;
+      while (bytes.size() - pos >= kHttp2FrameHeaderSize) {
+        Http2FrameHeader h = DecodeHttp2FrameHeader(reinterpret_cast<const uint8_t*>(bytes.data() + pos));
+        out.headers.push_back(h);
+        out.payloads.push_back(bytes.substr(pos + kHttp2FrameHeaderSize, h.length));
+        pos += kHttp2FrameHeaderSize + h.length;
+      }
+      return out;
+    };
+    auto data_bytes = [](const ParsedFrames& f, uint32_t sid, bool& end_stream, size_t& max_frame) {
+      size_t total = 0;
+      for (const auto& h : f.headers) {
+        if (h.type != Http2FrameType::DATA || h.stream_id != sid) continue;
+        total += h.length;
+        max_frame = std::max<size_t>(max_frame, h.length);
+        end_stream = end_stream || (h.flags & kHttp2FlagEndStream);
+      }
+      return total;
+    };
+
+    // 流 1：100000 字节内存 body，受对端默认 65535 窗口限制
+    HttpResponse resp;
+    resp.SetStatusCode(HttpStatusCode::OK);
+    resp.SetHeader("Content-Type", "text/html");
+    resp.SetHeader("Connection", "keep-alive");
+    resp.SetBody(std::string(100000, 'x'));
+    std::string head;
+    Http2Parser::EncodeResponseHead(resp, head);
+    HpackDecoder resp_dec;
+    auto resp_fields = decode_block(resp_dec, head);
+    bool has_conn = false, has_len = false;
+    for (const auto& f : resp_fields) {
+      has_conn = has_conn || f.first == "connection";
+      has_len = has_len || (f.first == "content-length" && f.second == "100000");
+    }
+    check(!resp_fields.empty() && resp_fields[0].first == ":status" && resp_fields[0].second == "200" &&
+              !has_conn && has_len,
+          "http2: 响应头部编码为 :status 开头且去掉 Connection");
+    h2.SubmitResponse(1, head, resp.TakeBody());
+
+    CollectSink sink;
+    h2.Flush(sink, SIZE_MAX);
+    ParsedFrames out1 = parse_frames(sink.bytes);
+    bool saw_settings_ack = false, saw_ping_ack = false, saw_headers = false;
+    for (size_t i = 0; i < out1.headers.size(); i++) {
+      const auto& h = out1.headers[i];
+      saw_settings_ack = saw_settings_ack || (h.type == Http2FrameType::SETTINGS && (h.flags & kHttp2FlagAck));
+      saw_ping_ack = saw_ping_ack || (h.type == Http2FrameType::PING && (h.flags & kHttp2FlagAck) &&
+                                      out1.payloads[i] == "pingpong");
+      saw_headers = saw_headers || (h.type == Http2FrameType::HEADERS && h.stream_id == 1);
+    }
+    bool end1 = false;
+    size_t max_frame = 0;
+    const size_t sent1 = data_bytes(out1, 1, end1, max_frame);
+    check(out1.headers.size() > 2 && out1.headers[0].type == Http2FrameType::SETTINGS &&
+              saw_settings_ack && saw_ping_ack && saw_headers,
+          "http2: 服务端前言、SETTINGS ACK 与 PING ACK");
+    check(sent1 == kHttp2DefaultWindowSize && !end1 && max_frame <= kHttp2DefaultMaxFrameSize &&
+              h2.ConnectionSendWindow() == 0,
+          "http2: DATA 帧受发送窗口与最大帧长限制");
+
+    std::string wu;
+    AppendHttp2Uint32(wu, 1u << 20);
+    std::string more = frame(Http2FrameType::WINDOW_UPDATE, 0, 0, wu) + frame(Http2FrameType::WINDOW_UPDATE, 0, 1, wu);
+    const bool wu_ok = h2.Feed(more.data(), more.size());
+    CollectSink sink2;
+    h2.Flush(sink2, SIZE_MAX);
+    ParsedFrames out2 = parse_frames(sink2.bytes);
+    bool end2 = false;
+    const size_t sent2 = data_bytes(out2, 1, end2, max_frame);
+    check(wu_ok && sent1 + sent2 == 100000 && end2, "http2: WINDOW_UPDATE 之后发完剩余 body 并结束流");
+
+    // 流 3：文件负载交给 sink 的 sendfile 区间，只有最后一段转移 fd 所有权
+    char tmpl[] = "/tmp/h2_body_XXXXXX";
+    int file_fd = ::mkstemp(tmpl);
+    ::unlink(tmpl);
+    h2.SubmitResponse(3, head, "", file_fd, 0, 40000);
+    CollectSink sink3;
+    h2.Flush(sink3, 20000);   // 输出预算只允许部分 DATA
+    const size_t first_budget_bytes = sink3.file_bytes;
+    h2.Flush(sink3, SIZE_MAX);
+    ParsedFrames out3 = parse_frames(sink3.bytes);
+    bool end3 = false;
+    size_t max3 = 0;
+    const size_t sent3 = data_bytes(out3, 3, end3, max3);
+    size_t transfers = 0;
+    for (const auto& f : sink3.files) transfers += f.second ? 1 : 0;
+    check(first_budget_bytes <= 20000 && sent3 == 40000 && sink3.file_bytes == 40000 && end3 &&
+              transfers == 1 && sink3.files.back().second && max3 <= kHttp2DefaultMaxFrameSize &&
+              h2.ActiveStreamCount() == 0,
+          "http2: sendfile DATA 帧按预算分段，最后一段转移 fd");
+
+    // 偶数流 ID 属于服务端：连接级 PROTOCOL_ERROR 并发出 GOAWAY
+    std::string bad = frame(Http2FrameType::HEADERS, kHttp2FlagEndHeaders | kHttp2FlagEndStream, 4, get_block);
+    const bool bad_ok = h2.Feed(bad.data(), bad.size());
+    CollectSink sink4;
+    h2.Flush(sink4, SIZE_MAX);
+    ParsedFrames out4 = parse_frames(sink4.bytes);
+    check(!bad_ok && h2.ShouldClose() && !out4.headers.empty() &&
+              out4.headers.back().type == Http2FrameType::GOAWAY &&
+              ReadHttp2Uint32(reinterpret_cast<const uint8_t*>(out4.payloads.back().data() + 4)) ==
+                  static_cast<uint32_t>(Http2ErrorCode::PROTOCOL_ERROR),
+          "http2: 非法流 ID 触发 GOAWAY(PROTOCOL_ERROR)");
+  }
+
+  std::cout << "\n[26] test_streaming_request_body\n";
+  {
+    // 超过阈值的请求只交付请求头，body 留在输入中；其后的小请求仍按原路径完整解析
+    const std::string head = "PUT /api/uploads/u1/parts/0 HTTP/1.1\r\nHost: x\r\nContent-Length: 4096\r\n\r\n";
+    std::string wire = head + std::string(100, 'b');
+    Http1Parser parser;
+    parser.SetBodyDeferThreshold(1024);
+    struct iovec iov1[1] = {{const_cast<char*>(wire.data()), wire.size()}};
+    std::unique_ptr<IHttpMessage> msg;
+    const int rc = parser.ParseSegments(iov1, 1, msg);
+    auto* req = dynamic_cast<HttpRequest*>(msg.get());
+    check(rc == static_cast<int>(ParseResult::SUCCESS) && req && parser.GetConsumeBytes() == head.size() &&
+              req->DeferredBodyLength() == 4096 && req->GetBodyView().empty() &&
+              req->GetHeader("Host").value_or("") == "x",
+          "body 流式: 大请求体只交付请求头，不等待 body");
+
+    const std::string small = "PUT /p HTTP/1.1\r\nContent-Length: 5\r\n\r\nhello";
+    struct iovec iov2[1] = {{const_cast<char*>(small.data()), small.size()}};
+    std::unique_ptr<IHttpMessage> msg2;
+    const int rc2 = parser.ParseSegments(iov2, 1, msg2);
+    auto* req2 = dynamic_cast<HttpRequest*>(msg2.get());
+    check(rc2 == static_cast<int>(ParseResult::SUCCESS) && req2 && req2->GetBodyView() == "hello" &&
+              req2->DeferredBodyLength() == 0 && parser.GetConsumeBytes() == small.size(),
+          "body 流式: 阈值以下的请求照常带 body 交付");
+
+    // 接收器：按偏移写入，总长不符或取消时只 Abort 一次，完成后取消不再生效
+    struct MemorySink : RequestBodySink {
+      std::string data;
+      int aborts = 0;
+      bool Write(uint64_t offset, const char* p, size_t len) override {
+        if (offset != data.size()) return false;
+        data.append(p, len);
+        return true;
+      }
+      bool Finish(uint64_t total) override { return total == data.size(); }
+      void Abort() override { aborts++; }
+    };
+    MemorySink ok;
+    const bool ok_flow = ok.Deliver(0, "abc", 3) && ok.Deliver(3, "de", 2) && ok.Complete(5);
+    ok.Cancel();
+    MemorySink short_body;
+    short_body.Deliver(0, "abc", 3);
+    const bool short_rejected = !short_body.Complete(5);
+    short_body.Cancel();
+    MemorySink gap;
+    const bool gap_rejected = gap.Deliver(0, "ab", 2) && !gap.Deliver(5, "cd", 2) && !gap.Deliver(2, "cd", 2);
+    check(ok_flow && ok.Completed() && ok.Received() == 5 && ok.aborts == 0 && short_rejected &&
+              !short_body.Completed() && short_body.aborts == 1 && gap_rejected && gap.aborts == 1 &&
+              gap.Received() == 2,
+          "body 流式: 接收器完成、长度不符与写入失败语义");
+
+    // 流式路由在匹配结果中带出接收器工厂
+    Router router;
+    router.AddStreamingRoute(HttpMethod::PUT, "/api/uploads/:uploadId/parts/:partNo",
+        [](HttpRequest&, HttpResponse&, const RouteParams&) { return true; },
+        [](HttpRequest&, const RouteParams& params, uint64_t length, HttpResponse&) -> std::unique_ptr<RequestBodySink> {
+          if (length > 8 || params.GetParam("uploadId").value_or("") != "u1") return nullptr;
+          return std::make_unique<MemorySink>();
+        },
+        "blocking_disk");
+    router.Put("/plain", [](HttpRequest&, HttpResponse&, const RouteParams&) { return true; });
+    HttpRequest put_part;
+    put_part.SetMethod(HttpMethod::PUT);
+    put_part.SetUrl("/api/uploads/u1/parts/3");
+    RouteMatchInfo part_info = router.MatchRoute(put_part);
+    HttpRequest put_plain;
+    put_plain.SetMethod(HttpMethod::PUT);
+    put_plain.SetUrl("/plain");
+    RouteMatchInfo plain_info = router.MatchRoute(put_plain);
+    HttpResponse sink_resp;
+    const bool factory_ok = part_info.bodySink &&
+                            (*part_info.bodySink)(put_part, part_info.params, 8, sink_resp) != nullptr &&
+                            (*part_info.bodySink)(put_part, part_info.params, 9, sink_resp) == nullptr;
+    check(part_info.result == RouteMatchResult::SUCCESS && part_info.executor == "blocking_disk" && factory_ok &&
+              plain_info.result == RouteMatchResult::SUCCESS && plain_info.bodySink == nullptr,
+          "body 流式: 流式路由带出接收器工厂，普通路由没有");
+  }
+
+  std::cout << "\n[27] test_response_body_producer\n";
+  {
+    // 生产者每次调用给出一段（可以超过 max_bytes，也可以为空）
+    auto make_producer = [](int64_t length, std::vector<std::string> pieces) {
+      auto index = std::make_shared<size_t>(0);
+      return std::make_shared<CallbackBodyProducer>(
+          [index, pieces](std::string& out, size_t) {
+            if (*index >= pieces.size()) return BodyProducer::Status::Done;
+            out.append(pieces[*index]);
+            ++*index;
+            return *index == pieces.size() ? BodyProducer::Status::Done : BodyProducer::Status::More;
+          },
+          length);
+    };
+    auto drain = [](BodyProducerFramer& framer, size_t max_bytes, size_t& pulls) {
+      std::string wire;
+      BodyProducer::Status status;
+      pulls = 0;
+      do {
+        status = framer.Next(wire, max_bytes);
+        pulls++;
+      } while (status == BodyProducer::Status::More && pulls < 100);
+      return std::make_pair(status, wire);
+    };
+
+    size_t pulls = 0;
+    BodyProducerFramer chunked(make_producer(-1, {std::string(5000, 'a'), "", std::string(3000, 'b')}), true);
+    auto [chunked_status, chunked_wire] = drain(chunked, 4096, pulls);
+    const std::string expected = "1388\r\n" + std::string(5000, 'a') + "\r\nbb8\r\n" + std::string(3000, 'b') + "\r\n0\r\n\r\n";
+    check(chunked_status == BodyProducer::Status::Done && chunked_wire == expected && chunked.Produced() == 8000 &&
+              pulls == 3,
+          "body 生产者: chunked 分块帧、跳过空段并以终止块结束");
+
+    BodyProducerFramer sized(make_producer(8000, {std::string(5000, 'a'), std::string(3000, 'b')}), false);
+    auto [sized_status, sized_wire] = drain(sized, 65536, pulls);
+    BodyProducerFramer short_body(make_producer(9000, {std::string(5000, 'a'), std::string(3000, 'b')}), false);
+    auto short_result = drain(short_body, 65536, pulls);
+    BodyProducerFramer long_body(make_producer(6000, {std::string(5000, 'a'), std::string(3000, 'b')}), false);
+    auto long_result = drain(long_body, 65536, pulls);
+    check(sized_status == BodyProducer::Status::Done && sized_wire.size() == 8000 &&
+              short_result.first == BodyProducer::Status::Error && long_result.first == BodyProducer::Status::Error,
+          "body 生产者: 已知长度原样发送，长度与声明不符时报错");
+
+    HttpResponse known;
+    known.SetBody("stale");
+    known.SetBodyProducer(make_producer(8000, {}));
+    HttpResponse unknown;
+    unknown.SetHeader("Content-Length", "5");
+    unknown.SetBodyProducer(make_producer(-1, {}));
+    std::string unknown_head;
+    unknown.SerializeHeadTo(unknown_head);
+    check(known.HasBodyProducer() && known.GetBodyLength() == 0 &&
+              known.GetHeader("Content-Length").value_or("") == "8000" &&
+              unknown.GetHeader("Transfer-Encoding").value_or("") == "chunked" && !unknown.HasHeader("Content-Length") &&
+              unknown_head.find("Content-Length") == std::string::npos &&
+              unknown_head.find("ontent-length") == std::string::npos && unknown.TakeBodyProducer() &&
+              !unknown.HasBodyProducer(),
+          "body 生产者: 响应按长度是否已知设置 Content-Length 或 chunked");
+
+    // HTTP/2：生产者挂在流上，按流的发送窗口逐段拉取（与 HttpServer::FlushHttp2 的拉取循环一致）
+    auto h2_frame = [](Http2FrameType type, uint8_t flags, uint32_t sid, const std::string& payload) {
+      std::string out;
+      AppendHttp2FrameHeader(out, static_cast<uint32_t>(payload.size()), type, flags, sid);
+      return out + payload;
+    };
+    struct BytesSink : Http2Parser::OutputSink {
+      std::string bytes;
+      void Write(const char* data, size_t len) override { bytes.append(data, len); }
+      void WriteFile(int, off_t, size_t, bool) override {}
+    };
+    auto h2_data = [](const std::string& bytes, uint32_t sid, bool& end_stream, bool& reset) {
+      size_t total = 0;
+      for (size_t pos = 0; bytes.size() - pos >= kHttp2FrameHeaderSize;) {
+        Http2FrameHeader h = DecodeHttp2FrameHeader(reinterpret_cast<const uint8_t*>(bytes.data() + pos));
+        if (h.stream_id == sid && h.type == Http2FrameType::DATA) {
+          total += h.length;
+          end_stream = end_stream || (h.flags & kHttp2FlagEndStream);
+        }
+        reset = reset || (h.stream_id == sid && h.type == Http2FrameType::RST_STREAM &&
+                          ReadHttp2Uint32(reinterpret_cast<const uint8_t*>(bytes.data() + pos + kHttp2FrameHeaderSize)) ==
+                              static_cast<uint32_t>(Http2ErrorCode::INTERNAL_ERROR));
+        pos += kHttp2FrameHeaderSize + h.length;
+      }
+      return total;
+    };
+    std::string get_block;
+    HpackEncoder::Encode(":method", "GET", get_block);
+    HpackEncoder::Encode(":scheme", "https", get_block);
+    HpackEncoder::Encode(":path", "/api/files", get_block);
+    HpackEncoder::Encode(":authority", "example.com", get_block);
+    const std::string h2_client = std::string(kHttp2ClientPreface) + h2_frame(Http2FrameType::SETTINGS, 0, 0, "") +
+                                  h2_frame(Http2FrameType::HEADERS, kHttp2FlagEndHeaders | kHttp2FlagEndStream, 1, get_block);
+    std::string h2_head;
+    HttpResponse h2_resp;
+    h2_resp.SetStatusCode(HttpStatusCode::OK);
+    Http2Parser::EncodeResponseHead(h2_resp, h2_head);
+
+    // 10 段各 16KB；失败版本在第 3 段报错
+    constexpr size_t kPiece = 16384;
+    constexpr int kPieces = 10;
+    auto counting_producer = [](int* calls, int fail_at) {
+      return std::make_shared<CallbackBodyProducer>([calls, fail_at](std::string& out, size_t) {
+        ++*calls;
+        if (*calls == fail_at) return BodyProducer::Status::Error;
+        out.append(kPiece, 'p');
+        return *calls == kPieces ? BodyProducer::Status::Done : BodyProducer::Status::More;
+      });
+    };
+    // 与 PullHttp2ResponseBodies/ApplyHttp2BodyPiece 相同：只为有需求的流拉取一段（每次一段 kPiece），追加后再写出
+    auto pump = [&](Http2Parser& h2, BodyProducerFramer& framer, BytesSink& sink, bool& open) {
+      std::vector<uint32_t> demand;
+      for (int guard = 0; open && guard < 100; ++guard) {
+        h2.Flush(sink, SIZE_MAX);
+        demand.clear();
+        h2.CollectBodyDemand(demand);
+        if (demand.empty()) break;
+        std::string piece;
+        const BodyProducer::Status st = framer.Next(piece, kPiece);
+        if (st == BodyProducer::Status::Error) {
+          h2.ResetStream(1, Http2ErrorCode::INTERNAL_ERROR);
+          open = false;
+        } else {
+          open = h2.AppendResponseBody(1, std::move(piece), st == BodyProducer::Status::Done) &&
+                 st == BodyProducer::Status::More;
+        }
+      }
+      h2.Flush(sink, SIZE_MAX);
+    };
+
+    Http2Parser h2;
+    std::unique_ptr<IHttpMessage> h2_msg;
+    uint32_t h2_sid = 0;
+    const bool h2_ready = h2.Feed(h2_client.data(), h2_client.size()) && h2.PopRequest(h2_msg, h2_sid) && h2_sid == 1;
+    int calls = 0;
+    BodyProducerFramer h2_framer(counting_producer(&calls, 0), false);
+    std::string h2_first;
+    h2_framer.Next(h2_first, kPiece);   // 首段在 worker 上随响应头生成
+    h2.SubmitStreamingResponse(1, h2_head, std::move(h2_first));
+    BytesSink h2_sink;
+    bool open = true;
+    pump(h2, h2_framer, h2_sink, open);
+    bool end_before = false, reset_before = false;
+    const size_t sent_before = h2_data(h2_sink.bytes, 1, end_before, reset_before);
+    const int calls_before = calls;
+    // 对端默认 65535 字节窗口：第 4 段写出 16383 字节后窗口耗尽，不再拉取
+    check(h2_ready && calls_before == 4 && sent_before == kHttp2DefaultWindowSize && !end_before &&
+              h2.ActiveStreamCount() == 1,
+          "body 生产者: HTTP/2 按流的发送窗口逐段拉取，窗口耗尽时暂停");
+
+    std::string wu;
+    AppendHttp2Uint32(wu, 1u << 20);
+    const std::string window_update =
+        h2_frame(Http2FrameType::WINDOW_UPDATE, 0, 0, wu) + h2_frame(Http2FrameType::WINDOW_UPDATE, 0, 1, wu);
+    const bool wu_ok = h2.Feed(window_update.data(), window_update.size());
+    BytesSink h2_sink2;
+    pump(h2, h2_framer, h2_sink2, open);
+    bool end_after = false, reset_after = false;
+    const size_t sent_after = h2_data(h2_sink2.bytes, 1, end_after, reset_after);
+    check(wu_ok && calls == kPieces && sent_before + sent_after == kPiece * kPieces && end_after &&
+              h2.ActiveStreamCount() == 0,
+          "body 生产者: HTTP/2 窗口恢复后继续拉取并以 END_STREAM 结束");
+
+    // 后续段失败：响应头已发出，只以 RST_STREAM(INTERNAL_ERROR) 重置该流
+    Http2Parser h2_fail;
+    std::unique_ptr<IHttpMessage> fail_msg;
+    uint32_t fail_sid = 0;
+    const bool fail_ready = h2_fail.Feed(h2_client.data(), h2_client.size()) && h2_fail.PopRequest(fail_msg, fail_sid);
+    int fail_calls = 0;
+    BodyProducerFramer fail_framer(counting_producer(&fail_calls, 3), false);
+    std::string fail_first;
+    fail_framer.Next(fail_first, kPiece);
+    h2_fail.SubmitStreamingResponse(1, h2_head, std::move(fail_first));
+    BytesSink fail_sink;
+    bool fail_open = true;
+    pump(h2_fail, fail_framer, fail_sink, fail_open);
+    bool fail_end = false, fail_reset = false;
+    const size_t fail_sent = h2_data(fail_sink.bytes, 1, fail_end, fail_reset);
+    check(fail_ready && fail_calls == 3 && fail_sent == 2 * kPiece && !fail_end && fail_reset &&
+              h2_fail.ActiveStreamCount() == 0 && !h2_fail.AppendResponseBody(1, "late", true),
+          "body 生产者: HTTP/2 后续段失败时以 RST_STREAM(INTERNAL_ERROR) 结束该流");
+  }
+
+  std::cout << "\n[28] test_response_compression\n";
+  {
+    check(NegotiateContentEncoding("gzip, deflate, br") == HttpContentEncoding::GZIP &&
+              NegotiateContentEncoding("deflate;q=1, gzip;q=0.5") == HttpContentEncoding::DEFLATE &&
+              NegotiateContentEncoding("gzip;q=0, *;q=0.3") == HttpContentEncoding::DEFLATE &&
+              NegotiateContentEncoding("br, identity") == HttpContentEncoding::IDENTITY &&
+              NegotiateContentEncoding("*;q=0") == HttpContentEncoding::IDENTITY &&
+              NegotiateContentEncoding("X-GZIP") == HttpContentEncoding::GZIP &&
+              NegotiateContentEncoding("") == HttpContentEncoding::IDENTITY,
+          "响应压缩: 按 q 值协商编码，q=0 表示拒绝");
+
+    check(IsCompressibleContentType("text/html; charset=utf-8") && IsCompressibleContentType("application/json") &&
+              IsCompressibleContentType("application/problem+json") && IsCompressibleContentType("image/svg+xml") &&
+              !IsCompressibleContentType("image/png") && !IsCompressibleContentType("application/octet-stream"),
+          "响应压缩: 只压缩文本类媒体类型");
+
+    // 用 zlib 解压（windowBits 47 自动识别 gzip/zlib 头）
+    auto inflate_all = [](const std::string& in, std::string& out) {
+      z_stream zs{};
+      if (inflateInit2(&zs, 47) != Z_OK) return false;
+      zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+      zs.avail_in = static_cast<uInt>(in.size());
+      int rc = Z_OK;
+      char buf[4096];
+      while (rc == Z_OK) {
+        zs.next_out = reinterpret_cast<Bytef*>(buf);
+        zs.avail_out = sizeof(buf);
+        rc = inflate(&zs, Z_NO_FLUSH);
+        out.append(buf, sizeof(buf) - zs.avail_out);
+        if (rc == Z_BUF_ERROR && zs.avail_in == 0) break;
+      }
+      inflateEnd(&zs);
+      return rc == Z_STREAM_END;
+    };
+
+    std::string text;
+    for (int i = 0; i < 2000; ++i) text += "{\"id\":" + std::to_string(i) + ",\"name\":\"file\"},";
+    std::string gz, df, gz_plain, df_plain;
+    bool gz_ok = CompressBody(text, HttpContentEncoding::GZIP, 6, gz);
+    bool df_ok = CompressBody(text, HttpContentEncoding::DEFLATE, 1, df);
+    check(gz_ok && df_ok && gz.size() < text.size() / 4 && static_cast<unsigned char>(gz[0]) == 0x1f &&
+              inflate_all(gz, gz_plain) && gz_plain == text && inflate_all(df, df_plain) && df_plain == text,
+          "响应压缩: gzip/deflate 一次性压缩可还原");
+
+    // 流式压缩：每段同步刷新，套上 chunked 帧后解出的内容与原文一致
+    auto pieces = std::make_shared<std::vector<std::string>>();
+    for (size_t off = 0; off < text.size(); off += 7000) pieces->push_back(text.substr(off, 7000));
+    auto index = std::make_shared<size_t>(0);
+    auto inner = std::make_shared<CallbackBodyProducer>([pieces, index](std::string& out, size_t) {
+      if (*index >= pieces->size()) return BodyProducer::Status::Done;
+      out.append((*pieces)[(*index)++]);
+      return BodyProducer::Status::More;
+    });
+    auto compressing = MakeCompressingProducer(inner, HttpContentEncoding::GZIP, 5);
+    BodyProducerFramer framer(compressing, true);
+    std::string wire;
+    BodyProducer::Status status;
+    size_t guard = 0;
+    do {
+      status = framer.Next(wire, 16384);
+    } while (status == BodyProducer::Status::More && ++guard < 1000);
+
+    std::string dechunked;
+    size_t pos = 0;
+    bool framing_ok = status == BodyProducer::Status::Done;
+    while (framing_ok) {
+      size_t line_end = wire.find("\r\n", pos);
+      if (line_end == std::string::npos) {
+        framing_ok = false;
+        break;
+      }
+      size_t chunk = std::stoul(wire.substr(pos, line_end - pos), nullptr, 16);
+      pos = line_end + 2;
+      if (chunk == 0) break;
+      dechunked.append(wire, pos, chunk);
+      pos += chunk + 2;
+    }
+    std::string streamed_plain;
+    check(framing_ok && compressing->Length() == -1 && inflate_all(dechunked, streamed_plain) &&
+              streamed_plain == text && dechunked.size() < text.size() / 2,
+          "响应压缩: 压缩生产者逐段输出，chunked 拆帧后可完整解压");
+  }
+
+  std::cout << "\n[29] test_request_object_reuse\n";
+  {
+    const std::string get_req =
+        "GET /static/js/app.bundle.js HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36\r\n"
+        "Accept: */*\r\n"
+        "Accept-Encoding: gzip, deflate, br\r\n"
+        "Cookie: session=4f9a1c2e7b3d4a5f8e6c0b1a2d3e4f5a; theme=dark\r\n"
+        "Connection: keep-alive\r\n"
+        "\r\n";
+    auto parse = [](Http1Parser& parser, const std::string& raw, std::unique_ptr<IHttpMessage>& msg) {
+      struct iovec iov[1] = {{const_cast<char*>(raw.data()), raw.size()}};
+      return parser.ParseSegments(iov, 1, msg) == static_cast<int>(ParseResult::SUCCESS);
+    };
+    auto recycle = [](Http1Parser& parser, std::unique_ptr<IHttpMessage>& msg) {
+      parser.RecycleRequest(std::unique_ptr<HttpRequest>(static_cast<HttpRequest*>(msg.release())));
+    };
+
+    // 长连接稳定状态：请求对象与请求头缓冲在同一解析器上循环使用
+    Http1Parser parser;
+    std::unique_ptr<IHttpMessage> msg;
+    bool reuse_ok = true;
+    for (int i = 0; i < 4; ++i) {
+      reuse_ok = reuse_ok && parse(parser, get_req, msg);
+      recycle(parser, msg);
+    }
+    constexpr int kReuseIters = 2000;
+    size_t sink = 0;
+    const void* first_object = nullptr;
+    const size_t alloc_before = g_alloc_count.load(std::memory_order_relaxed);
+    for (int i = 0; i < kReuseIters; ++i) {
+      reuse_ok = reuse_ok && parse(parser, get_req, msg);
+      HttpRequest* req = AsHttpRequest(msg.get());
+      if (!first_object) first_object = req;
+      reuse_ok = reuse_ok && req == first_object;
+      sink += req->GetPath().size() + req->GetHeaderView(KnownHeader::Host).value_or("").size();
+      recycle(parser, msg);
+    }
+    const size_t reuse_allocs = g_alloc_count.load(std::memory_order_relaxed) - alloc_before;
+    std::cout << "  keep-alive GET: allocs/req=" << static_cast<double>(reuse_allocs) / kReuseIters
+              << " (sink=" << sink << ")\n";
+    check(reuse_ok && reuse_allocs == 0, "请求复用: 稳定状态下解析 GET 不再分配内存");
+
+    // 复用的对象不残留上一个请求的头部、body 与查询参数
+    const std::string post_req =
+        "POST /api/upload?name=a.txt&x=1 HTTP/1.1\r\nHost: a\r\nX-Trace: 1\r\nContent-Length: 5\r\n\r\nhello";
+    const std::string plain_req = "GET /index.html HTTP/1.0\r\nHost: b\r\n\r\n";
+    bool post_ok = parse(parser, post_req, msg);
+    HttpRequest* post = AsHttpRequest(msg.get());
+    post_ok = post_ok && post->GetBody() == "hello" && post->GetQueryParam("name") == "a.txt";
+    recycle(parser, msg);
+    bool plain_ok = parse(parser, plain_req, msg);
+    HttpRequest* plain = AsHttpRequest(msg.get());
+    check(post_ok && plain_ok && plain == post && plain->GetBodyLength() == 0 && plain->GetAllQueryParams().empty() &&
+              !plain->HasHeader("X-Trace") && !plain->HasHeader("Content-Length") &&
+              plain->GetHeaderView(KnownHeader::Host).value_or("") == "b" && plain->GetPath() == "/index.html" &&
+              plain->GetVersion() == HttpVersion::HTTP_1_0 && plain->GetMethod() == HttpMethod::GET,
+          "请求复用: 复用的请求对象不残留上一个请求的状态");
+    recycle(parser, msg);
+
+    // 简单路径走快速路径，需要解码或规范化的路径结果不变
+    auto path_of = [](const std::string& url) {
+      HttpRequest r;
+      r.SetUrl(url);
+      return r.GetPath() + "|" + r.GetUrl();
+    };
+    check(path_of("/a/b.js") == "/a/b.js|/a/b.js" && path_of("/") == "/|/" && path_of("/a/b/") == "/a/b|/a/b" &&
+              path_of("/a/./b//c") == "/a/b/c|/a/b/c" && path_of("/a/../b") == "/b|/b" &&
+              path_of("/a%20b") == "/a b|/a b" && path_of("/x?k=v") == "/x|/x?k=v" && path_of("/..").rfind("|", 0) == 0,
+          "请求复用: 路径快速路径与完整解码规范化结果一致");
+
+    // dynamic_cast 的替代：只按 IsRequest() 判断具体类型
+    HttpResponse resp;
+    IHttpMessage* as_msg = &resp;
+    const IHttpMessage* as_const = plain;
+    check(AsHttpRequest(as_msg) == nullptr && AsHttpRequest(static_cast<IHttpMessage*>(nullptr)) == nullptr &&
+              AsHttpRequest(as_const) == plain,
+          "请求复用: AsHttpRequest 按消息类型静态转换");
+  }
+
+  std::cout << "\n[30] test_observer_event_mask\n";
+  {
+    // 阶段位互不重叠，kHttpAllStages 恰好覆盖全部阶段
+    const HttpProcessStage stages[] = {HttpProcessStage::SSL_PROCESS, HttpProcessStage::HTTP_PARSE,
+                                       HttpProcessStage::VALIDATION, HttpProcessStage::ROUTING,
+                                       HttpProcessStage::COMPLETE};
+    uint32_t all = 0;
+    bool disjoint = true;
+    for (HttpProcessStage st : stages) {
+      disjoint = disjoint && (all & HttpStageBit(st)) == 0;
+      all |= HttpStageBit(st);
+    }
+    check(disjoint && all == kHttpAllStages, "观察者事件: 阶段位互不重叠且全集等于 kHttpAllStages");
+
+    // 默认订阅全部阶段；只订阅 ROUTING 的观察者不覆盖解析阶段
+    struct RoutingOnly : IHttpObserver {
+      uint32_t StageMask() const override { return HttpStageBit(HttpProcessStage::ROUTING); }
+    };
+    IHttpObserver all_obs;
+    RoutingOnly routing_obs;
+    check(all_obs.StageMask() == kHttpAllStages &&
+              (routing_obs.StageMask() & HttpStageBit(HttpProcessStage::HTTP_PARSE)) == 0 &&
+              (routing_obs.StageMask() & HttpStageBit(HttpProcessStage::ROUTING)) != 0,
+          "观察者事件: StageMask 默认全订阅，可按阶段缩小");
+
+    check(std::string(HttpEventKindName(HttpEventKind::PARSE_DONE)) == "parse_done" &&
+              std::string(HttpEventKindName(HttpEventKind::MESSAGE_COMPLETE)) == "message_complete" &&
+              std::string(HttpProcessStageName(HttpProcessStage::ROUTING)) == "routing",
+          "观察者事件: 事件与阶段名称");
+
+    // 经 facade 分发：每个观察者只收到自己订阅阶段的事件，移除后不再收到
+    struct Recording : IHttpObserver {
+      explicit Recording(uint32_t mask) : mask(mask) {}
+      uint32_t StageMask() const override { return mask; }
+      void OnEvent(const HttpEvent& event) override {
+        events++;
+        if (!(mask & HttpStageBit(event.stage))) foreign++;
+        if (event.kind == HttpEventKind::PARSE_DONE) parse_done++;
+      }
+      void OnMessage(const IHttpMessage&) override { messages++; }
+      uint32_t mask;
+      int events{0};
+      int foreign{0};
+      int parse_done{0};
+      int messages{0};
+    };
+    HttpFacade facade;
+    auto process = [&facade]() {
+      std::unique_ptr<IHttpMessage> msg;
+      HttpResponse resp;
+      HttpError err;
+      return facade.Process("GET /obs HTTP/1.1\r\nHost: localhost\r\n\r\n", msg, resp, err);
+    };
+    const bool plain_ok = process() == HttpServerResult::SUCCESS;  // 无观察者：不生成事件，处理照常
+
+    auto every = std::make_shared<Recording>(kHttpAllStages);
+    auto routing = std::make_shared<Recording>(HttpStageBit(HttpProcessStage::ROUTING));
+    auto complete = std::make_shared<Recording>(HttpStageBit(HttpProcessStage::COMPLETE));
+    facade.AddObserver(every);
+    facade.AddObserver(routing);
+    facade.AddObserver(complete);
+    const bool observed_ok = process() == HttpServerResult::SUCCESS;
+    const int every_events = every->events;
+    const int routing_events = routing->events;
+    check(plain_ok && observed_ok && every->parse_done == 1 && every->messages == 1 &&
+              routing_events > 0 && routing->parse_done == 0 && routing->messages == 0 &&
+              complete->events == 1 && complete->messages == 1 &&
+              every->foreign + routing->foreign + complete->foreign == 0 &&
+              every_events > routing_events + complete->events,
+          "观察者事件: facade 按各观察者的阶段掩码分发事件");
+
+    // 移除后重建掩码：被移除的观察者不再收到事件，剩余观察者照常
+    facade.RemoveObserver(every);
+    facade.RemoveObserver(routing);
+    process();
+    const bool removed_silent = every->events == every_events && every->messages == 1 &&
+                                routing->events == routing_events && complete->events == 2 &&
+                                complete->messages == 2;
+    facade.RemoveObserver(complete);
+    process();
+    check(removed_silent && complete->events == 2 && complete->messages == 2,
+          "观察者事件: RemoveObserver 之后不再投递");
+  }
+
+  std::cout << "\n[31] test_pattern_scanner\n";
+  {
+    PatternScanner scanner(PatternScanner::DefaultRules(), {"referer"});
+    auto hit_of = [&](std::string_view text, PatternScanner::Scope scope) {
+      const PatternScanner::Rule* hit = scanner.Scan(text, scope);
+      return hit ? hit->pattern : std::string();
+    };
+    // 与逐条 find 的结果一致，且忽略大小写
+    check(hit_of("/a/../b", PatternScanner::kScopePath) == "../" &&
+              hit_of("/a/%2E%2E%2Fetc", PatternScanner::kScopePath) == "%2e%2e%2f" &&
+              hit_of("/x?q=1 UNION SELECT pw", PatternScanner::kScopeUrl) == "union select" &&
+              hit_of("/p?<ScRiPt>alert(1)", PatternScanner::kScopeUrl) == "<script" &&
+              hit_of("/img onError=x", PatternScanner::kScopePath) == "onerror=" &&
+              hit_of("/static/app.js", PatternScanner::kScopePath).empty() &&
+              hit_of("/api/upload?name=a.txt&offset=0", PatternScanner::kScopeUrl).empty(),
+          "模式扫描: 一趟扫描命中遍历、注入与 XSS 模式并忽略大小写");
+
+    // 重叠与后缀模式：失败链上结束的模式也能命中
+    PatternScanner overlap({{"abcd", PatternScanner::kScopePath, PatternScanner::RuleKind::Suspicious},
+                            {"bc", PatternScanner::kScopeUrl, PatternScanner::RuleKind::Suspicious},
+                            {"cde", PatternScanner::kScopePath, PatternScanner::RuleKind::Traversal}},
+                           {});
+    const PatternScanner::Rule* first = overlap.Scan("xabcdx", PatternScanner::kScopePath);
+    const PatternScanner::Rule* suffix = overlap.Scan("xxcde", PatternScanner::kScopePath);
+    check(first && first->pattern == "abcd" && suffix && suffix->kind == PatternScanner::RuleKind::Traversal &&
+              overlap.Scan("abce", PatternScanner::kScopeUrl) && !overlap.Scan("abce", PatternScanner::kScopePath),
+          "模式扫描: 重叠模式与作用域过滤");
+
+    // Traversal 优先：先出现的可疑片段不能遮住其后的遍历模式（仍应 403 而不是 400）
+    const PatternScanner::Rule* later = overlap.Scan("xabcde", PatternScanner::kScopePath);
+    check(hit_of("/exec(/../x", PatternScanner::kScopePath) == "../" &&
+              hit_of("/<script/..%2fetc", PatternScanner::kScopePath) == "..%2f" &&
+              hit_of("/exec(/x", PatternScanner::kScopePath) == "exec(" && later && later->pattern == "cde",
+          "模式扫描: 遍历规则优先于更早命中的可疑模式");
+
+    // 作用域：遍历规则只作用于路径，默认规则不扫描请求头
+    check(hit_of("/a/../b", PatternScanner::kScopeUrl).empty() && !scanner.HasScope(PatternScanner::kScopeHeader) &&
+              scanner.Scan("<script>", PatternScanner::kScopeHeader) == nullptr,
+          "模式扫描: 规则只在声明的字段上生效");
+
+    // 规则文件
+    char path[] = "/tmp/pattern_rules_XXXXXX";
+    int fd = mkstemp(path);
+    const std::string rules =
+        "# test rules\n"
+        "traversal path ../\n"
+        "suspicious url,header  sleep (\n"
+        "headers Referer\n";
+    bool wrote = fd >= 0 && write(fd, rules.data(), rules.size()) == static_cast<ssize_t>(rules.size());
+    if (fd >= 0) close(fd);
+    std::string err;
+    auto loaded = PatternScanner::LoadFromFile(path, &err);
+    check(wrote && loaded && loaded->Rules().size() == 2 && loaded->ScannedHeaders().size() == 1 &&
+              loaded->ScannedHeaders()[0] == "referer" && loaded->HasScope(PatternScanner::kScopeHeader) &&
+              loaded->Scan("http://x/?q=SLEEP (5)", PatternScanner::kScopeHeader) &&
+              !loaded->Scan("/union select", PatternScanner::kScopePath),
+          "模式扫描: 从规则文件加载并替换内置规则");
+    std::ofstream(path) << "block path ../\n";
+    auto bad = PatternScanner::LoadFromFile(path, &err);
+    check(bad == nullptr && err.find(":1:") != std::string::npos, "模式扫描: 规则文件格式错误时报告行号");
+    unlink(path);
+  }
+
   std::cout << "\n=== 结果: " << passed << " 通过, " << failed << " 失败 ===\n";
 
   if (failed > 0) {